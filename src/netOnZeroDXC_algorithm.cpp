@@ -34,31 +34,41 @@
 #include <cstring>
 #include <algorithm>
 #include <sstream>
+#include <fstream>
 #include <string>
 #include <vector>
 
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
 #include "omp.h"
 
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_fft_real.h>
-#include <gsl/gsl_fft_halfcomplex.h>
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+#endif
 
 #ifndef INCLUDED_ALGORITHM
 	#include "netOnZeroDXC_algorithm.hpp"
 	#define INCLUDED_ALGORITHM
 #endif
 
-struct PairValueId {
-	int index;
-	double value;
-};
-
 bool netOnZeroDXC_sort_values (PairValueId a, PairValueId b) {return a.value < b.value;}
+bool netOnZeroDXC_is_nan (double x) {return (x != x);}
 
 double netOnZeroDXC_compute_wmatrix_element (const std::vector <double> & efficiency, const std::vector <double> & window_widths, double threshold_eta)
+{
+	return netOnZeroDXC_compute_wmatrix_element(efficiency.data(), efficiency.size(), window_widths, threshold_eta);
+}
+
+double netOnZeroDXC_compute_wmatrix_element (const double * efficiency, int W, const std::vector <double> & window_widths, double threshold_eta)
 {
 	int	i;
-	for (i = 0; i < efficiency.size(); i++) {
+	for (i = 0; i < W; i++) {
 		if (efficiency[i] > threshold_eta)
 			return window_widths[i];
 	}
@@ -66,38 +76,154 @@ double netOnZeroDXC_compute_wmatrix_element (const std::vector <double> & effici
 	return -1.0;
 }
 
-int netOnZeroDXC_compute_efficiency (std::vector <double> & efficiency, const std::vector < std::vector <double> > & diagram, double threshold_alpha)
+double netOnZeroDXC_compute_wmatrix_element (const unsigned short * significant_cells, int W, int K, const std::vector <double> & window_widths, double threshold_eta)
 {
-	efficiency.clear();
+	// Efficiencies held as the number of significant cells out of the K of each row: the same ratio as netOnZeroDXC_compute_efficiency
+	int	i;
+	for (i = 0; i < W; i++) {
+		if ((double) significant_cells[i] / (double) K > threshold_eta)
+			return window_widths[i];
+	}
+
+	return -1.0;
+}
+
+int netOnZeroDXC_compute_efficiency (std::vector <double> & efficiency, ArrayView2D <const double> diagram, double threshold_alpha)
+{
+	efficiency.resize(diagram.rows());
+
+	return netOnZeroDXC_compute_efficiency(efficiency.data(), diagram, threshold_alpha);
+}
+
+int netOnZeroDXC_compute_efficiency (double * efficiency, ArrayView2D <const double> diagram, double threshold_alpha)
+{
+	// efficiency must hold diagram.rows() values, e.g. a row of an Array2D
+	int	i, j;
+	int	K = diagram.cols();
+	double	eta;
+	for (i = 0; i < diagram.rows(); i++) {
+		const double *	row = diagram[i];
+		eta = 0.0;
+		for (j = 0; j < K; j++) {
+			if (row[j] < threshold_alpha)
+				eta += 1.0;
+		}
+		efficiency[i] = eta / (double) K;
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_compute_efficiency_multithreshold (double * efficiencies, size_t threshold_stride, ArrayView2D <const double> diagram,
+					const std::vector <double> & thresholds, bool inclusive)
+{
+	// Each row is sorted once; the fraction of cells below any threshold then follows from a binary search. Efficiency at the t-th threshold
+	// is written in efficiencies[t * threshold_stride + l], l being the row. NaN cells never pass a threshold, as with the comparisons above.
+	int	l, t;
+	int	K = diagram.cols();
+	int	nr_thresholds = thresholds.size();
+	std::vector <double>	sorted_row(K);
+	for (l = 0; l < diagram.rows(); l++) {
+		std::copy(diagram[l], diagram[l] + K, sorted_row.begin());
+		std::vector <double>::iterator	valid_end = std::remove_if(sorted_row.begin(), sorted_row.end(), netOnZeroDXC_is_nan);
+		std::sort(sorted_row.begin(), valid_end);
+		for (t = 0; t < nr_thresholds; t++) {
+			std::vector <double>::iterator	bound = (inclusive)? std::upper_bound(sorted_row.begin(), valid_end, thresholds[t])
+									: std::lower_bound(sorted_row.begin(), valid_end, thresholds[t]);
+			efficiencies[t * threshold_stride + l] = (double) (bound - sorted_row.begin()) / (double) K;
+		}
+	}
+
+	return 0;
+}
 
-	int	i, j, n;
+int netOnZeroDXC_compute_efficiency_counts (std::vector <double> & efficiency, ArrayView2D <const unsigned short> exceedance_counts, int M, double threshold_alpha)
+{
+	// From the exceedance counts of a p-value diagram out of M surrogates, each p value being counts / M as in netOnZeroDXC_convert_counts_to_pdiagram
+	int	i, j;
+	int	K = exceedance_counts.cols();
 	double	eta;
-	for (i = 0; i < diagram.size(); i++) {
+	efficiency.resize(exceedance_counts.rows());
+	for (i = 0; i < exceedance_counts.rows(); i++) {
+		const unsigned short *	row = exceedance_counts[i];
 		eta = 0.0;
-		n = 0;
-		for (j = 0; j < diagram[i].size(); j++) {
-			if (diagram[i][j] < threshold_alpha)
+		for (j = 0; j < K; j++) {
+			if (row[j] / (double) M < threshold_alpha)
 				eta += 1.0;
-			n++;
 		}
-		efficiency.push_back(eta / (double) n);
+		efficiency[i] = eta / (double) K;
 	}
 
 	return 0;
 }
 
-int netOnZeroDXC_compute_cdiagram (std::vector < std::vector <double> > & correlation_diagram, const std::vector < std::vector <double> > & sequences,
+int netOnZeroDXC_count_significant_multithreshold (unsigned short * significant_cells, size_t threshold_stride, ArrayView2D <const double> diagram,
+					const std::vector <double> & thresholds)
+{
+	// As netOnZeroDXC_compute_efficiency_multithreshold (not inclusive), keeping the number of cells below each threshold instead of their fraction
+	int	l, t;
+	int	K = diagram.cols();
+	int	nr_thresholds = thresholds.size();
+	std::vector <double>	sorted_row(K);
+	for (l = 0; l < diagram.rows(); l++) {
+		std::copy(diagram[l], diagram[l] + K, sorted_row.begin());
+		std::vector <double>::iterator	valid_end = std::remove_if(sorted_row.begin(), sorted_row.end(), netOnZeroDXC_is_nan);
+		std::sort(sorted_row.begin(), valid_end);
+		for (t = 0; t < nr_thresholds; t++)
+			significant_cells[t * threshold_stride + l] = std::lower_bound(sorted_row.begin(), valid_end, thresholds[t]) - sorted_row.begin();
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_count_significant_multithreshold (unsigned short * significant_cells, size_t threshold_stride, ArrayView2D <const unsigned short> exceedance_counts,
+					int M, const std::vector <double> & thresholds)
+{
+	// Counts are at most M: a histogram of each row replaces the sort. Cell c is below threshold t if counts / M < t, as in netOnZeroDXC_compute_efficiency_counts.
+	int	l, t, c;
+	int	K = exceedance_counts.cols();
+	int	nr_thresholds = thresholds.size();
+	std::vector <int>	histogram(M + 1);
+	for (l = 0; l < exceedance_counts.rows(); l++) {
+		std::fill(histogram.begin(), histogram.end(), 0);
+		for (c = 0; c < K; c++)
+			histogram[exceedance_counts[l][c]]++;
+		int	count = 0, below = 0;
+		for (t = 0; t < nr_thresholds; t++) {			// Thresholds are increasing
+			while ((count <= M) && (count / (double) M < thresholds[t])) {
+				below += histogram[count];
+				count++;
+			}
+			significant_cells[t * threshold_stride + l] = below;
+		}
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_compute_cdiagram (ArrayView2D <double> correlation_diagram, const std::vector < std::vector <double> > & sequences,
 				int node_a, int node_b, int w_base, int W, bool apply_shift, int shift)
 {
+	CumulativeSumsXC	sums;
+
+	netOnZeroDXC_initialize_cumulative_sums(sums, sequences[node_a], sequences[node_b], (apply_shift)? shift : 0);
+
+	return netOnZeroDXC_compute_cdiagram_cumulative(correlation_diagram, sums, w_base, W, apply_shift, shift);
+}
+
+int netOnZeroDXC_compute_cdiagram_cumulative (ArrayView2D <double> correlation_diagram, const CumulativeSumsXC & sums,
+				int w_base, int W, bool apply_shift, int shift)
+{
+	int	N = sums.sum_a.size() - 1;
 	int	l, j, k, ws;
 	double	temp;
 	if (apply_shift) {
 		for (l = 0; l < W; l++) {
 			j = 0;
 			ws = (l + 1) * w_base;
-			for (k = W * w_base / 2 - 1; k < sequences[node_a].size() - W * w_base / 2 - shift; k = k + w_base) {
-				temp = 0.5 * netOnZeroDXC_compute_crosscorr(sequences, node_a, node_b, k + shift - ws/2 + 1, k + shift + ws/2, k - ws/2 + 1, k + ws/2);
-				temp += 0.5 * netOnZeroDXC_compute_crosscorr(sequences, node_a, node_b, k - ws/2 + 1, k + ws/2, k + shift - ws/2 + 1, k + shift + ws/2);
+			for (k = W * w_base / 2 - 1; k < N - W * w_base / 2 - shift; k = k + w_base) {
+				temp = 0.5 * netOnZeroDXC_compute_crosscorr_cumulative(sums, k + shift - ws/2 + 1, k + shift + ws/2, k - ws/2 + 1, k + ws/2);
+				temp += 0.5 * netOnZeroDXC_compute_crosscorr_cumulative(sums, k - ws/2 + 1, k + ws/2, k + shift - ws/2 + 1, k + shift + ws/2);
 				correlation_diagram[l][j] = temp;
 				j++;
 			}
@@ -106,8 +232,8 @@ int netOnZeroDXC_compute_cdiagram (std::vector < std::vector <double> > & correl
 		for (l = 0; l < W; l++) {
 			j = 0;
 			ws = (l + 1) * w_base;
-			for (k = W * w_base / 2 - 1; k < sequences[node_a].size() - W * w_base / 2; k = k + w_base) {
-				correlation_diagram[l][j] = netOnZeroDXC_compute_crosscorr(sequences, node_a, node_b, k - ws/2 + 1, k + ws/2, k - ws/2 + 1, k + ws/2);
+			for (k = W * w_base / 2 - 1; k < N - W * w_base / 2; k = k + w_base) {
+				correlation_diagram[l][j] = netOnZeroDXC_compute_crosscorr_cumulative(sums, k - ws/2 + 1, k + ws/2, k - ws/2 + 1, k + ws/2);
 				j++;
 			}
 		}
@@ -116,23 +242,184 @@ int netOnZeroDXC_compute_cdiagram (std::vector < std::vector <double> > & correl
 	return 0;
 }
 
-int netOnZeroDXC_update_pdiagram (std::vector < std::vector <double> > & pvalue_diagram, const std::vector < std::vector <double> > & cdiagram_data,
-				const std::vector < std::vector <double> > & cdiagram_surr, int W, int M)
+int netOnZeroDXC_initialize_cumulative_sums (CumulativeSumsXC & sums, const std::vector <double> & sequence_a, const std::vector <double> & sequence_b, int shift)
+{
+	int	N = sequence_a.size();
+	int	i;
+
+	// Sequences are centered on their global means, so that window sums stay small and differences of cumulative sums do not lose precision
+	double	mean_a = 0, mean_b = 0;
+	for (i = 0; i < N; i++) {
+		mean_a += sequence_a[i];
+		mean_b += sequence_b[i];
+	}
+	mean_a /= (double) N;
+	mean_b /= (double) N;
+
+	sums.mean_a = mean_a;
+	sums.mean_b = mean_b;
+	sums.sum_a.assign(N + 1, 0.0);
+	sums.sum_aa.assign(N + 1, 0.0);
+	sums.sum_b.assign(N + 1, 0.0);
+	sums.sum_bb.assign(N + 1, 0.0);
+	sums.sum_ab.assign(N + 1, 0.0);
+	double	xa, xb;
+	for (i = 0; i < N; i++) {
+		xa = sequence_a[i] - mean_a;
+		xb = sequence_b[i] - mean_b;
+		sums.sum_a[i + 1] = sums.sum_a[i] + xa;
+		sums.sum_aa[i + 1] = sums.sum_aa[i] + xa * xa;
+		sums.sum_b[i + 1] = sums.sum_b[i] + xb;
+		sums.sum_bb[i + 1] = sums.sum_bb[i] + xb * xb;
+		sums.sum_ab[i + 1] = sums.sum_ab[i] + xa * xb;
+	}
+
+	return netOnZeroDXC_update_cumulative_shift(sums, sequence_a, sequence_b, shift);
+}
+
+int netOnZeroDXC_update_cumulative_shift (CumulativeSumsXC & sums, const std::vector <double> & sequence_a, const std::vector <double> & sequence_b, int shift)
 {
-	int	K = pvalue_diagram[0].size();
+	// Only the delayed products depend on the shift: the sums of the same sequences can be moved to another delay without computing the others again
+	int	N = sequence_a.size();
+	int	i;
+
+	sums.shift = shift;
+	sums.sum_ab_forward.clear();
+	sums.sum_ab_backward.clear();
+	if ((shift > 0) && (shift < N)) {
+		sums.sum_ab_forward.assign(N - shift + 1, 0.0);
+		sums.sum_ab_backward.assign(N - shift + 1, 0.0);
+		for (i = 0; i < N - shift; i++) {
+			sums.sum_ab_forward[i + 1] = sums.sum_ab_forward[i] + (sequence_a[i + shift] - sums.mean_a) * (sequence_b[i] - sums.mean_b);
+			sums.sum_ab_backward[i + 1] = sums.sum_ab_backward[i] + (sequence_a[i] - sums.mean_a) * (sequence_b[i + shift] - sums.mean_b);
+		}
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_update_exceedance_counts (ArrayView2D <int> exceedance_counts, ArrayView2D <const double> cdiagram_data,
+				ArrayView2D <const double> cdiagram_surr, int W)
+{
+	int	K = exceedance_counts.cols();
 	int	l, k;
 	for (l = 0; l < W; l++) {
-		k = 0;
 		for (k = 0; k < K; k++) {
-			if (cdiagram_data[l][k] < cdiagram_surr[l][k]) {
-				pvalue_diagram[l][k] += 1.0 / (double) M;
-			}
+			if (cdiagram_data[l][k] < cdiagram_surr[l][k])
+				exceedance_counts[l][k]++;
 		}
 	}
 
 	return 0;
 }
 
+int netOnZeroDXC_count_surrogate_exceedances (ArrayView2D <int> exceedance_counts, ArrayView2D <const double> cdiagram_data,
+				const std::vector < std::vector <double> > & bank_a, const std::vector < std::vector <double> > & bank_b, int m_start, int m_end,
+				ArrayView2D <double> cdiagram_surr, CumulativeSumsXC & sums_surr, int w_base, int W, bool apply_shift, int shift)
+{
+	// Adds the exceedances of surrogates m_start ... m_end - 1 of a pair; cdiagram_surr and sums_surr are scratch space of the calling thread
+	int	m;
+	for (m = m_start; m < m_end; m++) {
+		netOnZeroDXC_initialize_cumulative_sums(sums_surr, bank_a[m], bank_b[m], (apply_shift)? shift : 0);
+		netOnZeroDXC_count_cumulative_exceedances(exceedance_counts, cdiagram_data, sums_surr, cdiagram_surr, w_base, W, apply_shift, shift);
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_count_cumulative_exceedances (ArrayView2D <int> exceedance_counts, ArrayView2D <const double> cdiagram_data, const CumulativeSumsXC & sums_surr,
+				ArrayView2D <double> cdiagram_surr, int w_base, int W, bool apply_shift, int shift)
+{
+	// Adds the exceedances of one surrogate whose cumulative sums are ready, e.g. moved to a new delay by netOnZeroDXC_update_cumulative_shift
+	netOnZeroDXC_compute_cdiagram_cumulative(cdiagram_surr, sums_surr, w_base, W, apply_shift, shift);
+	netOnZeroDXC_update_exceedance_counts(exceedance_counts, cdiagram_data, cdiagram_surr, W);
+
+	return 0;
+}
+
+int netOnZeroDXC_merge_exceedance_counts (ArrayView2D <int> exceedance_counts, ArrayView2D <const int> partial_counts, int W)
+{
+	int	K = exceedance_counts.cols();
+	int	l, k;
+	for (l = 0; l < W; l++) {
+		for (k = 0; k < K; k++)
+			exceedance_counts[l][k] += partial_counts[l][k];
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_convert_counts_to_pdiagram (ArrayView2D <double> pvalue_diagram, ArrayView2D <const int> exceedance_counts, int W, int M)
+{
+	int	K = exceedance_counts.cols();
+	int	l, k;
+	for (l = 0; l < W; l++) {
+		for (k = 0; k < K; k++)
+			pvalue_diagram[l][k] = exceedance_counts[l][k] / (double) M;
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_convert_compact_counts_to_pdiagram (ArrayView2D <double> pvalue_diagram, ArrayView2D <const unsigned short> exceedance_counts, int W, int M)
+{
+	int	K = exceedance_counts.cols();
+	int	l, k;
+	for (l = 0; l < W; l++) {
+		for (k = 0; k < K; k++)
+			pvalue_diagram[l][k] = exceedance_counts[l][k] / (double) M;
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_initialize_stop_rule (SequentialStopRule & rule, int M, int step, double alpha, double error_rate)
+{
+	// Checks are made after every 'step' surrogates. Under p = alpha the number of exceedances after m surrogates is binomial(m, alpha):
+	// a cell is settled as significant if a count as low as its own has probability <= error_rate, and as not significant if a count
+	// as high as its own has probability <= error_rate. The error rate holds for each single check of a cell.
+	rule.step = 0;
+	rule.max_count_significant.clear();
+	rule.min_count_not_significant.clear();
+	if ((step <= 0) || (M < step) || (error_rate <= 0.0) || (alpha < 0.0) || (alpha >= 1.0))
+		return 1;
+	rule.step = step;
+
+	int	m;
+	int	c_low = -1, c_high = 1;			// Both bounds never decrease with m: each search starts from the previous check
+	for (m = step; m <= M; m += step) {
+		while ((c_low + 1 < m) && (gsl_cdf_binomial_P(c_low + 1, alpha, m) <= error_rate))
+			c_low++;
+		rule.max_count_significant.push_back(c_low);
+
+		while ((c_high <= m) && (gsl_cdf_binomial_Q(c_high - 1, alpha, m) > error_rate))
+			c_high++;
+		rule.min_count_not_significant.push_back(c_high);
+	}
+
+	return 0;
+}
+
+bool netOnZeroDXC_check_counts_settled (const SequentialStopRule & rule, ArrayView2D <const int> exceedance_counts, int W, int m)
+{
+	// True if, after m surrogates, the decision p < alpha is settled in every cell. Always false if m is not a multiple of the step of the rule.
+	if ((rule.step <= 0) || (m <= 0) || (m % rule.step) || ((m / rule.step) > rule.max_count_significant.size()))
+		return false;
+
+	int	bound_low = rule.max_count_significant[m / rule.step - 1];
+	int	bound_high = rule.min_count_not_significant[m / rule.step - 1];
+	int	K = exceedance_counts.cols();
+	int	l, k;
+	for (l = 0; l < W; l++) {
+		for (k = 0; k < K; k++) {
+			if ((exceedance_counts[l][k] > bound_low) && (exceedance_counts[l][k] < bound_high))
+				return false;
+		}
+	}
+
+	return true;
+}
+
 int netOnZeroDXC_initialize_surrogate_generation (std::vector <double> & values_distribution, std::vector <double> & fft_amplitudes,
 						const std::vector < std::vector <double> > & sequences, int index)
 {
@@ -172,79 +459,358 @@ int netOnZeroDXC_initialize_surrogate_generation (std::vector <double> & values_
 
 int netOnZeroDXC_generate_surrogate_sequence (std::vector <double> & surrogate_sequence, const std::vector < std::vector <double> > & sequences, int index,
 					const std::vector <double> & values_distribution, const std::vector <double> & fft_amplitudes, double tolerance,
-					unsigned int random_engine_seed)
+					const SurrogateStream & stream)
 {
+	SurrogateGenerator	generator;
+
+	netOnZeroDXC_allocate_surrogate_generator(generator, sequences[index].size());
+	netOnZeroDXC_generate_surrogate_sequence(surrogate_sequence, generator, sequences[index], values_distribution, fft_amplitudes, tolerance, stream);
+	netOnZeroDXC_free_surrogate_generator(generator);
 
-	int	N		= sequences[index].size();
-	double	*data		= new double[N];
-	double	*data_prev_iter = new double[N];
+	return 0;
+}
+
+int netOnZeroDXC_generate_surrogate_sequence (std::vector <double> & surrogate_sequence, SurrogateGenerator & generator, const std::vector <double> & sequence,
+					const std::vector <double> & values_distribution, const std::vector <double> & fft_amplitudes, double tolerance,
+					const SurrogateStream & stream)
+{
+	int	N		= generator.N;
+	double	*data		= generator.data;
+	double	*data_prev_iter = generator.data_prev_iter;
 
-	std::vector <double>	original_sequence(N,0);
 	int	i;
-	for (i = 0; i < N; i++) {
-		data[i] = sequences[index][i];
-		original_sequence[i] = sequences[index][i];
-	}
+	for (i = 0; i < N; i++)
+		data[i] = sequence[i];
 
 	// Scramble randomly the original sequence
-	int	r = 0;
-	gsl_rng *random_generator = gsl_rng_alloc(gsl_rng_mt19937);
-	gsl_rng_set(random_generator, random_engine_seed);
-	for (i = 0; i < N; i++) {
-		r = gsl_rng_uniform_int(random_generator, original_sequence.size());
-		data[i] = original_sequence[r];
-		original_sequence.erase(original_sequence.begin() + r);
-	}
+	netOnZeroDXC_shuffle_sequence(data, N, stream);
 
 	// Iteratively refine
-	gsl_fft_real_wavetable		*wavetable_real		= gsl_fft_real_wavetable_alloc(N);
-	gsl_fft_halfcomplex_wavetable	*wavetable_halfcomplex	= gsl_fft_halfcomplex_wavetable_alloc(N);
-	gsl_fft_real_workspace		*workspace		= gsl_fft_real_workspace_alloc(N);
-	while(r < 1000) {
-		r++;
-		gsl_fft_real_transform(data, 1, N, wavetable_real, workspace);
+	int	iteration = 0;
+	generator.rank_buffer.clear();
+	while(iteration < 1000) {
+		iteration++;
+		netOnZeroDXC_generator_forward_fft(generator);
 		netOnZeroDXC_restore_fft_amplitude(data, fft_amplitudes, N);
-		gsl_fft_halfcomplex_inverse(data, 1, N, wavetable_halfcomplex, workspace);
-		netOnZeroDXC_rescale_sequence(data, values_distribution, N);
-		if (netOnZeroDXC_check_iteration_convergence(data, data_prev_iter, N, tolerance))
+		netOnZeroDXC_generator_inverse_fft(generator);
+		netOnZeroDXC_rescale_sequence_ranked(data, values_distribution, generator.rank_buffer, N);
+		if ((iteration > 1) && netOnZeroDXC_check_iteration_convergence(data, data_prev_iter, N, tolerance))
 			break;
 		memcpy(data_prev_iter, data, N * sizeof(double));
 	}
+	generator.iterations = iteration;
 
-	surrogate_sequence.clear();
-	for (i = 0; i < N; i++)
-		surrogate_sequence.push_back(data[i]);
+	surrogate_sequence.assign(data, data + N);
 
+	return 0;
+}
 
-	delete[] data;
-	delete[] data_prev_iter;
+int netOnZeroDXC_allocate_surrogate_generator (SurrogateGenerator & generator, int N)
+{
+	generator.N = N;
+	generator.iterations = 0;
+	generator.data = new double[N];
+	generator.data_prev_iter = new double[N];
+	generator.rank_buffer.reserve(N);
+
+#ifdef NETONZERODXC_USE_FFTW
+	generator.fftw_real = fftw_alloc_real(N);
+	generator.fftw_spectrum = fftw_alloc_complex(N/2 + 1);
+	#pragma omp critical (netOnZeroDXC_fftw_planner)
+	{
+		generator.plan_forward = fftw_plan_dft_r2c_1d(N, generator.fftw_real, generator.fftw_spectrum, FFTW_ESTIMATE);
+		generator.plan_backward = fftw_plan_dft_c2r_1d(N, generator.fftw_spectrum, generator.fftw_real, FFTW_ESTIMATE);
+	}
+#else
+	generator.wavetable_real = gsl_fft_real_wavetable_alloc(N);
+	generator.wavetable_halfcomplex = gsl_fft_halfcomplex_wavetable_alloc(N);
+	generator.workspace = gsl_fft_real_workspace_alloc(N);
+#endif
+
+	return 0;
+}
+
+void netOnZeroDXC_free_surrogate_generator (SurrogateGenerator & generator)
+{
+#ifdef NETONZERODXC_USE_FFTW
+	#pragma omp critical (netOnZeroDXC_fftw_planner)
+	{
+		fftw_destroy_plan(generator.plan_forward);
+		fftw_destroy_plan(generator.plan_backward);
+	}
+	fftw_free(generator.fftw_real);
+	fftw_free(generator.fftw_spectrum);
+#else
+	gsl_fft_halfcomplex_wavetable_free(generator.wavetable_halfcomplex);
+	gsl_fft_real_wavetable_free(generator.wavetable_real);
+	gsl_fft_real_workspace_free(generator.workspace);
+#endif
+
+	delete[] generator.data;
+	delete[] generator.data_prev_iter;
+	generator.rank_buffer.clear();
+	generator.N = 0;
+
+	return;
+}
+
+int netOnZeroDXC_generator_forward_fft (SurrogateGenerator & generator)
+{
+	// Transform generator.data in place; output follows the GSL halfcomplex layout in both implementations
+	int	N = generator.N;
+#ifdef NETONZERODXC_USE_FFTW
+	memcpy(generator.fftw_real, generator.data, N * sizeof(double));
+	fftw_execute(generator.plan_forward);
+	int	k;
+	generator.data[0] = generator.fftw_spectrum[0][0];
+	for (k = 1; 2*k < N; k++) {
+		generator.data[2*k - 1] = generator.fftw_spectrum[k][0];
+		generator.data[2*k] = generator.fftw_spectrum[k][1];
+	}
+	if (N%2 == 0)
+		generator.data[N - 1] = generator.fftw_spectrum[N/2][0];
+#else
+	gsl_fft_real_transform(generator.data, 1, N, generator.wavetable_real, generator.workspace);
+#endif
+
+	return 0;
+}
 
-	gsl_fft_halfcomplex_wavetable_free(wavetable_halfcomplex);
-	gsl_fft_real_wavetable_free (wavetable_real);
-	gsl_fft_real_workspace_free (workspace);
-	gsl_rng_free(random_generator);
+int netOnZeroDXC_generator_inverse_fft (SurrogateGenerator & generator)
+{
+	int	N = generator.N;
+#ifdef NETONZERODXC_USE_FFTW
+	int	k;
+	generator.fftw_spectrum[0][0] = generator.data[0];
+	generator.fftw_spectrum[0][1] = 0.0;
+	for (k = 1; 2*k < N; k++) {
+		generator.fftw_spectrum[k][0] = generator.data[2*k - 1];
+		generator.fftw_spectrum[k][1] = generator.data[2*k];
+	}
+	if (N%2 == 0) {
+		generator.fftw_spectrum[N/2][0] = generator.data[N - 1];
+		generator.fftw_spectrum[N/2][1] = 0.0;
+	}
+	fftw_execute(generator.plan_backward);		// FFTW does not normalize the backward transform
+	for (k = 0; k < N; k++)
+		generator.data[k] = generator.fftw_real[k] / (double) N;
+#else
+	gsl_fft_halfcomplex_inverse(generator.data, 1, N, generator.wavetable_halfcomplex, generator.workspace);
+#endif
 
 	return 0;
 }
 
+int netOnZeroDXC_generate_surrogate_bank (std::vector < std::vector <double> > & surrogate_bank, const std::vector < std::vector <double> > & sequences, int index,
+					int M, int m_first, double tolerance, unsigned int base_seed, int number_threads)
+{
+	// Surrogates m_first to m_first + M - 1 of the stream of node index, into surrogate_bank[0] to surrogate_bank[M - 1]
+	std::vector <double>	values_distribution;
+	std::vector <double>	fft_amplitudes;
+
+	netOnZeroDXC_initialize_surrogate_generation(values_distribution, fft_amplitudes, sequences, index);
+
+	surrogate_bank.clear();
+	surrogate_bank.resize(M);
+	if (number_threads > 1) {
+		#pragma omp parallel num_threads(number_threads)
+		{
+			SurrogateGenerator	generator;
+			netOnZeroDXC_allocate_surrogate_generator(generator, sequences[index].size());
+			#pragma omp for schedule(dynamic)
+			for (int m = 0; m < M; m++)
+				netOnZeroDXC_generate_surrogate_sequence(surrogate_bank[m], generator, sequences[index], values_distribution, fft_amplitudes, tolerance, netOnZeroDXC_surrogate_stream(base_seed, index, m_first + m));
+			netOnZeroDXC_free_surrogate_generator(generator);
+		}
+	} else {
+		SurrogateGenerator	generator;
+		netOnZeroDXC_allocate_surrogate_generator(generator, sequences[index].size());
+		int	m;
+		for (m = 0; m < M; m++)
+			netOnZeroDXC_generate_surrogate_sequence(surrogate_bank[m], generator, sequences[index], values_distribution, fft_amplitudes, tolerance, netOnZeroDXC_surrogate_stream(base_seed, index, m_first + m));
+		netOnZeroDXC_free_surrogate_generator(generator);
+	}
+
+	return 0;
+}
+
+size_t netOnZeroDXC_available_memory ()
+{
+	// Physical memory that can be given to a run without swapping, in bytes; 0 if it cannot be found
+#ifdef _WIN32
+	MEMORYSTATUSEX	status;
+	status.dwLength = sizeof(status);
+	if (GlobalMemoryStatusEx(&status))
+		return (size_t) status.ullAvailPhys;
+#else
+	std::ifstream	meminfo("/proc/meminfo");		// Linux: free memory plus the page cache that can be reclaimed
+	std::string	key;
+	size_t		value;
+	while (meminfo >> key >> value) {
+		if (key == "MemAvailable:")
+			return value * 1024;
+		meminfo.ignore(256, '\n');
+	}
+	#ifdef _SC_AVPHYS_PAGES
+	long	pages = sysconf(_SC_AVPHYS_PAGES);
+	long	page_size = sysconf(_SC_PAGESIZE);
+	if ((pages > 0) && (page_size > 0))
+		return (size_t) pages * page_size;
+	#endif
+#endif
+
+	return 0;
+}
+
+int netOnZeroDXC_surrogate_block_size (int nr_nodes, int N, int M, size_t pair_bytes, size_t memory_limit)
+{
+	// Surrogates per node that can be kept at once within memory_limit bytes (0: BANK_MEMORY_FRACTION of the available memory), between 1 and M.
+	// If the whole bank does not fit, surrogates are used in blocks and the counts of every pair, pair_bytes in all, are kept from one block to
+	// the next: they are taken from the limit, and blocks are a multiple of SEQUENTIAL_STOP_STEP whenever possible.
+	if (memory_limit == 0) {
+		size_t	available = netOnZeroDXC_available_memory();
+		memory_limit = (available > 0)? (size_t) (BANK_MEMORY_FRACTION * available) : BANK_MEMORY_FALLBACK;
+	}
+	size_t	surrogate_bytes = (size_t) nr_nodes * ((size_t) N * sizeof(double) + sizeof(std::vector <double>));
+	if ((surrogate_bytes == 0) || ((size_t) M * surrogate_bytes <= memory_limit))
+		return M;
+
+	size_t	block = (memory_limit > pair_bytes)? (memory_limit - pair_bytes) / surrogate_bytes : 0;
+	if (block >= SEQUENTIAL_STOP_STEP)
+		block -= block % SEQUENTIAL_STOP_STEP;
+	if (block < 1)
+		block = 1;
+
+	return (block < M)? (int) block : M;
+}
+
+void netOnZeroDXC_release_surrogates (std::vector < std::vector <double> > & surrogate_bank, int m_first, int m_last)
+{
+	// Frees the surrogates of one node outside m_first to m_last - 1, so that a bank only holds the block in use
+	int	m;
+	for (m = 0; m < surrogate_bank.size(); m++) {
+		if ((m < m_first) || (m >= m_last))
+			std::vector <double> ().swap(surrogate_bank[m]);
+	}
+
+	return;
+}
+
+SurrogateStream netOnZeroDXC_surrogate_stream (unsigned int base_seed, int index, int surrogate)
+{
+	// The m-th surrogate of a node draws from the Philox stream keyed by (base seed, node), at counters (draw, m): every surrogate can be
+	// generated on its own, by any thread, process or device, and no two of them share draws, whatever the number of nodes and surrogates
+	SurrogateStream	stream;
+	stream.key[0] = base_seed;
+	stream.key[1] = (unsigned int) index;
+	stream.surrogate = (unsigned int) surrogate;
+
+	return stream;
+}
+
+void netOnZeroDXC_philox4x32 (unsigned int * output, const unsigned int * counter, const unsigned int * key)
+{
+	// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC 2011): four output words for four counter words
+	unsigned int		c[4] = {counter[0], counter[1], counter[2], counter[3]};
+	unsigned int		k[2] = {key[0], key[1]};
+	unsigned long long	product_0, product_1;
+	int	round;
+	for (round = 0; round < 10; round++) {
+		if (round > 0) {
+			k[0] += 0x9E3779B9U;
+			k[1] += 0xBB67AE85U;
+		}
+		product_0 = 0xD2511F53ULL * c[0];
+		product_1 = 0xCD9E8D57ULL * c[2];
+		c[0] = (unsigned int) (product_1 >> 32) ^ c[1] ^ k[0];
+		c[2] = (unsigned int) (product_0 >> 32) ^ c[3] ^ k[1];
+		c[1] = (unsigned int) product_1;
+		c[3] = (unsigned int) product_0;
+	}
+	output[0] = c[0];
+	output[1] = c[1];
+	output[2] = c[2];
+	output[3] = c[3];
+}
+
+int netOnZeroDXC_stream_uniform_int (const SurrogateStream & stream, unsigned int draw, int n)
+{
+	// Integer in [0, n), from 53 bits of the draw-th block of the stream
+	unsigned int	counter[4] = {draw, stream.surrogate, 0, 0};
+	unsigned int	output[4];
+	netOnZeroDXC_philox4x32(output, counter, stream.key);
+	unsigned long long	bits = (((unsigned long long) output[0] << 32) | output[1]) >> 11;
+	int	r = (int) (ldexp((double) bits, -53) * n);
+
+	return (r < n)? r : n - 1;
+}
+
+void netOnZeroDXC_shuffle_sequence (double * data, int N, const SurrogateStream & stream)
+{
+	// Fisher-Yates shuffle, in place: the swap of position i uses draw i of the stream
+	int	i, r;
+	double	temp;
+	for (i = N - 1; i > 0; i--) {
+		r = netOnZeroDXC_stream_uniform_int(stream, (unsigned int) i, i + 1);
+		temp = data[i];
+		data[i] = data[r];
+		data[r] = temp;
+	}
+}
 
 
 int netOnZeroDXC_restore_fft_amplitude (double * data, const std::vector <double> & fft_amplitudes, int N)
 {
-	int	i;
-	double	phase;
-	for (i = 0; i < N; i++) {
-		if (i == 0) {
-			data[i] = fft_amplitudes[i/2];			// Zero freq. is real (FT symmetry)
-		} else if ((i < N-1) || (N%2 != 0)) {
-			phase = atan2(data[i+1], data[i]);
-			data[i] = fft_amplitudes[i/2 + 1] * cos(phase);
-			data[i+1] = fft_amplitudes[i/2 + 1] * sin(phase);
-			i++;
+	// Each complex bin z is scaled by amplitude/|z|, which keeps its phase; bins with z = 0 get phase 0, as atan2(0, 0) would.
+	const double	*amplitude = fft_amplitudes.data();
+	int	nr_bins = (N - 1) / 2;			// Complex bins k = 1 ... nr_bins, stored as (data[2k-1], data[2k])
+	int	k = 1;
+	double	re, im, magnitude;
+
+	data[0] = amplitude[0];				// Zero freq. is real (FT symmetry)
+#if defined(__AVX2__)
+	const __m256d	zero = _mm256_setzero_pd();
+	const __m256d	real_mask = _mm256_set_pd(0.0, 1.0, 0.0, 1.0);
+	__m256d		z, z2, m2, amp, scale, zero_bins;
+	for (; k + 1 <= nr_bins; k += 2) {
+		z = _mm256_loadu_pd(data + 2*k - 1);				// re_k, im_k, re_k+1, im_k+1
+		z2 = _mm256_mul_pd(z, z);
+		m2 = _mm256_add_pd(z2, _mm256_permute_pd(z2, 0x5));		// |z|^2 on both elements of each bin
+		amp = _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(amplitude + k)), 0x50);
+		scale = _mm256_div_pd(amp, _mm256_sqrt_pd(m2));
+		zero_bins = _mm256_cmp_pd(m2, zero, _CMP_EQ_OQ);
+		z = _mm256_blendv_pd(_mm256_mul_pd(z, scale), _mm256_mul_pd(amp, real_mask), zero_bins);
+		_mm256_storeu_pd(data + 2*k - 1, z);
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	float64x2x2_t	z;
+	float64x2_t	m2, amp, scale;
+	uint64x2_t	zero_bins;
+	for (; k + 1 <= nr_bins; k += 2) {
+		z = vld2q_f64(data + 2*k - 1);					// Deinterleaved: (re_k, re_k+1), (im_k, im_k+1)
+		m2 = vfmaq_f64(vmulq_f64(z.val[0], z.val[0]), z.val[1], z.val[1]);
+		amp = vld1q_f64(amplitude + k);
+		scale = vdivq_f64(amp, vsqrtq_f64(m2));
+		zero_bins = vceqzq_f64(m2);
+		z.val[0] = vbslq_f64(zero_bins, amp, vmulq_f64(z.val[0], scale));
+		z.val[1] = vbslq_f64(zero_bins, vdupq_n_f64(0.0), vmulq_f64(z.val[1], scale));
+		vst2q_f64(data + 2*k - 1, z);
+	}
+#endif
+	for (; k <= nr_bins; k++) {
+		re = data[2*k - 1];
+		im = data[2*k];
+		magnitude = sqrt(re*re + im*im);
+		if (magnitude > 0) {
+			data[2*k - 1] = re * (amplitude[k] / magnitude);
+			data[2*k] = im * (amplitude[k] / magnitude);
 		} else {
-			data[i] = fft_amplitudes[i/2 + 1];		// Also last freq. is real, if N is even (FT symmetry)
+			data[2*k - 1] = amplitude[k];
+			data[2*k] = 0.0;
 		}
 	}
+	if (N%2 == 0)
+		data[N - 1] = amplitude[N/2];		// Also last freq. is real, if N is even (FT symmetry)
 
 	return 0;
 }
@@ -266,11 +832,76 @@ int netOnZeroDXC_rescale_sequence (double * data, const std::vector <double> & v
 	return 0;
 }
 
+int netOnZeroDXC_rescale_sequence_ranked (double * data, const std::vector <double> & values_distribution, std::vector <PairValueId> & rank_buffer, int N)
+{
+	int	i, j;
+	if (rank_buffer.size() != N) {						// First iteration: full sort
+		rank_buffer.resize(N);
+		for (i = 0; i < N; i++) {
+			rank_buffer[i].value = data[i];
+			rank_buffer[i].index = i;
+		}
+		std::sort(rank_buffer.begin(), rank_buffer.end(), netOnZeroDXC_sort_values);
+	} else {
+		// Ranks change little between iterations: sort by insertion starting from the previous order,
+		// falling back to a full sort if too many elements have to be moved
+		for (i = 0; i < N; i++)
+			rank_buffer[i].value = data[rank_buffer[i].index];
+
+		long	moves = 0;
+		long	max_moves = 8 * (long) N;
+		PairValueId	temp;
+		for (i = 1; (i < N) && (moves <= max_moves); i++) {
+			temp = rank_buffer[i];
+			for (j = i - 1; (j >= 0) && (rank_buffer[j].value > temp.value); j--) {
+				rank_buffer[j + 1] = rank_buffer[j];
+				moves++;
+			}
+			rank_buffer[j + 1] = temp;
+		}
+		if (moves > max_moves)
+			std::sort(rank_buffer.begin(), rank_buffer.end(), netOnZeroDXC_sort_values);
+	}
+
+	for (i = 0; i < N; i++)
+		data[rank_buffer[i].index] = values_distribution[i];
+
+	return 0;
+}
+
 bool netOnZeroDXC_check_iteration_convergence (double * data, double * data_prev_iter, int N, double tolerance)
 {
-	int	i;
+	int	i = 0;
 	double	z = 0, I = 0;		// Compare the sum of squared differences (i.e. approximately N*std.dev.) with the signal energy
-	for (i = 0; i < N; i++) {
+#if defined(__AVX2__)
+	__m256d	sum_z = _mm256_setzero_pd();
+	__m256d	sum_I = _mm256_setzero_pd();
+	__m256d	x, d;
+	for (; i + 4 <= N; i += 4) {
+		x = _mm256_loadu_pd(data + i);
+		d = _mm256_sub_pd(x, _mm256_loadu_pd(data_prev_iter + i));
+		sum_z = _mm256_add_pd(sum_z, _mm256_mul_pd(d, d));
+		sum_I = _mm256_add_pd(sum_I, _mm256_mul_pd(x, x));
+	}
+	double	partial[4];
+	_mm256_storeu_pd(partial, sum_z);
+	z = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+	_mm256_storeu_pd(partial, sum_I);
+	I = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	float64x2_t	sum_z = vdupq_n_f64(0.0);
+	float64x2_t	sum_I = vdupq_n_f64(0.0);
+	float64x2_t	x, d;
+	for (; i + 2 <= N; i += 2) {
+		x = vld1q_f64(data + i);
+		d = vsubq_f64(x, vld1q_f64(data_prev_iter + i));
+		sum_z = vfmaq_f64(sum_z, d, d);
+		sum_I = vfmaq_f64(sum_I, x, x);
+	}
+	z = vaddvq_f64(sum_z);
+	I = vaddvq_f64(sum_I);
+#endif
+	for (; i < N; i++) {
 		z += (data[i] - data_prev_iter[i])*(data[i] - data_prev_iter[i]);
 		I += data[i] * data[i];
 	}
@@ -331,14 +962,60 @@ double netOnZeroDXC_compute_crosscorr (const std::vector < std::vector <double>
 	return scalar_product;
 }
 
-void netOnZeroDXC_initialize_temp_diagram(std::vector < std::vector <double> > & diagram, int size_x, int size_y)
+double netOnZeroDXC_compute_crosscorr_cumulative (const CumulativeSumsXC & sums, int start_a, int end_a, int start_b, int end_b)
 {
-	std::vector <double>	temp_row(size_x, 0);
+	// Windows must have the same length, and be either aligned or displaced by +/- sums.shift
+	double	n = (double) (end_a - start_a + 1);
+
+	double	s_a = sums.sum_a[end_a + 1] - sums.sum_a[start_a];
+	double	s_aa = sums.sum_aa[end_a + 1] - sums.sum_aa[start_a];
+	double	s_b = sums.sum_b[end_b + 1] - sums.sum_b[start_b];
+	double	s_bb = sums.sum_bb[end_b + 1] - sums.sum_bb[start_b];
+
+	double	s_ab;
+	if (start_a == start_b) {
+		s_ab = sums.sum_ab[end_a + 1] - sums.sum_ab[start_a];
+	} else if (start_a > start_b) {
+		s_ab = sums.sum_ab_forward[end_b + 1] - sums.sum_ab_forward[start_b];
+	} else {
+		s_ab = sums.sum_ab_backward[end_a + 1] - sums.sum_ab_backward[start_a];
+	}
 
-	diagram.clear();
-	int	i;
-	for (i = 0; i < size_y; i++)
-		diagram.push_back(temp_row);
+	double	norm_a = s_aa - s_a * s_a / n;
+	double	norm_b = s_bb - s_b * s_b / n;
+	double	scalar_product = s_ab - s_a * s_b / n;
+
+	scalar_product /= sqrt(norm_a);
+	scalar_product /= sqrt(norm_b);
+
+	return scalar_product;
+}
+
+void netOnZeroDXC_initialize_temp_diagram(Array2D <double> & diagram, int size_x, int size_y)
+{
+	diagram.resize(size_y, size_x, 0.0);
+
+	return;
+}
+
+void netOnZeroDXC_compact_diagram (ArrayView2D <float> compact, ArrayView2D <const double> diagram)
+{
+	// Compact storage: correlations rounded to float, counts (at most COMPACT_COUNT_MAX) as they are. Sizes must match.
+	std::copy(diagram.data(), diagram.data() + diagram.count(), compact.data());
+
+	return;
+}
+
+void netOnZeroDXC_compact_diagram (ArrayView2D <unsigned short> compact, ArrayView2D <const int> exceedance_counts)
+{
+	std::copy(exceedance_counts.data(), exceedance_counts.data() + exceedance_counts.count(), compact.data());
+
+	return;
+}
+
+void netOnZeroDXC_expand_diagram (ArrayView2D <double> diagram, ArrayView2D <const float> compact)
+{
+	std::copy(compact.data(), compact.data() + compact.count(), diagram.data());
 
 	return;
 }
@@ -28,18 +28,117 @@
 //
 // --------------------------------------------------------------------------
 
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
+
+#include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+#include <gsl/gsl_cdf.h>
+#ifdef NETONZERODXC_USE_FFTW
+	#include <fftw3.h>
+#endif
+
 #define TOLERANCE_SURROGATES 1e-6
+#define SEQUENTIAL_STOP_STEP 16		// Surrogates between two checks of the adaptive stopping rule
+#define COMPACT_COUNT_MAX 65535		// Largest count held by compact storage: surrogates of a p value, cells of an efficiency
+#define BANK_MEMORY_FRACTION 0.5	// Of the available memory, for the surrogates kept at once when no limit is given
+#define BANK_MEMORY_FALLBACK 1073741824	// Bytes, when the available memory cannot be found
+
+struct PairValueId {
+	int index;
+	double value;
+};
+
+struct SurrogateStream {			// Counter-based random stream of one surrogate, see netOnZeroDXC_surrogate_stream
+	unsigned int	key[2];			// Philox key: global seed and node
+	unsigned int	surrogate;		// Second counter word; the first one is the index of the draw
+};
+
+struct SurrogateGenerator {			// FFT plans and buffers for sequences of length N, to be reused by one thread across surrogates
+	int			N;
+	int			iterations;		// IAAFT iterations of the last surrogate, until convergence or the limit
+	double			*data;
+	double			*data_prev_iter;
+	std::vector <PairValueId>	rank_buffer;		// Samples sorted by value at the previous iteration
+#ifdef NETONZERODXC_USE_FFTW
+	double			*fftw_real;
+	fftw_complex		*fftw_spectrum;
+	fftw_plan		plan_forward;
+	fftw_plan		plan_backward;
+#else
+	gsl_fft_real_wavetable		*wavetable_real;
+	gsl_fft_halfcomplex_wavetable	*wavetable_halfcomplex;
+	gsl_fft_real_workspace		*workspace;
+#endif
+};
+
+struct SequentialStopRule {			// Exceedance counts at which the decision p < alpha is settled, one entry per check
+	int			step;
+	std::vector <int>	max_count_significant;		// count <= bound: p < alpha
+	std::vector <int>	min_count_not_significant;	// count >= bound: p >= alpha
+};
+
+struct CumulativeSumsXC {
+	int			shift;
+	double			mean_a;			// Global means the sums are centered on
+	double			mean_b;
+	std::vector <double>	sum_a;
+	std::vector <double>	sum_aa;
+	std::vector <double>	sum_b;
+	std::vector <double>	sum_bb;
+	std::vector <double>	sum_ab;
+	std::vector <double>	sum_ab_forward;		// a(t + shift) * b(t)
+	std::vector <double>	sum_ab_backward;	// a(t) * b(t + shift)
+};
 
 double netOnZeroDXC_compute_wmatrix_element (const std::vector <double> &, const std::vector <double> &, double);
-int netOnZeroDXC_compute_efficiency (std::vector <double> &, const std::vector < std::vector <double> > &, double);
-int netOnZeroDXC_compute_cdiagram (std::vector < std::vector <double> > &, const std::vector < std::vector <double> > &, int, int, int, int, bool, int);
+double netOnZeroDXC_compute_wmatrix_element (const double *, int, const std::vector <double> &, double);
+double netOnZeroDXC_compute_wmatrix_element (const unsigned short *, int, int, const std::vector <double> &, double);
+int netOnZeroDXC_compute_efficiency (std::vector <double> &, ArrayView2D <const double>, double);
+int netOnZeroDXC_compute_efficiency (double *, ArrayView2D <const double>, double);
+int netOnZeroDXC_compute_efficiency_multithreshold (double *, size_t, ArrayView2D <const double>, const std::vector <double> &, bool);
+int netOnZeroDXC_compute_efficiency_counts (std::vector <double> &, ArrayView2D <const unsigned short>, int, double);
+int netOnZeroDXC_count_significant_multithreshold (unsigned short *, size_t, ArrayView2D <const double>, const std::vector <double> &);
+int netOnZeroDXC_count_significant_multithreshold (unsigned short *, size_t, ArrayView2D <const unsigned short>, int, const std::vector <double> &);
+int netOnZeroDXC_compute_cdiagram (ArrayView2D <double>, const std::vector < std::vector <double> > &, int, int, int, int, bool, int);
+int netOnZeroDXC_compute_cdiagram_cumulative (ArrayView2D <double>, const CumulativeSumsXC &, int, int, bool, int);
+int netOnZeroDXC_initialize_cumulative_sums (CumulativeSumsXC &, const std::vector <double> &, const std::vector <double> &, int);
+int netOnZeroDXC_update_cumulative_shift (CumulativeSumsXC &, const std::vector <double> &, const std::vector <double> &, int);
 
 double netOnZeroDXC_compute_crosscorr (const std::vector < std::vector <double> > &, int, int, int, int, int, int);
-int netOnZeroDXC_update_pdiagram (std::vector < std::vector <double> > &, const std::vector < std::vector <double> > &, const std::vector < std::vector <double> > &, int, int);
-void netOnZeroDXC_initialize_temp_diagram (std::vector < std::vector <double> > &, int, int);
+double netOnZeroDXC_compute_crosscorr_cumulative (const CumulativeSumsXC &, int, int, int, int);
+int netOnZeroDXC_update_exceedance_counts (ArrayView2D <int>, ArrayView2D <const double>, ArrayView2D <const double>, int);
+int netOnZeroDXC_count_surrogate_exceedances (ArrayView2D <int>, ArrayView2D <const double>, const std::vector < std::vector <double> > &, const std::vector < std::vector <double> > &,
+				int, int, ArrayView2D <double>, CumulativeSumsXC &, int, int, bool, int);
+int netOnZeroDXC_count_cumulative_exceedances (ArrayView2D <int>, ArrayView2D <const double>, const CumulativeSumsXC &, ArrayView2D <double>, int, int, bool, int);
+int netOnZeroDXC_merge_exceedance_counts (ArrayView2D <int>, ArrayView2D <const int>, int);
+int netOnZeroDXC_convert_counts_to_pdiagram (ArrayView2D <double>, ArrayView2D <const int>, int, int);
+int netOnZeroDXC_convert_compact_counts_to_pdiagram (ArrayView2D <double>, ArrayView2D <const unsigned short>, int, int);
+int netOnZeroDXC_initialize_stop_rule (SequentialStopRule &, int, int, double, double);
+bool netOnZeroDXC_check_counts_settled (const SequentialStopRule &, ArrayView2D <const int>, int, int);
+void netOnZeroDXC_initialize_temp_diagram (Array2D <double> &, int, int);
+void netOnZeroDXC_compact_diagram (ArrayView2D <float>, ArrayView2D <const double>);
+void netOnZeroDXC_compact_diagram (ArrayView2D <unsigned short>, ArrayView2D <const int>);
+void netOnZeroDXC_expand_diagram (ArrayView2D <double>, ArrayView2D <const float>);
 
-int netOnZeroDXC_generate_surrogate_sequence (std::vector <double> &, const std::vector < std::vector <double> > &, int, const std::vector <double> &, const std::vector <double> &, double, unsigned int);
+int netOnZeroDXC_generate_surrogate_sequence (std::vector <double> &, const std::vector < std::vector <double> > &, int, const std::vector <double> &, const std::vector <double> &, double, const SurrogateStream &);
+int netOnZeroDXC_generate_surrogate_sequence (std::vector <double> &, SurrogateGenerator &, const std::vector <double> &, const std::vector <double> &, const std::vector <double> &, double, const SurrogateStream &);
+int netOnZeroDXC_allocate_surrogate_generator (SurrogateGenerator &, int);
+void netOnZeroDXC_free_surrogate_generator (SurrogateGenerator &);
+int netOnZeroDXC_generator_forward_fft (SurrogateGenerator &);
+int netOnZeroDXC_generator_inverse_fft (SurrogateGenerator &);
 int netOnZeroDXC_initialize_surrogate_generation (std::vector <double> &, std::vector <double> &, const std::vector < std::vector <double> > &, int);
+int netOnZeroDXC_generate_surrogate_bank (std::vector < std::vector <double> > &, const std::vector < std::vector <double> > &, int, int, int, double, unsigned int, int);
+size_t netOnZeroDXC_available_memory ();
+int netOnZeroDXC_surrogate_block_size (int, int, int, size_t, size_t);
+void netOnZeroDXC_release_surrogates (std::vector < std::vector <double> > &, int, int);
+SurrogateStream netOnZeroDXC_surrogate_stream (unsigned int, int, int);
+void netOnZeroDXC_philox4x32 (unsigned int *, const unsigned int *, const unsigned int *);
+int netOnZeroDXC_stream_uniform_int (const SurrogateStream &, unsigned int, int);
+void netOnZeroDXC_shuffle_sequence (double *, int, const SurrogateStream &);
 int netOnZeroDXC_restore_fft_amplitude (double *, const std::vector <double> &, int);
 int netOnZeroDXC_rescale_sequence (double *, const std::vector <double> &, int);
+int netOnZeroDXC_rescale_sequence_ranked (double *, const std::vector <double> &, std::vector <PairValueId> &, int);
 bool netOnZeroDXC_check_iteration_convergence (double *, double *, int, double);
@@ -28,6 +28,7 @@
 //
 // --------------------------------------------------------------------------
 
+#include <cstdio>
 #include <cstdlib>
 #include <cmath>
 #include <ctime>
@@ -47,109 +48,885 @@
 	#include "netOnZeroDXC_algorithm.hpp"
 	#define INCLUDED_ALGORITHM
 #endif
+#ifndef INCLUDED_IOFUNCTIONS
+	#include "netOnZeroDXC_io.hpp"
+	#define INCLUDED_IOFUNCTIONS
+#endif
+#ifndef INCLUDED_ALGORITHM_GUI
+	#include "netOnZeroDXC_analysis_gui_algorithm.hpp"
+	#define INCLUDED_ALGORITHM_GUI
+#endif
 
 
-int netOnZeroDXC_compute_pdiagram (std::vector < std::vector <double> > & pvalue_diagram, WorkerThread* owner_thread, ContainerWorkspace* workspace,
-				double & progress, int index_a, int index_b, int index_diagram, int M, int w_base, int W, bool apply_shift,
-				int shift, int number_threads)
+int netOnZeroDXC_compute_surrogate_bank (WorkerThread* owner_thread, ContainerWorkspace* workspace, int M, int m_first, int m_last,
+				const std::vector <char> & pairs_needed, bool report_progress, int number_threads)
 {
-	std::vector <double>	distribution_values_a, distribution_values_b;
-	std::vector <double>	fft_amplitudes_a, fft_amplitudes_b;
+	// Surrogates m_first to m_last - 1 of every node, into surrogate_bank[node][m] (M slots per node); those of a previous block are freed first,
+	// so that the bank holds (m_last - m_first) surrogates per node at most. All (node, surrogate) pairs are independent tasks, dynamically
+	// scheduled over threads: there is no barrier between nodes. Only nodes of the pairs marked in pairs_needed get surrogates; if it is empty,
+	// all nodes do, except, when resuming from a checkpoint, those whose pairs are all completed.
+	// Without report_progress, cancellation is still polled, but progress is left to the caller, e.g. for the steps of adaptive stopping.
+	RunTiming &	timing = workspace->run_timing;
+	double		start_time = omp_get_wtime();
+	int	nr_nodes = workspace->sequences.size();
+	int	N = workspace->sequences[0].size();
+	std::vector < std::vector <double> >	values_distribution(nr_nodes);
+	std::vector < std::vector <double> >	fft_amplitudes(nr_nodes);
+	std::vector <char>			node_needed(nr_nodes, 1);
 
-	netOnZeroDXC_initialize_surrogate_generation(distribution_values_a, fft_amplitudes_a, workspace->sequences, index_a);
-	netOnZeroDXC_initialize_surrogate_generation(distribution_values_b, fft_amplitudes_b, workspace->sequences, index_b);
-	std::vector <double>	temp_vector(workspace->diagrams_correlation[index_diagram][0].size(), 0.0);
+	int	i;
+	if (!pairs_needed.empty() || (workspace->checkpoint_files.journal != NULL)) {
+		std::vector <int>	pair_node_a, pair_node_b;
+		netOnZeroDXC_list_pair_nodes(pair_node_a, pair_node_b, nr_nodes);
+		node_needed.assign(nr_nodes, 0);
+		for (i = 0; i < pair_node_a.size(); i++) {
+			if ((pairs_needed.empty())? (workspace->checkpoint_state.status[i] != CHECKPOINT_PAIR_DONE) : pairs_needed[i]) {
+				node_needed[pair_node_a[i]] = 1;
+				node_needed[pair_node_b[i]] = 1;
+			}
+		}
+	}
+
+	int	nr_range = m_last - m_first;
+	long	nr_tasks = (long) nr_nodes * nr_range;
+	long	tasks_done = 0;
+	workspace->surrogate_bank.resize(nr_nodes);
+	for (i = 0; i < nr_nodes; i++) {
+		netOnZeroDXC_release_surrogates(workspace->surrogate_bank[i], 0, 0);
+		if (!node_needed[i]) {
+			tasks_done += nr_range;
+			continue;
+		}
+		netOnZeroDXC_initialize_surrogate_generation(values_distribution[i], fft_amplitudes[i], workspace->sequences, i);
+		workspace->surrogate_bank[i].resize(M);
+	}
 
 	bool	go_flag = 1;
 	int	old_progress = -1;
+	long	tasks_skipped = tasks_done;
+	double	section_start_time = omp_get_wtime();
+
+	#pragma omp parallel num_threads((number_threads > 1)? number_threads : 1)
+	{
+		SurrogateGenerator	generator;
+		StageClock		thread_clock;
+		long			thread_surrogates = 0;
+		long			thread_iterations = 0;
+		int			thread_max_iterations = 0;
+		netOnZeroDXC_allocate_surrogate_generator(generator, N);
+		netOnZeroDXC_start_clock(thread_clock);
+
+		#pragma omp for schedule(dynamic)
+		for (long t = 0; t < nr_tasks; t++) {
+			bool	go_on;
+			#pragma omp atomic read
+			go_on = go_flag;
+			int	node = t / nr_range;
+			int	m = m_first + t % nr_range;
+			if (!go_on || !node_needed[node])
+				continue;
+
+			netOnZeroDXC_generate_surrogate_sequence(workspace->surrogate_bank[node][m], generator, workspace->sequences[node], values_distribution[node], fft_amplitudes[node],
+								TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(workspace->parameter_random_seed, node, m));
+			thread_surrogates++;
+			thread_iterations += generator.iterations;
+			if (generator.iterations > thread_max_iterations)
+				thread_max_iterations = generator.iterations;
+			#pragma omp atomic
+			tasks_done++;
+
+			if (omp_get_thread_num() == 0) {		// The master thread is the worker thread itself: it polls for cancellation and reports progress
+				long	done;
+				#pragma omp atomic read
+				done = tasks_done;
+				if (owner_thread->TestDestroy() || owner_thread->parent_frame->workCancelled()) {
+					#pragma omp atomic write
+					go_flag = 0;
+				}
+				if (report_progress)
+					netOnZeroDXC_post_task_progress(owner_thread, done, nr_tasks, old_progress, section_start_time, tasks_skipped, "surrogates");
+			}
+		}
+
+		netOnZeroDXC_add_surrogate_iterations(timing, thread_surrogates, thread_iterations, thread_max_iterations);
+		netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+		netOnZeroDXC_lap_clock(timing, TIMING_STAGE_SURROGATES, thread_clock, thread_surrogates);
+		netOnZeroDXC_free_surrogate_generator(generator);
+	}
+	netOnZeroDXC_add_parallel_section(timing, number_threads, omp_get_wtime() - section_start_time);
+
+	if (!go_flag) {
+		workspace->surrogate_bank.clear();
+		return 1;
+	}
+	netOnZeroDXC_add_stage_elapsed(timing, TIMING_STAGE_SURROGATES, omp_get_wtime() - start_time, 0);
+
+	return 0;
+}
+
+int netOnZeroDXC_compute_all_pdiagrams (WorkerThread* owner_thread, ContainerWorkspace* workspace, int M, int w_base, int W, bool apply_shift,
+				int shift, int number_threads)
+{
+	// The surrogates of all nodes are generated first, then tasks are (pair, chunk of surrogates); each task counts exceedances locally and adds
+	// them atomically to the integer counts of the pair. p values are obtained only at the end, as counts / M.
+	// If a checkpoint is open, counts are added under a lock instead, so that the chunks counted so far can be saved along with them.
+	// With compact storage, each task computes the correlation diagram of its pair again in double precision, and the counts are kept.
+	// Returns 1 if cancelled, 2 if the checkpoint could not be read or written.
+	RunTiming &	timing = workspace->run_timing;
+	double		start_time = omp_get_wtime();
+	bool	compact = !workspace->diagrams_correlation_compact.empty();
+	int	nr_pairs = (compact)? workspace->diagrams_correlation_compact.size() : workspace->diagrams_correlation.size();
+	int	nr_nodes = workspace->node_labels.size();
+	int	K = (compact)? workspace->diagrams_correlation_compact.cols() : workspace->diagrams_correlation.cols();
+
+	SequentialStopRule	stop_rule;
+	workspace->surrogates_used.clear();
+	if (!netOnZeroDXC_initialize_stop_rule(stop_rule, M, SEQUENTIAL_STOP_STEP, workspace->parameter_thr_significance, workspace->parameter_adaptive_error))
+		return netOnZeroDXC_compute_adaptive_pdiagrams(owner_thread, workspace, stop_rule, M, w_base, W, apply_shift, shift, number_threads);
+
+	wxThreadEvent eventStartBank(wxEVT_THREAD, EVENT_WORKER_UPDATE);	// Surrogates of each node are generated only once, and shared by all pairs
+	eventStartBank.SetInt(-251);
+	wxQueueEvent(owner_thread->parent_frame, eventStartBank.Clone());
+	if (netOnZeroDXC_compute_surrogate_bank(owner_thread, workspace, M, 0, M, std::vector <char> (), true, number_threads))
+		return 1;
+	wxThreadEvent eventStartPath1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+	eventStartPath1.SetInt(-254);
+	wxQueueEvent(owner_thread->parent_frame, eventStartPath1.Clone());
+	start_time = omp_get_wtime();
+
+	std::vector <int>	pair_node_a, pair_node_b;
 	int	i;
-	unsigned int	seed;
-	double	progress_step;
+	netOnZeroDXC_list_pair_nodes(pair_node_a, pair_node_b, nr_nodes);
 
-	if (number_threads > 1) {
-		omp_set_num_threads(number_threads);
+	Array3D <int>	exceedance_counts(nr_pairs, W, K, 0);
 
-		progress_step = 100.0 * number_threads / ((double) M);
+	int	chunks_per_pair = (M + SURROGATE_CHUNK_SIZE - 1) / SURROGATE_CHUNK_SIZE;
+	long	nr_tasks = (long) nr_pairs * chunks_per_pair;
+	long	tasks_done = 0;
+	bool	go_flag = 1;
+	bool	write_error = 0;
+	int	old_progress = -1;
 
-		int	threads_to_run;
-		i = 0;
-		while (i < M) {
-			if (owner_thread->TestDestroy() || owner_thread->parent_frame->workCancelled()) {
-				go_flag = 0;
-				break;
+	bool			checkpoint = (workspace->checkpoint_files.journal != NULL);
+	CheckpointFiles &	checkpoint_files = workspace->checkpoint_files;
+	std::vector <char>	chunks_done;
+	std::vector <int>	surrogates_done;
+	std::vector <char>	pair_finished;
+	std::vector <int>	chunks_left;
+	std::vector <PairProgress>	stored_progress;
+	if (checkpoint) {
+		chunks_done.assign(nr_tasks, 0);
+		surrogates_done.assign(nr_pairs, 0);
+		pair_finished.assign(nr_pairs, 0);
+		chunks_left.assign(nr_pairs, chunks_per_pair);
+		if (netOnZeroDXC_restore_stored_progress(workspace, exceedance_counts, chunks_done, surrogates_done, pair_finished, false))
+			return 2;
+		for (long t = 0; t < nr_tasks; t++) {
+			if (chunks_done[t]) {
+				chunks_left[t / chunks_per_pair]--;
+				tasks_done++;
 			}
+		}
+	}
+	long	tasks_restored = tasks_done;
+
+	#pragma omp parallel num_threads((number_threads > 1)? number_threads : 1)
+	{
+		Array2D <double>	surrogate_cdiagram(W, K, 0.0);
+		Array2D <double>	pair_cdiagram((compact)? W : 0, K, 0.0);
+		Array2D <int>		local_counts(W, K, 0);
+		CumulativeSumsXC	sums_surrogate;
+		StageClock		thread_clock;
+		netOnZeroDXC_start_clock(thread_clock);
+
+		#pragma omp for schedule(dynamic)
+		for (long t = 0; t < nr_tasks; t++) {
+			bool	go_on;
+			#pragma omp atomic read
+			go_on = go_flag;
+			if (!go_on || (checkpoint && chunks_done[t]))
+				continue;
+
+			int	k = t / chunks_per_pair;
+			int	m_start = (t % chunks_per_pair) * SURROGATE_CHUNK_SIZE;
+			int	m_end = ((m_start + SURROGATE_CHUNK_SIZE) < M)? (m_start + SURROGATE_CHUNK_SIZE) : M;
+			const std::vector < std::vector <double> > &	bank_a = workspace->surrogate_bank[pair_node_a[k]];
+			const std::vector < std::vector <double> > &	bank_b = workspace->surrogate_bank[pair_node_b[k]];
+			ArrayView2D <int>				pair_counts = exceedance_counts[k];
+			if (compact)
+				netOnZeroDXC_compute_cdiagram(pair_cdiagram, workspace->sequences, pair_node_a[k], pair_node_b[k], w_base, W, apply_shift, shift);
+			ArrayView2D <const double>			cdiagram_data = (compact)? ArrayView2D <const double> (pair_cdiagram) : ArrayView2D <const double> (workspace->diagrams_correlation[k]);
+
+			int	l, c;
+			local_counts.fill(0);
+			netOnZeroDXC_count_surrogate_exceedances(local_counts, cdiagram_data, bank_a, bank_b, m_start, m_end, surrogate_cdiagram, sums_surrogate, w_base, W, apply_shift, shift);
 
-			threads_to_run = ((M - i) < number_threads)? (M - i) : number_threads;
-			seed = (unsigned int) clock() + 2*i;
-
-			#pragma omp parallel for firstprivate(seed)
-			for (int j = 0; j < threads_to_run; j++) {
-				std::vector < std::vector <double> >	surrogate_cdiagram(W, temp_vector);
-				std::vector <double>			sequence_surrogate_a;
-				std::vector <double>			sequence_surrogate_b;
-				std::vector < std::vector <double> >	sequences_surrogate;
-
-				seed = seed + 2*j;
-				netOnZeroDXC_generate_surrogate_sequence(sequence_surrogate_a, workspace->sequences, index_a, distribution_values_a, fft_amplitudes_a, TOLERANCE_SURROGATES, seed);
-				seed = seed + 1;
-				netOnZeroDXC_generate_surrogate_sequence(sequence_surrogate_b, workspace->sequences, index_b, distribution_values_b, fft_amplitudes_b, TOLERANCE_SURROGATES, seed);
-				sequences_surrogate.push_back(sequence_surrogate_a);
-				sequences_surrogate.push_back(sequence_surrogate_b);
-				netOnZeroDXC_compute_cdiagram(surrogate_cdiagram, sequences_surrogate, 0, 1, w_base, W, apply_shift, shift);
-				#pragma omp critical
+			if (checkpoint) {
+				int	error = 0;
+				#pragma omp critical (checkpoint)
 				{
-					netOnZeroDXC_update_pdiagram(pvalue_diagram, workspace->diagrams_correlation[index_diagram], surrogate_cdiagram, W, M);
-					i++;
+					netOnZeroDXC_merge_exceedance_counts(pair_counts, local_counts, W);
+					chunks_done[t] = 1;
+					surrogates_done[k] += m_end - m_start;
+					if (--chunks_left[k] == 0) {
+						pair_finished[k] = 1;
+						error = netOnZeroDXC_append_checkpoint_pair(checkpoint_files, k, M, pair_counts);
+					}
+					if (!error && netOnZeroDXC_checkpoint_due(checkpoint_files)) {
+						netOnZeroDXC_collect_stored_progress(stored_progress, exceedance_counts, chunks_done, surrogates_done, pair_finished);
+						error = netOnZeroDXC_save_checkpoint_snapshot(checkpoint_files, workspace->checkpoint_state, stored_progress);
+					}
 				}
+				if (error) {
+					#pragma omp atomic write
+					write_error = 1;
+					#pragma omp atomic write
+					go_flag = 0;
+				}
+			} else {
+				for (l = 0; l < W; l++) {
+					for (c = 0; c < K; c++) {
+						if (local_counts[l][c]) {
+							#pragma omp atomic
+							pair_counts[l][c] += local_counts[l][c];
+						}
+					}
+				}
+			}
+
+			#pragma omp atomic
+			tasks_done++;
+
+			if (omp_get_thread_num() == 0) {
+				long	done;
+				#pragma omp atomic read
+				done = tasks_done;
+				if (owner_thread->TestDestroy() || owner_thread->parent_frame->workCancelled()) {
+					#pragma omp atomic write
+					go_flag = 0;
+				}
+				netOnZeroDXC_post_task_progress(owner_thread, done, nr_tasks, old_progress, start_time, tasks_restored, NULL);
 			}
+		}
+
+		netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+		netOnZeroDXC_lap_clock(timing, TIMING_STAGE_PDIAGRAM, thread_clock, 0);
+	}
+	netOnZeroDXC_add_parallel_section(timing, number_threads, omp_get_wtime() - start_time);
+
+	if (checkpoint && !go_flag && !write_error) {		// Cancelled: keep the chunks counted so far
+		netOnZeroDXC_collect_stored_progress(stored_progress, exceedance_counts, chunks_done, surrogates_done, pair_finished);
+		netOnZeroDXC_save_checkpoint_snapshot(checkpoint_files, workspace->checkpoint_state, stored_progress);
+	}
+
+	if (write_error)
+		return 2;
+	if (!go_flag) {
+		return 1;
+	}
+
+	if (compact) {
+		workspace->diagrams_counts.resize(nr_pairs, W, K, 0);
+		for (i = 0; i < nr_pairs; i++)
+			netOnZeroDXC_compact_diagram(workspace->diagrams_counts[i], exceedance_counts[i]);
+	} else {
+		workspace->diagrams_pvalue.resize(nr_pairs, W, K, 0.0);
+		for (i = 0; i < nr_pairs; i++)
+			netOnZeroDXC_convert_counts_to_pdiagram(workspace->diagrams_pvalue[i], exceedance_counts[i], W, M);
+	}
+	netOnZeroDXC_add_stage_elapsed(timing, TIMING_STAGE_PDIAGRAM, omp_get_wtime() - start_time, nr_pairs);
+
+	return 0;
+}
+
+int netOnZeroDXC_compute_adaptive_pdiagrams (WorkerThread* owner_thread, ContainerWorkspace* workspace, const SequentialStopRule & stop_rule, int M, int w_base, int W,
+				bool apply_shift, int shift, int number_threads)
+{
+	// Rounds of (pair, step of the stopping rule) tasks over the pairs whose decision is not settled yet; each round gives every such pair
+	// enough steps to keep all threads busy, and first generates the surrogates of those steps, only for the nodes of these pairs. Counts of
+	// each step are kept apart and added in order at the end of the round, so that a pair stops after the same number of surrogates whatever
+	// the number of threads. p values are counts / (surrogates used by the pair).
+	// If a checkpoint is open, pairs are added to its journal as they stop, and the active ones are saved after a round when due.
+	// With compact storage, correlation diagrams are computed again in double precision as in netOnZeroDXC_compute_all_pdiagrams.
+	// Returns 1 if cancelled, 2 if the checkpoint could not be read or written.
+	RunTiming &	timing = workspace->run_timing;
+	double		start_time = omp_get_wtime();
+	bool	compact = !workspace->diagrams_correlation_compact.empty();
+	int	nr_pairs = (compact)? workspace->diagrams_correlation_compact.size() : workspace->diagrams_correlation.size();
+	int	nr_nodes = workspace->node_labels.size();
+	int	K = (compact)? workspace->diagrams_correlation_compact.cols() : workspace->diagrams_correlation.cols();
+	int	step = stop_rule.step;
+	int	nr_threads = (number_threads > 1)? number_threads : 1;
+
+	std::vector <int>	pair_node_a, pair_node_b;
+	std::vector <int>	active_pairs, still_active;
+	std::vector <int>	surrogates_done(nr_pairs, 0);
+	int	i, s;
+	netOnZeroDXC_list_pair_nodes(pair_node_a, pair_node_b, nr_nodes);
+
+	Array3D <int>	exceedance_counts(nr_pairs, W, K, 0);
+	Array3D <int>	step_counts;
+
+	bool			checkpoint = (workspace->checkpoint_files.journal != NULL);
+	int			chunks_per_pair = (M + SURROGATE_CHUNK_SIZE - 1) / SURROGATE_CHUNK_SIZE;
+	std::vector <char>	chunks_done;
+	std::vector <char>	pair_finished(nr_pairs, 0);
+	std::vector <PairProgress>	stored_progress;
+	if (checkpoint) {
+		chunks_done.assign((size_t) nr_pairs * chunks_per_pair, 0);
+		if (netOnZeroDXC_restore_stored_progress(workspace, exceedance_counts, chunks_done, surrogates_done, pair_finished, true))
+			return 2;
+	}
+	long	progress_restored = 0;
+	for (i = 0; i < nr_pairs; i++) {
+		if (!pair_finished[i])
+			active_pairs.push_back(i);
+		progress_restored += (pair_finished[i])? M : surrogates_done[i];
+	}
+
+	bool	go_flag = 1;
+	bool	write_error = 0;
+	int	old_progress = -1;
+	double	bank_elapsed = 0.0;				// Surrogates have a stage of their own
+	std::vector <char>	round_pairs(nr_pairs, 0);
+
+	wxThreadEvent eventStartPath1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+	eventStartPath1.SetInt(-254);
+	wxQueueEvent(owner_thread->parent_frame, eventStartPath1.Clone());
+	while (active_pairs.size()) {
+		int	nr_active = active_pairs.size();
+		int	steps_per_pair = (nr_threads + nr_active - 1) / nr_active;
+		long	nr_tasks = (long) nr_active * steps_per_pair;
+		int	round_first = M;
+		int	round_last = 0;
+		round_pairs.assign(nr_pairs, 0);
+		for (i = 0; i < nr_active; i++) {
+			int	k = active_pairs[i];
+			round_pairs[k] = 1;
+			if (surrogates_done[k] < round_first)
+				round_first = surrogates_done[k];
+			if (surrogates_done[k] + steps_per_pair * step > round_last)
+				round_last = surrogates_done[k] + steps_per_pair * step;
+		}
+		double	bank_start_time = omp_get_wtime();
+		if (netOnZeroDXC_compute_surrogate_bank(owner_thread, workspace, M, round_first, (round_last < M)? round_last : M, round_pairs, false, number_threads)) {
+			go_flag = 0;
+			break;
+		}
+		bank_elapsed += omp_get_wtime() - bank_start_time;
+
+		step_counts.resize(nr_tasks, W, K, 0);
+		double	section_start_time = omp_get_wtime();
+
+		#pragma omp parallel num_threads(nr_threads)
+		{
+			Array2D <double>	surrogate_cdiagram(W, K, 0.0);
+			Array2D <double>	pair_cdiagram((compact)? W : 0, K, 0.0);
+			CumulativeSumsXC	sums_surrogate;
+			StageClock		thread_clock;
+			netOnZeroDXC_start_clock(thread_clock);
+
+			#pragma omp for schedule(dynamic)
+			for (long t = 0; t < nr_tasks; t++) {
+				bool	go_on;
+				#pragma omp atomic read
+				go_on = go_flag;
+				if (!go_on)
+					continue;
+
+				int	k = active_pairs[t / steps_per_pair];
+				int	m_start = surrogates_done[k] + (t % steps_per_pair) * step;
+				int	m_end = ((m_start + step) < M)? (m_start + step) : M;
+				const std::vector < std::vector <double> > &	bank_a = workspace->surrogate_bank[pair_node_a[k]];
+				const std::vector < std::vector <double> > &	bank_b = workspace->surrogate_bank[pair_node_b[k]];
+				if (compact)
+					netOnZeroDXC_compute_cdiagram(pair_cdiagram, workspace->sequences, pair_node_a[k], pair_node_b[k], w_base, W, apply_shift, shift);
+				ArrayView2D <const double>			cdiagram_data = (compact)? ArrayView2D <const double> (pair_cdiagram) : ArrayView2D <const double> (workspace->diagrams_correlation[k]);
+
+				netOnZeroDXC_count_surrogate_exceedances(step_counts[t], cdiagram_data, bank_a, bank_b, m_start, m_end, surrogate_cdiagram, sums_surrogate,
+									w_base, W, apply_shift, shift);
+
+				if ((omp_get_thread_num() == 0) && (owner_thread->TestDestroy() || owner_thread->parent_frame->workCancelled())) {
+					#pragma omp atomic write
+					go_flag = 0;
+				}
+			}
+
+			netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+			netOnZeroDXC_lap_clock(timing, TIMING_STAGE_PDIAGRAM, thread_clock, 0);
+		}
+		netOnZeroDXC_add_parallel_section(timing, nr_threads, omp_get_wtime() - section_start_time);
+		if (!go_flag)
+			break;
 
-			if (((int) progress) != old_progress) {
-				old_progress = (progress >= 100)? 99 : (int) progress;	// Progress dialog is nasty, values > 100 will make it crash in a bad way.
-				wxThreadEvent eventProgress(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-				eventProgress.SetInt((int) old_progress);
-				wxQueueEvent(owner_thread->parent_frame, eventProgress.Clone());
+		long	progress_done;
+		still_active.clear();
+		for (i = 0; i < nr_active; i++) {
+			int	k = active_pairs[i];
+			bool	settled = false;
+			for (s = 0; (s < steps_per_pair) && (surrogates_done[k] < M) && !settled; s++) {
+				netOnZeroDXC_merge_exceedance_counts(exceedance_counts[k], step_counts[i * steps_per_pair + s], W);
+				surrogates_done[k] = ((surrogates_done[k] + step) < M)? (surrogates_done[k] + step) : M;
+				settled = netOnZeroDXC_check_counts_settled(stop_rule, exceedance_counts[k], W, surrogates_done[k]);
+			}
+			if (!settled && (surrogates_done[k] < M)) {
+				still_active.push_back(k);
+			} else if (checkpoint && !write_error) {
+				pair_finished[k] = 1;
+				write_error = netOnZeroDXC_append_checkpoint_pair(workspace->checkpoint_files, k, surrogates_done[k], exceedance_counts[k]);
 			}
-			progress += progress_step;
+			if (checkpoint)				// Only whole chunks are marked: a resumed pair continues from surrogates_done anyway
+				std::fill(chunks_done.begin() + (size_t) k * chunks_per_pair, chunks_done.begin() + (size_t) k * chunks_per_pair + surrogates_done[k] / SURROGATE_CHUNK_SIZE, 1);
+		}
+		active_pairs.swap(still_active);
+		if (write_error)
+			break;
+		progress_done = (long) (nr_pairs - active_pairs.size()) * M;		// Pairs already settled count as done
+		for (i = 0; i < active_pairs.size(); i++)
+			progress_done += surrogates_done[active_pairs[i]];
+
+		if (owner_thread->TestDestroy() || owner_thread->parent_frame->workCancelled()) {
+			go_flag = 0;
+			break;
+		}
+		if (checkpoint && netOnZeroDXC_checkpoint_due(workspace->checkpoint_files)) {
+			netOnZeroDXC_collect_stored_progress(stored_progress, exceedance_counts, chunks_done, surrogates_done, pair_finished);
+			write_error = netOnZeroDXC_save_checkpoint_snapshot(workspace->checkpoint_files, workspace->checkpoint_state, stored_progress);
+			if (write_error)
+				break;
 		}
+		netOnZeroDXC_post_task_progress(owner_thread, progress_done, (long) nr_pairs * M, old_progress, start_time, progress_restored, NULL);
+	}
+
+	if (checkpoint && !go_flag && !write_error) {		// Cancelled: the counts of the last, interrupted round are lost, those before are kept
+		netOnZeroDXC_collect_stored_progress(stored_progress, exceedance_counts, chunks_done, surrogates_done, pair_finished);
+		netOnZeroDXC_save_checkpoint_snapshot(workspace->checkpoint_files, workspace->checkpoint_state, stored_progress);
+	}
+
+	if (write_error)
+		return 2;
+	if (!go_flag) {
+		return 1;
+	}
+
+	workspace->surrogates_used = surrogates_done;
+	if (compact) {
+		workspace->diagrams_counts.resize(nr_pairs, W, K, 0);
+		for (i = 0; i < nr_pairs; i++)
+			netOnZeroDXC_compact_diagram(workspace->diagrams_counts[i], exceedance_counts[i]);
 	} else {
-		std::vector < std::vector <double> >	surrogate_cdiagram(W, temp_vector);
-		std::vector <double>			sequence_surrogate_a;
-		std::vector <double>			sequence_surrogate_b;
-		std::vector < std::vector <double> >	sequences_surrogate;
-		progress_step = 100.0 / ((double) M);
-
-		for (i = 0; i < M; i++) {
-			if (owner_thread->TestDestroy() || owner_thread->parent_frame->workCancelled()) {
+		workspace->diagrams_pvalue.resize(nr_pairs, W, K, 0.0);
+		for (i = 0; i < nr_pairs; i++)
+			netOnZeroDXC_convert_counts_to_pdiagram(workspace->diagrams_pvalue[i], exceedance_counts[i], W, surrogates_done[i]);
+	}
+	netOnZeroDXC_add_stage_elapsed(timing, TIMING_STAGE_PDIAGRAM, omp_get_wtime() - start_time - bank_elapsed, nr_pairs);
+
+	return 0;
+}
+
+int netOnZeroDXC_compute_streamed_pairs (WorkerThread* owner_thread, ContainerWorkspace* workspace, int M, int w_base, int W, int K, bool apply_shift,
+				int shift, bool compute_pvalues, bool print_cdiagrams, bool print_pdiagrams, double sampling_period, int number_threads)
+{
+	// Each pair is a task: one thread computes its correlation diagram and, if requested, its p-value diagram and efficiencies, writes the
+	// diagrams and keeps only the efficiencies. At most one diagram per kind and per thread is alive at any time.
+	// Surrogates are generated here, all at once if they fit in memory (see netOnZeroDXC_surrogate_block_size); otherwise one block at a time,
+	// and every pair still open goes through each block in turn, with its counts kept in between. Memory is then one block plus the counts of all pairs.
+	// With adaptive stopping, blocks are steps of the stopping rule: each pair stops as soon as its decision at alpha is settled, and the next
+	// step is generated only for the nodes of the pairs still open.
+	// If a checkpoint is open, completed pairs are added to its journal and the pairs in progress are saved periodically; pairs completed
+	// before resuming are not computed again, partial ones continue from their saved counts.
+	// Returns 1 if cancelled, 2 if an output file could not be written.
+	int	nr_nodes = workspace->node_labels.size();
+	int	nr_pairs = nr_nodes * (nr_nodes - 1) / 2;
+	int	N = workspace->sequences[0].size();
+	bool	multiple_alpha = (workspace->parameter_computation_target == 3);
+	bool	compact = workspace->parameter_compact_storage && (K <= COMPACT_COUNT_MAX);	// Multi-threshold efficiencies as counts of significant cells
+	double	alpha = workspace->parameter_thr_significance;
+
+	std::vector <int>	pair_node_a, pair_node_b;
+	std::vector <double>	alpha_thresholds;
+	SequentialStopRule	stop_rule;
+	netOnZeroDXC_list_pair_nodes(pair_node_a, pair_node_b, nr_nodes);
+	netOnZeroDXC_list_alpha_thresholds(alpha_thresholds);
+	netOnZeroDXC_initialize_stop_rule(stop_rule, M, SEQUENTIAL_STOP_STEP, alpha, workspace->parameter_adaptive_error);
+	workspace->surrogates_used.clear();
+	if (compute_pvalues && (stop_rule.step > 0))
+		workspace->surrogates_used.assign(nr_pairs, 0);
+
+	int	l;
+	if (compute_pvalues) {
+		workspace->window_widths.clear();
+		for (l = 0; l < W; l++)
+			workspace->window_widths.push_back((l + 1) * w_base * sampling_period);
+		workspace->efficiencies.assign(nr_pairs, std::vector <double> (W, 0.0));
+		workspace->efficiencies_multialpha.clear();
+		workspace->significant_cells_multialpha.clear();
+		if (multiple_alpha && compact) {
+			workspace->significant_cells_multialpha.resize(NR_THRESHOLD_STEPS, nr_pairs, W, 0);
+			workspace->significant_cells_total = K;
+		} else if (multiple_alpha) {
+			workspace->efficiencies_multialpha.resize(NR_THRESHOLD_STEPS, nr_pairs, W, 0.0);
+		}
+	}
+
+	bool			checkpoint = (workspace->checkpoint_files.journal != NULL);
+	CheckpointFiles &	checkpoint_files = workspace->checkpoint_files;
+	CheckpointState &	resume_state = workspace->checkpoint_state;
+	ResultsWriter *		results_writer = &workspace->results_writer;
+	bool			rewrite_done = results_writer->isOpen();	// A new results container must also hold the pairs completed before resuming
+	int			nr_threads = (number_threads > 1)? number_threads : 1;
+	int			nr_chunks = (M + SURROGATE_CHUNK_SIZE - 1) / SURROGATE_CHUNK_SIZE;
+	std::vector <PairProgress>	thread_progress(nr_threads);
+	if (checkpoint) {
+		for (l = 0; l < nr_threads; l++)
+			netOnZeroDXC_initialize_pair_progress(thread_progress[l], nr_chunks, W, K);
+	}
+
+	// With several blocks, the counts of every pair live in pair_counts from one block to the next; otherwise each thread has a slot of its own
+	size_t	counts_bytes = (size_t) nr_pairs * W * K * sizeof(int) * ((checkpoint)? 2 : 1);		// Snapshots copy the counts of the open pairs
+	int	block = (compute_pvalues)? netOnZeroDXC_surrogate_block_size(nr_nodes, N, M, counts_bytes, 0) : M;
+	bool	step_blocks = compute_pvalues && (stop_rule.step > 0) && (block > stop_rule.step);
+	if (step_blocks)
+		block = stop_rule.step;				// Adaptive stopping: each step of surrogates is generated only for the nodes of the pairs still open
+	int	nr_blocks = (block < M)? (M + block - 1) / block : 1;
+	Array3D <int>		pair_counts((nr_blocks > 1)? nr_pairs : nr_threads, W, K, 0);
+	std::vector <int>	pair_next(nr_pairs, 0);			// First surrogate not counted yet
+	std::vector <char>	pair_open(nr_pairs, 1);			// Still to be completed by this run
+	std::vector <char>	block_pairs(nr_pairs, 0);		// Open pairs that need the surrogates of the current block
+	std::vector <PairProgress>	block_progress;
+
+	long	tasks_done = 0;
+	bool	go_flag = 1;
+	bool	write_error = 0;
+	int	old_progress = -1;
+
+	// Steps of a pair are timed by the thread running it; stages are interleaved, so they have no elapsed time of their own
+	RunTiming &	timing = workspace->run_timing;
+	double		start_time = omp_get_wtime();
+	long		pairs_restored = 0;
+	if (checkpoint) {
+		for (l = 0; l < nr_pairs; l++) {
+			if (resume_state.status[l] == CHECKPOINT_PAIR_DONE)
+				pairs_restored++;
+		}
+	}
+
+	int	c;
+	for (c = 0; (c < nr_blocks) && go_flag && !write_error; c++) {
+		int	block_first = c * block;
+		int	block_last = (block_first + block < M)? block_first + block : M;
+		if (compute_pvalues) {
+			bool	block_needed = false;
+			for (l = 0; l < nr_pairs; l++) {
+				block_pairs[l] = pair_open[l] && (pair_next[l] < block_last) && (!checkpoint || (resume_state.status[l] != CHECKPOINT_PAIR_DONE));
+				block_needed = block_needed || block_pairs[l];
+			}
+			if ((c > 0) && !block_needed)			// Pairs settled, or resumed beyond this block
+				continue;
+			if (!step_blocks) {				// Steps are short: progress is only that of the pairs
+				wxThreadEvent eventStartBank(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventStartBank.SetInt(-251);
+				wxQueueEvent(owner_thread->parent_frame, eventStartBank.Clone());
+			}
+			if (netOnZeroDXC_compute_surrogate_bank(owner_thread, workspace, M, block_first, block_last, block_pairs, !step_blocks, number_threads)) {
 				go_flag = 0;
 				break;
 			}
+			if (!step_blocks || (c == 0)) {
+				wxThreadEvent eventStartPath1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventStartPath1.SetInt(-254);
+				wxQueueEvent(owner_thread->parent_frame, eventStartPath1.Clone());
+			}
+		}
+
+		double	block_start_time = omp_get_wtime();
+		#pragma omp parallel num_threads(nr_threads)
+		{
+			Array2D <double>	cdiagram_data(W, K, 0.0);
+			Array2D <double>	cdiagram_surr(W, K, 0.0);
+			Array2D <double>	pdiagram(W, K, 0.0);
+			CumulativeSumsXC	sums_surrogate;
+			StageClock		thread_clock;
+			StageClock		pair_clock;
+			netOnZeroDXC_start_clock(thread_clock);
+
+			#pragma omp for schedule(dynamic)
+			for (int k = 0; k < nr_pairs; k++) {
+				bool	go_on;
+				#pragma omp atomic read
+				go_on = go_flag;
+				if (!go_on || !pair_open[k] || ((c > 0) && (pair_next[k] >= block_last)))
+					continue;
+
+				int	error = 0;
+				int	status = (checkpoint)? resume_state.status[k] : CHECKPOINT_PAIR_NONE;
+				int	m_start = pair_next[k];
+				ArrayView2D <int>	counts = pair_counts[(nr_blocks > 1)? k : omp_get_thread_num()];
+				netOnZeroDXC_start_clock(pair_clock);
+				if (c == 0)
+					counts.fill(0);
+				if ((c == 0) && (status == CHECKPOINT_PAIR_DONE)) {	// Completed before resuming: its text files exist, only its results are needed
+					#pragma omp critical (checkpoint)
+					{
+						error = netOnZeroDXC_read_checkpoint_pair(checkpoint_files, resume_state, k, counts);
+						m_start = resume_state.surrogates[k];
+					}
+				} else if ((c == 0) && (status == CHECKPOINT_PAIR_PARTIAL)) {
+					#pragma omp critical (checkpoint)
+					{
+						PairProgress &	saved = resume_state.partial[resume_state.partial_index[k]];
+						if (netOnZeroDXC_check_chunks_prefix(saved)) {		// Otherwise its surrogates were split among threads: it starts again
+							std::copy(saved.counts.data(), saved.counts.data() + (size_t) W * K, counts.data());
+							m_start = saved.surrogates;
+						}
+						saved.pair = -1;				// From now on, its progress is saved by this thread
+					}
+					pair_next[k] = m_start;
+				}
+
+				if ((c == 0) && ((status != CHECKPOINT_PAIR_DONE) || (rewrite_done && print_cdiagrams)) && !error && print_cdiagrams) {
+					netOnZeroDXC_compute_cdiagram(cdiagram_data, workspace->sequences, pair_node_a[k], pair_node_b[k], w_base, W, apply_shift, shift);
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_CDIAGRAM, pair_clock, 1);
+					error = netOnZeroDXC_write_diagram(results_writer, cdiagram_data, workspace->path_output_folder, workspace->path_output_prefix, "cdiag", '_',
+									workspace->node_pairs[k].label_a, workspace->node_pairs[k].label_b, '\t');
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_WRITE, pair_clock, 1);
+				} else if ((status != CHECKPOINT_PAIR_DONE) && compute_pvalues && !error && (m_start < block_last)) {
+					netOnZeroDXC_compute_cdiagram(cdiagram_data, workspace->sequences, pair_node_a[k], pair_node_b[k], w_base, W, apply_shift, shift);
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_CDIAGRAM, pair_clock, 1);
+				}
+
+				if (compute_pvalues && !error) {
+					int	m = m_start;
+					if (status != CHECKPOINT_PAIR_DONE) {
+						const std::vector < std::vector <double> > &	bank_a = workspace->surrogate_bank[pair_node_a[k]];
+						const std::vector < std::vector <double> > &	bank_b = workspace->surrogate_bank[pair_node_b[k]];
+						bool	settled = false;
+						for (; (m < block_last) && !settled && !error; m++) {
+							if ((m % SURROGATE_CHUNK_SIZE) == 0) {		// A pair can take long: cancellation is also checked within it
+								if (checkpoint && (nr_blocks == 1) && (m > 0)) {
+									#pragma omp critical (checkpoint)
+									{
+										PairProgress &	slot = thread_progress[omp_get_thread_num()];
+										slot.pair = k;
+										slot.surrogates = m;
+										std::fill(slot.chunks_done.begin(), slot.chunks_done.end(), 0);
+										std::fill(slot.chunks_done.begin(), slot.chunks_done.begin() + m / SURROGATE_CHUNK_SIZE, 1);
+										std::copy(counts.data(), counts.data() + (size_t) W * K, slot.counts.data());
+										if (netOnZeroDXC_checkpoint_due(checkpoint_files))
+											error = netOnZeroDXC_save_checkpoint_snapshot(checkpoint_files, resume_state, thread_progress);
+									}
+									if (error)
+										break;
+								}
+								#pragma omp atomic read
+								go_on = go_flag;
+								if (!go_on)
+									break;
+								if ((omp_get_thread_num() == 0) && (owner_thread->TestDestroy() || owner_thread->parent_frame->workCancelled())) {
+									#pragma omp atomic write
+									go_flag = 0;
+									break;
+								}
+							}
+							netOnZeroDXC_count_surrogate_exceedances(counts, cdiagram_data, bank_a, bank_b, m, m + 1, cdiagram_surr, sums_surrogate, w_base, W,
+												apply_shift, shift);
+							settled = netOnZeroDXC_check_counts_settled(stop_rule, counts, W, m + 1);
+						}
+						pair_next[k] = m;
+						netOnZeroDXC_lap_clock(timing, TIMING_STAGE_PDIAGRAM, pair_clock, (settled || (m == M))? 1 : 0);
+						if ((m < M) && !settled && !error)
+							continue;				// Cancelled, or taken up again in the next block
+					}
+
+					if (!error) {
+						pair_open[k] = 0;
+						if (stop_rule.step > 0)
+							workspace->surrogates_used[k] = m;
+						netOnZeroDXC_convert_counts_to_pdiagram(pdiagram, counts, W, m);
+						if (print_pdiagrams && ((status != CHECKPOINT_PAIR_DONE) || rewrite_done)) {
+							error = netOnZeroDXC_write_diagram(results_writer, pdiagram, workspace->path_output_folder, workspace->path_output_prefix, "pdiag", '_',
+											workspace->node_pairs[k].label_a, workspace->node_pairs[k].label_b, '\t');
+							netOnZeroDXC_lap_clock(timing, TIMING_STAGE_WRITE, pair_clock, 1);
+						}
 
-			seed = (unsigned int) clock();
+						netOnZeroDXC_compute_efficiency(workspace->efficiencies[k].data(), pdiagram, alpha);
+						if (multiple_alpha && compact)
+							netOnZeroDXC_count_significant_multithreshold(workspace->significant_cells_multialpha[0][k], (size_t) nr_pairs * W, pdiagram, alpha_thresholds);
+						else if (multiple_alpha)
+							netOnZeroDXC_compute_efficiency_multithreshold(workspace->efficiencies_multialpha[0][k], (size_t) nr_pairs * W, pdiagram, alpha_thresholds, false);
+						netOnZeroDXC_lap_clock(timing, TIMING_STAGE_EFFICIENCY, pair_clock, 1);
+					}
 
-			sequences_surrogate.clear();
-			netOnZeroDXC_generate_surrogate_sequence(sequence_surrogate_a, workspace->sequences, index_a, distribution_values_a, fft_amplitudes_a, TOLERANCE_SURROGATES, seed);
-			seed = seed + 1;
-			netOnZeroDXC_generate_surrogate_sequence(sequence_surrogate_b, workspace->sequences, index_b, distribution_values_b, fft_amplitudes_b, TOLERANCE_SURROGATES, seed);
-			sequences_surrogate.push_back(sequence_surrogate_a);
-			sequences_surrogate.push_back(sequence_surrogate_b);
+					if (checkpoint && (status != CHECKPOINT_PAIR_DONE) && !error) {	// Only once its files have been written
+						#pragma omp critical (checkpoint)
+						{
+							error = netOnZeroDXC_append_checkpoint_pair(checkpoint_files, k, m, counts);
+							thread_progress[omp_get_thread_num()].pair = -1;
+						}
+					}
+				} else {
+					pair_open[k] = 0;
+				}
+
+				if (error) {
+					#pragma omp atomic write
+					write_error = 1;
+					#pragma omp atomic write
+					go_flag = 0;
+				}
 
-			netOnZeroDXC_compute_cdiagram(surrogate_cdiagram, sequences_surrogate, 0, 1, w_base, W, apply_shift, shift);
-			netOnZeroDXC_update_pdiagram(pvalue_diagram, workspace->diagrams_correlation[index_diagram], surrogate_cdiagram, W, M);
+				#pragma omp atomic
+				tasks_done++;
 
-			if (((int) progress) != old_progress) {
-				old_progress = (progress >= 100)? 99 : (int) progress;
-				wxThreadEvent eventProgress(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-				eventProgress.SetInt((int) old_progress);
-				wxQueueEvent(owner_thread->parent_frame, eventProgress.Clone());
+				if (omp_get_thread_num() == 0) {
+					long	done;
+					#pragma omp atomic read
+					done = tasks_done;
+					if (owner_thread->TestDestroy() || owner_thread->parent_frame->workCancelled()) {
+						#pragma omp atomic write
+						go_flag = 0;
+					}
+					netOnZeroDXC_post_task_progress(owner_thread, done, nr_pairs, old_progress, start_time, pairs_restored, "pairs");
+				}
 			}
-			progress += progress_step;
+
+			netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+		}
+		netOnZeroDXC_add_parallel_section(timing, nr_threads, omp_get_wtime() - block_start_time);
+
+		if (checkpoint && (nr_blocks > 1) && go_flag && !write_error && netOnZeroDXC_checkpoint_due(checkpoint_files)) {	// Pairs left open by this block
+			netOnZeroDXC_collect_open_pairs(block_progress, pair_counts, pair_next, pair_open, 0, nr_chunks, SURROGATE_CHUNK_SIZE);
+			if (netOnZeroDXC_save_checkpoint_snapshot(checkpoint_files, resume_state, block_progress))
+				write_error = 1;
 		}
 	}
+	workspace->surrogate_bank.clear();
 
+	if (checkpoint && !go_flag && !write_error) {			// Cancelled: keep the progress of the pairs left partial
+		if (nr_blocks > 1) {
+			netOnZeroDXC_collect_open_pairs(block_progress, pair_counts, pair_next, pair_open, 0, nr_chunks, SURROGATE_CHUNK_SIZE);
+			netOnZeroDXC_save_checkpoint_snapshot(checkpoint_files, resume_state, block_progress);
+		} else {
+			netOnZeroDXC_save_checkpoint_snapshot(checkpoint_files, resume_state, thread_progress);
+		}
+	}
 
-	if (!go_flag) {
+	if (write_error)
+		return 2;
+	if (!go_flag)
 		return 1;
+
+	return 0;
+}
+
+int netOnZeroDXC_restore_stored_progress (ContainerWorkspace* workspace, Array3D <int> & exceedance_counts, std::vector <char> & chunks_done,
+				std::vector <int> & surrogates_done, std::vector <char> & pair_finished, bool prefix_only)
+{
+	// Counts of the pairs completed before resuming are read back from the journal, those of the partial pairs from the snapshot.
+	// With prefix_only, a partial pair is taken up again only if its counted chunks are the first ones; otherwise it starts from zero.
+	CheckpointState &	state = workspace->checkpoint_state;
+	int	nr_pairs = exceedance_counts.size();
+	int	chunks_per_pair = chunks_done.size() / nr_pairs;
+	int	k;
+	for (k = 0; k < nr_pairs; k++) {
+		std::vector <char>::iterator	pair_chunks = chunks_done.begin() + (size_t) k * chunks_per_pair;
+		if (state.status[k] == CHECKPOINT_PAIR_DONE) {
+			if (netOnZeroDXC_read_checkpoint_pair(workspace->checkpoint_files, state, k, exceedance_counts[k]))
+				return 1;
+			surrogates_done[k] = state.surrogates[k];
+			pair_finished[k] = 1;
+			std::fill(pair_chunks, pair_chunks + chunks_per_pair, 1);
+		} else if (state.status[k] == CHECKPOINT_PAIR_PARTIAL) {
+			PairProgress &	saved = state.partial[state.partial_index[k]];
+			if ((!prefix_only || netOnZeroDXC_check_chunks_prefix(saved)) && (saved.chunks_done.size() == chunks_per_pair)) {
+				std::copy(saved.counts.data(), saved.counts.data() + exceedance_counts[k].count(), exceedance_counts[k].data());
+				std::copy(saved.chunks_done.begin(), saved.chunks_done.end(), pair_chunks);
+				surrogates_done[k] = saved.surrogates;
+			}
+			saved.pair = -1;			// From now on, its progress is saved along with the others
+		}
 	}
 
 	return 0;
 }
+
+void netOnZeroDXC_collect_stored_progress (std::vector <PairProgress> & progress, const Array3D <int> & exceedance_counts, const std::vector <char> & chunks_done,
+				const std::vector <int> & surrogates_done, const std::vector <char> & pair_finished)
+{
+	// Pairs started but not completed, as saved in a snapshot
+	int	nr_pairs = exceedance_counts.size();
+	int	chunks_per_pair = chunks_done.size() / nr_pairs;
+	int	k;
+	progress.clear();
+	for (k = 0; k < nr_pairs; k++) {
+		if (pair_finished[k] || (surrogates_done[k] == 0))
+			continue;
+		PairProgress	current;
+		current.pair = k;
+		current.surrogates = surrogates_done[k];
+		current.chunks_done.assign(chunks_done.begin() + (size_t) k * chunks_per_pair, chunks_done.begin() + (size_t) (k + 1) * chunks_per_pair);
+		current.counts.resize(exceedance_counts.rows(), exceedance_counts.cols(), 0);
+		std::copy(exceedance_counts[k].data(), exceedance_counts[k].data() + exceedance_counts[k].count(), current.counts.data());
+		progress.push_back(current);
+	}
+
+	return;
+}
+
+void netOnZeroDXC_list_pair_nodes (std::vector <int> & pair_node_a, std::vector <int> & pair_node_b, int nr_nodes)
+{
+	// Pairs are enumerated as (0,1), (0,2), ..., (1,2), ..., the same order of node_pairs and of the stored diagrams
+	pair_node_a.clear();
+	pair_node_b.clear();
+	int	i, j;
+	for (i = 0; i < nr_nodes - 1; i++) {
+		for (j = i + 1; j < nr_nodes; j++) {
+			pair_node_a.push_back(i);
+			pair_node_b.push_back(j);
+		}
+	}
+
+	return;
+}
+
+void netOnZeroDXC_list_alpha_thresholds (std::vector <double> & alpha_thresholds)
+{
+	// Significance thresholds of the preview, alpha = 0, 0.001, ..., 0.1
+	int	s;
+	alpha_thresholds.clear();
+	for (s = 0; s < NR_THRESHOLD_STEPS; s++)
+		alpha_thresholds.push_back(((double) s) / 1000.0);
+
+	return;
+}
+
+void netOnZeroDXC_post_task_progress (WorkerThread* owner_thread, long tasks_done, long nr_tasks, int & old_progress, double start_time, long tasks_restored,
+				const char * task_unit)
+{
+	// The time left is extrapolated from the tasks done since start_time, i.e. without those restored from a checkpoint;
+	// if task_unit is not NULL, the rate of tasks is also reported.
+	int	progress = (int) (100 * tasks_done / nr_tasks);
+	if (progress >= 100)
+		progress = 99;			// Progress dialog is nasty, values > 100 will make it crash in a bad way.
+
+	if (progress != old_progress) {
+		old_progress = progress;
+		double	elapsed = omp_get_wtime() - start_time;
+		double	remaining = netOnZeroDXC_estimate_remaining_time(start_time, tasks_done - tasks_restored, nr_tasks - tasks_restored);
+		std::stringstream	report;
+		report << "\nElapsed " << netOnZeroDXC_format_duration(elapsed) << ", about " << netOnZeroDXC_format_duration(remaining) << " left";
+		if (task_unit && (elapsed > 0.0)) {
+			char	rate[64];
+			sprintf(rate, " (%.1f %s/s)", (double) (tasks_done - tasks_restored) / elapsed, task_unit);
+			report << rate;
+		}
+		report << ".";
+
+		wxThreadEvent eventProgress(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+		eventProgress.SetInt(progress);
+		eventProgress.SetString(report.str());
+		wxQueueEvent(owner_thread->parent_frame, eventProgress.Clone());
+	}
+
+	return;
+}
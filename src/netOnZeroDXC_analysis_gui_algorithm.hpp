@@ -28,4 +28,14 @@
 //
 // --------------------------------------------------------------------------
 
-int netOnZeroDXC_compute_pdiagram (std::vector < std::vector <double> > &, WorkerThread*, ContainerWorkspace*, double &, int, int, int, int, int, int, bool, int, int);
+#define SURROGATE_CHUNK_SIZE 16
+
+int netOnZeroDXC_compute_surrogate_bank (WorkerThread*, ContainerWorkspace*, int, int, int, const std::vector <char> &, bool, int);
+int netOnZeroDXC_compute_all_pdiagrams (WorkerThread*, ContainerWorkspace*, int, int, int, bool, int, int);
+int netOnZeroDXC_compute_adaptive_pdiagrams (WorkerThread*, ContainerWorkspace*, const SequentialStopRule &, int, int, int, bool, int, int);
+int netOnZeroDXC_compute_streamed_pairs (WorkerThread*, ContainerWorkspace*, int, int, int, int, bool, int, bool, bool, bool, double, int);
+int netOnZeroDXC_restore_stored_progress (ContainerWorkspace*, Array3D <int> &, std::vector <char> &, std::vector <int> &, std::vector <char> &, bool);
+void netOnZeroDXC_collect_stored_progress (std::vector <PairProgress> &, const Array3D <int> &, const std::vector <char> &, const std::vector <int> &, const std::vector <char> &);
+void netOnZeroDXC_list_pair_nodes (std::vector <int> &, std::vector <int> &, int);
+void netOnZeroDXC_list_alpha_thresholds (std::vector <double> &);
+void netOnZeroDXC_post_task_progress (WorkerThread*, long, long, int &, double, long, const char *);
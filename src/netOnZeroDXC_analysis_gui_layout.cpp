@@ -161,11 +161,36 @@ GuiFrame::GuiFrame (const wxString& title)
 	statictext_save_prefix = new wxStaticText(this, wxID_ANY, wxT("Prefix of output file names:"), wxDefaultPosition, wxDefaultSize, 0);
 	textctrl_save_prefix = new wxTextCtrl(this, wxID_ANY, wxT(""), wxDefaultPosition, wxDefaultSize, wxTE_LEFT);
 
+	// Output format: one text file per result, or all results in a single container ([prefix_]results.dat)
+	wxArrayString	m_list_of_output_formats;
+	m_list_of_output_formats.Add(wxT("One text file per result"));
+	m_list_of_output_formats.Add(wxT("Single results container"));
+	if (netOnZeroDXC_results_compression_available())
+		m_list_of_output_formats.Add(wxT("Single container, compressed"));
+	statictext_output_format = new wxStaticText(this, wxID_ANY, wxT("Output files:"), wxDefaultPosition, wxDefaultSize, 0);
+	combobox_output_format = new wxComboBox(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, m_list_of_output_formats, 0);
+	combobox_output_format->SetSelection(0);
+
 	// Parallel computation controls
 	checkbox_parallel_omp = new wxCheckBox(this, wxID_ANY, wxT("Enable parallel computing"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE | wxALIGN_RIGHT);
 	spinner_threadnum = new wxSpinCtrl(this, wxID_ANY, wxT(""), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, 256, 4);
 	statictext_threadnum = new wxStaticText(this, wxID_ANY, wxT("Nr. threads:"), wxDefaultPosition, wxDefaultSize, 0);
 
+	// Seed of surrogate generation
+	spinner_random_seed = new wxSpinCtrl(this, wxID_ANY, wxT(""), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 999999, 1);
+	statictext_random_seed = new wxStaticText(this, wxID_ANY, wxT("Random seed:"), wxDefaultPosition, wxDefaultSize, 0);
+
+	// Error rate of adaptive stopping of surrogates, 0 = always use all of them
+	spinner_adaptive_error = new wxSpinCtrlDouble(this, wxID_ANY, wxT(""), wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 0.1, 0, 0.001);
+	statictext_adaptive_error = new wxStaticText(this, wxID_ANY, wxT("Adaptive stop, error (0 = off):"), wxDefaultPosition, wxDefaultSize, 0);
+
+	// Checkpoints of surrogate computations, so that an interrupted run can be resumed
+	checkbox_write_checkpoint = new wxCheckBox(this, wxID_ANY, wxT("Write checkpoints"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE | wxALIGN_RIGHT);
+	checkbox_resume_checkpoint = new wxCheckBox(this, wxID_ANY, wxT("Resume from checkpoint"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE | wxALIGN_RIGHT);
+
+	// Reduced precision of the diagrams kept in memory, for runs with many pairs
+	checkbox_compact_storage = new wxCheckBox(this, wxID_ANY, wxT("Compact storage in memory"), wxDefaultPosition, wxDefaultSize, wxCHK_2STATE | wxALIGN_RIGHT);
+
 	staticline_run = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
 	staticline_parameters = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
 
@@ -245,6 +270,8 @@ GuiFrame::GuiFrame (const wxString& title)
 	wxBoxSizer *vbox_tf_prefix = new wxBoxSizer(wxVERTICAL);
 	vbox_tf_prefix->Add(statictext_save_prefix, 1, wxBOTTOM | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 	vbox_tf_prefix->Add(textctrl_save_prefix, 0, wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN);
+	vbox_tf_prefix->Add(statictext_output_format, 1, wxTOP | wxBOTTOM | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+	vbox_tf_prefix->Add(combobox_output_format, 0, wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN);
 	wxBoxSizer *vbox_tf_save = new wxBoxSizer(wxVERTICAL);
 	vbox_tf_save->Add(statictext_save_header, 0, wxBOTTOM | wxALIGN_LEFT | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 	vbox_tf_save->Add(checkbox_save_cdiagrams, 1, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN);
@@ -280,9 +307,22 @@ GuiFrame::GuiFrame (const wxString& title)
 	hbox_threadnum->Add(statictext_threadnum, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
 	hbox_threadnum->Add(spinner_threadnum, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
 
+	wxBoxSizer *hbox_random_seed = new wxBoxSizer(wxHORIZONTAL);
+	hbox_random_seed->Add(statictext_random_seed, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+	hbox_random_seed->Add(spinner_random_seed, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+
+	wxBoxSizer *hbox_adaptive_error = new wxBoxSizer(wxHORIZONTAL);
+	hbox_adaptive_error->Add(statictext_adaptive_error, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+	hbox_adaptive_error->Add(spinner_adaptive_error, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+
 	wxBoxSizer *vbox_parallel = new wxBoxSizer(wxVERTICAL);
 	vbox_parallel->Add(checkbox_parallel_omp, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
 	vbox_parallel->Add(hbox_threadnum, 0,  wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+	vbox_parallel->Add(hbox_random_seed, 0,  wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+	vbox_parallel->Add(hbox_adaptive_error, 0,  wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+	vbox_parallel->Add(checkbox_write_checkpoint, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+	vbox_parallel->Add(checkbox_resume_checkpoint, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
+	vbox_parallel->Add(checkbox_compact_storage, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 2);
 
 	wxBoxSizer *hbox_all_run = new wxBoxSizer(wxHORIZONTAL);
 	hbox_all_run->Add(vbox_parallel, 1, wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN);
@@ -418,6 +458,10 @@ void GuiFrame::onSelectMode (wxCommandEvent& WXUNUSED(event))
 				spinner_basewidth->Enable();
 				spinner_nr_windowwidths->Enable();
 				spinner_nr_surrogates->Disable();
+				spinner_random_seed->Disable();
+				spinner_adaptive_error->Disable();
+				checkbox_write_checkpoint->Disable();
+				checkbox_resume_checkpoint->Disable();
 				spinner_thr_significance->Disable();
 				spinner_thr_efficiency->Disable();
 				checkbox_save_cdiagrams->SetValue(1);
@@ -434,6 +478,10 @@ void GuiFrame::onSelectMode (wxCommandEvent& WXUNUSED(event))
 				spinner_basewidth->Enable();
 				spinner_nr_windowwidths->Enable();
 				spinner_nr_surrogates->Enable();
+				spinner_random_seed->Enable();
+				spinner_adaptive_error->Enable();
+				checkbox_write_checkpoint->Enable();
+				checkbox_resume_checkpoint->Enable();
 				spinner_thr_significance->Disable();
 				spinner_thr_efficiency->Disable();
 				checkbox_save_cdiagrams->SetValue(0);
@@ -450,6 +498,10 @@ void GuiFrame::onSelectMode (wxCommandEvent& WXUNUSED(event))
 				spinner_basewidth->Enable();
 				spinner_nr_windowwidths->Enable();
 				spinner_nr_surrogates->Enable();
+				spinner_random_seed->Enable();
+				spinner_adaptive_error->Enable();
+				checkbox_write_checkpoint->Enable();
+				checkbox_resume_checkpoint->Enable();
 				spinner_thr_significance->Enable();
 				spinner_thr_efficiency->Disable();
 				checkbox_save_cdiagrams->SetValue(0);
@@ -466,6 +518,10 @@ void GuiFrame::onSelectMode (wxCommandEvent& WXUNUSED(event))
 				spinner_basewidth->Enable();
 				spinner_nr_windowwidths->Enable();
 				spinner_nr_surrogates->Enable();
+				spinner_random_seed->Enable();
+				spinner_adaptive_error->Enable();
+				checkbox_write_checkpoint->Enable();
+				checkbox_resume_checkpoint->Enable();
 				spinner_thr_significance->Enable();
 				spinner_thr_efficiency->Enable();
 				checkbox_save_cdiagrams->SetValue(0);
@@ -485,6 +541,10 @@ void GuiFrame::onSelectMode (wxCommandEvent& WXUNUSED(event))
 				spinner_basewidth->Enable();
 				spinner_nr_windowwidths->Disable();
 				spinner_nr_surrogates->Disable();
+				spinner_random_seed->Disable();
+				spinner_adaptive_error->Disable();
+				checkbox_write_checkpoint->Disable();
+				checkbox_resume_checkpoint->Disable();
 				spinner_thr_significance->Enable();
 				spinner_thr_efficiency->Disable();
 				checkbox_save_cdiagrams->SetValue(0);
@@ -501,6 +561,10 @@ void GuiFrame::onSelectMode (wxCommandEvent& WXUNUSED(event))
 				spinner_basewidth->Enable();
 				spinner_nr_windowwidths->Disable();
 				spinner_nr_surrogates->Disable();
+				spinner_random_seed->Disable();
+				spinner_adaptive_error->Disable();
+				checkbox_write_checkpoint->Disable();
+				checkbox_resume_checkpoint->Disable();
 				spinner_thr_significance->Enable();
 				spinner_thr_efficiency->Enable();
 				checkbox_save_cdiagrams->SetValue(0);
@@ -518,6 +582,10 @@ void GuiFrame::onSelectMode (wxCommandEvent& WXUNUSED(event))
 		spinner_basewidth->Enable();
 		spinner_nr_windowwidths->Disable();
 		spinner_nr_surrogates->Disable();
+		spinner_random_seed->Disable();
+		spinner_adaptive_error->Disable();
+		checkbox_write_checkpoint->Disable();
+		checkbox_resume_checkpoint->Disable();
 		spinner_thr_significance->Disable();
 		spinner_thr_efficiency->Enable();
 		checkbox_save_cdiagrams->SetValue(0);
@@ -583,6 +651,8 @@ GuiFrame::~GuiFrame ()
 	delete	spinner_nr_surrogates;
 	delete	spinner_source_leakage;
 	delete	spinner_threadnum;
+	delete	spinner_random_seed;
+	delete	spinner_adaptive_error;
 	delete	spinner_sampling_period;
 	delete	spinner_thr_significance;
 	delete	spinner_thr_efficiency;
@@ -592,8 +662,12 @@ GuiFrame::~GuiFrame ()
 	delete	checkbox_save_pdiagrams;
 	delete	checkbox_save_efficiencies;
 	delete	checkbox_parallel_omp;
+	delete	checkbox_write_checkpoint;
+	delete	checkbox_resume_checkpoint;
+	delete	checkbox_compact_storage;
 
 	delete	textctrl_save_prefix;
+	delete	combobox_output_format;
 
 	delete	staticline_title_input;
 	delete	staticline_title_output;
@@ -613,7 +687,10 @@ GuiFrame::~GuiFrame ()
 	delete	statictext_source_leakage;
 	delete	statictext_save_header;
 	delete	statictext_save_prefix;
+	delete	statictext_output_format;
 	delete	statictext_threadnum;
+	delete	statictext_random_seed;
+	delete	statictext_adaptive_error;
 	delete	staticline_run;
 	delete	staticline_parameters;
 }
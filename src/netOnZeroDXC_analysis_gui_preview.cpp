@@ -40,6 +40,14 @@
 	#define INCLUDED_MAINAPP
 #endif
 
+#ifndef INCLUDED_ALGORITHM
+	#include "netOnZeroDXC_algorithm.hpp"
+	#define INCLUDED_ALGORITHM
+#endif
+#ifndef INCLUDED_IOFUNCTIONS
+	#include "netOnZeroDXC_io.hpp"
+	#define INCLUDED_IOFUNCTIONS
+#endif
 #ifndef INCLUDED_COLORS
 	#include "netOnZeroDXC_gui_colors.hpp"
 	#define INCLUDED_COLORS
@@ -59,13 +67,7 @@ PlotFrame::PlotFrame (const wxString& title, GuiFrame *parent)
 {
 	results_workspace = parent->m_workspace;
 
-	int	nr_pixels;
-
-	if (results_workspace->parameter_computation_pathway == 3) {
-		nr_pixels = results_workspace->matrices_multieta[0].size();
-	} else if (results_workspace->parameter_computation_pathway < 3) {
-		nr_pixels = results_workspace->matrices_multieta_multialpha[0][0].size();
-	}
+	int	nr_pixels = results_workspace->node_labels.size();
 
 	slider_thr_significance = new wxSlider(this, EVENT_SLIDER_THR_SGN, 10, 0, 100, wxDefaultPosition, wxDefaultSize, wxSL_HORIZONTAL | wxSL_VALUE_LABEL | wxSL_MIN_MAX_LABELS);
 	statictext_slider_thr_significance = new wxStaticText(this, wxID_ANY, wxT("Significance threshold (1/1000):"), wxDefaultPosition, wxDefaultSize, 0);
@@ -120,6 +122,7 @@ PlotFrame::PlotFrame (const wxString& title, GuiFrame *parent)
 
 void PlotFrame::OnSlide (wxCommandEvent & WXUNUSED(event))
 {
+	plot_area->invalidateBitmap();
 	plot_area->Refresh();
 }
 
@@ -128,6 +131,9 @@ PanelPlot::PanelPlot (PlotFrame *parent, wxSize panel_size)
 {
 	parent_frame = parent;
 	results_workspace = parent->results_workspace;
+	netOnZeroDXC_build_color_lut(color_lut);
+	bitmap_valid = false;
+	bitmap_pxsize = 0;
 
 	Connect(wxEVT_PAINT, wxPaintEventHandler(PanelPlot::OnPaint));
 	Connect(wxEVT_SIZE, wxSizeEventHandler(PanelPlot::OnResize));
@@ -138,18 +144,16 @@ void PanelPlot::OnResize (wxSizeEvent & WXUNUSED(event))
 	this->Refresh();
 }
 
+void PanelPlot::invalidateBitmap ()
+{
+	bitmap_valid = false;
+}
+
 void PanelPlot::OnPaint (wxPaintEvent & WXUNUSED(event))
 {
 	wxPaintDC dc(this);
 
-	bool	variable_alpha = false;
-	int	nr_pixels;
-	if (results_workspace->parameter_computation_pathway == 3) {
-		nr_pixels = results_workspace->matrices_multieta[0].size();
-	} else if (results_workspace->parameter_computation_pathway < 3) {
-		nr_pixels = results_workspace->matrices_multieta_multialpha[0][0].size();
-		variable_alpha = true;
-	}
+	int	nr_pixels = results_workspace->node_labels.size();
 
 	double	w_max = results_workspace->window_widths.back();
 
@@ -166,24 +170,18 @@ void PanelPlot::OnPaint (wxPaintEvent & WXUNUSED(event))
 		dc.DrawLabel(results_workspace->node_labels[i], wxRect(wxPoint(0, size_displace + i*pxsize),wxSize(size_displace, pxsize)), wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
 	}
 
-	dc.SetPen(*wxTRANSPARENT_PEN);
-	int	selected_threshold_alpha = parent_frame->slider_thr_significance->GetValue();
-	int	selected_threshold_eta = parent_frame->slider_thr_efficiency->GetValue();
-	int	j;
-	double	w_to_draw;
-	for (i = 0; i < nr_pixels; i++) {
-		for (j = 0; j < nr_pixels; j++) {
-			wxBrush brush1;
-			if (variable_alpha) {
-				w_to_draw = results_workspace->matrices_multieta_multialpha[selected_threshold_alpha][selected_threshold_eta][i][j] / w_max;
-			} else {
-				w_to_draw = results_workspace->matrices_multieta[selected_threshold_eta][i][j] / w_max;
-			}
-			brush1 = wxBrush(netOnZeroDXC_color_palette(w_to_draw));
-			dc.SetBrush(brush1);
-			dc.DrawRectangle(wxRect(size_displace + j*pxsize, size_displace + i*pxsize, pxsize, pxsize));
-		}
+	if (pxsize < 1)
+		return;
+	if (!bitmap_valid || (pxsize != bitmap_pxsize)) {		// Resizes that keep the size of the elements only blit the bitmap again
+		int	selected_threshold_alpha = parent_frame->slider_thr_significance->GetValue();
+		int	selected_threshold_eta = parent_frame->slider_thr_efficiency->GetValue();
+		wxImage	matrix_image;
+		netOnZeroDXC_render_matrix(matrix_image, results_workspace->preview_slices.getSlice(selected_threshold_alpha, selected_threshold_eta), w_max, pxsize, color_lut);
+		matrix_bitmap = wxBitmap(matrix_image);
+		bitmap_valid = true;
+		bitmap_pxsize = pxsize;
 	}
+	dc.DrawBitmap(matrix_bitmap, size_displace, size_displace, false);
 
 	return;
 }
@@ -240,3 +238,96 @@ void PanelColorbox::OnResize (wxSizeEvent & WXUNUSED(event))
 {
 	this->Refresh();
 }
+
+MatrixSliceCache::MatrixSliceCache ()
+{
+	source = NULL;
+	use_counter = 0;
+}
+
+void MatrixSliceCache::clear ()
+{
+	source = NULL;
+	slices.clear();
+	slice_keys.clear();
+	slice_last_use.clear();
+	use_counter = 0;
+}
+
+// Called at the end of the analysis: efficiencies are ready, matrices are built by getSlice() only when the preview asks for them
+void MatrixSliceCache::initialize (const ContainerWorkspace * workspace)
+{
+	clear();
+	source = workspace;
+	slices.reserve(PREVIEW_CACHE_SIZE);
+}
+
+bool MatrixSliceCache::isReady () const
+{
+	return (source != NULL);
+}
+
+ArrayView2D <const double> MatrixSliceCache::getSlice (int alpha_index, int eta_index)
+{
+	if (source->parameter_computation_pathway == 3)		// Efficiencies were loaded at a single significance threshold
+		alpha_index = 0;
+
+	int	key = alpha_index * NR_THRESHOLD_STEPS + eta_index;
+	int	i;
+	use_counter++;
+	for (i = 0; i < slice_keys.size(); i++) {
+		if (slice_keys[i] == key) {
+			slice_last_use[i] = use_counter;
+			return ArrayView2D <const double> (slices[i].data(), slices[i].rows(), slices[i].cols());
+		}
+	}
+
+	if (slices.size() < PREVIEW_CACHE_SIZE) {
+		slices.push_back(Array2D <double> ());
+		slice_keys.push_back(key);
+		slice_last_use.push_back(use_counter);
+		i = slices.size() - 1;
+	} else {
+		int	k;
+		i = 0;
+		for (k = 1; k < slices.size(); k++) {
+			if (slice_last_use[k] < slice_last_use[i])
+				i = k;
+		}
+		slice_keys[i] = key;
+		slice_last_use[i] = use_counter;
+	}
+	buildSlice(slices[i], alpha_index, eta_index);
+
+	return ArrayView2D <const double> (slices[i].data(), slices[i].rows(), slices[i].cols());
+}
+
+void MatrixSliceCache::buildSlice (Array2D <double> & matrix, int alpha_index, int eta_index)
+{
+	int	nr_nodes = source->node_labels.size();
+	bool	variable_alpha = (source->parameter_computation_pathway < 3);
+	double	threshold_eta = ((double) eta_index) / 100.0;
+
+	matrix.resize(nr_nodes, nr_nodes, -1.0);
+	int	i, j, k;
+	for (i = 0; i < nr_nodes; i++) {
+		matrix[i][i] = 0.0;
+		for (j = i + 1; j < nr_nodes; j++) {
+			k = source->pair_index.index(i, j);
+			if (k < 0)
+				continue;
+			if (variable_alpha && !source->significant_cells_multialpha.empty()) {	// Compact storage keeps counts of significant cells
+				matrix[i][j] = netOnZeroDXC_compute_wmatrix_element(source->significant_cells_multialpha[alpha_index][k], source->significant_cells_multialpha.cols(),
+										source->significant_cells_total, source->window_widths, threshold_eta);
+			} else if (variable_alpha) {
+				matrix[i][j] = netOnZeroDXC_compute_wmatrix_element(source->efficiencies_multialpha[alpha_index][k], source->efficiencies_multialpha.cols(),
+										source->window_widths, threshold_eta);
+			} else {
+				matrix[i][j] = netOnZeroDXC_compute_wmatrix_element(source->efficiencies[k], source->window_widths, threshold_eta);
+			}
+			matrix[j][i] = matrix[i][j];
+		}
+	}
+
+	return;
+}
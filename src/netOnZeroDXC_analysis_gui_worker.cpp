@@ -87,9 +87,18 @@ void GuiFrame::setNotReadyStatus ()
 	statictext_threadnum->Hide();
 	checkbox_parallel_omp->Hide();
 	spinner_threadnum->Hide();
+	statictext_random_seed->Hide();
+	statictext_adaptive_error->Hide();
+	spinner_random_seed->Hide();
+	spinner_adaptive_error->Hide();
+	checkbox_write_checkpoint->Hide();
+	checkbox_resume_checkpoint->Hide();
+	checkbox_compact_storage->Hide();
 
 	statictext_save_prefix->Hide();
 	textctrl_save_prefix->Hide();
+	statictext_output_format->Hide();
+	combobox_output_format->Hide();
 
 	staticline_parameters->Hide();
 	staticline_run->Hide();
@@ -143,10 +152,19 @@ void GuiFrame::setReadyStatus (int chosen_pathway)
 
 	statictext_save_prefix->Show();
 	textctrl_save_prefix->Show();
+	statictext_output_format->Show();
+	combobox_output_format->Show();
 
 	statictext_threadnum->Show();
 	checkbox_parallel_omp->Show();
 	spinner_threadnum->Show();
+	statictext_random_seed->Show();
+	statictext_adaptive_error->Show();
+	spinner_random_seed->Show();
+	spinner_adaptive_error->Show();
+	checkbox_write_checkpoint->Show();
+	checkbox_resume_checkpoint->Show();
+	checkbox_compact_storage->Show();
 
 	staticline_parameters->Show();
 	staticline_run->Show();
@@ -165,7 +183,7 @@ void GuiFrame::setReadyStatus (int chosen_pathway)
 
 	m_workspace->parameter_computation_pathway = chosen_pathway;
 	if (chosen_pathway == 2) {
-		spinner_nr_windowwidths->SetValue(m_workspace->diagrams_pvalue[0].size());
+		spinner_nr_windowwidths->SetValue(m_workspace->diagrams_pvalue.rows());
 	} else if (chosen_pathway == 3) {
 		spinner_nr_windowwidths->SetValue(m_workspace->efficiencies[0].size());
 	}
@@ -203,12 +221,18 @@ int GuiFrame::loadParameterTable ()
 	m_workspace->parameter_print_cdiagrams = checkbox_save_cdiagrams->GetValue();
 	m_workspace->parameter_print_pdiagrams = checkbox_save_pdiagrams->GetValue();
 	m_workspace->parameter_print_efficiencies = checkbox_save_efficiencies->GetValue();
+	m_workspace->parameter_output_format = combobox_output_format->GetSelection();
 
 	m_workspace->parameter_use_shift = checkbox_source_leakage->GetValue();
 	m_workspace->parameter_shift_value = spinner_source_leakage->GetValue();
 
 	m_workspace->parameter_use_parallel = checkbox_parallel_omp->GetValue();
 	m_workspace->parameter_numthreads = spinner_threadnum->GetValue();
+	m_workspace->parameter_random_seed = (unsigned int) spinner_random_seed->GetValue();
+	m_workspace->parameter_adaptive_error = spinner_adaptive_error->GetValue();
+	m_workspace->parameter_write_checkpoint = checkbox_write_checkpoint->GetValue();
+	m_workspace->parameter_resume_checkpoint = checkbox_resume_checkpoint->GetValue();
+	m_workspace->parameter_compact_storage = checkbox_compact_storage->GetValue();
 
 	wxString	prefix = textctrl_save_prefix->GetLineText(0);
 	m_workspace->path_output_prefix = prefix.ToStdString();
@@ -224,6 +248,8 @@ int GuiFrame::loadParameterTable ()
 	if (m_workspace->parameter_computation_pathway > 1)
 		netOnZeroDXC_postfill_list_labels(m_workspace->node_labels, m_workspace->node_pairs);
 
+	netOnZeroDXC_build_pair_index_table(m_workspace->pair_index, m_workspace->node_pairs, m_workspace->node_labels);
+
 	return 0;
 }
 
@@ -264,7 +290,7 @@ void GuiFrame::onWorkerEvent (wxThreadEvent& event)
 	// static bool	dialog_is_dead = false;
 	int n = event.GetInt();
 	// if ((!dialog_is_dead) && ((n == -1) || (n == -2) || (n == -3) || (n == -4))) {
-	if ((n == -1) || (n == -2) || (n == -3) || (n == -4)) {
+	if ((n == -1) || (n == -2) || (n == -3) || (n == -4) || (n == -5)) {
 		dialog_progress->Destroy();
 		dialog_progress = (wxProgressDialog *) NULL;
 		// dialog_is_dead = true;
@@ -275,22 +301,29 @@ void GuiFrame::onWorkerEvent (wxThreadEvent& event)
 			wxMessageBox("Error while writing output files!\nPlease check paths and permissions.", "Error", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
 		if (n == -4)
 			wxMessageBox("Unknown error in node labels.\nPlease check file naming and labels.", "Error", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
-	} else if (n == -255) {
-		dialog_progress->Update(0, "Computing correlation diagrams.\nPress [Cancel] to abort.");
-	} else if ( (n == -254)) {
-		dialog_progress->Update(0, "Computing p-value diagrams by surrogate generation.\nThis can take a very long time.\nPress [Cancel] to abort.");
-	} else if ( (n == -253)) {
-		dialog_progress->Update(0, "Computing efficiencies.\nPress [Cancel] to abort.");
-	} else if ( (n == -252)) {
-		dialog_progress->Update(0, "Preparing data for preview.\nPress [Cancel] to abort.");
-	} else if ( (n == -127)) {
-		dialog_progress->Update(0, "Writing data to file.\nClosing this window will result in loss of data.");
-	} else if ( (n == -126)) {
-		dialog_progress->Update(0, "Writing data to file.\nClosing this window will result in loss of data.");
+		if (n == -5)
+			wxMessageBox("The checkpoint in the output folder is damaged, or belongs to a run with different data or parameters.\nPlease remove it or disable resuming.", "Error", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+	} else if ((n == -255) || (n == -254) || (n == -253) || (n == -252) || (n == -251) || (n == -127) || (n == -126)) {	// Start of a stage: its description stays above the progress reports
+		if (n == -255)
+			m_progress_message = "Computing correlation diagrams.\nPress [Cancel] to abort.";
+		else if (n == -254)
+			m_progress_message = "Computing p-value diagrams by surrogate generation.\nThis can take a very long time.\nPress [Cancel] to abort.";
+		else if (n == -253)
+			m_progress_message = "Computing efficiencies.\nPress [Cancel] to abort.";
+		else if (n == -251)
+			m_progress_message = "Generating surrogate sequences of each node.\nPress [Cancel] to abort.";
+		else if (n == -252)
+			m_progress_message = "Preparing data for preview.\nPress [Cancel] to abort.";
+		else
+			m_progress_message = "Writing data to file.\nClosing this window will result in loss of data.";
+		dialog_progress->Update(0, m_progress_message);
 	} else if ( (n == -63)) {
 		dialog_progress->Update(0, event.GetString());
 	} else if ( (!m_cancelled)) {
-		if (!dialog_progress->Update(n)) {
+		wxString	progress_report = event.GetString();		// Elapsed and estimated time left, if known
+		if (!progress_report.IsEmpty())
+			progress_report = m_progress_message + progress_report;
+		if (!dialog_progress->Update(n, progress_report)) {
 			wxCriticalSectionLocker lock(m_cs_cancelled);
 			m_cancelled = true;
 			wxMessageBox("Computation was cancelled by the user.", "Info", wxOK, NULL, wxDefaultCoord, wxDefaultCoord);
@@ -311,8 +344,50 @@ WorkerThread::WorkerThread (GuiFrame *frame)
 void WorkerThread::workerExit () {}
 
 wxThread::ExitCode WorkerThread::Entry ()
+{
+	// With a results container, every product of the run goes to [prefix_]results.dat, written by a background thread.
+	// A completed run closes it before reporting the end; otherwise it is closed here, with the results written so far.
+	// Stages are timed from here on; a completed run writes their times in [prefix_]timing.log (see finishRun).
+	ResultsWriter &	results_writer = data_container->results_writer;
+	results_writer.close();
+	netOnZeroDXC_initialize_run_timing(data_container->run_timing, (data_container->parameter_use_parallel)? data_container->parameter_numthreads : 1);
+	data_container->run_timing.stages[TIMING_STAGE_LOAD] = data_container->load_timing;
+	if (data_container->parameter_output_format > 0) {
+		std::string	results_name = netOnZeroDXC_generate_filepath(data_container->path_output_folder, data_container->path_output_prefix, "results", '_', "", "");
+		if (results_writer.open(results_name, (data_container->parameter_output_format == 2))) {
+			wxThreadEvent eventError(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+			eventError.SetInt(-3);
+			wxQueueEvent(parent_frame, eventError.Clone());
+			return NULL;
+		}
+	}
+
+	runComputation();
+	results_writer.close();
+
+	return NULL;
+}
+
+bool WorkerThread::finishRun ()
+{
+	// Once a run is complete, before reporting its end: closes the results container, i.e. writes its last tables, and saves the timing log.
+	// The log is not part of the results: a run is not reported as failed if it cannot be written. Returns true on write errors.
+	RunTiming &	timing = data_container->run_timing;
+	StageClock	write_clock;
+	netOnZeroDXC_start_clock(write_clock);
+	bool	error = data_container->results_writer.close();
+	netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, write_clock, 0);
+
+	netOnZeroDXC_finish_run_timing(timing);
+	netOnZeroDXC_save_timing_log(timing, data_container->path_output_folder, data_container->path_output_prefix, '_');
+
+	return error;
+}
+
+void *WorkerThread::runComputation ()
 {
 	bool	asked_to_exit = false;
+	bool	efficiencies_ready = false;
 	bool	apply_shift = data_container->parameter_use_shift;
 	bool	print_cdiagrams = data_container->parameter_print_cdiagrams;
 	bool	print_pdiagrams = data_container->parameter_print_pdiagrams;
@@ -329,6 +404,9 @@ wxThread::ExitCode WorkerThread::Entry ()
 	double	alpha = data_container->parameter_thr_significance;
 	double	eta_0 = data_container->parameter_thr_efficiency;
 
+	RunTiming &	timing = data_container->run_timing;
+	StageClock	stage_clock;
+
 	int	number_threads;
 	if (data_container->parameter_use_parallel) {
 		number_threads = data_container->parameter_numthreads;
@@ -363,100 +441,190 @@ wxThread::ExitCode WorkerThread::Entry ()
 		}
 
 		int	i, j;
-		std::vector < std::vector <double> >	temp_diagram;
-		data_container->diagrams_correlation.clear();
-		for (i = 0; i < data_container->node_labels.size() - 1; i++) {
-			for (j = i + 1; j < data_container->node_labels.size(); j++) {	// Compute all correlation diagrams
-				if (parent_frame->workCancelled() || TestDestroy()) {
-					asked_to_exit = 1;
-					break;
-				}
-				netOnZeroDXC_initialize_temp_diagram(temp_diagram, k_size, W);
-				netOnZeroDXC_compute_cdiagram (temp_diagram, data_container->sequences, i, j, L, W, apply_shift, shift_value);
-				data_container->diagrams_correlation.push_back(temp_diagram);
-
-				wxThreadEvent eventUpdate0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-				eventUpdate0.SetInt(100 * i / data_container->node_labels.size());
-				wxQueueEvent(parent_frame, eventUpdate0.Clone());
+		int	nr_nodes = data_container->node_labels.size();
+		int	nr_pairs = nr_nodes * (nr_nodes - 1) / 2;
+
+		CheckpointFiles &	checkpoint_files = data_container->checkpoint_files;
+		netOnZeroDXC_close_checkpoint(checkpoint_files, false);			// Left open by a cancelled run
+		if ((target > 0) && (data_container->parameter_write_checkpoint || data_container->parameter_resume_checkpoint)) {
+			CheckpointHeader	checkpoint_header;
+			std::vector <int>	pair_node_a, pair_node_b;
+			netOnZeroDXC_list_pair_nodes(pair_node_a, pair_node_b, nr_nodes);
+			netOnZeroDXC_fill_checkpoint_header(checkpoint_header, data_container->sequences, pair_node_a, pair_node_b, W, L, k_size, M, SURROGATE_CHUNK_SIZE,
+								(apply_shift)? shift_value : 0, data_container->parameter_random_seed, alpha, data_container->parameter_adaptive_error);
+			int	error = netOnZeroDXC_open_checkpoint(checkpoint_files, data_container->checkpoint_state, checkpoint_header, output_path, output_prefix, '_',
+								data_container->parameter_resume_checkpoint);
+			if (error) {
+				wxThreadEvent eventError0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventError0.SetInt((error == 2)? -3 : -5);
+				wxQueueEvent(parent_frame, eventError0.Clone());
+				return NULL;
 			}
-			if (asked_to_exit)
-				break;
 		}
 
-		if (asked_to_exit)
-			return NULL;
+		// As long as there are at least as many pairs as threads, pairs are streamed: each thread computes the correlation diagram, the p-value
+		// diagram and the efficiencies of one pair at a time, writes them and frees them. Memory then holds the surrogates (one block of them if the
+		// whole bank does not fit, see netOnZeroDXC_compute_streamed_pairs), the counts of the pairs left open, the efficiencies of all pairs and one
+		// diagram per kind and per thread. Otherwise all diagrams are kept, and the surrogates of each pair, all generated at once, are split among
+		// threads: if they do not fit in memory, pairs are streamed anyway.
+		bool	stream_pairs = (nr_pairs >= ((number_threads > 1)? number_threads : 1))
+				|| ((target > 0) && (netOnZeroDXC_surrogate_block_size(nr_nodes, data_container->sequences[0].size(), M, 0, 0) < M));
+		if (stream_pairs) {
+			data_container->diagrams_correlation.clear();
+			data_container->diagrams_pvalue.clear();
+			data_container->diagrams_correlation_compact.clear();
+			data_container->diagrams_counts.clear();
+			int	error;
+			error = netOnZeroDXC_compute_streamed_pairs(this, data_container, M, L, W, k_size, apply_shift, shift_value, (target > 0), print_cdiagrams, print_pdiagrams, T, number_threads);
+			if (error)
+				netOnZeroDXC_close_checkpoint(checkpoint_files, false);
+			if (error == 2) {
+				wxThreadEvent eventError0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventError0.SetInt(-3);
+				wxQueueEvent(parent_frame, eventError0.Clone());
+				return NULL;
+			}
+			if (error)
+				return NULL;
+
+			if (target == 0) {
+				wxThreadEvent eventEnd0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventEnd0.SetInt((finishRun())? -3 : -1); // that's it
+				wxQueueEvent(parent_frame, eventEnd0.Clone());
+				return NULL;
+			}
+			efficiencies_ready = true;
+		} else {
+			// With compact storage, diagrams are kept in reduced precision and expanded one at a time when written
+			bool	compact = data_container->parameter_compact_storage;
+			int	pair_index = 0;
+			Array2D <double>	pair_diagram(W, k_size, 0.0);
+			netOnZeroDXC_start_clock(stage_clock);
+			data_container->diagrams_pvalue.clear();			// Only the diagrams of the chosen storage are kept
+			data_container->diagrams_counts.clear();
+			if (compact) {
+				data_container->diagrams_correlation.clear();
+				data_container->diagrams_correlation_compact.resize(nr_pairs, W, k_size, 0.0f);
+			} else {
+				data_container->diagrams_correlation_compact.clear();
+				data_container->diagrams_correlation.resize(nr_pairs, W, k_size, 0.0);
+			}
+			for (i = 0; i < nr_nodes - 1; i++) {
+				for (j = i + 1; j < nr_nodes; j++) {				// Compute all correlation diagrams
+					if (parent_frame->workCancelled() || TestDestroy()) {
+						asked_to_exit = 1;
+						break;
+					}
+					if (compact) {
+						netOnZeroDXC_compute_cdiagram (pair_diagram, data_container->sequences, i, j, L, W, apply_shift, shift_value);
+						netOnZeroDXC_compact_diagram(data_container->diagrams_correlation_compact[pair_index], pair_diagram);
+					} else {
+						netOnZeroDXC_compute_cdiagram (data_container->diagrams_correlation[pair_index], data_container->sequences, i, j, L, W, apply_shift, shift_value);
+					}
+					pair_index++;
+
+					wxThreadEvent eventUpdate0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+					eventUpdate0.SetInt(100 * i / data_container->node_labels.size());
+					wxQueueEvent(parent_frame, eventUpdate0.Clone());
+				}
+				if (asked_to_exit)
+					break;
+			}
+
+			if (asked_to_exit)
+				return NULL;
+			netOnZeroDXC_stop_clock(timing, TIMING_STAGE_CDIAGRAM, stage_clock, pair_index);
+
+			if (print_cdiagrams) {							// If necessary, write them in output
+				wxThreadEvent eventPrint0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventPrint0.SetInt(-127);
+				wxQueueEvent(parent_frame, eventPrint0.Clone());
+				netOnZeroDXC_start_clock(stage_clock);
+				int	error;
+				for (i = 0; i < data_container->node_pairs.size(); i++) {
+					if (compact)
+						netOnZeroDXC_expand_diagram(pair_diagram, data_container->diagrams_correlation_compact[i]);
+					error = netOnZeroDXC_write_diagram(&data_container->results_writer, (compact)? ArrayView2D <const double> (pair_diagram) : ArrayView2D <const double> (data_container->diagrams_correlation[i]),
+									output_path, output_prefix, "cdiag", '_', data_container->node_pairs[i].label_a, data_container->node_pairs[i].label_b, '\t');
+					if (error) {
+						wxThreadEvent eventError0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+						eventError0.SetInt(-3);
+						wxQueueEvent(parent_frame, eventError0.Clone());
+						return NULL;
+					}
+				}
+				netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, stage_clock, data_container->node_pairs.size());
+			}
+			if (target == 0) {
+				wxThreadEvent eventEnd0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventEnd0.SetInt((finishRun())? -3 : -1); // that's it
+				wxQueueEvent(parent_frame, eventEnd0.Clone());
+				return NULL;
+			}									// Otherwise, compute all p-value diagrams, surrogates included
 
-		if (print_cdiagrams) {							// If necessary, write them in output
-			wxThreadEvent eventPrint0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-			eventPrint0.SetInt(-127);
-			wxQueueEvent(parent_frame, eventPrint0.Clone());
 			int	error;
-			for (i = 0; i < data_container->node_pairs.size(); i++) {
-				error = netOnZeroDXC_save_diagram(data_container->diagrams_correlation[i], output_path, output_prefix, "cdiag", '_', data_container->node_pairs[i].label_a, data_container->node_pairs[i].label_b, '\t');
-				if (error) {
-					wxThreadEvent eventError0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-					eventError0.SetInt(-3);
-					wxQueueEvent(parent_frame, eventError0.Clone());
-					return NULL;
+			error = netOnZeroDXC_compute_all_pdiagrams(this, data_container, M, L, W, apply_shift, shift_value, number_threads);
+			if (error) {
+				data_container->surrogate_bank.clear();
+				netOnZeroDXC_close_checkpoint(checkpoint_files, false);
+				if (error == 2) {
+					wxThreadEvent eventError1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+					eventError1.SetInt(-3);
+					wxQueueEvent(parent_frame, eventError1.Clone());
 				}
+				return NULL;
 			}
-		}
-		if (target == 0) {
-			wxThreadEvent eventEnd0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-			eventEnd0.SetInt(-1); // that's it
-			wxQueueEvent(parent_frame, eventEnd0.Clone());
-			return NULL;
-		}									// Otherwise, compute all p-value diagrams
-
-		double	progress_shared = 0.0;
-		wxThreadEvent eventStartPath1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-		eventStartPath1.SetInt(-254);
-		wxQueueEvent(parent_frame, eventStartPath1.Clone());
-		data_container->diagrams_pvalue.clear();
-		k = 0;
-		int	error;
-		for (i = 0; i < data_container->node_labels.size() - 1; i++) {
-			for (j = i + 1; j < data_container->node_labels.size(); j++) {
-				netOnZeroDXC_initialize_temp_diagram(temp_diagram, k_size, W);
-				asked_to_exit = netOnZeroDXC_compute_pdiagram(temp_diagram, this, data_container, progress_shared, i, j, k, M, L, W, apply_shift, shift_value, number_threads);
-				k++;
-				if (asked_to_exit) {
-					break;
-				} else {
-					data_container->diagrams_pvalue.push_back(temp_diagram);
-
-					std::stringstream	message_updated;
-					message_updated << "Computing p-value diagrams by surrogate generation.\nThis can take a very long time.\nPair ";
-					message_updated << k << " out of " << data_container->node_pairs.size() << "\nPress [Cancel] to abort.";
-					wxString	message = message_updated.str();
-					wxThreadEvent eventNewPair(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-					eventNewPair.SetInt(-63);
-					eventNewPair.SetString(message);
-					wxQueueEvent(parent_frame, eventNewPair.Clone());
-					progress_shared = 0.0;
-
-					if (print_pdiagrams) {
-						error = netOnZeroDXC_save_diagram(temp_diagram, output_path, output_prefix, "pdiag", '_', data_container->node_labels[i], data_container->node_labels[j], '\t');
-						if (error) {
-							wxThreadEvent eventError0(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-							eventError0.SetInt(-3);
-							wxQueueEvent(parent_frame, eventError0.Clone());
-							return NULL;
-						}
+
+			if (print_pdiagrams) {							// If necessary, write them in output
+				wxThreadEvent eventPrint1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventPrint1.SetInt(-127);
+				wxQueueEvent(parent_frame, eventPrint1.Clone());
+				netOnZeroDXC_start_clock(stage_clock);
+				int	error;
+				for (i = 0; i < data_container->node_pairs.size(); i++) {
+					if (compact)
+						netOnZeroDXC_convert_compact_counts_to_pdiagram(pair_diagram, data_container->diagrams_counts[i], W,
+											(data_container->surrogates_used.size())? data_container->surrogates_used[i] : M);
+					error = netOnZeroDXC_write_diagram(&data_container->results_writer, (compact)? ArrayView2D <const double> (pair_diagram) : ArrayView2D <const double> (data_container->diagrams_pvalue[i]),
+									output_path, output_prefix, "pdiag", '_', data_container->node_pairs[i].label_a, data_container->node_pairs[i].label_b, '\t');
+					if (error) {
+						netOnZeroDXC_close_checkpoint(checkpoint_files, false);
+						wxThreadEvent eventError1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+						eventError1.SetInt(-3);
+						wxQueueEvent(parent_frame, eventError1.Clone());
+						return NULL;
 					}
 				}
+				netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, stage_clock, data_container->node_pairs.size());
 			}
-			if (asked_to_exit)
-				break;
 		}
+		data_container->surrogate_bank.clear();
 		asked_to_exit = parent_frame->workCancelled();
 
-		if (asked_to_exit)
+		if (asked_to_exit) {
+			netOnZeroDXC_close_checkpoint(checkpoint_files, false);
 			return NULL;
+		}
+
+		if (data_container->surrogates_used.size()) {				// Adaptive stopping: log the surrogates used by each pair
+			std::vector <std::string>	labels_a, labels_b;
+			for (i = 0; i < data_container->node_pairs.size(); i++) {
+				labels_a.push_back(data_container->node_pairs[i].label_a);
+				labels_b.push_back(data_container->node_pairs[i].label_b);
+			}
+			if (netOnZeroDXC_save_surrogates_used(labels_a, labels_b, data_container->surrogates_used, M, output_path, output_prefix, '_', '\t')) {
+				netOnZeroDXC_close_checkpoint(checkpoint_files, false);
+				wxThreadEvent eventError1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventError1.SetInt(-3);
+				wxQueueEvent(parent_frame, eventError1.Clone());
+				return NULL;
+			}
+		}
+		netOnZeroDXC_close_checkpoint(checkpoint_files, true);			// All p-value diagrams are done: the checkpoint is not needed any more
 
 		if (target == 1) {							// If this is all the user needs, exit
 			wxThreadEvent eventEnd1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-			eventEnd1.SetInt(-1); // that's it
+			eventEnd1.SetInt((finishRun())? -3 : -1); // that's it
 			wxQueueEvent(parent_frame, eventEnd1.Clone());
 			return NULL;
 		}
@@ -464,29 +632,41 @@ wxThread::ExitCode WorkerThread::Entry ()
 
 	// When pathway < 3 (AND we haven't returned yet) efficiencies must be computed.
 	if (pathway < 3) {
-		wxThreadEvent eventStartPath1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-		eventStartPath1.SetInt(-253);
-		wxQueueEvent(parent_frame, eventStartPath1.Clone());
-
 		int	i;
 		std::vector <double>	temp_efficiency;
-		data_container->efficiencies.clear();
-		data_container->window_widths.clear();
-		for (i = 0; i < data_container->diagrams_pvalue[0].size(); i++)
-			data_container->window_widths.push_back((i + 1) * L * T);
-
-		for (i = 0; i < data_container->diagrams_pvalue.size(); i++) {
-			if (parent_frame->workCancelled() || TestDestroy()) {
-				asked_to_exit = 1;
-				break;
+		bool	from_counts = !data_container->diagrams_counts.empty();		// Computed with compact storage; loaded diagrams are never compact
+		int	nr_stored = (from_counts)? data_container->diagrams_counts.size() : data_container->diagrams_pvalue.size();
+		int	nr_rows = (from_counts)? data_container->diagrams_counts.rows() : data_container->diagrams_pvalue.rows();
+		int	nr_cols = (from_counts)? data_container->diagrams_counts.cols() : data_container->diagrams_pvalue.cols();
+		if (!efficiencies_ready) {					// Streamed pairs already have their efficiencies
+			wxThreadEvent eventStartPath1(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+			eventStartPath1.SetInt(-253);
+			wxQueueEvent(parent_frame, eventStartPath1.Clone());
+			netOnZeroDXC_start_clock(stage_clock);
+
+			data_container->efficiencies.clear();
+			data_container->window_widths.clear();
+			for (i = 0; i < nr_rows; i++)
+				data_container->window_widths.push_back((i + 1) * L * T);
+
+			for (i = 0; i < nr_stored; i++) {
+				if (parent_frame->workCancelled() || TestDestroy()) {
+					asked_to_exit = 1;
+					break;
+				}
+				temp_efficiency.clear();
+				if (from_counts)
+					netOnZeroDXC_compute_efficiency_counts(temp_efficiency, data_container->diagrams_counts[i],
+										(data_container->surrogates_used.size())? data_container->surrogates_used[i] : M, alpha);
+				else
+					netOnZeroDXC_compute_efficiency(temp_efficiency, data_container->diagrams_pvalue[i], alpha);
+				data_container->efficiencies.push_back(temp_efficiency);
+
+				wxThreadEvent eventUpdate2(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+				eventUpdate2.SetInt(100 * i / nr_stored);
+				wxQueueEvent(parent_frame, eventUpdate2.Clone());
 			}
-			temp_efficiency.clear();
-			netOnZeroDXC_compute_efficiency(temp_efficiency, data_container->diagrams_pvalue[i], alpha);
-			data_container->efficiencies.push_back(temp_efficiency);
-
-			wxThreadEvent eventUpdate2(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-			eventUpdate2.SetInt(100 * i / data_container->diagrams_pvalue.size());
-			wxQueueEvent(parent_frame, eventUpdate2.Clone());
+			netOnZeroDXC_stop_clock(timing, TIMING_STAGE_EFFICIENCY, stage_clock, data_container->efficiencies.size());
 		}
 		asked_to_exit = parent_frame->workCancelled();
 
@@ -497,9 +677,10 @@ wxThread::ExitCode WorkerThread::Entry ()
 			wxThreadEvent eventPrint2(wxEVT_THREAD, EVENT_WORKER_UPDATE);
 			eventPrint2.SetInt(-126);
 			wxQueueEvent(parent_frame, eventPrint2.Clone());
+			netOnZeroDXC_start_clock(stage_clock);
 			int	error;
 			for (i = 0; i < data_container->node_pairs.size(); i++) {
-				error = netOnZeroDXC_save_linear_data(data_container->window_widths, data_container->efficiencies[i], output_path, output_prefix, "eff", '_', data_container->node_pairs[i].label_a, data_container->node_pairs[i].label_b, '\t');
+				error = netOnZeroDXC_write_linear_data(&data_container->results_writer, data_container->window_widths, data_container->efficiencies[i], output_path, output_prefix, "eff", '_', data_container->node_pairs[i].label_a, data_container->node_pairs[i].label_b, '\t');
 				if (error) {
 					wxThreadEvent eventError2(wxEVT_THREAD, EVENT_WORKER_UPDATE);
 					eventError2.SetInt(-3);
@@ -507,37 +688,52 @@ wxThread::ExitCode WorkerThread::Entry ()
 					return NULL;
 				}
 			}
+			netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, stage_clock, data_container->node_pairs.size());
 		}
 
 		if (target == 2) {
 			wxThreadEvent eventEnd2(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-			eventEnd2.SetInt(-1); // that's it
+			eventEnd2.SetInt((finishRun())? -3 : -1); // that's it
 			wxQueueEvent(parent_frame, eventEnd2.Clone());
 			return NULL;
 		}
 
-		if (target == 3) {	// In case of target matrix, we prepare efficiencies at different significance thresholds
-			int	k;
-			std::vector < std::vector <double> >	temp_efficiency_list;
-			for (k = 0; k <= 100; k++) {
-				temp_efficiency_list.clear();
-				for (i = 0; i < data_container->diagrams_pvalue.size(); i++) {
-					if (parent_frame->workCancelled() || TestDestroy()) {
-						return NULL;
-					}
-					temp_efficiency.clear();
-					netOnZeroDXC_compute_efficiency(temp_efficiency, data_container->diagrams_pvalue[i], ((double) k) / 1000.0);
-					temp_efficiency_list.push_back(temp_efficiency);
+		if ((target == 3) && !efficiencies_ready) {	// In case of target matrix, we prepare efficiencies at different significance thresholds
+			bool	compact = data_container->parameter_compact_storage && (nr_cols <= COMPACT_COUNT_MAX);
+			std::vector <double>	alpha_thresholds;
+			netOnZeroDXC_start_clock(stage_clock);
+			netOnZeroDXC_list_alpha_thresholds(alpha_thresholds);
+			if (compact) {
+				data_container->efficiencies_multialpha.clear();
+				data_container->significant_cells_multialpha.resize(NR_THRESHOLD_STEPS, nr_stored, nr_rows, 0);
+				data_container->significant_cells_total = nr_cols;
+			} else {
+				data_container->significant_cells_multialpha.clear();
+				data_container->efficiencies_multialpha.resize(NR_THRESHOLD_STEPS, nr_stored, nr_rows, 0.0);
+			}
+			for (i = 0; i < nr_stored; i++) {		// One pass per diagram for all the thresholds
+				if (parent_frame->workCancelled() || TestDestroy()) {
+					return NULL;
 				}
-				data_container->efficiencies_multialpha.push_back(temp_efficiency_list);
+				if (from_counts)
+					netOnZeroDXC_count_significant_multithreshold(data_container->significant_cells_multialpha[0][i], (size_t) nr_stored * nr_rows, data_container->diagrams_counts[i],
+											(data_container->surrogates_used.size())? data_container->surrogates_used[i] : M, alpha_thresholds);
+				else if (compact)
+					netOnZeroDXC_count_significant_multithreshold(data_container->significant_cells_multialpha[0][i], (size_t) nr_stored * nr_rows,
+											data_container->diagrams_pvalue[i], alpha_thresholds);
+				else
+					netOnZeroDXC_compute_efficiency_multithreshold(data_container->efficiencies_multialpha[0][i], (size_t) nr_stored * nr_rows,
+											data_container->diagrams_pvalue[i], alpha_thresholds, false);
 				wxThreadEvent eventUpdate3(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-				eventUpdate3.SetInt((k < 100)? k : 99);
+				eventUpdate3.SetInt(100 * i / nr_stored);
 				wxQueueEvent(parent_frame, eventUpdate3.Clone());
 			}
+			netOnZeroDXC_stop_clock(timing, TIMING_STAGE_EFFICIENCY, stage_clock, 0);		// Same pairs, at other thresholds
 		}
 	} // End-if (pathway < 3)
 
 	// If we haven't returned yet, the matrix of time scales must be computed.
+	netOnZeroDXC_start_clock(stage_clock);
 	std::vector <double>			matrix_row(data_container->node_labels.size(), -1.0);
 	std::vector < std::vector <double> >	timescale_matrix(data_container->node_labels.size(), matrix_row);
 
@@ -548,7 +744,7 @@ wxThread::ExitCode WorkerThread::Entry ()
 		}
 		timescale_matrix[i][i] = 0.0;
 		for (j = i + 1; j < data_container->node_labels.size(); j++) {
-			k = netOnZeroDXC_associate_index_of_pair(data_container->node_pairs, data_container->node_labels, i, j);
+			k = data_container->pair_index.index(i, j);
 			timescale_matrix[i][j] = netOnZeroDXC_compute_wmatrix_element(data_container->efficiencies[k], data_container->window_widths, eta_0);
 			timescale_matrix[j][i] = timescale_matrix[i][j];
 		}
@@ -559,65 +755,14 @@ wxThread::ExitCode WorkerThread::Entry ()
 	eventUpdate4.SetInt(-252);
 	wxQueueEvent(parent_frame, eventUpdate4.Clone());
 
-	if (pathway == 3) {
-		std::vector < std::vector <double> >	temp_matrix(data_container->node_labels.size(), matrix_row);
-		data_container->matrices_multieta.clear();
-		int	eta_index;
-		for (eta_index = 0; eta_index <= 100; eta_index++) {
-			if (parent_frame->workCancelled() || TestDestroy()) {
-				return NULL;
-			}
-			temp_matrix.clear();
-			temp_matrix.resize(data_container->node_labels.size(), matrix_row);
-			for (i = 0; i < data_container->node_labels.size() - 1; i++) {
-				temp_matrix[i][i] = 0.0;
-				for (j = i + 1; j < data_container->node_labels.size(); j++) {
-					k = netOnZeroDXC_associate_index_of_pair(data_container->node_pairs, data_container->node_labels, i, j);
-					temp_matrix[i][j] = netOnZeroDXC_compute_wmatrix_element(data_container->efficiencies[k], data_container->window_widths, ((double) eta_index) / 100.0);
-					temp_matrix[j][i] = temp_matrix[i][j];
-				}
-			}
-			temp_matrix[i][i] = 0.0;
-			data_container->matrices_multieta.push_back(temp_matrix);
-			wxThreadEvent eventUpdate5(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-			eventUpdate5.SetInt((eta_index < 100)? eta_index : 99);
-			wxQueueEvent(parent_frame, eventUpdate5.Clone());
-		}
-	} else {
-		std::vector < std::vector <double> >			temp_matrix(data_container->node_labels.size(), matrix_row);
-		std::vector < std::vector < std::vector <double> > >	temp_matrix_list;
-		data_container->matrices_multieta_multialpha.clear();
-		int	alpha_index, eta_index;
-		for (alpha_index = 0; alpha_index <= 100; alpha_index++) {
-			temp_matrix_list.clear();
-			for (eta_index = 0; eta_index <= 100; eta_index++) {
-				temp_matrix.clear();
-				temp_matrix.resize(data_container->node_labels.size(), matrix_row);
-				if (parent_frame->workCancelled() || TestDestroy()) {
-					return NULL;
-				}
-				for (i = 0; i < data_container->node_labels.size() - 1; i++) {
-					temp_matrix[i][i] = 0.0;
-					for (j = i + 1; j < data_container->node_labels.size(); j++) {
-						k = netOnZeroDXC_associate_index_of_pair(data_container->node_pairs, data_container->node_labels, i, j);
-						temp_matrix[i][j] = netOnZeroDXC_compute_wmatrix_element(data_container->efficiencies_multialpha[alpha_index][k], data_container->window_widths, ((double) eta_index) / 100.0);
-						temp_matrix[j][i] = temp_matrix[i][j];
-					}
-				}
-				temp_matrix[i][i] = 0.0;
-				temp_matrix_list.push_back(temp_matrix);
-			}
-			data_container->matrices_multieta_multialpha.push_back(temp_matrix_list);
-			wxThreadEvent eventUpdate5(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-			eventUpdate5.SetInt((alpha_index < 100)? alpha_index : 99);
-			wxQueueEvent(parent_frame, eventUpdate5.Clone());
-		}
-	}
-
+	data_container->preview_slices.initialize(data_container);	// Matrices at the thresholds selected in the preview will be computed on demand
 	parent_frame->enablePreview();
+	int	nr_nodes = data_container->node_labels.size();
+	netOnZeroDXC_stop_clock(timing, TIMING_STAGE_MATRIX, stage_clock, nr_nodes * (nr_nodes - 1) / 2);
 
 	int	error;
-	error = netOnZeroDXC_save_diagram(timescale_matrix, output_path, output_prefix, "matrix", '_', "", "", '\t');
+	error = netOnZeroDXC_write_diagram(&data_container->results_writer, timescale_matrix, output_path, output_prefix, "matrix", '_', "", "", '\t');
+	netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, stage_clock, 1);
 	if (error) {
 		wxThreadEvent eventError4(wxEVT_THREAD, EVENT_WORKER_UPDATE);
 		eventError4.SetInt(-3);
@@ -626,7 +771,7 @@ wxThread::ExitCode WorkerThread::Entry ()
 	}
 
 	wxThreadEvent eventFinal(wxEVT_THREAD, EVENT_WORKER_UPDATE);
-	eventFinal.SetInt(-1); // that's it
+	eventFinal.SetInt((finishRun())? -3 : -1); // that's it
 	wxQueueEvent(parent_frame, eventFinal.Clone());
 	return NULL;
 
@@ -634,6 +779,7 @@ wxThread::ExitCode WorkerThread::Entry ()
 
 ContainerWorkspace::ContainerWorkspace ()
 {
+	checkpoint_files.journal = NULL;
 	clearWorkspace();
 };
 
@@ -652,20 +798,39 @@ void ContainerWorkspace::clearWorkspace ()
 	parameter_print_cdiagrams = 0;
 	parameter_print_pdiagrams = 0;
 	parameter_print_efficiencies = 0;
+	parameter_output_format = 0;
 	parameter_use_parallel = false;
 	parameter_numthreads = 1;
+	parameter_random_seed = 1;
+	parameter_adaptive_error = -1.0;
+	parameter_write_checkpoint = false;
+	parameter_resume_checkpoint = false;
+	parameter_compact_storage = false;
 
 	sequences.clear();
 	diagrams_correlation.clear();
 	diagrams_pvalue.clear();
+	diagrams_correlation_compact.clear();
+	diagrams_counts.clear();
 	efficiencies.clear();
 	window_widths.clear();
 	node_labels.clear();
 	node_pairs.clear();
+	pair_index.clear();
+	surrogate_bank.clear();
+	surrogates_used.clear();
+	netOnZeroDXC_close_checkpoint(checkpoint_files, false);
+	checkpoint_state = CheckpointState();
+	results_writer.close();
+	load_timing.elapsed_time = 0.0;
+	load_timing.thread_time = 0.0;
+	load_timing.cpu_time = 0.0;
+	load_timing.items = 0;
 
-	matrices_multieta.clear();
 	efficiencies_multialpha.clear();
-	matrices_multieta_multialpha.clear();
+	significant_cells_multialpha.clear();
+	significant_cells_total = 0;
+	preview_slices.clear();
 
 	path_filename_delimiter = '_';
 	path_output_folder.clear();
@@ -688,6 +853,11 @@ int ContainerWorkspace::validateParameterTable ()
 			return 2;
 		}
 	}
+	if (parameter_compact_storage && ((parameter_nr_surrogates > COMPACT_COUNT_MAX)
+				|| ((parameter_computation_pathway < 2) && (sequences[0].size() / parameter_basewidth > COMPACT_COUNT_MAX)))) {
+		wxMessageBox("Error: too many surrogates or window positions.\nCompact storage holds counts up to 65535: please disable it.", "Error", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+		return 2;
+	}
 	if (path_output_prefix.size()) {
 		if (path_output_prefix.find_first_of(" ") != std::string::npos) {
 			wxMessageBox("Error: bad file names.\nPrefix of file names should not contain spaces.", "Error", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
@@ -729,7 +899,7 @@ int ContainerWorkspace::validateParameterTable ()
 
 void GuiFrame::popupPreview (wxCommandEvent& WXUNUSED(event))
 {
-	if (m_workspace->matrices_multieta.size() || m_workspace->matrices_multieta_multialpha.size()) {
+	if (m_workspace->preview_slices.isReady()) {
 		new PlotFrame("Preview matrix of time scales", this);
 	}
 
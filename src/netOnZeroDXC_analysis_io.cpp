@@ -34,6 +34,8 @@
 #include <sstream>
 #include <string>
 
+#include "omp.h"
+
 #ifndef INCLUDED_MAINAPP
 	#include "netOnZeroDXC_analysis_main.hpp"
 	#define INCLUDED_MAINAPP
@@ -117,6 +119,8 @@ void GuiFrame::loadInputFiles(wxCommandEvent& WXUNUSED(event))
 	std::stringstream	displayed_file_info_stream;
 	std::stringstream	displayed_folder_info_stream;
 	int			loading_error;
+	double			load_start_time = omp_get_wtime();
+	double			load_start_cpu_time = netOnZeroDXC_process_cpu_time();
 	if (loading_mode == 0)
 		loading_error = netOnZeroDXC_load_single_file(m_workspace->sequences, m_workspace->node_labels, file_name, separator_char);
 	else if (loading_mode == 1)
@@ -126,6 +130,12 @@ void GuiFrame::loadInputFiles(wxCommandEvent& WXUNUSED(event))
 	else if (loading_mode == 3)
 		loading_error = netOnZeroDXC_load_multi_efficiencies(m_workspace->efficiencies, m_workspace->node_pairs, m_workspace->window_widths, list_of_files, separator_char, filename_delimiter_char);
 
+	StageTiming &	load_timing = m_workspace->load_timing;		// Reset by clearWorkspace if loading failed
+	load_timing.elapsed_time = omp_get_wtime() - load_start_time;
+	load_timing.thread_time = load_timing.elapsed_time;
+	load_timing.cpu_time = netOnZeroDXC_process_cpu_time() - load_start_cpu_time;
+	load_timing.items = (loading_mode < 2)? m_workspace->sequences.size() : ((loading_mode == 2)? m_workspace->diagrams_pvalue.size() : m_workspace->efficiencies.size());
+
 	switch (loading_error) {
 		case 1:
 			sstm << "Error in reading files!\nFilenames cannot be correctly parsed. Maybe a wrong delimiter?\nNoting was loaded.";
@@ -182,10 +192,10 @@ void GuiFrame::loadInputFiles(wxCommandEvent& WXUNUSED(event))
 			} else if (loading_mode == 2) {
 				sstm << "Successfully read " << list_of_files.GetCount() << " files with index delimiter " << delimiter_label << ".\n";
 				sstm << "Loaded " << m_workspace->diagrams_pvalue.size() << " diagrams with separator " << separator_label << ", content read:\n";
-				sstm << "- Detected data rows (i.e. window widths): " << m_workspace->diagrams_pvalue[0].size() << "\n";
-				sstm << "- Detected data columns (i.e. window positions): " << m_workspace->diagrams_pvalue[0][0].size() << "\n";
+				sstm << "- Detected data rows (i.e. window widths): " << m_workspace->diagrams_pvalue.rows() << "\n";
+				sstm << "- Detected data columns (i.e. window positions): " << m_workspace->diagrams_pvalue.cols() << "\n";
 				sstm << "Consistency between diagrams was checked. Everything is fine.";
-				displayed_file_info_stream << "Diagrams loaded: " << m_workspace->diagrams_pvalue.size() << ". Size: " << m_workspace->diagrams_pvalue[0].size() << " x " << m_workspace->diagrams_pvalue[0][0].size();
+				displayed_file_info_stream << "Diagrams loaded: " << m_workspace->diagrams_pvalue.size() << ". Size: " << m_workspace->diagrams_pvalue.rows() << " x " << m_workspace->diagrams_pvalue.cols();
 			} else if (loading_mode == 3) {
 				sstm << "Successfully read " << list_of_files.GetCount() << " files with index delimiter " << delimiter_label << ".\n";
 				sstm << "Loaded " << m_workspace->efficiencies.size() << " efficiencies with separator " << separator_label << ", content read:\n";
@@ -57,10 +57,33 @@
 	#include "netOnZeroDXC_pair.hpp"
 	#define INCLUDED_PAIR
 #endif
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
+#ifndef INCLUDED_CHECKPOINT
+	#include "netOnZeroDXC_checkpoint.hpp"
+	#define INCLUDED_CHECKPOINT
+#endif
+#ifndef INCLUDED_IORESULTS
+	#include "netOnZeroDXC_io_results.hpp"
+	#define INCLUDED_IORESULTS
+#endif
+#ifndef INCLUDED_TIMING
+	#include "netOnZeroDXC_timing.hpp"
+	#define INCLUDED_TIMING
+#endif
 #ifndef INCLUDED_ICON
 	#include "netOnZeroDXC_gui_icon.hpp"
 	#define INCLUDED_ICON
 #endif
+#ifndef INCLUDED_COLORS
+	#include "netOnZeroDXC_gui_colors.hpp"
+	#define INCLUDED_COLORS
+#endif
+
+#define NR_THRESHOLD_STEPS 101		// Thresholds alpha and eta sampled for the preview
+#define PREVIEW_CACHE_SIZE 32		// Matrices of time scales kept in memory by the preview
 
 class MainApp;
 class GuiFrame;
@@ -154,6 +177,7 @@ private:
 	std::string	description_mode_33;
 
 	wxProgressDialog	*dialog_progress;
+	wxString		m_progress_message;		// Stage being run, shown above its progress and estimated time left
 
 	wxRadioBox		*radiobox_selectpathway;
 	wxRadioBox		*radiobox_mode;
@@ -164,6 +188,7 @@ private:
 	wxButton		*button_preview;
 	wxComboBox 		*combobox_separators;
 	wxComboBox 		*combobox_delimiters;
+	wxComboBox 		*combobox_output_format;
 
 	wxSpinCtrl		*spinner_columnr;
 	wxSpinCtrl		*spinner_basewidth;
@@ -171,15 +196,20 @@ private:
 	wxSpinCtrl		*spinner_nr_surrogates;
 	wxSpinCtrl		*spinner_source_leakage;
 	wxSpinCtrl		*spinner_threadnum;
+	wxSpinCtrl		*spinner_random_seed;
 	wxSpinCtrlDouble	*spinner_sampling_period;
 	wxSpinCtrlDouble	*spinner_thr_significance;
 	wxSpinCtrlDouble	*spinner_thr_efficiency;
+	wxSpinCtrlDouble	*spinner_adaptive_error;
 
 	wxCheckBox		*checkbox_source_leakage;
 	wxCheckBox		*checkbox_save_cdiagrams;
 	wxCheckBox		*checkbox_save_pdiagrams;
 	wxCheckBox		*checkbox_save_efficiencies;
 	wxCheckBox		*checkbox_parallel_omp;
+	wxCheckBox		*checkbox_write_checkpoint;
+	wxCheckBox		*checkbox_resume_checkpoint;
+	wxCheckBox		*checkbox_compact_storage;
 
 	wxTextCtrl		*textctrl_save_prefix;
 
@@ -201,7 +231,10 @@ private:
 	wxStaticText		*statictext_source_leakage;
 	wxStaticText		*statictext_save_header;
 	wxStaticText		*statictext_save_prefix;
+	wxStaticText		*statictext_output_format;
 	wxStaticText		*statictext_threadnum;
+	wxStaticText		*statictext_random_seed;
+	wxStaticText		*statictext_adaptive_error;
 	wxStaticLine		*staticline_run;
 	wxStaticLine		*staticline_parameters;
 
@@ -210,6 +243,25 @@ private:
 	wxDECLARE_EVENT_TABLE();
 };
 
+class MatrixSliceCache
+{
+public:
+	MatrixSliceCache();
+	void clear();
+	void initialize(const ContainerWorkspace *);
+	bool isReady() const;
+	ArrayView2D <const double> getSlice(int, int);
+
+private:
+	void buildSlice(Array2D <double> &, int, int);
+
+	const ContainerWorkspace		*source;
+	std::vector < Array2D <double> >	slices;			// Matrices of time scales, least recently used is replaced first
+	std::vector <int>			slice_keys;
+	std::vector <unsigned long>		slice_last_use;
+	unsigned long				use_counter;
+};
+
 class ContainerWorkspace
 {
 public:
@@ -230,21 +282,38 @@ public:
 	bool	parameter_print_cdiagrams;
 	bool	parameter_print_pdiagrams;
 	bool	parameter_print_efficiencies;
+	int	parameter_output_format;			// 0 = text files, 1 = results container, 2 = compressed results container
 
 	bool	parameter_use_parallel;
 	int	parameter_numthreads;
+	unsigned int	parameter_random_seed;
+	double	parameter_adaptive_error;			// Error rate of adaptive stopping of surrogates, <= 0 if disabled
+	bool	parameter_write_checkpoint;
+	bool	parameter_resume_checkpoint;
+	bool	parameter_compact_storage;			// Diagrams kept as float correlations and exceedance counts, efficiencies at many alpha as cell counts
 
 	std::vector < std::vector <double> >			sequences;
-	std::vector < std::vector < std::vector <double> > >	diagrams_correlation;
-	std::vector < std::vector < std::vector <double> > >	diagrams_pvalue;
+	Array3D <double>					diagrams_correlation;		// [pair][window width][window position]
+	Array3D <double>					diagrams_pvalue;
+	Array3D <float>						diagrams_correlation_compact;	// As diagrams_correlation, with parameter_compact_storage
+	Array3D <unsigned short>				diagrams_counts;		// Exceedance counts in place of diagrams_pvalue, with parameter_compact_storage
 	std::vector < std::vector <double> >			efficiencies;
 	std::vector <double>					window_widths;
 	std::vector <std::string>				node_labels;
 	std::vector <PairOfLabels>				node_pairs;
-
-	std::vector < std::vector < std::vector <double> > >			matrices_multieta;
-	std::vector < std::vector < std::vector <double> > >			efficiencies_multialpha;
-	std::vector < std::vector < std::vector < std::vector <double> > > >	matrices_multieta_multialpha;
+	PairIndexTable						pair_index;			// Built once node_labels and node_pairs are final
+	std::vector < std::vector < std::vector <double> > >	surrogate_bank;
+	std::vector <int>					surrogates_used;		// Per pair, with adaptive stopping
+	CheckpointFiles						checkpoint_files;		// journal != NULL while a checkpoint is being written
+	CheckpointState						checkpoint_state;
+	ResultsWriter						results_writer;			// Open during a run written to a results container
+	StageTiming						load_timing;			// Of the loaded input, reported with the next runs
+	RunTiming						run_timing;
+
+	Array3D <double>					efficiencies_multialpha;	// [alpha][pair][window width]
+	Array3D <unsigned short>				significant_cells_multialpha;	// Same, as numbers of cells below alpha, with parameter_compact_storage
+	int							significant_cells_total;	// Cells of a row of the diagrams, i.e. the denominator of those efficiencies
+	MatrixSliceCache					preview_slices;
 
 	char		path_filename_delimiter;
 	std::string	path_output_folder;
@@ -257,6 +326,8 @@ public:
 	WorkerThread(GuiFrame *frame);
 
 	virtual void *Entry();
+	void *runComputation();
+	bool finishRun();
 	virtual void workerExit();
 
 	ContainerWorkspace	*data_container;
@@ -289,10 +360,15 @@ public:
 	PanelPlot(PlotFrame *, wxSize);
 	void OnPaint(wxPaintEvent&);
 	void OnResize(wxSizeEvent&);
+	void invalidateBitmap();
 
 private:
 	PlotFrame		*parent_frame;
 	ContainerWorkspace	*results_workspace;
+	ColorLUT		color_lut;
+	wxBitmap		matrix_bitmap;		// The matrix as last drawn, rendered again only when its slice or the size of its elements change
+	bool			bitmap_valid;
+	int			bitmap_pxsize;
 
 	wxDECLARE_EVENT_TABLE();
 };
@@ -0,0 +1,113 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+
+// Diagrams and matrices are stored row-major in a single contiguous block: element (r, c) of a rows x cols array is at r * cols + c.
+// Array2D and Array3D own their storage; ArrayView2D is a non-owning window on one of them (e.g. a single slice of an Array3D),
+// and is what algorithm and I/O functions take as argument. Rows are accessed as plain pointers, so a[r][c] works as with nested vectors.
+
+template <typename T>
+class ArrayView2D
+{
+public:
+	ArrayView2D() : values(NULL), nr_rows(0), nr_cols(0) {}
+	ArrayView2D(T * v, int r, int c) : values(v), nr_rows(r), nr_cols(c) {}
+	template <typename U>
+	ArrayView2D(const ArrayView2D <U> & other) : values(other.data()), nr_rows(other.rows()), nr_cols(other.cols()) {}	// T* -> const T*
+
+	T *		operator[] (int r) const {return values + (size_t) r * nr_cols;}
+	T *		data() const {return values;}
+	int		rows() const {return nr_rows;}
+	int		cols() const {return nr_cols;}
+	size_t		count() const {return (size_t) nr_rows * nr_cols;}
+	void		fill(const T & value) const {size_t i; for (i = 0; i < count(); i++) values[i] = value;}
+
+private:
+	T		*values;
+	int		nr_rows;
+	int		nr_cols;
+};
+
+template <typename T>
+class Array2D
+{
+public:
+	Array2D() : nr_rows(0), nr_cols(0) {}
+	Array2D(int r, int c, const T & value = T()) : values((size_t) r * c, value), nr_rows(r), nr_cols(c) {}
+
+	void		resize(int r, int c, const T & value = T()) {values.assign((size_t) r * c, value); nr_rows = r; nr_cols = c;}
+	void		fill(const T & value) {values.assign(values.size(), value);}
+	void		clear() {values.clear(); nr_rows = 0; nr_cols = 0;}
+	bool		empty() const {return values.empty();}
+
+	T *		operator[] (int r) {return values.data() + (size_t) r * nr_cols;}
+	const T *	operator[] (int r) const {return values.data() + (size_t) r * nr_cols;}
+	T *		data() {return values.data();}
+	const T *	data() const {return values.data();}
+	int		rows() const {return nr_rows;}
+	int		cols() const {return nr_cols;}
+
+	operator	ArrayView2D <T> () {return ArrayView2D <T> (values.data(), nr_rows, nr_cols);}
+	operator	ArrayView2D <const T> () const {return ArrayView2D <const T> (values.data(), nr_rows, nr_cols);}
+
+private:
+	std::vector <T>	values;
+	int		nr_rows;
+	int		nr_cols;
+};
+
+template <typename T>
+class Array3D
+{
+public:
+	Array3D() : nr_slices(0), nr_rows(0), nr_cols(0) {}
+	Array3D(int s, int r, int c, const T & value = T()) : values((size_t) s * r * c, value), nr_slices(s), nr_rows(r), nr_cols(c) {}
+
+	void		resize(int s, int r, int c, const T & value = T()) {values.assign((size_t) s * r * c, value); nr_slices = s; nr_rows = r; nr_cols = c;}
+	void		fill(const T & value) {values.assign(values.size(), value);}
+	void		clear() {values.clear(); nr_slices = 0; nr_rows = 0; nr_cols = 0;}
+	bool		empty() const {return values.empty();}
+
+	ArrayView2D <T>		operator[] (int s) {return ArrayView2D <T> (values.data() + (size_t) s * nr_rows * nr_cols, nr_rows, nr_cols);}
+	ArrayView2D <const T>	operator[] (int s) const {return ArrayView2D <const T> (values.data() + (size_t) s * nr_rows * nr_cols, nr_rows, nr_cols);}
+	T *		data() {return values.data();}
+	const T *	data() const {return values.data();}
+	int		size() const {return nr_slices;}
+	int		rows() const {return nr_rows;}
+	int		cols() const {return nr_cols;}
+
+private:
+	std::vector <T>	values;
+	int		nr_slices;
+	int		nr_rows;
+	int		nr_cols;
+};
@@ -0,0 +1,698 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <gsl/gsl_randist.h>
+
+#include "omp.h"
+
+#ifndef INCLUDED_ALGORITHM
+	#include "netOnZeroDXC_algorithm.hpp"
+	#define INCLUDED_ALGORITHM
+#endif
+
+#define BENCH_SEED 12345
+#define BENCH_COUPLING 0.3			// Share of the common component in each synthetic channel
+#define BENCH_ALPHA 0.05
+#define BENCH_ETA 0.5
+
+struct BenchRecord {				// One row of the results table
+	std::string	benchmark;
+	std::string	config;
+	int		threads;
+	double		work;
+	std::string	unit;
+	double		wall_time;
+	double		cpu_time;
+	double		speedup;
+	long		peak_rss_kb;
+};
+
+struct BenchPipelineCase {			// End-to-end run on synthetic data; max_pairs = 0 means all pairs
+	std::string	name;
+	int		nr_nodes;
+	int		N;
+	int		W;
+	int		L;
+	int		M;
+	int		max_pairs;
+	int		min_scale;
+};
+
+void netOnZeroDXC_bench_help (char *);
+int netOnZeroDXC_bench_parse_options (int, char **, int &, int &, int &, std::string &);
+void netOnZeroDXC_bench_list_threads (std::vector <int> &, int);
+void netOnZeroDXC_bench_generate_sequences (std::vector < std::vector <double> > &, int, int, unsigned int);
+unsigned int netOnZeroDXC_bench_node_seed (unsigned int, int);
+int netOnZeroDXC_bench_count_windows (int, int, int);
+double netOnZeroDXC_bench_cpu_time ();
+void netOnZeroDXC_bench_reset_peak_rss ();
+long netOnZeroDXC_bench_peak_rss ();
+void netOnZeroDXC_bench_print_header (FILE *, int, int);
+void netOnZeroDXC_bench_print_record (FILE *, const BenchRecord &);
+void netOnZeroDXC_bench_crosscorr (FILE *, const std::vector <int> &, int, int);
+void netOnZeroDXC_bench_cdiagram (FILE *, const std::vector <int> &, int, int);
+void netOnZeroDXC_bench_surrogates (FILE *, const std::vector <int> &, int, int);
+void netOnZeroDXC_bench_efficiency (FILE *, const std::vector <int> &, int, int);
+void netOnZeroDXC_bench_pipeline (FILE *, const std::vector <int> &, const BenchPipelineCase &);
+
+int main(int argc, char *argv[]) {
+
+	int	scale = 1;
+	int	max_threads = 0;
+	int	repetitions = 3;
+	std::string	selected_output_filename;
+
+	int error;
+	error = netOnZeroDXC_bench_parse_options(argc, argv, scale, max_threads, repetitions, selected_output_filename);
+	if (error)
+		exit(1);
+	if (max_threads <= 0)
+		max_threads = omp_get_max_threads();
+
+	FILE *	output = stdout;
+	if (selected_output_filename.size()) {
+		output = fopen(selected_output_filename.c_str(), "w");
+		if (!output) {
+			std::cerr << "ERROR: cannot write on file '" << selected_output_filename << "'. Please check permissions.\n";
+			exit(1);
+		}
+	}
+
+	std::vector <int>	thread_counts;
+	netOnZeroDXC_bench_list_threads(thread_counts, max_threads);
+	netOnZeroDXC_bench_print_header(output, scale, max_threads);
+
+	netOnZeroDXC_bench_crosscorr(output, thread_counts, scale, repetitions);
+	netOnZeroDXC_bench_cdiagram(output, thread_counts, scale, repetitions);
+	netOnZeroDXC_bench_surrogates(output, thread_counts, scale, repetitions);
+	netOnZeroDXC_bench_efficiency(output, thread_counts, scale, repetitions);
+
+	// The first case has the size of examples/example_1 and its suggested parameters; the others scale it up to 256 channels x 10^6 samples.
+	// On the larger ones, only the pairs among a few channels are computed: their throughput gives the time of a complete run.
+	BenchPipelineCase	cases[] = {
+		{"example_1",	15,	500,		50,	4,	500,	0,	1},
+		{"64x10^4",	64,	10000,		50,	20,	100,	128,	2},
+		{"256x10^5",	256,	100000,		50,	200,	32,	32,	3},
+		{"256x10^6",	256,	1000000,	50,	2000,	8,	8,	3}
+	};
+	int	i;
+	for (i = 0; i < (int) (sizeof(cases) / sizeof(cases[0])); i++) {
+		if (cases[i].min_scale <= scale)
+			netOnZeroDXC_bench_pipeline(output, thread_counts, cases[i]);
+	}
+
+	if (output != stdout) {
+		if (fclose(output) == EOF) {
+			std::cerr << "ERROR: i/o error when writing data on file '" << selected_output_filename << "'. Please check permissions.\n";
+			exit(1);
+		}
+	}
+
+	return 0;
+}
+
+void netOnZeroDXC_bench_help (char *program_name)
+{
+	std::cerr << "Usage:\n";
+	std::cerr << "\t" << program_name << " (<Options>)\n";
+	std::cerr << "\nTimes the core kernels of the package and complete analyses on synthetic data, for an increasing number of threads.\n";
+	std::cerr << "Results are printed as a table with one row per benchmark, configuration and number of threads; columns are\n";
+	std::cerr << "separated by TAB, and lines starting with '#' are comments. Columns:\n";
+	std::cerr << "\tbenchmark, config\tkernel or pipeline stage, and its parameters;\n";
+	std::cerr << "\tthreads\t\tnumber of OpenMP threads;\n";
+	std::cerr << "\twork, unit\tamount of work done, and what it is counted in;\n";
+	std::cerr << "\twall_s, cpu_s\telapsed and CPU time, in seconds (kernels: best of the repetitions);\n";
+	std::cerr << "\tthroughput\twork per second of elapsed time;\n";
+	std::cerr << "\tspeedup\t\tthroughput relative to the same configuration with one thread;\n";
+	std::cerr << "\tutilization\tCPU time over (elapsed time x threads);\n";
+	std::cerr << "\tpeak_rss_kb\tpeak resident memory while running the benchmark, in kB.\n";
+
+	std::cerr << "\nOptions:\n";
+	std::cerr << "\t-s <#>\t\tsize of the benchmark: 1 (default) for small data, up to the size of examples/example_1;\n";
+	std::cerr << "\t\t\t2 adds larger kernels and 64 channels x 10^4 samples; 3 goes up to 256 channels x 10^6 samples\n";
+	std::cerr << "\t\t\t(several GB of memory and hours with few threads);\n";
+	std::cerr << "\t-t <#>\t\tlargest number of threads, default as set by OpenMP; 1, 2, 4, ... up to it are timed;\n";
+	std::cerr << "\t-r <#>\t\trepetitions of each kernel benchmark, default 3;\n";
+	std::cerr << "\t-o <fname>\twrite results to file 'fname' instead of the standard output.\n";
+
+	std::cerr << "\n\t-h or --help\tshow this help.\n";
+}
+
+int netOnZeroDXC_bench_parse_options (int argc, char *argv[], int & scale, int & max_threads, int & repetitions, std::string & output_filename)
+{
+	int	n = 1;
+	while (n < argc) {
+		if (strcmp(argv[n], "-s") == 0) {
+			n++;
+			scale = atoi(argv[n]);
+		} else if (strcmp(argv[n], "-t") == 0) {
+			n++;
+			max_threads = atoi(argv[n]);
+		} else if (strcmp(argv[n], "-r") == 0) {
+			n++;
+			repetitions = atoi(argv[n]);
+		} else if (strcmp(argv[n], "-o") == 0) {
+			n++;
+			output_filename = argv[n];
+
+		} else if ((strcmp("-h", argv[n]) == 0) || (strcmp("--help", argv[n]) == 0))  {
+			netOnZeroDXC_bench_help(argv[0]);
+			exit(0);
+		}
+		n++;
+	}
+
+	if ((scale < 1) || (scale > 3)) {
+		std::cerr << "ERROR: the size of the benchmark must be 1, 2 or 3. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (repetitions < 1) {
+		std::cerr << "ERROR: at least one repetition is required.\n";
+		return 1;
+	}
+
+	return 0;
+}
+
+void netOnZeroDXC_bench_list_threads (std::vector <int> & thread_counts, int max_threads)
+{
+	int	t;
+	thread_counts.clear();
+	for (t = 1; t < max_threads; t = 2 * t)
+		thread_counts.push_back(t);
+	thread_counts.push_back(max_threads);
+}
+
+void netOnZeroDXC_bench_generate_sequences (std::vector < std::vector <double> > & sequences, int nr_nodes, int N, unsigned int seed)
+{
+	// AR(1) channels sharing a common AR(1) component, so that pairs are partially correlated as in recorded data
+	std::vector <double>	common(N, 0.0);
+	gsl_rng	*random_generator = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(random_generator, seed);
+	int	j;
+	for (j = 1; j < N; j++)
+		common[j] = 0.9 * common[j-1] + gsl_ran_gaussian(random_generator, 1.0);
+	gsl_rng_free(random_generator);
+
+	sequences.assign(nr_nodes, std::vector <double> (N, 0.0));
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < nr_nodes; i++) {
+		gsl_rng	*node_generator = gsl_rng_alloc(gsl_rng_mt19937);
+		gsl_rng_set(node_generator, netOnZeroDXC_bench_node_seed(seed, i));
+		double	x = 0.0;
+		int	k;
+		for (k = 0; k < N; k++) {
+			x = 0.7 * x + gsl_ran_gaussian(node_generator, 1.0);
+			sequences[i][k] = (1.0 - BENCH_COUPLING) * x + BENCH_COUPLING * common[k];
+		}
+		gsl_rng_free(node_generator);
+	}
+}
+
+unsigned int netOnZeroDXC_bench_node_seed (unsigned int base_seed, int index)
+{
+	// A 32-bit seed for the synthetic sequence of each node, that depends only on (base seed, node)
+	unsigned long long	z = base_seed;
+	int	i;
+	for (i = 0; i < 2; i++) {
+		z += 0x9E3779B97F4A7C15ULL * (unsigned long long) (((i == 0)? index : 0) + 1);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;		// splitmix64 finalizer
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z = z ^ (z >> 31);
+	}
+
+	return (unsigned int) (z ^ (z >> 32));
+}
+
+int netOnZeroDXC_bench_count_windows (int N, int W, int L)
+{
+	// Same centres as netOnZeroDXC_compute_cdiagram, without shift
+	int	K = 0;
+	int	k;
+	for (k = W*L / 2 - 1; k < N - W*L / 2; k = k + L)
+		K++;
+
+	return K;
+}
+
+double netOnZeroDXC_bench_cpu_time ()
+{
+	struct rusage	usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return (double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + 1e-6 * (double) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+void netOnZeroDXC_bench_reset_peak_rss ()
+{
+	// Writing 5 to clear_refs resets the peak resident set of the process (Linux 4.0 and later); otherwise peaks are cumulative
+	FILE *	file_pointer = fopen("/proc/self/clear_refs", "w");
+	if (file_pointer) {
+		fprintf(file_pointer, "5");
+		fclose(file_pointer);
+	}
+}
+
+long netOnZeroDXC_bench_peak_rss ()
+{
+	long	peak = -1;
+	char	line[256];
+	FILE *	file_pointer = fopen("/proc/self/status", "r");
+	if (file_pointer) {
+		while (fgets(line, sizeof(line), file_pointer)) {
+			if (strncmp(line, "VmHWM:", 6) == 0) {
+				peak = atol(line + 6);
+				break;
+			}
+		}
+		fclose(file_pointer);
+	}
+	if (peak < 0) {
+		struct rusage	usage;
+		getrusage(RUSAGE_SELF, &usage);
+		peak = usage.ru_maxrss;
+	}
+
+	return peak;
+}
+
+void netOnZeroDXC_bench_print_header (FILE * output, int scale, int max_threads)
+{
+#ifdef NETONZERODXC_USE_FFTW
+	const char *	fft_library = "fftw";
+#else
+	const char *	fft_library = "gsl";
+#endif
+	fprintf(output, "# netOnZeroDXC_bench scale=%d max_threads=%d fft=%s\n", scale, max_threads, fft_library);
+	fprintf(output, "#benchmark\tconfig\tthreads\twork\tunit\twall_s\tcpu_s\tthroughput\tspeedup\tutilization\tpeak_rss_kb\n");
+	fflush(output);
+}
+
+void netOnZeroDXC_bench_print_record (FILE * output, const BenchRecord & record)
+{
+	double	throughput = (record.wall_time > 0.0)? record.work / record.wall_time : 0.0;
+	double	utilization = (record.wall_time > 0.0)? record.cpu_time / (record.wall_time * record.threads) : 0.0;
+	fprintf(output, "%s\t%s\t%d\t%.0f\t%s\t%.6f\t%.6f\t%.6g\t%.3f\t%.3f\t%ld\n", record.benchmark.c_str(), record.config.c_str(), record.threads, record.work,
+		record.unit.c_str(), record.wall_time, record.cpu_time, throughput, record.speedup, utilization, record.peak_rss_kb);
+	fflush(output);
+	std::cerr << record.benchmark << " " << record.config << ", " << record.threads << " threads: " << throughput << " " << record.unit << "/s\n";
+}
+
+void netOnZeroDXC_bench_crosscorr (FILE * output, const std::vector <int> & thread_counts, int scale, int repetitions)
+{
+	// Windows of width w slide along two channels; each call is independent, and calls are split among threads
+	int	N = (scale > 1)? 1000000 : 100000;
+	int	widths[] = {4, 64, 1024};
+	long	samples_per_width = (scale > 1)? 200000000L : 20000000L;
+	std::vector < std::vector <double> >	sequences;
+	netOnZeroDXC_bench_reset_peak_rss();
+	netOnZeroDXC_bench_generate_sequences(sequences, 2, N, BENCH_SEED);
+
+	int	i, t, r;
+	for (i = 0; i < (int) (sizeof(widths) / sizeof(widths[0])); i++) {
+		int	w = widths[i];
+		long	nr_calls = samples_per_width / w;
+		char	config[64];
+		sprintf(config, "N=%d;w=%d", N, w);
+		double	reference_time = 0.0;
+		for (t = 0; t < (int) thread_counts.size(); t++) {
+			BenchRecord	record;
+			record.benchmark = "crosscorr";
+			record.config = config;
+			record.threads = thread_counts[t];
+			record.work = (double) nr_calls * w;
+			record.unit = "samples";
+			record.wall_time = -1.0;
+			double	checksum = 0.0;
+			for (r = 0; r < repetitions; r++) {
+				double	start_wall = omp_get_wtime();
+				double	start_cpu = netOnZeroDXC_bench_cpu_time();
+				double	sum = 0.0;
+				#pragma omp parallel for schedule(static) reduction(+:sum) num_threads(thread_counts[t])
+				for (long c = 0; c < nr_calls; c++) {
+					int	start = (int) ((c * w) % (N - w));
+					sum += netOnZeroDXC_compute_crosscorr(sequences, 0, 1, start, start + w - 1, start, start + w - 1);
+				}
+				double	wall_time = omp_get_wtime() - start_wall;
+				double	cpu_time = netOnZeroDXC_bench_cpu_time() - start_cpu;
+				if ((record.wall_time < 0.0) || (wall_time < record.wall_time)) {
+					record.wall_time = wall_time;
+					record.cpu_time = cpu_time;
+				}
+				checksum += sum;
+			}
+			if (t == 0)
+				reference_time = record.wall_time;
+			record.speedup = (record.wall_time > 0.0)? reference_time / record.wall_time : 0.0;
+			record.peak_rss_kb = netOnZeroDXC_bench_peak_rss();
+			if (std::isnan(checksum))				// Keeps the calls from being optimized away
+				record.config += ";nan";
+			netOnZeroDXC_bench_print_record(output, record);
+		}
+	}
+}
+
+void netOnZeroDXC_bench_cdiagram (FILE * output, const std::vector <int> & thread_counts, int scale, int repetitions)
+{
+	// All the pairs among 8 channels, one correlation diagram each; pairs are split among threads
+	int	nr_nodes = 8;
+	int	N = (scale > 1)? 100000 : 10000;
+	int	parameters[][2] = {{4, 50}, {20, 50}, {4, 200}};		// {L, W}
+	std::vector < std::vector <double> >	sequences;
+	netOnZeroDXC_bench_reset_peak_rss();
+	netOnZeroDXC_bench_generate_sequences(sequences, nr_nodes, N, BENCH_SEED);
+
+	std::vector <int>	pair_node_a, pair_node_b;
+	int	i, j, t, r;
+	for (i = 0; i < nr_nodes; i++) {
+		for (j = i + 1; j < nr_nodes; j++) {
+			pair_node_a.push_back(i);
+			pair_node_b.push_back(j);
+		}
+	}
+	int	nr_pairs = pair_node_a.size();
+
+	for (i = 0; i < (int) (sizeof(parameters) / sizeof(parameters[0])); i++) {
+		int	L = parameters[i][0];
+		int	W = parameters[i][1];
+		int	K = netOnZeroDXC_bench_count_windows(N, W, L);
+		char	config[64];
+		sprintf(config, "N=%d;L=%d;W=%d", N, L, W);
+		double	reference_time = 0.0;
+		for (t = 0; t < (int) thread_counts.size(); t++) {
+			BenchRecord	record;
+			record.benchmark = "cdiagram";
+			record.config = config;
+			record.threads = thread_counts[t];
+			record.work = (double) nr_pairs * W * K;
+			record.unit = "cells";
+			record.wall_time = -1.0;
+			for (r = 0; r < repetitions; r++) {
+				double	start_wall = omp_get_wtime();
+				double	start_cpu = netOnZeroDXC_bench_cpu_time();
+				#pragma omp parallel num_threads(thread_counts[t])
+				{
+					Array2D <double>	cdiagram(W, K, 0.0);
+					#pragma omp for schedule(dynamic)
+					for (int p = 0; p < nr_pairs; p++)
+						netOnZeroDXC_compute_cdiagram(cdiagram, sequences, pair_node_a[p], pair_node_b[p], L, W, false, 0);
+				}
+				double	wall_time = omp_get_wtime() - start_wall;
+				double	cpu_time = netOnZeroDXC_bench_cpu_time() - start_cpu;
+				if ((record.wall_time < 0.0) || (wall_time < record.wall_time)) {
+					record.wall_time = wall_time;
+					record.cpu_time = cpu_time;
+				}
+			}
+			if (t == 0)
+				reference_time = record.wall_time;
+			record.speedup = (record.wall_time > 0.0)? reference_time / record.wall_time : 0.0;
+			record.peak_rss_kb = netOnZeroDXC_bench_peak_rss();
+			netOnZeroDXC_bench_print_record(output, record);
+		}
+	}
+}
+
+void netOnZeroDXC_bench_surrogates (FILE * output, const std::vector <int> & thread_counts, int scale, int repetitions)
+{
+	// IAAFT surrogates of one channel, as in the surrogate bank: one generator per thread, surrogates split among threads
+	int	lengths[] = {500, 4096, 10000, 100000, 1000000};
+	int	nr_lengths = (scale == 1)? 3 : ((scale == 2)? 4 : 5);
+	int	max_threads = thread_counts.back();
+	int	i, t, r;
+	for (i = 0; i < nr_lengths; i++) {
+		int	N = lengths[i];
+		int	nr_surrogates = std::max(2 * max_threads, (int) (4000000L / N));
+		std::vector < std::vector <double> >	sequences;
+		std::vector <double>	values_distribution, fft_amplitudes;
+		netOnZeroDXC_bench_reset_peak_rss();
+		netOnZeroDXC_bench_generate_sequences(sequences, 1, N, BENCH_SEED);
+		netOnZeroDXC_initialize_surrogate_generation(values_distribution, fft_amplitudes, sequences, 0);
+
+		char	config[64];
+		sprintf(config, "N=%d", N);
+		double	reference_time = 0.0;
+		for (t = 0; t < (int) thread_counts.size(); t++) {
+			BenchRecord	record;
+			record.benchmark = "surrogate";
+			record.config = config;
+			record.threads = thread_counts[t];
+			record.work = nr_surrogates;
+			record.unit = "surrogates";
+			record.wall_time = -1.0;
+			for (r = 0; r < repetitions; r++) {
+				double	start_wall = omp_get_wtime();
+				double	start_cpu = netOnZeroDXC_bench_cpu_time();
+				#pragma omp parallel num_threads(thread_counts[t])
+				{
+					SurrogateGenerator	generator;
+					std::vector <double>	surrogate;
+					netOnZeroDXC_allocate_surrogate_generator(generator, N);
+					#pragma omp for schedule(dynamic)
+					for (int m = 0; m < nr_surrogates; m++)
+						netOnZeroDXC_generate_surrogate_sequence(surrogate, generator, sequences[0], values_distribution, fft_amplitudes,
+											TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(BENCH_SEED, 0, m));
+					netOnZeroDXC_free_surrogate_generator(generator);
+				}
+				double	wall_time = omp_get_wtime() - start_wall;
+				double	cpu_time = netOnZeroDXC_bench_cpu_time() - start_cpu;
+				if ((record.wall_time < 0.0) || (wall_time < record.wall_time)) {
+					record.wall_time = wall_time;
+					record.cpu_time = cpu_time;
+				}
+			}
+			if (t == 0)
+				reference_time = record.wall_time;
+			record.speedup = (record.wall_time > 0.0)? reference_time / record.wall_time : 0.0;
+			record.peak_rss_kb = netOnZeroDXC_bench_peak_rss();
+			netOnZeroDXC_bench_print_record(output, record);
+		}
+	}
+}
+
+void netOnZeroDXC_bench_efficiency (FILE * output, const std::vector <int> & thread_counts, int scale, int repetitions)
+{
+	// Efficiencies of a set of p-value diagrams with uniform values, visited repeatedly; calls are split among threads
+	int	W = 50;
+	int	K = 1000;
+	int	nr_diagrams = 64;
+	long	nr_calls = (scale > 1)? 40000L : 4000L;
+	Array3D <double>	diagrams;
+	netOnZeroDXC_bench_reset_peak_rss();
+	diagrams.resize(nr_diagrams, W, K, 0.0);
+	gsl_rng	*random_generator = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(random_generator, BENCH_SEED);
+	size_t	c;
+	for (c = 0; c < (size_t) nr_diagrams * W * K; c++)
+		diagrams.data()[c] = gsl_rng_uniform(random_generator);
+	gsl_rng_free(random_generator);
+
+	char	config[64];
+	sprintf(config, "W=%d;K=%d", W, K);
+	double	reference_time = 0.0;
+	int	t, r;
+	for (t = 0; t < (int) thread_counts.size(); t++) {
+		BenchRecord	record;
+		record.benchmark = "efficiency";
+		record.config = config;
+		record.threads = thread_counts[t];
+		record.work = (double) nr_calls * W * K;
+		record.unit = "cells";
+		record.wall_time = -1.0;
+		double	checksum = 0.0;
+		for (r = 0; r < repetitions; r++) {
+			double	start_wall = omp_get_wtime();
+			double	start_cpu = netOnZeroDXC_bench_cpu_time();
+			double	sum = 0.0;
+			#pragma omp parallel num_threads(thread_counts[t]) reduction(+:sum)
+			{
+				std::vector <double>	efficiency(W, 0.0);
+				#pragma omp for schedule(static)
+				for (long n = 0; n < nr_calls; n++) {
+					netOnZeroDXC_compute_efficiency(efficiency.data(), diagrams[n % nr_diagrams], BENCH_ALPHA);
+					sum += efficiency[0];
+				}
+			}
+			double	wall_time = omp_get_wtime() - start_wall;
+			double	cpu_time = netOnZeroDXC_bench_cpu_time() - start_cpu;
+			if ((record.wall_time < 0.0) || (wall_time < record.wall_time)) {
+				record.wall_time = wall_time;
+				record.cpu_time = cpu_time;
+			}
+			checksum += sum;
+		}
+		if (t == 0)
+			reference_time = record.wall_time;
+		record.speedup = (record.wall_time > 0.0)? reference_time / record.wall_time : 0.0;
+		record.peak_rss_kb = netOnZeroDXC_bench_peak_rss();
+		if (std::isnan(checksum))
+			record.config += ";nan";
+		netOnZeroDXC_bench_print_record(output, record);
+	}
+}
+
+void netOnZeroDXC_bench_pipeline (FILE * output, const std::vector <int> & thread_counts, const BenchPipelineCase & bench_case)
+{
+	// Same steps as netOnZeroDXC_diagram -all followed by the matrix of time scales, in memory: a surrogate bank for the nodes involved,
+	// then one task per pair computing its correlation diagram, exceedance counts, p-value diagram, efficiencies and matrix element.
+	// If only some pairs are computed, they are all the pairs among a few channels spread over the montage, so that the bank stays small.
+	int	nr_nodes = bench_case.nr_nodes;
+	int	N = bench_case.N;
+	int	W = bench_case.W;
+	int	L = bench_case.L;
+	int	M = bench_case.M;
+	int	K = netOnZeroDXC_bench_count_windows(N, W, L);
+	int	nr_selected = nr_nodes;
+	if (bench_case.max_pairs > 0) {
+		nr_selected = 2;
+		while ((nr_selected < nr_nodes) && (nr_selected * (nr_selected - 1) / 2 < bench_case.max_pairs))
+			nr_selected++;
+	}
+
+	std::vector <int>	used_nodes;
+	std::vector <int>	pair_node_a, pair_node_b;
+	int	i, j, t;
+	for (i = 0; i < nr_selected; i++)
+		used_nodes.push_back((int) ((long) i * nr_nodes / nr_selected));
+	for (i = 0; i < nr_selected; i++) {
+		for (j = i + 1; j < nr_selected; j++) {
+			if ((bench_case.max_pairs > 0) && ((int) pair_node_a.size() == bench_case.max_pairs))
+				break;
+			pair_node_a.push_back(used_nodes[i]);
+			pair_node_b.push_back(used_nodes[j]);
+		}
+	}
+	int	nr_pairs = pair_node_a.size();
+	int	nr_used = used_nodes.size();
+	long	nr_all_pairs = (long) nr_nodes * (nr_nodes - 1) / 2;
+
+	std::vector <double>	window_widths;
+	for (i = 0; i < W; i++)
+		window_widths.push_back((i + 1) * L);
+
+	std::vector < std::vector <double> >	sequences;
+	netOnZeroDXC_bench_generate_sequences(sequences, nr_nodes, N, BENCH_SEED);
+
+	char	config[128];
+	sprintf(config, "%s;nodes=%d;N=%d;L=%d;W=%d;M=%d;pairs=%d/%ld", bench_case.name.c_str(), nr_nodes, N, L, W, M, nr_pairs, nr_all_pairs);
+	double	reference_time[3] = {0.0, 0.0, 0.0};		// Bank, pairs, total with one thread
+	for (t = 0; t < (int) thread_counts.size(); t++) {
+		int	number_threads = thread_counts[t];
+		netOnZeroDXC_bench_reset_peak_rss();
+		double	start_wall = omp_get_wtime();
+		double	start_cpu = netOnZeroDXC_bench_cpu_time();
+
+		std::vector < std::vector < std::vector <double> > >	surrogate_bank(nr_nodes);
+		std::vector < std::vector <double> >	values_distribution(nr_nodes);
+		std::vector < std::vector <double> >	fft_amplitudes(nr_nodes);
+		for (i = 0; i < nr_used; i++) {
+			netOnZeroDXC_initialize_surrogate_generation(values_distribution[used_nodes[i]], fft_amplitudes[used_nodes[i]], sequences, used_nodes[i]);
+			surrogate_bank[used_nodes[i]].resize(M);
+		}
+		long	nr_tasks = (long) nr_used * M;
+		#pragma omp parallel num_threads(number_threads)
+		{
+			SurrogateGenerator	generator;
+			netOnZeroDXC_allocate_surrogate_generator(generator, N);
+			#pragma omp for schedule(dynamic)
+			for (long n = 0; n < nr_tasks; n++) {
+				int	node = used_nodes[n / M];
+				int	m = n % M;
+				netOnZeroDXC_generate_surrogate_sequence(surrogate_bank[node][m], generator, sequences[node], values_distribution[node], fft_amplitudes[node],
+									TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(BENCH_SEED, node, m));
+			}
+			netOnZeroDXC_free_surrogate_generator(generator);
+		}
+		double	pairs_wall = omp_get_wtime();
+		double	pairs_cpu = netOnZeroDXC_bench_cpu_time();
+
+		std::vector <double>	matrix_elements(nr_pairs, 0.0);
+		#pragma omp parallel num_threads(number_threads)
+		{
+			Array2D <double>	cdiagram_data(W, K, 0.0);
+			Array2D <double>	cdiagram_surr(W, K, 0.0);
+			Array2D <double>	pdiagram(W, K, 0.0);
+			Array2D <int>		counts(W, K, 0);
+			CumulativeSumsXC	sums_surrogate;
+			std::vector <double>	efficiency(W, 0.0);
+
+			#pragma omp for schedule(dynamic)
+			for (int p = 0; p < nr_pairs; p++) {
+				int	a = pair_node_a[p];
+				int	b = pair_node_b[p];
+				int	m;
+				counts.fill(0);
+				netOnZeroDXC_compute_cdiagram(cdiagram_data, sequences, a, b, L, W, false, 0);
+				for (m = 0; m < M; m++) {
+					netOnZeroDXC_initialize_cumulative_sums(sums_surrogate, surrogate_bank[a][m], surrogate_bank[b][m], 0);
+					netOnZeroDXC_compute_cdiagram_cumulative(cdiagram_surr, sums_surrogate, L, W, false, 0);
+					netOnZeroDXC_update_exceedance_counts(counts, cdiagram_data, cdiagram_surr, W);
+				}
+				netOnZeroDXC_convert_counts_to_pdiagram(pdiagram, counts, W, M);
+				netOnZeroDXC_compute_efficiency(efficiency.data(), pdiagram, BENCH_ALPHA);
+				matrix_elements[p] = netOnZeroDXC_compute_wmatrix_element(efficiency.data(), W, window_widths, BENCH_ETA);
+			}
+		}
+		double	end_wall = omp_get_wtime();
+		double	end_cpu = netOnZeroDXC_bench_cpu_time();
+		long	peak_rss = netOnZeroDXC_bench_peak_rss();
+		double	stage_wall[3] = {pairs_wall - start_wall, end_wall - pairs_wall, end_wall - start_wall};
+		double	stage_cpu[3] = {pairs_cpu - start_cpu, end_cpu - pairs_cpu, end_cpu - start_cpu};
+		const char *	stage_names[3] = {"pipeline_bank", "pipeline_pairs", "pipeline_total"};
+		const char *	stage_units[3] = {"surrogates", "pairs", "pairs"};
+		double	stage_work[3] = {(double) nr_tasks, (double) nr_pairs, (double) nr_pairs};
+		int	s;
+		for (s = 0; s < 3; s++) {
+			if (t == 0)
+				reference_time[s] = stage_wall[s];
+			BenchRecord	record;
+			record.benchmark = stage_names[s];
+			record.config = config;
+			record.threads = number_threads;
+			record.work = stage_work[s];
+			record.unit = stage_units[s];
+			record.wall_time = stage_wall[s];
+			record.cpu_time = stage_cpu[s];
+			record.speedup = (stage_wall[s] > 0.0)? reference_time[s] / stage_wall[s] : 0.0;
+			record.peak_rss_kb = peak_rss;
+			netOnZeroDXC_bench_print_record(output, record);
+		}
+	}
+}
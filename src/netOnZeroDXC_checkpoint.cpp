@@ -0,0 +1,459 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+	#include <io.h>
+	#define checkpoint_fseek _fseeki64
+	#define checkpoint_ftell _ftelli64
+#else
+	#include <unistd.h>
+	#define checkpoint_fseek fseeko
+	#define checkpoint_ftell ftello
+#endif
+
+#ifndef INCLUDED_IOFUNCTIONS
+	#include "netOnZeroDXC_io.hpp"
+	#define INCLUDED_IOFUNCTIONS
+#endif
+#ifndef INCLUDED_CHECKPOINT
+	#include "netOnZeroDXC_checkpoint.hpp"
+	#define INCLUDED_CHECKPOINT
+#endif
+
+int netOnZeroDXC_truncate_file (std::string, int64_t);
+
+void netOnZeroDXC_fill_checkpoint_header (CheckpointHeader & header, const std::vector < std::vector <double> > & sequences, const std::vector <int> & pair_node_a,
+					const std::vector <int> & pair_node_b, int W, int L, int K, int M, int chunk_size, int shift, unsigned int seed,
+					double adaptive_alpha, double adaptive_error)
+{
+	// Pairs are identified in the files by their position in the list: the list is part of the hash, along with the data
+	memset(&header, 0, sizeof(CheckpointHeader));
+	memcpy(header.magic, CHECKPOINT_MAGIC, 8);
+	header.nr_nodes = sequences.size();
+	header.length = (sequences.size())? sequences[0].size() : 0;
+	header.nr_widths = W;
+	header.basewidth = L;
+	header.nr_positions = K;
+	header.nr_surrogates = M;
+	header.chunk_size = chunk_size;
+	header.shift = shift;
+	header.seed = seed;
+	header.nr_pairs = pair_node_a.size();
+	header.adaptive_alpha = (adaptive_error > 0.0)? adaptive_alpha : 0.0;
+	header.adaptive_error = (adaptive_error > 0.0)? adaptive_error : 0.0;
+
+	uint64_t	hash = 14695981039346656037ULL;		// FNV-1a of the values of all sequences, then of the node indexes of all pairs
+	int	i, j;
+	size_t	b;
+	for (i = 0; i < sequences.size(); i++) {
+		for (j = 0; j < sequences[i].size(); j++) {
+			const unsigned char *	bytes = (const unsigned char *) &sequences[i][j];
+			for (b = 0; b < sizeof(double); b++) {
+				hash ^= bytes[b];
+				hash *= 1099511628211ULL;
+			}
+		}
+	}
+	for (i = 0; i < pair_node_a.size(); i++) {
+		int32_t			nodes[2] = {pair_node_a[i], pair_node_b[i]};
+		const unsigned char *	bytes = (const unsigned char *) nodes;
+		for (b = 0; b < sizeof(nodes); b++) {
+			hash ^= bytes[b];
+			hash *= 1099511628211ULL;
+		}
+	}
+	header.data_hash = hash;
+
+	return;
+}
+
+int netOnZeroDXC_open_checkpoint (CheckpointFiles & files, CheckpointState & state, const CheckpointHeader & header, std::string path, std::string prefix,
+				char delimiter, bool resume)
+{
+	// Without resume, or if no checkpoint exists, a new one is started. Returns 0 if ok, 2 if files cannot be read or written,
+	// 3 if the checkpoint is damaged, 4 if it belongs to a run with different data or parameters.
+	files.journal = NULL;
+	files.header = header;
+	files.journal_name = netOnZeroDXC_generate_filepath(path, prefix, "checkpoint", delimiter, "", "");
+	files.snapshot_name = netOnZeroDXC_generate_filepath(path, prefix, "checkpoint_partial", delimiter, "", "");
+	files.last_snapshot = time(NULL);
+
+	int	nr_pairs = header.nr_pairs;
+	state.status.assign(nr_pairs, CHECKPOINT_PAIR_NONE);
+	state.surrogates.assign(nr_pairs, 0);
+	state.journal_offset.assign(nr_pairs, -1);
+	state.partial_index.assign(nr_pairs, -1);
+	state.partial.clear();
+
+	bool	resumed = false;
+	if (resume) {
+		int64_t	valid_size;
+		int	error = netOnZeroDXC_read_checkpoint_journal(state, valid_size, files.journal_name, header);
+		if ((error == 3) || (error == 4))
+			return error;
+		if (!error) {
+			if (netOnZeroDXC_truncate_file(files.journal_name, valid_size))	// Drops a record left incomplete by a crash
+				return 2;
+			netOnZeroDXC_read_checkpoint_snapshot(state, files.snapshot_name, header);	// A missing or damaged snapshot only loses partial pairs
+			files.journal = fopen(files.journal_name.c_str(), "r+b");
+			if (!files.journal)
+				return 2;
+			resumed = true;
+		}
+	}
+
+	if (!resumed) {
+		remove(files.snapshot_name.c_str());
+		files.journal = fopen(files.journal_name.c_str(), "w+b");
+		if (!files.journal)
+			return 2;
+		if ((fwrite(&header, sizeof(CheckpointHeader), 1, files.journal) != 1) || fflush(files.journal)) {
+			fclose(files.journal);
+			files.journal = NULL;
+			return 2;
+		}
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_read_checkpoint_journal (CheckpointState & state, int64_t & valid_size, std::string file_name, const CheckpointHeader & header)
+{
+	// Returns 2 if there is no journal; completed pairs are marked in state, valid_size is the size up to the last complete record
+	FILE *	file_pointer = fopen(file_name.c_str(), "rb");
+	if (!file_pointer)
+		return 2;
+
+	CheckpointHeader	file_header;
+	if (fread(&file_header, sizeof(CheckpointHeader), 1, file_pointer) != 1) {
+		fclose(file_pointer);
+		return 2;				// Crashed right after creation: nothing to resume
+	}
+	if (memcmp(file_header.magic, CHECKPOINT_MAGIC, 8) != 0) {
+		fclose(file_pointer);
+		return 3;
+	}
+	if (memcmp(&file_header, &header, sizeof(CheckpointHeader)) != 0) {
+		fclose(file_pointer);
+		return 4;
+	}
+
+	size_t			nr_counts = (size_t) header.nr_widths * header.nr_positions;
+	int			nr_pairs = state.status.size();
+	int32_t			record[2];
+	std::vector <int32_t>	buffer(nr_counts);
+	valid_size = sizeof(CheckpointHeader);
+	while (fread(record, sizeof(int32_t), 2, file_pointer) == 2) {
+		if (fread(buffer.data(), sizeof(int32_t), nr_counts, file_pointer) != nr_counts)
+			break;
+		if ((record[0] < 0) || (record[0] >= nr_pairs) || (record[1] <= 0) || (record[1] > (int32_t) header.nr_surrogates)) {
+			fclose(file_pointer);
+			return 3;
+		}
+		state.status[record[0]] = CHECKPOINT_PAIR_DONE;
+		state.surrogates[record[0]] = record[1];
+		state.journal_offset[record[0]] = valid_size + 2 * sizeof(int32_t);
+		valid_size += (2 + nr_counts) * sizeof(int32_t);
+	}
+	fclose(file_pointer);
+
+	return 0;
+}
+
+int netOnZeroDXC_read_checkpoint_snapshot (CheckpointState & state, std::string file_name, const CheckpointHeader & header)
+{
+	FILE *	file_pointer = fopen(file_name.c_str(), "rb");
+	if (!file_pointer)
+		return 2;
+
+	CheckpointHeader	file_header;
+	if ((fread(&file_header, sizeof(CheckpointHeader), 1, file_pointer) != 1) || (memcmp(&file_header, &header, sizeof(CheckpointHeader)) != 0)) {
+		fclose(file_pointer);
+		return 3;
+	}
+
+	int	W = header.nr_widths;
+	int	K = header.nr_positions;
+	int	nr_chunks = (header.nr_surrogates + header.chunk_size - 1) / header.chunk_size;
+	int	nr_pairs = state.status.size();
+	int	l;
+	int32_t			record[3];
+	std::vector <int32_t>	buffer(K);
+	PairProgress		progress;
+	while (fread(record, sizeof(int32_t), 3, file_pointer) == 3) {
+		if ((record[0] < 0) || (record[0] >= nr_pairs) || (record[1] < 0) || (record[1] > (int32_t) header.nr_surrogates) || (record[2] != nr_chunks))
+			break;
+		netOnZeroDXC_initialize_pair_progress(progress, nr_chunks, W, K);
+		progress.pair = record[0];
+		progress.surrogates = record[1];
+		bool	complete = (fread(progress.chunks_done.data(), 1, nr_chunks, file_pointer) == nr_chunks);
+		for (l = 0; (l < W) && complete; l++) {
+			complete = (fread(buffer.data(), sizeof(int32_t), K, file_pointer) == K);
+			if (complete)
+				std::copy(buffer.begin(), buffer.end(), progress.counts[l]);
+		}
+		if (!complete)
+			break;
+		if (state.status[progress.pair] != CHECKPOINT_PAIR_NONE)	// Completed in the meantime
+			continue;
+		state.status[progress.pair] = CHECKPOINT_PAIR_PARTIAL;
+		state.surrogates[progress.pair] = progress.surrogates;
+		state.partial_index[progress.pair] = state.partial.size();
+		state.partial.push_back(progress);
+	}
+	fclose(file_pointer);
+
+	return 0;
+}
+
+int netOnZeroDXC_append_checkpoint_pair (CheckpointFiles & files, int pair, int surrogates, ArrayView2D <const int> counts)
+{
+	// Not thread safe: callers serialize all accesses to the checkpoint
+	if (!files.journal)
+		return 1;
+
+	int32_t			record[2] = {pair, surrogates};
+	std::vector <int32_t>	buffer(counts.cols());
+	bool	failed = (checkpoint_fseek(files.journal, 0, SEEK_END) != 0);
+	failed = failed || (fwrite(record, sizeof(int32_t), 2, files.journal) != 2);
+	int	l;
+	for (l = 0; (l < counts.rows()) && !failed; l++) {
+		std::copy(counts[l], counts[l] + counts.cols(), buffer.begin());
+		failed = (fwrite(buffer.data(), sizeof(int32_t), buffer.size(), files.journal) != buffer.size());
+	}
+	failed = failed || fflush(files.journal);
+
+	return (failed)? 1 : 0;
+}
+
+int netOnZeroDXC_read_checkpoint_pair (CheckpointFiles & files, const CheckpointState & state, int pair, ArrayView2D <int> counts)
+{
+	// Counts of a pair completed before resuming; not thread safe, as netOnZeroDXC_append_checkpoint_pair
+	if (!files.journal || (state.journal_offset[pair] < 0))
+		return 1;
+
+	std::vector <int32_t>	buffer(counts.cols());
+	bool	failed = (checkpoint_fseek(files.journal, state.journal_offset[pair], SEEK_SET) != 0);
+	int	l;
+	for (l = 0; (l < counts.rows()) && !failed; l++) {
+		failed = (fread(buffer.data(), sizeof(int32_t), buffer.size(), files.journal) != buffer.size());
+		if (!failed)
+			std::copy(buffer.begin(), buffer.end(), counts[l]);
+	}
+
+	return (failed)? 1 : 0;
+}
+
+int netOnZeroDXC_save_checkpoint_snapshot (CheckpointFiles & files, const CheckpointState & state, const std::vector <PairProgress> & progress)
+{
+	// Pairs in progress, plus the partial pairs recovered when resuming that have not been taken up again yet (pair >= 0 in state.partial).
+	// Written to a temporary file and then renamed, so that a crash never leaves a half-written snapshot.
+	std::string	temp_name = files.snapshot_name + ".tmp";
+	FILE *	file_pointer = fopen(temp_name.c_str(), "wb");
+	if (!file_pointer)
+		return 1;
+
+	bool	failed = (fwrite(&files.header, sizeof(CheckpointHeader), 1, file_pointer) != 1);
+	int	i, l;
+	std::vector <int32_t>	buffer;
+	for (i = 0; (i < progress.size() + state.partial.size()) && !failed; i++) {
+		const PairProgress &	current = (i < progress.size())? progress[i] : state.partial[i - progress.size()];
+		if (current.pair < 0)
+			continue;
+		int32_t	record[3] = {current.pair, current.surrogates, (int32_t) current.chunks_done.size()};
+		failed = (fwrite(record, sizeof(int32_t), 3, file_pointer) != 3);
+		failed = failed || (fwrite(current.chunks_done.data(), 1, current.chunks_done.size(), file_pointer) != current.chunks_done.size());
+		buffer.resize(current.counts.cols());
+		for (l = 0; (l < current.counts.rows()) && !failed; l++) {
+			std::copy(current.counts[l], current.counts[l] + current.counts.cols(), buffer.begin());
+			failed = (fwrite(buffer.data(), sizeof(int32_t), buffer.size(), file_pointer) != buffer.size());
+		}
+	}
+
+	if ((fclose(file_pointer) == EOF) || failed) {
+		remove(temp_name.c_str());
+		return 1;
+	}
+	if (rename(temp_name.c_str(), files.snapshot_name.c_str()) != 0) {	// Windows does not replace an existing file
+		remove(files.snapshot_name.c_str());
+		if (rename(temp_name.c_str(), files.snapshot_name.c_str()) != 0)
+			return 1;
+	}
+	files.last_snapshot = time(NULL);
+
+	return 0;
+}
+
+bool netOnZeroDXC_checkpoint_due (const CheckpointFiles & files)
+{
+	return (difftime(time(NULL), files.last_snapshot) >= CHECKPOINT_INTERVAL);
+}
+
+void netOnZeroDXC_close_checkpoint (CheckpointFiles & files, bool remove_files)
+{
+	// Files are removed once the run they belong to has been completed
+	if (!files.journal)
+		return;
+	fclose(files.journal);
+	files.journal = NULL;
+	if (remove_files) {
+		remove(files.journal_name.c_str());
+		remove(files.snapshot_name.c_str());
+	}
+
+	return;
+}
+
+int netOnZeroDXC_open_shard_file (CheckpointFiles & files, const CheckpointHeader & header, std::string path, std::string prefix, char delimiter, int shard)
+{
+	// A new shard file, to be filled by netOnZeroDXC_append_checkpoint_pair and closed by netOnZeroDXC_close_checkpoint (files kept).
+	// Returns 0 if ok, 2 if the file cannot be written.
+	std::stringstream	label;
+	label << "shard" << delimiter << shard;
+	files.journal = NULL;
+	files.header = header;
+	files.journal_name = netOnZeroDXC_generate_filepath(path, prefix, label.str(), delimiter, "", "");
+	files.snapshot_name = "";
+	files.last_snapshot = time(NULL);
+
+	files.journal = fopen(files.journal_name.c_str(), "w+b");
+	if (!files.journal)
+		return 2;
+	if ((fwrite(&header, sizeof(CheckpointHeader), 1, files.journal) != 1) || fflush(files.journal)) {
+		fclose(files.journal);
+		files.journal = NULL;
+		return 2;
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_read_shard_file (CheckpointFiles & files, CheckpointState & state, const CheckpointHeader & header, std::string path, std::string prefix,
+				char delimiter, int shard)
+{
+	// The pairs found in a shard file are marked as completed in state, and their counts are read with netOnZeroDXC_read_checkpoint_pair.
+	// Returns 0 if ok, 2 if the file cannot be read, 3 if it is damaged or incomplete, 4 if it belongs to a run with different data or parameters.
+	std::stringstream	label;
+	label << "shard" << delimiter << shard;
+	files.journal = NULL;
+	files.header = header;
+	files.journal_name = netOnZeroDXC_generate_filepath(path, prefix, label.str(), delimiter, "", "");
+	files.snapshot_name = "";
+
+	int	nr_pairs = header.nr_pairs;
+	state.status.assign(nr_pairs, CHECKPOINT_PAIR_NONE);
+	state.surrogates.assign(nr_pairs, 0);
+	state.journal_offset.assign(nr_pairs, -1);
+	state.partial_index.assign(nr_pairs, -1);
+	state.partial.clear();
+
+	int64_t	valid_size;
+	int	error = netOnZeroDXC_read_checkpoint_journal(state, valid_size, files.journal_name, header);
+	if (error)
+		return error;
+	files.journal = fopen(files.journal_name.c_str(), "rb");
+	if (!files.journal)
+		return 2;
+	checkpoint_fseek(files.journal, 0, SEEK_END);
+	if (checkpoint_ftell(files.journal) != valid_size) {		// A shard that did not end writes a record only in part
+		fclose(files.journal);
+		files.journal = NULL;
+		return 3;
+	}
+
+	return 0;
+}
+
+void netOnZeroDXC_initialize_pair_progress (PairProgress & progress, int nr_chunks, int W, int K)
+{
+	progress.pair = -1;
+	progress.surrogates = 0;
+	progress.chunks_done.assign(nr_chunks, 0);
+	progress.counts.resize(W, K, 0);
+
+	return;
+}
+
+bool netOnZeroDXC_check_chunks_prefix (const PairProgress & progress)
+{
+	// True if the counted chunks are the first ones, as when the surrogates of a pair are used in order
+	int	c = 0;
+	while ((c < progress.chunks_done.size()) && progress.chunks_done[c])
+		c++;
+	while ((c < progress.chunks_done.size()) && !progress.chunks_done[c])
+		c++;
+
+	return (c == progress.chunks_done.size());
+}
+
+void netOnZeroDXC_collect_open_pairs (std::vector <PairProgress> & progress, const Array3D <int> & pair_counts, const std::vector <int> & pair_next,
+				const std::vector <char> & pair_open, int m_first, int nr_chunks, int chunk_size)
+{
+	// Progress of the pairs left open between two blocks of surrogates: their counts are kept per pair, and cover surrogates m_first to pair_next - 1
+	int	W = pair_counts.rows();
+	int	K = pair_counts.cols();
+	progress.clear();
+	for (int i = 0; i < pair_open.size(); i++) {
+		if (!pair_open[i] || (pair_next[i] == m_first))
+			continue;
+		progress.push_back(PairProgress());
+		PairProgress &	current = progress.back();
+		netOnZeroDXC_initialize_pair_progress(current, nr_chunks, W, K);
+		current.pair = i;
+		current.surrogates = pair_next[i];
+		std::fill(current.chunks_done.begin(), current.chunks_done.begin() + pair_next[i] / chunk_size, 1);
+		std::copy(pair_counts[i].data(), pair_counts[i].data() + (size_t) W * K, current.counts.data());
+	}
+
+	return;
+}
+
+int netOnZeroDXC_truncate_file (std::string file_name, int64_t size)
+{
+#ifdef _WIN32
+	FILE *	file_pointer = fopen(file_name.c_str(), "r+b");
+	if (!file_pointer)
+		return 1;
+	int	error = _chsize_s(_fileno(file_pointer), size);
+	fclose(file_pointer);
+	return (error)? 1 : 0;
+#else
+	return (truncate(file_name.c_str(), size))? 1 : 0;
+#endif
+}
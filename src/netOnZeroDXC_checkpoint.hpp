@@ -0,0 +1,111 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
+
+// A checkpoint consists of two files in the output folder, both beginning with a CheckpointHeader, in the byte order of the machine:
+//	[prefix_]checkpoint.dat, a journal to which a record is appended as soon as a pair is completed:
+//		int32 pair, int32 surrogates used, W x K int32 exceedance counts (row-major)
+//	[prefix_]checkpoint_partial.dat, rewritten every CHECKPOINT_INTERVAL seconds and when a run is cancelled, with the pairs in progress:
+//		int32 pair, int32 surrogates counted, int32 nr. of chunks, one byte per chunk (1 = counted), W x K int32 exceedance counts
+// The m-th surrogate of a node draws from the stream of (seed, node, m) only: the seed in the header is all that is needed to continue a run.
+// A run split among processes writes one file per shard, [prefix_]shard_<#>.dat, in the format of the journal: the counts of its pairs,
+// or of its range of surrogates of every pair, which are then added up by the merge step.
+#define CHECKPOINT_MAGIC "NZDXCKP2"		// 2: surrogates drawn from Philox streams (netOnZeroDXC_surrogate_stream)
+#define CHECKPOINT_INTERVAL 600			// Seconds between two snapshots of the pairs in progress
+
+#define CHECKPOINT_PAIR_NONE 0
+#define CHECKPOINT_PAIR_PARTIAL 1
+#define CHECKPOINT_PAIR_DONE 2
+
+struct CheckpointHeader {			// Data and parameters of a run: a checkpoint is resumed only if all of them match
+	char		magic[8];
+	uint32_t	nr_nodes;
+	uint32_t	length;
+	uint32_t	nr_widths;
+	uint32_t	basewidth;
+	uint32_t	nr_positions;
+	uint32_t	nr_surrogates;
+	uint32_t	chunk_size;
+	int32_t		shift;
+	uint32_t	seed;
+	uint32_t	nr_pairs;
+	double		adaptive_alpha;
+	double		adaptive_error;
+	uint64_t	data_hash;
+};
+
+struct PairProgress {
+	int			pair;			// -1 if the slot is not in use
+	int			surrogates;
+	std::vector <char>	chunks_done;		// Chunks of chunk_size surrogates already counted
+	Array2D <int>		counts;
+};
+
+struct CheckpointState {			// Progress recovered when resuming
+	std::vector <int>		status;			// Per pair, CHECKPOINT_PAIR_*
+	std::vector <int>		surrogates;		// Surrogates used (completed pairs) or counted (partial pairs)
+	std::vector <int64_t>		journal_offset;		// Completed pairs: position of their counts in the journal
+	std::vector <int>		partial_index;		// Partial pairs: position in 'partial', otherwise -1
+	std::vector <PairProgress>	partial;
+};
+
+struct CheckpointFiles {
+	FILE			*journal;
+	std::string		journal_name;
+	std::string		snapshot_name;
+	CheckpointHeader	header;
+	time_t			last_snapshot;
+};
+
+void netOnZeroDXC_fill_checkpoint_header (CheckpointHeader &, const std::vector < std::vector <double> > &, const std::vector <int> &, const std::vector <int> &,
+					int, int, int, int, int, int, unsigned int, double, double);
+int netOnZeroDXC_open_checkpoint (CheckpointFiles &, CheckpointState &, const CheckpointHeader &, std::string, std::string, char, bool);
+int netOnZeroDXC_read_checkpoint_journal (CheckpointState &, int64_t &, std::string, const CheckpointHeader &);
+int netOnZeroDXC_read_checkpoint_snapshot (CheckpointState &, std::string, const CheckpointHeader &);
+int netOnZeroDXC_append_checkpoint_pair (CheckpointFiles &, int, int, ArrayView2D <const int>);
+int netOnZeroDXC_read_checkpoint_pair (CheckpointFiles &, const CheckpointState &, int, ArrayView2D <int>);
+int netOnZeroDXC_save_checkpoint_snapshot (CheckpointFiles &, const CheckpointState &, const std::vector <PairProgress> &);
+bool netOnZeroDXC_checkpoint_due (const CheckpointFiles &);
+void netOnZeroDXC_close_checkpoint (CheckpointFiles &, bool);
+int netOnZeroDXC_open_shard_file (CheckpointFiles &, const CheckpointHeader &, std::string, std::string, char, int);
+int netOnZeroDXC_read_shard_file (CheckpointFiles &, CheckpointState &, const CheckpointHeader &, std::string, std::string, char, int);
+void netOnZeroDXC_initialize_pair_progress (PairProgress &, int, int, int);
+bool netOnZeroDXC_check_chunks_prefix (const PairProgress &);
+void netOnZeroDXC_collect_open_pairs (std::vector <PairProgress> &, const Array3D <int> &, const std::vector <int> &, const std::vector <char> &, int, int, int);
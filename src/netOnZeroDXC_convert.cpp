@@ -0,0 +1,199 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef INCLUDED_IOFUNCTIONS
+	#include "netOnZeroDXC_io.hpp"
+	#define INCLUDED_IOFUNCTIONS
+#endif
+#ifndef INCLUDED_IOBINARY
+	#include "netOnZeroDXC_io_binary.hpp"
+	#define INCLUDED_IOBINARY
+#endif
+
+void netOnZeroDXC_conv_help (char *);
+int netOnZeroDXC_conv_parse_options (int, char **, bool &, bool &, std::string &, std::string &, std::string &, char &);
+int netOnZeroDXC_conv_save_text (const std::vector < std::vector <double> > &, std::string, char, bool);
+
+int main(int argc, char *argv[]) {
+
+	bool	single_precision = false;
+	bool	rows_as_channels = false;
+	char	separator_char = 't';
+	std::string	selected_input_filename;
+	std::string	selected_output_filename;
+	std::string	selected_labels_filename;
+
+	int error;
+	error = netOnZeroDXC_conv_parse_options (argc, argv, single_precision, rows_as_channels, selected_input_filename, selected_output_filename, selected_labels_filename, separator_char);
+	if (error)
+		exit(1);
+
+	std::vector < std::vector <double> > 	loaded_sequences;
+	std::vector <std::string>		node_labels;
+	BinaryFileHeader	header;
+	bool	input_is_binary = (netOnZeroDXC_read_binary_header(header, selected_input_filename) == 0);
+	if (input_is_binary)
+		rows_as_channels = (header.flags & BINARY_FLAG_ROWS);
+
+	if (rows_as_channels) {
+		error = netOnZeroDXC_load_single_table(loaded_sequences, selected_input_filename, separator_char);
+		if (!error)
+			error = netOnZeroDXC_check_linear_sizes(loaded_sequences);
+	} else {
+		error = netOnZeroDXC_load_single_file(loaded_sequences, node_labels, selected_input_filename, separator_char);
+	}
+	if (error == 2) {
+		std::cerr << "ERROR: cannot read the selected file '" << selected_input_filename << "'.\n";
+		exit(1);
+	}
+	if (error) {
+		std::cerr << "ERROR: inconsistent sizes found, or only one sequence detected.\n";
+		exit(1);
+	}
+
+	if (input_is_binary) {							// Binary -> text, with the orientation stored in the file
+		error = netOnZeroDXC_conv_save_text(loaded_sequences, selected_output_filename, separator_char, rows_as_channels);
+	} else {								// Text -> binary
+		if (selected_labels_filename.size()) {
+			error = netOnZeroDXC_load_labels_dictionary(node_labels, selected_labels_filename, separator_char);
+			if (error || (node_labels.size() != loaded_sequences.size())) {
+				std::cerr << "ERROR: the labels file '" << selected_labels_filename << "' cannot be read, or does not match the number of sequences.\n";
+				exit(1);
+			}
+		}
+		if (rows_as_channels)
+			node_labels.clear();
+		error = netOnZeroDXC_save_binary_file(loaded_sequences, node_labels, selected_output_filename, (single_precision)? 4 : 8, (rows_as_channels)? BINARY_FLAG_ROWS : 0);
+	}
+	if (error) {
+		std::cerr << "ERROR: i/o error when writing data on file '" << selected_output_filename << "'. Please check permissions.\n";
+		exit(1);
+	}
+
+	return 0;
+}
+
+void netOnZeroDXC_conv_help (char *program_name)
+{
+	std::cerr << "Usage:\n";
+	std::cerr << "\t" << program_name << " -i <fname> -o <fname> (<Options>)\n";
+	std::cerr << "\nConverts a text file of sequences (one per column) to the binary format read by all the programs of the package,\n";
+	std::cerr << "or a binary file back to text. The direction is chosen according to the input file.\n";
+	std::cerr << "\nMandatory assignment:\n";
+	std::cerr << "\t-i <fname>\tread from file 'fname';\n";
+	std::cerr << "\t-o <fname>\twrite to file 'fname'.\n";
+
+	std::cerr << "\nOptions:\n";
+	std::cerr << "\t-l <fname>\tstore the node labels listed in the dictionary file 'fname' (text to binary only);\n";
+	std::cerr << "\t-f32\t\tstore values in single precision (text to binary only; default is double precision);\n";
+	std::cerr << "\t-rows\t\tstore each row as a channel, e.g. for diagrams to be read by netOnZeroDXC_efficiency (text to binary only);\n";
+	std::cerr << "\t-s <@>\t\tset column separator, default t (TAB); other options are s (space) or c (comma ',').\n";
+
+	std::cerr << "\n\t-h or --help\tshow this help.\n";
+}
+
+int netOnZeroDXC_conv_parse_options (int argc, char *argv[], bool & single_precision, bool & rows_as_channels, std::string & input_filename, std::string & output_filename,
+				std::string & labels_filename, char & separator_char)
+{
+	int	n = 1;
+	while (n < argc) {
+		if (strcmp(argv[n], "-i") == 0) {
+			n++;
+			input_filename = argv[n];
+		} else if (strcmp(argv[n], "-o") == 0) {
+			n++;
+			output_filename = argv[n];
+		} else if (strcmp(argv[n], "-l") == 0) {
+			n++;
+			labels_filename = argv[n];
+		} else if (strcmp(argv[n], "-s") == 0) {
+			n++;
+			separator_char = argv[n][0];
+
+		} else if (strcmp(argv[n], "-f32") == 0) {
+			single_precision = true;
+		} else if (strcmp(argv[n], "-rows") == 0) {
+			rows_as_channels = true;
+
+		} else if ((strcmp("-h", argv[n]) == 0) || (strcmp("--help", argv[n]) == 0))  {
+			netOnZeroDXC_conv_help(argv[0]);
+			exit(0);
+		}
+		n++;
+	}
+
+	if ((input_filename.size() == 0) || (output_filename.size() == 0)) {
+		std::cerr << "ERROR: input and output files were not correctly set. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (separator_char == 's') {
+		separator_char = ' ';
+	} else if (separator_char == 'c') {
+		separator_char = ',';
+	} else {
+		separator_char = '\t';
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_conv_save_text (const std::vector < std::vector <double> > & sequences, std::string file_name, char separator, bool rows_as_channels)
+{
+	FILE *	file_pointer;
+	file_pointer = fopen(file_name.c_str(), "w");
+	if (!file_pointer)
+		return 1;
+
+	int	i, j;
+	int	nr_lines = (rows_as_channels)? sequences.size() : sequences[0].size();
+	int	nr_fields = (rows_as_channels)? sequences[0].size() : sequences.size();
+	for (j = 0; j < nr_lines; j++) {				// Full precision, so that a text -> binary -> text round trip is lossless
+		for (i = 0; i < nr_fields; i++) {
+			double	value = (rows_as_channels)? sequences[j][i] : sequences[i][j];
+			if (i == 0)
+				fprintf(file_pointer, "%.17g", value);
+			else
+				fprintf(file_pointer, "%c%.17g", separator, value);
+		}
+		fprintf(file_pointer, "\n");
+	}
+
+	if(fclose(file_pointer) == EOF)
+		return 1;
+
+	return 0;
+}
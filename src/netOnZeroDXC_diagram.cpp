@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <cmath>
 #include <ctime>
+#include <cstdio>
 #include <cstring>
 #include <algorithm>
 #include <iostream>
@@ -48,44 +49,154 @@
 	#include "netOnZeroDXC_io.hpp"
 	#define INCLUDED_IOFUNCTIONS
 #endif
+#ifndef INCLUDED_CHECKPOINT
+	#include "netOnZeroDXC_checkpoint.hpp"
+	#define INCLUDED_CHECKPOINT
+#endif
+#ifndef INCLUDED_IORESULTS
+	#include "netOnZeroDXC_io_results.hpp"
+	#define INCLUDED_IORESULTS
+#endif
+#ifndef INCLUDED_TIMING
+	#include "netOnZeroDXC_timing.hpp"
+	#define INCLUDED_TIMING
+#endif
+#ifndef INCLUDED_INCREMENTAL
+	#include "netOnZeroDXC_incremental.hpp"
+	#define INCLUDED_INCREMENTAL
+#endif
+#ifndef INCLUDED_ENGINE
+	#include "netOnZeroDXC_engine.hpp"
+	#define INCLUDED_ENGINE
+#endif
+#ifdef NETONZERODXC_USE_CUDA
+	#ifndef INCLUDED_GPU
+		#include "netOnZeroDXC_gpu.hpp"
+		#define INCLUDED_GPU
+	#endif
+#endif
+
+struct DiagramOptions {				// Command line, see netOnZeroDXC_xc_help; defaults set by netOnZeroDXC_xc_initialize_options
+	bool		read_from_file;
+	bool		write_to_file;
+	bool		print_corr_diagram;
+	bool		compute_pvalue_diagram;
+	bool		enable_parallel_computing;
+	bool		batch_all_pairs;
+	bool		write_checkpoint;
+	bool		resume_checkpoint;
+	bool		write_container;
+	bool		compress_container;
+	bool		print_timing;
+	bool		split_surrogates;
+	int		index_a, index_b;		// Column numbers, from 1, of the pair of -n
+	int		shard_index, nr_shards, merge_shards;
+	int		gpu_device;			// -1: no GPU
+	int		follow_columns;			// 0: the whole input at once
+	int		memory_limit;			// MB of surrogates kept at once in batch mode; 0: see netOnZeroDXC_surrogate_block_size
+	double		follow_alpha, follow_eta;
+	int		apply_tau;			// <= 0: no delay
+	std::vector <int>	tau_list;		// Empty unless -tau-list
+	int		nr_window_widths, window_basewidth, nr_surrogates;
+	unsigned int	random_seed;
+	double		adaptive_alpha, adaptive_error;	// -1: no adaptive stopping
+	char		separator_char;
+	std::string	input_filename;
+	std::string	output_filename;
+	std::string	pairs_filename;
+	std::string	output_folder;
+	std::string	output_prefix;
+	std::string	timing_filename;
+};
+
+struct DiagramEngineProgress {			// User data of the engine callbacks of netOnZeroDXC_xc_run_engine
+	RunTiming *	timing;
+	StageClock	stage_clock;			// Since the last change of engine stage
+	int		stage;				// Timing stage running: TIMING_STAGE_CDIAGRAM until the first callback
+	int		old_progress;			// Tenths of the p value tasks reported
+	bool		report_progress;
+	double		start_time;
+};
 
 void netOnZeroDXC_xc_help (char *);
-int netOnZeroDXC_xc_parse_options (int, char **, bool &, bool &, bool &, bool &, bool &, int &, int &, int &, int &, int &, int &, std::string &, std::string &, char &);
+void netOnZeroDXC_xc_initialize_options (DiagramOptions &);
+int netOnZeroDXC_xc_parse_options (int, char **, DiagramOptions &);
+int netOnZeroDXC_xc_count_threads (const DiagramOptions &);
+int netOnZeroDXC_xc_parse_delays (std::vector <int> &, const char *);
 int netOnZeroDXC_xc_check_sequences (const std::vector < std::vector <double> > &, int, int, int, int &, int);
+int netOnZeroDXC_xc_list_batch_pairs (std::vector <int> &, std::vector <int> &, bool, std::string, int, char);
+int netOnZeroDXC_xc_run_batch (const DiagramOptions &, const std::vector < std::vector <double> > &, const std::vector <std::string> &, const std::vector <int> &,
+				const std::vector <int> &, RunTiming &);
+int netOnZeroDXC_xc_run_engine (const DiagramOptions &, const std::vector < std::vector <double> > &, const std::vector <std::string> &, const std::vector <int> &,
+				const std::vector <int> &, RunTiming &);
+void netOnZeroDXC_xc_report_engine_progress (void *, int, long, long);
+int netOnZeroDXC_xc_generate_bank (std::vector < std::vector < std::vector <double> > > &, const std::vector < std::vector <double> > &, const std::vector <int> &,
+				int, int, int, unsigned int, int, RunTiming &);
+int netOnZeroDXC_xc_run_batch_multitau (const DiagramOptions &, const std::vector < std::vector <double> > &, const std::vector <std::string> &, const std::vector <int> &,
+				const std::vector <int> &, RunTiming &);
+#ifdef NETONZERODXC_USE_CUDA
+int netOnZeroDXC_xc_run_batch_gpu (const DiagramOptions &, const std::vector < std::vector <double> > &, const std::vector <std::string> &, const std::vector <int> &,
+				const std::vector <int> &, RunTiming &);
+#endif
+int netOnZeroDXC_xc_merge_shards (const DiagramOptions &, const std::vector < std::vector <double> > &, const std::vector <std::string> &, const std::vector <int> &,
+				const std::vector <int> &, RunTiming &);
+int netOnZeroDXC_xc_compute_adaptive_counts (Array2D <int> &, const std::vector < std::vector <double> > &, int, int, ArrayView2D <const double>, int, int, int, int,
+				unsigned int, const SequentialStopRule &, int, RunTiming &);
+int netOnZeroDXC_xc_run_follow (const DiagramOptions &);
+int netOnZeroDXC_xc_read_stdin_rows (std::vector < std::vector <double> > &, int, int, char);
+int netOnZeroDXC_xc_report_timing (RunTiming &, bool, std::string);
 
 int main(int argc, char *argv[]) {
 
-	bool	read_from_file = false;
-	bool	write_to_file = false;
-	bool	print_corr_diagram = false;
-	bool	compute_pvalue_diagram = false;
-	bool	enable_parallel_computing = false;
-	int	index_a = -1, index_b = -1;
-	int	apply_tau = -1;
-	int	nr_window_widths = -1, window_basewidth = -1, nr_surrogates = 100;
-	char	separator_char = 't';
-	std::string	selected_input_filename;
-	std::string	selected_output_filename;
+	DiagramOptions	options;
+	netOnZeroDXC_xc_initialize_options(options);
 
 	int error;
-	error = netOnZeroDXC_xc_parse_options (argc, argv, read_from_file, write_to_file, print_corr_diagram, compute_pvalue_diagram, enable_parallel_computing, index_a, index_b,
-					apply_tau, nr_window_widths, window_basewidth, nr_surrogates, selected_input_filename, selected_output_filename, separator_char);
+	error = netOnZeroDXC_xc_parse_options(argc, argv, options);
 	if (error)
 		exit(1);
+	bool	batch_mode = (options.batch_all_pairs || options.pairs_filename.size());
+	int	number_threads = netOnZeroDXC_xc_count_threads(options);
+
+	RunTiming	run_timing;
+	StageClock	stage_clock;
+	netOnZeroDXC_initialize_run_timing(run_timing, number_threads);
+	netOnZeroDXC_start_clock(stage_clock);
+
+	SequentialStopRule	stop_rule;				// Left empty (step = 0) unless adaptive stopping was requested
+	netOnZeroDXC_initialize_stop_rule(stop_rule, options.nr_surrogates, SEQUENTIAL_STOP_STEP, options.adaptive_alpha, options.adaptive_error);
+
+	if (options.follow_columns > 0) {				// Rows are analyzed as they come, without waiting for the end of the stream
+		error = netOnZeroDXC_xc_run_follow(options);
+		if (error == 2) {
+			std::cerr << "ERROR: cannot read the selected file '" << options.input_filename << "'.\n";
+			exit(1);
+		} else if (error == 3) {
+			std::cerr << "ERROR: inconsistent sequences sizes found, or only one sequence detected.\n";
+			exit(1);
+		} else if (error == 5) {
+			std::cerr << "ERROR: windowing settings are invalid: the stream ended before the first column of the diagrams.\n";
+			exit(1);
+		} else if (error == 1) {
+			std::cerr << "ERROR: i/o error when writing efficiencies in folder '" << options.output_folder << "'. Please check permissions.\n";
+			exit(1);
+		}
+		exit(error? 1 : 0);					// 4: the list of pairs was rejected, and the reason already reported
+	}
 
 	std::vector < std::vector <double> > 	loaded_sequences;
-	std::vector <std::string>		dummy_node_labels;
+	std::vector <std::string>		node_labels;
 
-	if (read_from_file) {
-		error = netOnZeroDXC_load_single_file(loaded_sequences, dummy_node_labels, selected_input_filename, separator_char);
+	if (options.read_from_file) {
+		error = netOnZeroDXC_load_single_file(loaded_sequences, node_labels, options.input_filename, options.separator_char);
 		if (error == 2) {
-			std::cerr << "ERROR: cannot read the selected file '" << selected_input_filename << "'.\n";
+			std::cerr << "ERROR: cannot read the selected file '" << options.input_filename << "'.\n";
 			exit(1);
 		}
 	} else {
 		std::vector < std::vector <double> > 	temp_data_table;
 		std::vector <double>			temp_sequence;
-		netOnZeroDXC_load_stdin(temp_data_table, separator_char);
+		netOnZeroDXC_load_stdin(temp_data_table, options.separator_char);
 		int	i, j;
 		for (i = 0; i < temp_data_table[0].size(); i++) {
 			temp_sequence.clear();
@@ -95,127 +206,245 @@ int main(int argc, char *argv[]) {
 			loaded_sequences.push_back(temp_sequence);
 		}
 		error = netOnZeroDXC_check_linear_sizes(loaded_sequences);
+		char	temp_label[16];
+		for (i = 0; i < loaded_sequences.size(); i++) {
+			if ((i+1) < 10)
+				sprintf(temp_label, "0%d", i + 1);
+			else
+				sprintf(temp_label, "%d", i + 1);
+			node_labels.push_back(std::string(temp_label));
+		}
 	}
 	if ((error == 3) || (error == 5)) {
 		std::cerr << "ERROR: inconsistent sequences sizes found, or only one sequence detected.\n";
 		exit(1);
 	}
-        error = netOnZeroDXC_xc_check_sequences(loaded_sequences, index_a, index_b, nr_window_widths, window_basewidth, apply_tau);
+	netOnZeroDXC_stop_clock(run_timing, TIMING_STAGE_LOAD, stage_clock, loaded_sequences.size());
+
+	if (batch_mode) {							// Many pairs out of a single loading: one diagram file per pair
+		std::vector <int>	pair_node_a, pair_node_b;
+		if (options.tau_list.size())					// The largest delay leaves the fewest columns
+			options.apply_tau = *std::max_element(options.tau_list.begin(), options.tau_list.end());
+		error = netOnZeroDXC_xc_check_sequences(loaded_sequences, 1, 1, options.nr_window_widths, options.window_basewidth, options.apply_tau);
+		if (error)
+			exit(1);
+		error = netOnZeroDXC_xc_list_batch_pairs(pair_node_a, pair_node_b, options.batch_all_pairs, options.pairs_filename, loaded_sequences.size(),
+						options.separator_char);
+		if (error)
+			exit(1);
+		if (options.tau_list.size()) {					// One pass for all delays, sharing surrogates and cumulative sums
+			error = netOnZeroDXC_xc_run_batch_multitau(options, loaded_sequences, node_labels, pair_node_a, pair_node_b, run_timing);
+			if (error) {
+				std::cerr << "ERROR: i/o error when writing diagrams in folder '" << options.output_folder << "'. Please check permissions.\n";
+				exit(1);
+			}
+			exit(netOnZeroDXC_xc_report_timing(run_timing, options.print_timing, options.timing_filename));
+		}
+		if (options.merge_shards > 0) {					// The shards were computed by netOnZeroDXC_xc_run_batch, possibly on other machines
+			error = netOnZeroDXC_xc_merge_shards(options, loaded_sequences, node_labels, pair_node_a, pair_node_b, run_timing);
+			if (error == 2) {
+				std::cerr << "ERROR: cannot read the shard files in folder '" << options.output_folder << "'.\n";
+				exit(1);
+			} else if (error == 3) {
+				std::cerr << "ERROR: a shard file in folder '" << options.output_folder << "' is damaged, or its shard did not end.\n";
+				exit(1);
+			} else if (error == 4) {
+				std::cerr << "ERROR: the shard files in folder '" << options.output_folder << "' belong to a run with different data, pairs or parameters.\n";
+				exit(1);
+			} else if (error == 5) {
+				std::cerr << "ERROR: the shard files in folder '" << options.output_folder << "' do not hold all pairs and surrogates of the run; check the number of shards.\n";
+				exit(1);
+			} else if (error) {
+				std::cerr << "ERROR: i/o error when writing diagrams in folder '" << options.output_folder << "'. Please check permissions.\n";
+				exit(1);
+			}
+			exit(netOnZeroDXC_xc_report_timing(run_timing, options.print_timing, options.timing_filename));
+		}
+#ifdef NETONZERODXC_USE_CUDA
+		if ((options.gpu_device >= 0) && !options.print_corr_diagram) {	// Correlation diagrams alone are not worth a device
+			error = netOnZeroDXC_xc_run_batch_gpu(options, loaded_sequences, node_labels, pair_node_a, pair_node_b, run_timing);
+			if (error == 5) {
+				std::cerr << "ERROR: the computation on GPU " << options.gpu_device << " failed.\n";
+				exit(1);
+			} else if (error == 6) {
+				std::cerr << "ERROR: GPU " << options.gpu_device << " has not enough free memory for one surrogate of each node.\n";
+				exit(1);
+			} else if (error) {
+				std::cerr << "ERROR: i/o error when writing diagrams in folder '" << options.output_folder << "'. Please check permissions.\n";
+				exit(1);
+			}
+			exit(netOnZeroDXC_xc_report_timing(run_timing, options.print_timing, options.timing_filename));
+		}
+#endif
+		if (!options.print_corr_diagram && !options.write_checkpoint && !options.resume_checkpoint && !options.write_container
+				&& (options.nr_shards == 0) && (stop_rule.step == 0)) {	// Plain p value diagrams: the analysis engine alone
+			error = netOnZeroDXC_xc_run_engine(options, loaded_sequences, node_labels, pair_node_a, pair_node_b, run_timing);
+			if (error > 1) {
+				std::cerr << "ERROR: the analysis engine rejected the pairs or the windowing settings.\n";
+				exit(1);
+			} else if (error) {
+				std::cerr << "ERROR: i/o error when writing diagrams in folder '" << options.output_folder << "'. Please check permissions.\n";
+				exit(1);
+			}
+			exit(netOnZeroDXC_xc_report_timing(run_timing, options.print_timing, options.timing_filename));
+		}
+		error = netOnZeroDXC_xc_run_batch(options, loaded_sequences, node_labels, pair_node_a, pair_node_b, run_timing);
+		if (error == 3) {
+			std::cerr << "ERROR: the checkpoint in folder '" << options.output_folder << "' is damaged. Remove it to start again.\n";
+			exit(1);
+		} else if (error == 4) {
+			std::cerr << "ERROR: the checkpoint in folder '" << options.output_folder << "' belongs to a run with different data, pairs or parameters.\n";
+			exit(1);
+		} else if (error) {
+			std::cerr << "ERROR: i/o error when writing diagrams in folder '" << options.output_folder << "'. Please check permissions.\n";
+			exit(1);
+		}
+		exit(netOnZeroDXC_xc_report_timing(run_timing, options.print_timing, options.timing_filename));
+	}
+
+        error = netOnZeroDXC_xc_check_sequences(loaded_sequences, options.index_a, options.index_b, options.nr_window_widths, options.window_basewidth,
+						options.apply_tau);
 	if (error)
 		exit(1);
-	index_a--;
-	index_b--;
+	options.index_a--;
+	options.index_b--;
 
-	std::vector <double>	dummy_vector;
+	int	k_size = 0;
 	int	k;
-	if (apply_tau > 0) {
-		for (k = nr_window_widths*window_basewidth / 2 - 1; k < loaded_sequences[index_a].size() - nr_window_widths*window_basewidth / 2 - apply_tau; k = k + window_basewidth)
-			dummy_vector.push_back(0);
+	int	half_span = options.nr_window_widths*options.window_basewidth / 2;
+	int	nr_samples = loaded_sequences[options.index_a].size();
+	if (options.apply_tau > 0) {
+		for (k = half_span - 1; k < nr_samples - half_span - options.apply_tau; k = k + options.window_basewidth)
+			k_size++;
 	} else {
-		for (k = nr_window_widths*window_basewidth / 2 - 1; k < loaded_sequences[index_a].size() - nr_window_widths*window_basewidth / 2; k = k + window_basewidth)
-			dummy_vector.push_back(0);
+		for (k = half_span - 1; k < nr_samples - half_span; k = k + options.window_basewidth)
+			k_size++;
 	}
-	std::vector < std::vector <double> >	correlation_diagram_data(nr_window_widths, dummy_vector);
-	std::vector < std::vector <double> >	p_value_diagram(nr_window_widths, dummy_vector);
+	Array2D <double>	correlation_diagram_data;
+	Array2D <double>	p_value_diagram;
+	netOnZeroDXC_initialize_temp_diagram(correlation_diagram_data, k_size, options.nr_window_widths);
+	netOnZeroDXC_initialize_temp_diagram(p_value_diagram, k_size, options.nr_window_widths);
 
-	netOnZeroDXC_compute_cdiagram(correlation_diagram_data, loaded_sequences, index_a, index_b, window_basewidth, nr_window_widths, (apply_tau > 0)? true : false, apply_tau);
+	netOnZeroDXC_start_clock(stage_clock);
+	netOnZeroDXC_compute_cdiagram(correlation_diagram_data, loaded_sequences, options.index_a, options.index_b, options.window_basewidth,
+				options.nr_window_widths, (options.apply_tau > 0)? true : false, options.apply_tau);
+	netOnZeroDXC_stop_clock(run_timing, TIMING_STAGE_CDIAGRAM, stage_clock, 1);
 
-	if (print_corr_diagram) {
-		if (write_to_file) {
-			error = netOnZeroDXC_save_single_file(correlation_diagram_data, selected_output_filename, separator_char);
+	if (options.print_corr_diagram) {
+		if (options.write_to_file) {
+			error = netOnZeroDXC_save_single_file(correlation_diagram_data, options.output_filename, options.separator_char);
 		} else {
 			int	l;
-			for (l = 0; l < nr_window_widths; l++) {
+			for (l = 0; l < options.nr_window_widths; l++) {
 				std::cout << correlation_diagram_data[l][0];
-				for (k = 1; k < correlation_diagram_data[l].size(); k++) {
-					std::cout << separator_char << correlation_diagram_data[l][k];
+				for (k = 1; k < k_size; k++) {
+					std::cout << options.separator_char << correlation_diagram_data[l][k];
 				}
 				std::cout << "\n";
 			}
 		}
 		if (error) {
-			std::cerr << "ERROR: i/o error when writing data on file '" << selected_output_filename << "'. Please check permissions.\n";
+			std::cerr << "ERROR: i/o error when writing data on file '" << options.output_filename << "'. Please check permissions.\n";
 			exit(1);
 		}
-		exit(0);
-	}
-
-	std::vector <double>		values_distribution_a, values_distribution_b;
-	std::vector <double>		fft_amplitudes_a, fft_amplitudes_b;
-
-	netOnZeroDXC_initialize_surrogate_generation(values_distribution_a, fft_amplitudes_a, loaded_sequences, index_a);
-	netOnZeroDXC_initialize_surrogate_generation(values_distribution_b, fft_amplitudes_b, loaded_sequences, index_b);
-
-	unsigned int	seed = (unsigned int) clock();
-	if (enable_parallel_computing) {
-		#pragma omp parallel for schedule(dynamic)
-		for (int i = 0; i < nr_surrogates; i++) {
-			std::vector < std::vector <double> >	correlation_diagram_surrogates(nr_window_widths, dummy_vector);
-			std::vector <double>		temp_surrogate_sequence_a;
-			std::vector <double>		temp_surrogate_sequence_b;
-			std::vector < std::vector <double> >	surrogates_container;
-			surrogates_container.clear();
-			temp_surrogate_sequence_a.clear();
-			temp_surrogate_sequence_b.clear();
-			seed = seed + 2*i;
-			netOnZeroDXC_generate_surrogate_sequence(temp_surrogate_sequence_a, loaded_sequences, index_a, values_distribution_a, fft_amplitudes_a, TOLERANCE_SURROGATES, seed);
-			seed++;
-			netOnZeroDXC_generate_surrogate_sequence(temp_surrogate_sequence_b, loaded_sequences, index_b, values_distribution_b, fft_amplitudes_b, TOLERANCE_SURROGATES, seed);
-			surrogates_container.push_back(temp_surrogate_sequence_a);
-			surrogates_container.push_back(temp_surrogate_sequence_b);
-			netOnZeroDXC_compute_cdiagram(correlation_diagram_surrogates, surrogates_container, 0, 1, window_basewidth, nr_window_widths, (apply_tau > 0)? true : false, apply_tau);
+		netOnZeroDXC_stop_clock(run_timing, TIMING_STAGE_WRITE, stage_clock, 1);
+		exit(netOnZeroDXC_xc_report_timing(run_timing, options.print_timing, options.timing_filename));
+	}
+
+	Array2D <int>	exceedance_counts(options.nr_window_widths, k_size, 0);
+
+	if (stop_rule.step > 0) {					// Surrogates are generated a few at a time, until the decision at alpha is settled
+		int	nr_used;
+		nr_used = netOnZeroDXC_xc_compute_adaptive_counts(exceedance_counts, loaded_sequences, options.index_a, options.index_b,
+						correlation_diagram_data, options.nr_window_widths, options.window_basewidth, options.nr_surrogates,
+						options.apply_tau, options.random_seed, stop_rule, number_threads, run_timing);
+		std::cerr << "INFO: adaptive stopping used " << nr_used << " of " << options.nr_surrogates << " surrogates.\n";
+		options.nr_surrogates = nr_used;
+	} else {
+		// Nothing is reused with a single pair: each thread generates surrogate i of both nodes and counts it right away,
+		// so that memory is that of two sequences per thread whatever the number of surrogates
+		std::vector <double>	values_distribution_a, fft_amplitudes_a;
+		std::vector <double>	values_distribution_b, fft_amplitudes_b;
+		netOnZeroDXC_initialize_surrogate_generation(values_distribution_a, fft_amplitudes_a, loaded_sequences, options.index_a);
+		netOnZeroDXC_initialize_surrogate_generation(values_distribution_b, fft_amplitudes_b, loaded_sequences, options.index_b);
+
+		double	section_start_time = omp_get_wtime();
+		#pragma omp parallel if (options.enable_parallel_computing)
+		{
+			Array2D <double>	correlation_diagram_surrogates(options.nr_window_widths, k_size, 0.0);
+			Array2D <int>		partial_counts(options.nr_window_widths, k_size, 0);
+			std::vector < std::vector <double> >	surrogate_a(1), surrogate_b(1);	// Banks of one surrogate, for netOnZeroDXC_count_surrogate_exceedances
+			SurrogateGenerator	generator;
+			CumulativeSumsXC	sums_surrogates;
+			StageClock		thread_clock;
+			StageClock		step_clock;
+			long			thread_surrogates = 0;
+			long			thread_iterations = 0;
+			int			thread_max_iterations = 0;
+			netOnZeroDXC_allocate_surrogate_generator(generator, loaded_sequences[options.index_a].size());
+			netOnZeroDXC_start_clock(thread_clock);
+			step_clock = thread_clock;
+
+			#pragma omp for schedule(dynamic)
+			for (int i = 0; i < options.nr_surrogates; i++) {
+				netOnZeroDXC_generate_surrogate_sequence(surrogate_a[0], generator, loaded_sequences[options.index_a], values_distribution_a, fft_amplitudes_a,
+									TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(options.random_seed, options.index_a, i));
+				thread_iterations += generator.iterations;
+				thread_max_iterations = std::max(thread_max_iterations, generator.iterations);
+				netOnZeroDXC_generate_surrogate_sequence(surrogate_b[0], generator, loaded_sequences[options.index_b], values_distribution_b, fft_amplitudes_b,
+									TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(options.random_seed, options.index_b, i));
+				thread_iterations += generator.iterations;
+				thread_max_iterations = std::max(thread_max_iterations, generator.iterations);
+				thread_surrogates += 2;
+				netOnZeroDXC_lap_clock(run_timing, TIMING_STAGE_SURROGATES, step_clock, 2);
+				netOnZeroDXC_count_surrogate_exceedances(partial_counts, correlation_diagram_data, surrogate_a, surrogate_b, 0, 1, correlation_diagram_surrogates,
+							sums_surrogates, options.window_basewidth, options.nr_window_widths, (options.apply_tau > 0)? true : false, options.apply_tau);
+				netOnZeroDXC_lap_clock(run_timing, TIMING_STAGE_PDIAGRAM, step_clock, 0);
+			}
+
 			#pragma omp critical
 			{
-				netOnZeroDXC_update_pdiagram (p_value_diagram, correlation_diagram_data, correlation_diagram_surrogates, nr_window_widths, nr_surrogates);
+				netOnZeroDXC_merge_exceedance_counts(exceedance_counts, partial_counts, options.nr_window_widths);	// Once per thread
 			}
+			netOnZeroDXC_free_surrogate_generator(generator);
+			netOnZeroDXC_add_surrogate_iterations(run_timing, thread_surrogates, thread_iterations, thread_max_iterations);
+			netOnZeroDXC_lap_clock(run_timing, TIMING_STAGE_PDIAGRAM, step_clock, 0);
+			netOnZeroDXC_stop_thread_clock(run_timing, thread_clock);
 		}
-	} else {
-		int	i;
-		for (i = 0; i < nr_surrogates; i++) {
-			std::vector < std::vector <double> >	correlation_diagram_surrogates(nr_window_widths, dummy_vector);
-			std::vector <double>		temp_surrogate_sequence_a;
-			std::vector <double>		temp_surrogate_sequence_b;
-			std::vector < std::vector <double> >	surrogates_container;
-			surrogates_container.clear();
-			temp_surrogate_sequence_a.clear();
-			temp_surrogate_sequence_b.clear();
-			netOnZeroDXC_generate_surrogate_sequence(temp_surrogate_sequence_a, loaded_sequences, index_a, values_distribution_a, fft_amplitudes_a, TOLERANCE_SURROGATES, seed);
-			seed++;
-			netOnZeroDXC_generate_surrogate_sequence(temp_surrogate_sequence_b, loaded_sequences, index_b, values_distribution_b, fft_amplitudes_b, TOLERANCE_SURROGATES, seed);
-			seed++;
-			surrogates_container.push_back(temp_surrogate_sequence_a);
-			surrogates_container.push_back(temp_surrogate_sequence_b);
-			netOnZeroDXC_compute_cdiagram(correlation_diagram_surrogates, surrogates_container, 0, 1, window_basewidth, nr_window_widths, (apply_tau > 0)? true : false, apply_tau);
-			netOnZeroDXC_update_pdiagram (p_value_diagram, correlation_diagram_data, correlation_diagram_surrogates, nr_window_widths, nr_surrogates);
-		}
-	}
-
-	if (write_to_file) {
-		error = netOnZeroDXC_save_single_file(p_value_diagram, selected_output_filename, separator_char);
+		netOnZeroDXC_add_parallel_section(run_timing, number_threads, omp_get_wtime() - section_start_time);
+		run_timing.stages[TIMING_STAGE_PDIAGRAM].items++;
+	}
+	netOnZeroDXC_convert_counts_to_pdiagram(p_value_diagram, exceedance_counts, options.nr_window_widths, options.nr_surrogates);
+
+	netOnZeroDXC_start_clock(stage_clock);
+	if (options.write_to_file) {
+		error = netOnZeroDXC_save_single_file(p_value_diagram, options.output_filename, options.separator_char);
 	} else {
 		int	l;
-		for (l = 0; l < nr_window_widths; l++) {
+		for (l = 0; l < options.nr_window_widths; l++) {
 			std::cout << p_value_diagram[l][0];
-			for (k = 1; k < p_value_diagram[l].size(); k++) {
-				std::cout << separator_char << p_value_diagram[l][k];
+			for (k = 1; k < k_size; k++) {
+				std::cout << options.separator_char << p_value_diagram[l][k];
 			}
 			std::cout << "\n";
 		}
 	}
 	if (error) {
-		std::cerr << "ERROR: i/o error when writing data on file '" << selected_output_filename << "'. Please check permissions.\n";
+		std::cerr << "ERROR: i/o error when writing data on file '" << options.output_filename << "'. Please check permissions.\n";
 		exit(1);
 	}
+	netOnZeroDXC_stop_clock(run_timing, TIMING_STAGE_WRITE, stage_clock, 1);
 
-	return 0;
+	return netOnZeroDXC_xc_report_timing(run_timing, options.print_timing, options.timing_filename);
 }
 
 void netOnZeroDXC_xc_help (char *program_name)
 {
 	std::cerr << "Usage:\n";
 	std::cerr << "\t" << program_name << " -n <#> <#> -W <#> -L <#> (<Options>)\t<\t<vector stream>\n";
+	std::cerr << "\t" << program_name << " -all -O <folder> -W <#> -L <#> (<Options>)\t<\t<vector stream>\n";
 	std::cerr << "\nMandatory assignment:\n";
-	std::cerr << "\t-n <#> <#>\tset column numbers of the two sequences to be analyzed;\n";
+	std::cerr << "\t-n <#> <#>\tset column numbers of the two sequences to be analyzed, or use one of the batch modes below;\n";
 	std::cerr << "\t-W <#>\t\tset the number of window widths (rows of a correlation diagram);\n";
 	std::cerr << "\t-L <#>\t\tset the base window width (in number of samples; if odd, will be reduced by 1).\n";
 
@@ -224,60 +453,202 @@ void netOnZeroDXC_xc_help (char *program_name)
 	std::cerr << "\t-p\t\tcompute p value diagram by surrogate generation (default);\n";
 	std::cerr << "\t-M <#>\t\tset the number of surrogates to be generated (default = 100);\n";
 	std::cerr << "\t-tau <#>\tapply the delay of +/-tau points to assess zero-delay cross-correlation as the average of two delayed cross-correlations;\n";
+	std::cerr << "\t-tau-list <@>\tin batch mode, compute the diagrams of several delays in one pass, sharing the surrogates: a list separated by\n";
+	std::cerr << "\t\t\tcommas, or a range first:step:last (0 for no delay); the files of delay tau are named [prefix_]tau<tau>_pdiag_<#>_<#>.dat\n";
+	std::cerr << "\t\t\t(cdiag with -C), and equal those of a run with -tau <tau>; not with -tau, -adaptive, checkpoints, shards, -container or -gpu;\n";
+	std::cerr << "\t-seed <#>\tset the seed of the random generator used for surrogates (default = 1);\n";
+	std::cerr << "\t-adaptive <#> <#>\tstop generating surrogates, -M being the maximum, as soon as in every cell of the diagram it is settled whether p is below\n";
+	std::cerr << "\t\t\tthe significance threshold (first value), with the given error rate (second value) at each check; checks are made every " << SEQUENTIAL_STOP_STEP << " surrogates;\n";
 	std::cerr << "\t-parallel\tenable parallel computing.\n";
 
+	std::cerr << "\nBatch modes (sequences are loaded and surrogates generated once for all pairs):\n";
+	std::cerr << "\t-all\t\tanalyze all pairs of sequences;\n";
+	std::cerr << "\t-pairs <fname>\tanalyze the pairs of column numbers listed in file 'fname', one pair per line;\n";
+	std::cerr << "\t-O <folder>\twrite one file per pair in 'folder', named [prefix_]pdiag_<#>_<#>.dat (cdiag with -C) (mandatory in batch mode);\n";
+	std::cerr << "\t\t\twith -adaptive, the number of surrogates used by each pair is written in [prefix_]surrogates_used.dat;\n";
+	std::cerr << "\t-prefix <str>\tset the prefix of the file names written in batch mode;\n";
+	std::cerr << "\t-checkpoint\twrite the progress of surrogate computations in [prefix_]checkpoint.dat and [prefix_]checkpoint_partial.dat, so that an\n";
+	std::cerr << "\t\t\tinterrupted run can be resumed; both files are removed when the run is completed;\n";
+	std::cerr << "\t-resume\t\tresume the run recorded in the checkpoint of the output folder (same data, pairs and options), or start one if there is none;\n";
+	std::cerr << "\t-container\twrite all diagrams in a single file, [prefix_]results.dat, instead of one file per pair (read it with netOnZeroDXC_efficiency -pair);\n";
+	std::cerr << "\t-compress\tas -container, with compressed diagrams (requires zlib support, see the setup instructions);\n";
+	std::cerr << "\t-memory <#>\tkeep at most # MB of surrogates in memory (default: half of the available memory); if the surrogates of all nodes\n";
+	std::cerr << "\t\t\tdo not fit, they are generated in blocks, and every pair goes through the blocks in turn with its counts kept in between.\n";
+	std::cerr << "\nDistributed runs (batch mode, one process per shard, same data and options for all, output folder shared or gathered before merging):\n";
+	std::cerr << "\t-shard <#> <#>\trun shard i (first value, from 0) of n (second value): the pairs are dealt among shards, and the exceedance counts\n";
+	std::cerr << "\t\t\tof this shard are written in [prefix_]shard_<i>.dat instead of the diagrams (with -C, its correlation diagrams are written);\n";
+	std::cerr << "\t-split-surrogates\twith -shard, deal the surrogates of every pair among shards instead of the pairs (not with -adaptive);\n";
+	std::cerr << "\t-merge <#>\tadd up the counts of the n shard files and write the diagrams, and the other files, that a single run would write.\n";
+	std::cerr << "\t-gpu <#>\tcompute surrogates and p value diagrams on GPU number # (from 0; requires CUDA support, see the setup instructions);\n";
+	std::cerr << "\t\t\tnot with -adaptive or -checkpoint, and its shards are merged as the others.\n";
+	std::cerr << "\nSliding analysis (batch mode, for recordings that grow while they are analyzed):\n";
+	std::cerr << "\t-follow <#>\tread the samples as they come and analyze them in blocks of # new columns of the diagrams (# times the base width\n";
+	std::cerr << "\t\t\tin samples), each one against surrogates of the samples its windows span; after every block, rewrite the efficiencies\n";
+	std::cerr << "\t\t\tof all columns so far, [prefix_]eff_<#>_<#>.dat, and the matrix of time scales, [prefix_]matrix.dat;\n";
+	std::cerr << "\t-a <#>\t\tset the p value significance threshold of the efficiencies (default = 0.01);\n";
+	std::cerr << "\t-eta <#>\tset the efficiency threshold of the matrix of time scales (default = 0.5).\n";
+
 	std::cerr << "\nInput/output:\n";
-	std::cerr << "\t-i <fname>\tread from file 'fname' instead of standard input;\n";
+	std::cerr << "\t-i <fname>\tread from file 'fname' instead of standard input (text or binary, see netOnZeroDXC_convert);\n";
 	std::cerr << "\t-o <fname>\twrite to file 'fname' instead of standard output;\n";
 	std::cerr << "\t-s <@>\t\tset column separator, default t (TAB); other options are s (space) or c (comma ',').\n";
+	std::cerr << "\t-timing\t\tprint the elapsed and CPU time of each stage, the surrogates per second and the use of each thread on standard error;\n";
+	std::cerr << "\t\t\tin batch mode, also report the progress of pairs with an estimate of the time left;\n";
+	std::cerr << "\t-json <fname>\twrite the same timing summary in JSON format to file 'fname'.\n";
 
 	std::cerr << "\n\t-h or --help\tshow this help.\n";
 }
 
-int netOnZeroDXC_xc_parse_options (int argc, char *argv[], bool & read_from_file, bool & write_to_file, bool & print_corr_diagram, bool & compute_pvalue_diagram,
-				bool & enable_parallel_computing, int & index_a, int & index_b, int & tau, int & W, int & L, int & M, std::string & input_filename,
-				std::string & output_filename, char & separator_char)
+void netOnZeroDXC_xc_initialize_options (DiagramOptions & options)
 {
+	options.read_from_file = false;
+	options.write_to_file = false;
+	options.print_corr_diagram = false;
+	options.compute_pvalue_diagram = false;
+	options.enable_parallel_computing = false;
+	options.batch_all_pairs = false;
+	options.write_checkpoint = false;
+	options.resume_checkpoint = false;
+	options.write_container = false;
+	options.compress_container = false;
+	options.print_timing = false;
+	options.split_surrogates = false;
+	options.index_a = -1;
+	options.index_b = -1;
+	options.shard_index = -1;
+	options.nr_shards = 0;
+	options.merge_shards = 0;
+	options.gpu_device = -1;
+	options.follow_columns = 0;
+	options.memory_limit = 0;
+	options.follow_alpha = 0.01;
+	options.follow_eta = 0.5;
+	options.apply_tau = -1;
+	options.tau_list.clear();
+	options.nr_window_widths = -1;
+	options.window_basewidth = -1;
+	options.nr_surrogates = 100;
+	options.random_seed = 1;
+	options.adaptive_alpha = -1.0;
+	options.adaptive_error = -1.0;
+	options.separator_char = 't';
+	options.input_filename.clear();
+	options.output_filename.clear();
+	options.pairs_filename.clear();
+	options.output_folder.clear();
+	options.output_prefix.clear();
+	options.timing_filename.clear();
+}
+
+int netOnZeroDXC_xc_parse_options (int argc, char *argv[], DiagramOptions & options)
+{
+	bool	tau_set = false;
 	int	n = 1;
 	while (n < argc) {
 		if (strcmp(argv[n], "-n") == 0) {
 			n++;
-			index_a = atoi(argv[n]);
+			options.index_a = atoi(argv[n]);
 			n++;
-			index_b = atoi(argv[n]);
+			options.index_b = atoi(argv[n]);
 
 		} else if (strcmp(argv[n], "-i") == 0) {
-			read_from_file = true;
+			options.read_from_file = true;
 			n++;
-			input_filename = argv[n];
+			options.input_filename = argv[n];
 		} else if (strcmp(argv[n], "-o") == 0) {
-			write_to_file = true;
+			options.write_to_file = true;
 			n++;
-			output_filename = argv[n];
+			options.output_filename = argv[n];
 		} else if (strcmp(argv[n], "-s") == 0) {
 			n++;
-			separator_char = argv[n][0];
+			options.separator_char = argv[n][0];
+		} else if (strcmp(argv[n], "-timing") == 0) {
+			options.print_timing = true;
+		} else if (strcmp(argv[n], "-json") == 0) {
+			n++;
+			options.timing_filename = argv[n];
 
 		} else if (strcmp(argv[n], "-parallel") == 0) {
-			enable_parallel_computing = true;
+			options.enable_parallel_computing = true;
+
+		} else if (strcmp(argv[n], "-all") == 0) {
+			options.batch_all_pairs = true;
+		} else if (strcmp(argv[n], "-pairs") == 0) {
+			n++;
+			options.pairs_filename = argv[n];
+		} else if (strcmp(argv[n], "-O") == 0) {
+			n++;
+			options.output_folder = argv[n];
+		} else if (strcmp(argv[n], "-prefix") == 0) {
+			n++;
+			options.output_prefix = argv[n];
+		} else if (strcmp(argv[n], "-checkpoint") == 0) {
+			options.write_checkpoint = true;
+		} else if (strcmp(argv[n], "-resume") == 0) {
+			options.resume_checkpoint = true;
+		} else if (strcmp(argv[n], "-container") == 0) {
+			options.write_container = true;
+		} else if (strcmp(argv[n], "-compress") == 0) {
+			options.write_container = true;
+			options.compress_container = true;
+		} else if (strcmp(argv[n], "-shard") == 0) {
+			n++;
+			options.shard_index = atoi(argv[n]);
+			n++;
+			options.nr_shards = atoi(argv[n]);
+		} else if (strcmp(argv[n], "-split-surrogates") == 0) {
+			options.split_surrogates = true;
+		} else if (strcmp(argv[n], "-merge") == 0) {
+			n++;
+			options.merge_shards = atoi(argv[n]);
+		} else if (strcmp(argv[n], "-gpu") == 0) {
+			n++;
+			options.gpu_device = atoi(argv[n]);
+		} else if (strcmp(argv[n], "-memory") == 0) {
+			n++;
+			options.memory_limit = atoi(argv[n]);
+		} else if (strcmp(argv[n], "-follow") == 0) {
+			n++;
+			options.follow_columns = atoi(argv[n]);
+		} else if (strcmp(argv[n], "-a") == 0) {
+			n++;
+			options.follow_alpha = atof(argv[n]);
+		} else if (strcmp(argv[n], "-eta") == 0) {
+			n++;
+			options.follow_eta = atof(argv[n]);
 
 		} else if ((strcmp(argv[n], "-C") == 0) || (strcmp(argv[n], "-c") == 0)) {
-			print_corr_diagram = true;
+			options.print_corr_diagram = true;
 		} else if (strcmp( argv[n], "-p") == 0) {
-			compute_pvalue_diagram = true;
+			options.compute_pvalue_diagram = true;
 
 		} else if( strcmp( argv[n], "-W" ) == 0 ) {
 			n++;
-			W = atoi(argv[n]);
+			options.nr_window_widths = atoi(argv[n]);
 		} else if( strcmp( argv[n], "-L" ) == 0 ) {
 			n++;
-			L = atoi(argv[n]);
+			options.window_basewidth = atoi(argv[n]);
 		} else if( strcmp( argv[n], "-M" ) == 0 ) {
 			n++;
-			M = atoi(argv[n]);
+			options.nr_surrogates = atoi(argv[n]);
+		} else if( strcmp( argv[n], "-seed" ) == 0 ) {
+			n++;
+			options.random_seed = (unsigned int) strtoul(argv[n], NULL, 10);
+		} else if( strcmp( argv[n], "-adaptive" ) == 0 ) {
+			n++;
+			options.adaptive_alpha = atof(argv[n]);
+			n++;
+			options.adaptive_error = atof(argv[n]);
 		} else if( strcmp( argv[n], "-tau" ) == 0 ) {
 			n++;
-			tau = atoi(argv[n]);
+			options.apply_tau = atoi(argv[n]);
+			tau_set = true;
+		} else if( strcmp( argv[n], "-tau-list" ) == 0 ) {
+			n++;
+			if (netOnZeroDXC_xc_parse_delays(options.tau_list, argv[n])) {
+				std::cerr << "ERROR: the list of delays '" << argv[n] << "' is invalid. Use " << argv[0] << " -h for a list of options.\n";
+				return 1;
+			}
 
 		} else if ((strcmp("-h", argv[n]) == 0) || (strcmp("--help", argv[n]) == 0))  {
 			netOnZeroDXC_xc_help(argv[0]);
@@ -286,34 +657,181 @@ int netOnZeroDXC_xc_parse_options (int argc, char *argv[], bool & read_from_file
 		n++;
 	}
 
-	if (!compute_pvalue_diagram && !print_corr_diagram)
-		compute_pvalue_diagram = true;
-	else if (compute_pvalue_diagram && print_corr_diagram)
-		print_corr_diagram = false;
+	if (!options.compute_pvalue_diagram && !options.print_corr_diagram)
+		options.compute_pvalue_diagram = true;
+	else if (options.compute_pvalue_diagram && options.print_corr_diagram)
+		options.print_corr_diagram = false;
 
-	if ((index_a <= 0) || (index_b <= 0)) {
+	bool	batch_mode = (options.batch_all_pairs || options.pairs_filename.size());
+	if (batch_mode && (options.output_folder.size() == 0)) {
+		std::cerr << "ERROR: batch mode requires an output folder (-O). Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (!batch_mode && (options.write_checkpoint || options.resume_checkpoint)) {
+		std::cerr << "ERROR: checkpoints are only written in batch mode. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (!batch_mode && options.write_container) {
+		std::cerr << "ERROR: results containers are only written in batch mode. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (!batch_mode && (options.nr_shards || options.merge_shards)) {
+		std::cerr << "ERROR: shards are only run and merged in batch mode. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (options.memory_limit < 0) {
+		std::cerr << "ERROR: the memory limit was not correctly set, it must be a positive number of MB. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (options.nr_shards && ((options.nr_shards < 1) || (options.shard_index < 0) || (options.shard_index >= options.nr_shards))) {
+		std::cerr << "ERROR: shard number was not correctly set, it must be between 0 and the number of shards minus 1. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (options.nr_shards && options.merge_shards) {
+		std::cerr << "ERROR: shards are merged by a separate run, without -shard. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if ((options.nr_shards || options.merge_shards) && (options.write_checkpoint || options.resume_checkpoint)) {
+		std::cerr << "ERROR: checkpoints are not written by distributed runs; a failed shard is run again. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (options.merge_shards && options.print_corr_diagram) {
+		std::cerr << "ERROR: shards of correlation diagrams write their diagrams and need no merging. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (options.gpu_device >= 0) {
+#ifdef NETONZERODXC_USE_CUDA
+		if (!batch_mode) {
+			std::cerr << "ERROR: the GPU is only used in batch mode. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+		if ((options.adaptive_error != -1.0) || (options.adaptive_alpha != -1.0) || options.write_checkpoint || options.resume_checkpoint) {
+			std::cerr << "ERROR: the GPU computes all surrogates of a chunk at once, without adaptive stopping or checkpoints. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+		if (options.gpu_device >= netOnZeroDXC_gpu_count_devices()) {
+			std::cerr << "ERROR: GPU number " << options.gpu_device << " was not found. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+#else
+		std::cerr << "ERROR: this program was compiled without CUDA support; run it without -gpu. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+#endif
+	}
+	if (options.follow_columns != 0) {
+		if (!batch_mode || (options.follow_columns < 0)) {
+			std::cerr << "ERROR: -follow requires a batch mode and a positive number of columns per block. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+		if (options.print_corr_diagram || options.write_container || options.write_checkpoint || options.resume_checkpoint || options.nr_shards
+				|| options.merge_shards || (options.gpu_device >= 0) || (options.adaptive_error != -1.0) || (options.adaptive_alpha != -1.0)
+				|| options.timing_filename.size()) {
+			std::cerr << "ERROR: -follow only writes efficiencies and matrices of time scales, one block at a time: it is not combined with -C, -container,\n";
+			std::cerr << "\tcheckpoints, shards, -gpu, -adaptive or -json. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+		if ((options.follow_alpha <= 0.0) || (options.follow_alpha >= 1.0) || (options.follow_eta <= 0.0) || (options.follow_eta >= 1.0)) {
+			std::cerr << "ERROR: the significance and efficiency thresholds must be between 0 and 1. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+	}
+	if (options.tau_list.size()) {
+		if (!batch_mode) {
+			std::cerr << "ERROR: -tau-list is only used in batch mode. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+		if (tau_set || options.write_container || options.write_checkpoint || options.resume_checkpoint || options.nr_shards || options.merge_shards
+				|| (options.gpu_device >= 0) || options.follow_columns || (options.adaptive_error != -1.0) || (options.adaptive_alpha != -1.0)) {
+			std::cerr << "ERROR: -tau-list writes one file per pair and delay with all the surrogates: it is not combined with -tau, -container,\n";
+			std::cerr << "\tcheckpoints, shards, -gpu, -follow or -adaptive. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+	}
+	if (options.compress_container && !netOnZeroDXC_results_compression_available()) {
+		options.compress_container = false;
+		std::cerr << "WARNING: this program was compiled without zlib; the results container is written uncompressed.\n";
+	}
+	if (!batch_mode && ((options.index_a <= 0) || (options.index_b <= 0))) {
 		std::cerr << "ERROR: column numbers were not correctly set. Use " << argv[0] << " -h for a list of options.\n";
 		return 1;
 	}
-	if (W <= 0) {
+	if (options.nr_window_widths <= 0) {
 		std::cerr << "ERROR: number of window widths was not correctly set. Use " << argv[0] << " -h for a list of options.\n";
 		return 1;
 	}
-	if (L <= 0) {
+	if (options.window_basewidth <= 0) {
 		std::cerr << "ERROR: base width was not correctly set. Use " << argv[0] << " -h for a list of options.\n";
 		return 1;
 	}
-	if (separator_char == 's') {
-		separator_char = ' ';
-	} else if (separator_char == 'c') {
-		separator_char = ',';
+	if ((options.adaptive_error != -1.0) || (options.adaptive_alpha != -1.0)) {
+		if ((options.adaptive_alpha <= 0.0) || (options.adaptive_alpha >= 1.0) || (options.adaptive_error <= 0.0) || (options.adaptive_error >= 1.0)) {
+			std::cerr << "ERROR: adaptive stopping requires a significance threshold and an error rate between 0 and 1. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+		if (options.nr_surrogates < SEQUENTIAL_STOP_STEP) {
+			std::cerr << "ERROR: adaptive stopping requires at least " << SEQUENTIAL_STOP_STEP << " surrogates. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+		if (options.split_surrogates) {
+			std::cerr << "ERROR: adaptive stopping needs all the surrogates of a pair in the same shard. Use " << argv[0] << " -h for a list of options.\n";
+			return 1;
+		}
+	}
+	if (options.split_surrogates && (options.nr_surrogates < ((options.nr_shards > options.merge_shards)? options.nr_shards : options.merge_shards))) {
+		std::cerr << "ERROR: surrogates cannot be split among more shards than surrogates. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
+	if (options.separator_char == 's') {
+		options.separator_char = ' ';
+	} else if (options.separator_char == 'c') {
+		options.separator_char = ',';
 	} else {
-		separator_char = '\t';
+		options.separator_char = '\t';
 	}
 
 	return 0;
 }
 
+int netOnZeroDXC_xc_count_threads (const DiagramOptions & options)
+{
+	return (options.enable_parallel_computing)? omp_get_max_threads() : 1;
+}
+
+int netOnZeroDXC_xc_parse_delays (std::vector <int> & tau_list, const char * argument)
+{
+	// Delays in points, as a list separated by commas or a range first:step:last, last included; returns 1 if one is negative or missing
+	tau_list.clear();
+	std::string	text(argument);
+	size_t	first_colon = text.find(':');
+	if (first_colon != std::string::npos) {
+		size_t	second_colon = text.find(':', first_colon + 1);
+		if (second_colon == std::string::npos)
+			return 1;
+		int	first = atoi(text.substr(0, first_colon).c_str());
+		int	step = atoi(text.substr(first_colon + 1, second_colon - first_colon - 1).c_str());
+		int	last = atoi(text.substr(second_colon + 1).c_str());
+		if ((first < 0) || (step <= 0) || (last < first))
+			return 1;
+		int	value;
+		for (value = first; value <= last; value = value + step)
+			tau_list.push_back(value);
+		return 0;
+	}
+
+	size_t	start = 0;
+	size_t	comma;
+	do {
+		comma = text.find(',', start);
+		std::string	item = text.substr(start, (comma == std::string::npos)? std::string::npos : comma - start);
+		if ((item.size() == 0) || (atoi(item.c_str()) < 0))
+			return 1;
+		tau_list.push_back(atoi(item.c_str()));
+		start = comma + 1;
+	} while (comma != std::string::npos);
+
+	return 0;
+}
+
 int netOnZeroDXC_xc_check_sequences (const std::vector < std::vector <double> > & sequences, int na, int nb, int W, int & L, int tau)
 {
 	if ((na > sequences.size()) || (nb > sequences.size())) {
@@ -333,3 +851,1153 @@ int netOnZeroDXC_xc_check_sequences (const std::vector < std::vector <double> >
 
 	return 0;
 }
+
+int netOnZeroDXC_xc_list_batch_pairs (std::vector <int> & pair_node_a, std::vector <int> & pair_node_b, bool all_pairs, std::string pairs_filename, int nr_nodes,
+				char separator_char)
+{
+	// Pairs are stored as 0-based node indexes; the list file holds 1-based column numbers, as the -n option
+	int	i, j;
+	pair_node_a.clear();
+	pair_node_b.clear();
+	if (all_pairs) {
+		for (i = 0; i < nr_nodes - 1; i++) {
+			for (j = i + 1; j < nr_nodes; j++) {
+				pair_node_a.push_back(i);
+				pair_node_b.push_back(j);
+			}
+		}
+		return 0;
+	}
+
+	std::vector < std::vector <double> >	pairs_table;
+	if (netOnZeroDXC_read_data_table(pairs_table, pairs_filename, separator_char)) {
+		std::cerr << "ERROR: cannot read the pairs file '" << pairs_filename << "'.\n";
+		return 1;
+	}
+	for (i = 0; i < pairs_table.size(); i++) {
+		int	a = (pairs_table[i].size() >= 2)? (int) pairs_table[i][0] : 0;
+		int	b = (pairs_table[i].size() >= 2)? (int) pairs_table[i][1] : 0;
+		if ((a <= 0) || (b <= 0) || (a > nr_nodes) || (b > nr_nodes) || (a == b)) {
+			std::cerr << "ERROR: invalid pair of column numbers at entry " << i + 1 << " of the pairs file '" << pairs_filename << "'.\n";
+			return 1;
+		}
+		pair_node_a.push_back(a - 1);
+		pair_node_b.push_back(b - 1);
+	}
+	if (pair_node_a.size() == 0) {
+		std::cerr << "ERROR: no pairs found in the pairs file '" << pairs_filename << "'.\n";
+		return 1;
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_xc_run_batch (const DiagramOptions & options, const std::vector < std::vector <double> > & sequences, const std::vector <std::string> & node_labels,
+				const std::vector <int> & pair_node_a, const std::vector <int> & pair_node_b, RunTiming & timing)
+{
+	// Surrogates are generated once per node involved, as (node, surrogate) tasks; then each pair is a task that computes and writes its diagram.
+	// Surrogate seeds depend only on (seed, node, surrogate): every diagram equals the one obtained for the same pair with -n.
+	// If the surrogates of all nodes do not fit in memory_limit bytes (see netOnZeroDXC_surrogate_block_size), they are generated one block at a
+	// time, and every pair still open goes through each block in turn, its counts being kept in between: memory is then that of one block plus
+	// the counts of all pairs. With adaptive stopping each pair stops using surrogates as soon as its decision is settled, and a block is only
+	// generated for the nodes of the pairs still open.
+	// With a checkpoint, pairs completed before resuming are skipped (and so are nodes only involved in them), partial ones continue from their counts.
+	// With a results container, all diagrams go to [prefix_]results.dat through its writer thread; completed pairs are rebuilt there from their counts.
+	// Each step is added to timing; with report_progress, every tenth of the pairs done is reported on standard error with the time left.
+	// As shard shard_index of nr_shards (if nr_shards > 0), only one pair out of nr_shards is computed, or with split_surrogates one range of surrogates
+	// of every pair, and the exceedance counts go to [prefix_]shard_<#>.dat for netOnZeroDXC_xc_merge_shards; correlation diagrams are still written.
+	// Returns 1 on write errors, 2-4 as netOnZeroDXC_open_checkpoint.
+	bool	only_cdiagrams = options.print_corr_diagram;
+	bool	write_container = options.write_container;
+	bool	report_progress = options.print_timing;
+	int	W = options.nr_window_widths;
+	int	L = options.window_basewidth;
+	int	M = options.nr_surrogates;
+	int	tau = options.apply_tau;
+	unsigned int	seed = options.random_seed;
+	int	number_threads = netOnZeroDXC_xc_count_threads(options);
+	size_t	memory_limit = (size_t) options.memory_limit << 20;
+	SequentialStopRule	stop_rule;				// Left empty (step = 0) unless adaptive stopping was requested
+	netOnZeroDXC_initialize_stop_rule(stop_rule, M, SEQUENTIAL_STOP_STEP, options.adaptive_alpha, options.adaptive_error);
+	int	nr_nodes = sequences.size();
+	int	nr_pairs = pair_node_a.size();
+	int	N = sequences[0].size();
+	bool	apply_shift = (tau > 0);
+	int	shift = (apply_shift)? tau : 0;
+	int	i, k;
+
+	int	K = 0;
+	for (k = W*L / 2 - 1; k < N - W*L / 2 - shift; k = k + L)
+		K++;
+
+	bool	sharded = (options.nr_shards > 0);
+	int	m_first = (sharded && options.split_surrogates)? (int) ((long) options.shard_index * M / options.nr_shards) : 0;
+	int	m_last = (sharded && options.split_surrogates)? (int) ((long) (options.shard_index + 1) * M / options.nr_shards) : M;
+	std::vector <bool>	pair_selected(nr_pairs, true);
+	if (sharded && !options.split_surrogates) {
+		for (i = 0; i < nr_pairs; i++)
+			pair_selected[i] = ((i % options.nr_shards) == options.shard_index);		// Dealt in turn: neighbouring pairs, of similar cost, go to different shards
+	}
+
+	CheckpointFiles	checkpoint_files;
+	CheckpointState	resume_state;
+	bool		checkpoint = (!only_cdiagrams && (options.write_checkpoint || options.resume_checkpoint));
+	checkpoint_files.journal = NULL;
+	if (checkpoint) {
+		CheckpointHeader	header;
+		netOnZeroDXC_fill_checkpoint_header(header, sequences, pair_node_a, pair_node_b, W, L, K, M, SEQUENTIAL_STOP_STEP, shift, seed, options.adaptive_alpha, options.adaptive_error);
+		int	error = netOnZeroDXC_open_checkpoint(checkpoint_files, resume_state, header, options.output_folder, options.output_prefix, '_', options.resume_checkpoint);
+		if (error)
+			return error;
+	}
+
+	CheckpointFiles	shard_files;
+	bool		write_shard = (sharded && !only_cdiagrams);
+	shard_files.journal = NULL;
+	if (write_shard) {
+		CheckpointHeader	header;
+		netOnZeroDXC_fill_checkpoint_header(header, sequences, pair_node_a, pair_node_b, W, L, K, M, SEQUENTIAL_STOP_STEP, shift, seed, options.adaptive_alpha, options.adaptive_error);
+		if (netOnZeroDXC_open_shard_file(shard_files, header, options.output_folder, options.output_prefix, '_', options.shard_index))
+			return 1;
+		write_container = false;						// Diagrams are written by the merge step
+	}
+
+	ResultsWriter	results_writer;
+	if (write_container) {
+		if (results_writer.open(netOnZeroDXC_generate_filepath(options.output_folder, options.output_prefix, "results", '_', "", ""), options.compress_container)) {
+			netOnZeroDXC_close_checkpoint(checkpoint_files, false);
+			return 1;
+		}
+	}
+
+	std::vector <int>	used_nodes;
+	std::vector <bool>	node_used(nr_nodes, false);
+	for (i = 0; i < nr_pairs; i++) {
+		if ((checkpoint && (resume_state.status[i] == CHECKPOINT_PAIR_DONE)) || !pair_selected[i])
+			continue;
+		node_used[pair_node_a[i]] = true;
+		node_used[pair_node_b[i]] = true;
+	}
+	for (i = 0; i < nr_nodes; i++) {
+		if (node_used[i])
+			used_nodes.push_back(i);
+	}
+
+	// With several blocks, the counts of every pair live in pair_counts from one block to the next; otherwise each thread has a slot of its own
+	size_t	counts_bytes = (size_t) nr_pairs * W * K * sizeof(int) * ((checkpoint)? 2 : 1);		// Snapshots copy the counts of the open pairs
+	int	block = (only_cdiagrams)? m_last - m_first : netOnZeroDXC_surrogate_block_size(used_nodes.size(), N, m_last - m_first, counts_bytes, memory_limit);
+	if (block < m_last - m_first)
+		std::cerr << "INFO: the surrogates of all nodes do not fit in memory: they are generated in " << (m_last - m_first + block - 1) / block << " blocks of " << block << ".\n";
+	if (!only_cdiagrams && (stop_rule.step > 0) && (block > stop_rule.step))
+		block = stop_rule.step;				// Adaptive stopping: each step of surrogates is generated only for the nodes of the pairs still open
+	int	nr_blocks = (block < m_last - m_first)? (m_last - m_first + block - 1) / block : 1;
+	std::vector < std::vector < std::vector <double> > >	surrogate_bank(nr_nodes);
+	Array3D <int>		pair_counts((nr_blocks > 1)? nr_pairs : number_threads, W, K, 0);
+	std::vector <int>	pair_next(nr_pairs, m_first);		// First surrogate not counted yet
+	std::vector <char>	pair_open(nr_pairs, 0);			// Still to be completed by this run
+	for (i = 0; i < nr_pairs; i++)
+		pair_open[i] = pair_selected[i];
+
+	std::vector <int>		surrogates_used(nr_pairs, 0);
+	std::vector <PairProgress>	thread_progress(number_threads);
+	if (checkpoint) {
+		for (i = 0; i < number_threads; i++)
+			netOnZeroDXC_initialize_pair_progress(thread_progress[i], (M + SEQUENTIAL_STOP_STEP - 1) / SEQUENTIAL_STOP_STEP, W, K);
+	}
+	bool	write_error = false;
+	long	pairs_done = 0;
+	long	pairs_restored = 0;
+	int	old_progress = 0;
+	int	c;
+	for (i = 0; i < nr_pairs; i++) {
+		if ((checkpoint && (resume_state.status[i] == CHECKPOINT_PAIR_DONE)) || !pair_selected[i])
+			pairs_restored++;			// Not computed by this run
+	}
+	double	section_start_time = omp_get_wtime();
+	for (c = 0; (c < nr_blocks) && !write_error; c++) {
+		int	block_first = m_first + c * block;
+		int	block_last = (block_first + block < m_last)? block_first + block : m_last;
+		if (c > 0) {
+			used_nodes.clear();
+			node_used.assign(nr_nodes, false);
+			for (i = 0; i < nr_pairs; i++) {
+				if (pair_open[i] && (pair_next[i] < block_last)) {
+					node_used[pair_node_a[i]] = true;
+					node_used[pair_node_b[i]] = true;
+				}
+			}
+			for (i = 0; i < nr_nodes; i++) {
+				if (node_used[i])
+					used_nodes.push_back(i);
+			}
+			if (used_nodes.empty())				// Pairs settled, or resumed beyond this block
+				continue;
+		}
+		if (!only_cdiagrams)
+			netOnZeroDXC_xc_generate_bank(surrogate_bank, sequences, used_nodes, M, block_first, block_last, seed, number_threads, timing);
+
+		double	block_start_time = omp_get_wtime();
+		#pragma omp parallel num_threads(number_threads)
+		{
+			Array2D <double>	cdiagram_data(W, K, 0.0);
+			Array2D <double>	cdiagram_surr(W, K, 0.0);
+			Array2D <double>	pdiagram(W, K, 0.0);
+			CumulativeSumsXC	sums_surrogate;
+			StageClock		thread_clock;
+			StageClock		pair_clock;
+			netOnZeroDXC_start_clock(thread_clock);
+
+			#pragma omp for schedule(dynamic)
+			for (int p = 0; p < nr_pairs; p++) {
+				int	a = pair_node_a[p];
+				int	b = pair_node_b[p];
+				int	error = 0;
+				int	m = pair_next[p];
+				bool	settled = false;
+				if (!pair_open[p] || ((c > 0) && (m >= block_last)))
+					continue;
+				ArrayView2D <int>	counts = pair_counts[(nr_blocks > 1)? p : omp_get_thread_num()];
+				netOnZeroDXC_start_clock(pair_clock);
+				if (c == 0)
+					counts.fill(0);
+				if ((c == 0) && checkpoint && (resume_state.status[p] == CHECKPOINT_PAIR_DONE)) {	// Its diagram was written before resuming
+					pair_open[p] = 0;
+					surrogates_used[p] = resume_state.surrogates[p];
+					if (write_container) {
+						#pragma omp critical (checkpoint)
+						error = netOnZeroDXC_read_checkpoint_pair(checkpoint_files, resume_state, p, counts);
+						if (!error) {
+							netOnZeroDXC_convert_counts_to_pdiagram(pdiagram, counts, W, surrogates_used[p]);
+							error = results_writer.add("pdiag", node_labels[a], node_labels[b], pdiagram);
+						}
+						if (error) {
+							#pragma omp atomic write
+							write_error = true;
+						}
+					}
+					continue;
+				} else if ((c == 0) && checkpoint && (resume_state.status[p] == CHECKPOINT_PAIR_PARTIAL)) {
+					#pragma omp critical (checkpoint)
+					{
+						PairProgress &	saved = resume_state.partial[resume_state.partial_index[p]];
+						if (netOnZeroDXC_check_chunks_prefix(saved)) {
+							std::copy(saved.counts.data(), saved.counts.data() + (size_t) W * K, counts.data());
+							m = saved.surrogates;
+						}
+						saved.pair = -1;
+					}
+					pair_next[p] = m;
+					if ((m >= block_last) && (m < m_last))
+						continue;
+				}
+				netOnZeroDXC_compute_cdiagram(cdiagram_data, sequences, a, b, L, W, apply_shift, shift);
+				netOnZeroDXC_lap_clock(timing, TIMING_STAGE_CDIAGRAM, pair_clock, 1);
+				if (only_cdiagrams) {
+					pair_open[p] = 0;
+					error = netOnZeroDXC_write_diagram(&results_writer, cdiagram_data, options.output_folder, options.output_prefix, "cdiag", '_', node_labels[a], node_labels[b],
+									options.separator_char);
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_WRITE, pair_clock, 1);
+				} else {
+					while ((m < block_last) && !settled) {
+						if (checkpoint && (nr_blocks == 1) && (m > 0) && ((m % SEQUENTIAL_STOP_STEP) == 0)) {
+							#pragma omp critical (checkpoint)
+							{
+								PairProgress &	slot = thread_progress[omp_get_thread_num()];
+								slot.pair = p;
+								slot.surrogates = m;
+								std::fill(slot.chunks_done.begin(), slot.chunks_done.end(), 0);
+								std::fill(slot.chunks_done.begin(), slot.chunks_done.begin() + m / SEQUENTIAL_STOP_STEP, 1);
+								std::copy(counts.data(), counts.data() + (size_t) W * K, slot.counts.data());
+								if (netOnZeroDXC_checkpoint_due(checkpoint_files))
+									error = netOnZeroDXC_save_checkpoint_snapshot(checkpoint_files, resume_state, thread_progress);
+							}
+							if (error)
+								break;
+						}
+						netOnZeroDXC_count_surrogate_exceedances(counts, cdiagram_data, surrogate_bank[a], surrogate_bank[b], m, m + 1, cdiagram_surr, sums_surrogate,
+										L, W, apply_shift, shift);
+						m++;
+						settled = netOnZeroDXC_check_counts_settled(stop_rule, counts, W, m);
+					}
+					pair_next[p] = m;
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_PDIAGRAM, pair_clock, (settled || (m == m_last))? 1 : 0);
+					if (!error && !settled && (m < m_last))
+						continue;					// Taken up again in the next block
+					pair_open[p] = 0;
+					surrogates_used[p] = m;
+					if (write_shard && !error) {
+						#pragma omp critical (shard)
+						error = netOnZeroDXC_append_checkpoint_pair(shard_files, p, m - m_first, counts);
+					} else if (!error) {
+						netOnZeroDXC_convert_counts_to_pdiagram(pdiagram, counts, W, m);
+						error = netOnZeroDXC_write_diagram(&results_writer, pdiagram, options.output_folder, options.output_prefix, "pdiag", '_', node_labels[a], node_labels[b],
+										options.separator_char);
+					}
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_WRITE, pair_clock, 1);
+					if (checkpoint && !error) {
+						#pragma omp critical (checkpoint)
+						{
+							error = netOnZeroDXC_append_checkpoint_pair(checkpoint_files, p, m, counts);
+							thread_progress[omp_get_thread_num()].pair = -1;
+						}
+					}
+				}
+				if (error) {
+					#pragma omp atomic write
+					write_error = true;
+				}
+				if (report_progress) {
+					#pragma omp critical (progress)
+					{
+						pairs_done++;
+						int	progress = (int) (10 * (pairs_done + pairs_restored) / nr_pairs);
+						if (progress != old_progress) {
+							old_progress = progress;
+							std::cerr << "INFO: " << pairs_done + pairs_restored << " of " << nr_pairs << " pairs done, elapsed "
+								<< netOnZeroDXC_format_duration(omp_get_wtime() - timing.start_time) << ", about "
+								<< netOnZeroDXC_format_duration(netOnZeroDXC_estimate_remaining_time(section_start_time, pairs_done, nr_pairs - pairs_restored))
+								<< " left.\n";
+						}
+					}
+				}
+			}
+
+			netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+		}
+		netOnZeroDXC_add_parallel_section(timing, number_threads, omp_get_wtime() - block_start_time);
+
+		if (checkpoint && (nr_blocks > 1) && !write_error && netOnZeroDXC_checkpoint_due(checkpoint_files)) {	// Pairs left open by this block
+			std::vector <PairProgress>	block_progress;
+			netOnZeroDXC_collect_open_pairs(block_progress, pair_counts, pair_next, pair_open, m_first, (M + SEQUENTIAL_STOP_STEP - 1) / SEQUENTIAL_STOP_STEP, SEQUENTIAL_STOP_STEP);
+			if (netOnZeroDXC_save_checkpoint_snapshot(checkpoint_files, resume_state, block_progress))
+				write_error = true;
+		}
+	}
+	surrogate_bank.clear();
+
+	StageClock	write_clock;
+	netOnZeroDXC_start_clock(write_clock);
+	int	close_error = results_writer.close();
+	netOnZeroDXC_close_checkpoint(shard_files, false);
+	netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, write_clock, 0);
+	if (close_error || write_error) {
+		netOnZeroDXC_close_checkpoint(checkpoint_files, false);
+		return 1;
+	}
+
+	if (!only_cdiagrams && !write_shard && (stop_rule.step > 0)) {
+		std::vector <std::string>	labels_a, labels_b;
+		for (i = 0; i < nr_pairs; i++) {
+			labels_a.push_back(node_labels[pair_node_a[i]]);
+			labels_b.push_back(node_labels[pair_node_b[i]]);
+		}
+		if (netOnZeroDXC_save_surrogates_used(labels_a, labels_b, surrogates_used, M, options.output_folder, options.output_prefix, '_', options.separator_char)) {
+			netOnZeroDXC_close_checkpoint(checkpoint_files, false);
+			return 1;
+		}
+	}
+	netOnZeroDXC_close_checkpoint(checkpoint_files, true);
+
+	return 0;
+}
+
+int netOnZeroDXC_xc_run_engine (const DiagramOptions & options, const std::vector < std::vector <double> > & sequences, const std::vector <std::string> & node_labels,
+				const std::vector <int> & pair_node_a, const std::vector <int> & pair_node_b, RunTiming & timing)
+{
+	// Batch mode with none of checkpoints, shards, results container or adaptive stopping: the run is a single netOnZeroDXC_run_job, the same
+	// engine netOnZeroDXC_engine.hpp offers to other programs, and the p value diagrams are written when it ends. Surrogates and counts are
+	// those of netOnZeroDXC_xc_run_batch, but the diagrams of all pairs are kept until the end instead of being written one pair at a time.
+	// Returns 1 on write errors, 2-5 as netOnZeroDXC_check_job.
+	AnalysisJob	job;
+	netOnZeroDXC_initialize_job(job);
+	job.sequences = &sequences;
+	job.pair_node_a = pair_node_a;
+	job.pair_node_b = pair_node_b;
+	job.W = options.nr_window_widths;
+	job.L = options.window_basewidth;
+	job.M = options.nr_surrogates;
+	job.tau = options.apply_tau;
+	job.seed = options.random_seed;
+	job.number_threads = netOnZeroDXC_xc_count_threads(options);
+	job.memory_limit = (size_t) options.memory_limit << 20;
+	int	nr_pairs = pair_node_a.size();
+	int	i;
+
+	DiagramEngineProgress	progress;
+	progress.timing = &timing;
+	progress.stage = TIMING_STAGE_CDIAGRAM;
+	progress.old_progress = 0;
+	progress.report_progress = options.print_timing;
+	progress.start_time = omp_get_wtime();
+	netOnZeroDXC_start_clock(progress.stage_clock);
+	job.callbacks.user_data = &progress;
+	job.callbacks.progress = netOnZeroDXC_xc_report_engine_progress;
+
+	AnalysisResults	results;
+	double	start_cpu_time = netOnZeroDXC_process_cpu_time();
+	int	error = netOnZeroDXC_run_job(results, job);
+	netOnZeroDXC_stop_clock(timing, progress.stage, progress.stage_clock, 0);
+	netOnZeroDXC_add_parallel_section(timing, job.number_threads, omp_get_wtime() - progress.start_time);
+	double	thread_cpu_time = (netOnZeroDXC_process_cpu_time() - start_cpu_time) / job.number_threads;
+	for (i = 0; (i < job.number_threads) && (i < (int) timing.threads.size()); i++)
+		timing.threads[i].cpu_time += thread_cpu_time;		// The engine does not time its threads: the team shares the CPU time of the job
+	if (error)
+		return error;
+
+	std::vector <char>	node_used(sequences.size(), 0);
+	long			nr_used_nodes = 0;
+	for (i = 0; i < nr_pairs; i++) {
+		node_used[pair_node_a[i]] = 1;
+		node_used[pair_node_b[i]] = 1;
+	}
+	for (i = 0; i < (int) sequences.size(); i++)
+		nr_used_nodes += node_used[i];
+	netOnZeroDXC_add_stage_elapsed(timing, TIMING_STAGE_CDIAGRAM, 0.0, nr_pairs);
+	netOnZeroDXC_add_stage_elapsed(timing, TIMING_STAGE_SURROGATES, 0.0, nr_used_nodes * job.M);
+	netOnZeroDXC_add_stage_elapsed(timing, TIMING_STAGE_PDIAGRAM, 0.0, nr_pairs);
+
+	StageClock	stage_clock;
+	netOnZeroDXC_start_clock(stage_clock);
+	for (i = 0; (i < nr_pairs) && !error; i++)
+		error = netOnZeroDXC_save_diagram(results.diagrams_pvalue[i], options.output_folder, options.output_prefix, "pdiag", '_', node_labels[pair_node_a[i]],
+						node_labels[pair_node_b[i]], options.separator_char);
+	netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, stage_clock, nr_pairs);
+
+	return (error)? 1 : 0;
+}
+
+void netOnZeroDXC_xc_report_engine_progress (void * user_data, int stage, long done, long nr_tasks)
+{
+	// Engine callback: the time since the last change of stage goes to the stage that ended, and with report_progress every tenth of the
+	// p value tasks done is reported on standard error with the time left
+	DiagramEngineProgress &	progress = *((DiagramEngineProgress *) user_data);
+	int	timing_stage = (stage == ENGINE_STAGE_SURROGATES)? TIMING_STAGE_SURROGATES : TIMING_STAGE_PDIAGRAM;
+	if (timing_stage != progress.stage) {
+		netOnZeroDXC_stop_clock(*progress.timing, progress.stage, progress.stage_clock, 0);
+		progress.stage = timing_stage;
+	}
+
+	if (!progress.report_progress || (stage != ENGINE_STAGE_PDIAGRAMS))
+		return;
+	int	tenths = (int) (10 * done / nr_tasks);
+	if (tenths != progress.old_progress) {
+		progress.old_progress = tenths;
+		std::cerr << "INFO: " << 10 * tenths << "% of the p value diagrams done, elapsed " << netOnZeroDXC_format_duration(omp_get_wtime() - progress.timing->start_time)
+			<< ", about " << netOnZeroDXC_format_duration(netOnZeroDXC_estimate_remaining_time(progress.start_time, done, nr_tasks)) << " left.\n";
+	}
+}
+
+int netOnZeroDXC_xc_generate_bank (std::vector < std::vector < std::vector <double> > > & surrogate_bank, const std::vector < std::vector <double> > & sequences,
+				const std::vector <int> & used_nodes, int M, int m_first, int m_last, unsigned int seed, int number_threads, RunTiming & timing)
+{
+	// Surrogates m_first to m_last - 1 of every node in used_nodes, as (node, surrogate) tasks, into surrogate_bank[node][m] (M slots per node);
+	// the surrogates the bank held before, of a previous block, are freed first. Surrogate seeds depend only on (seed, node, surrogate), so the
+	// bank does not depend on the number of threads nor on the blocks it is generated in.
+	int	nr_nodes = sequences.size();
+	int	N = sequences[0].size();
+	int	i;
+
+	for (i = 0; i < nr_nodes; i++)
+		netOnZeroDXC_release_surrogates(surrogate_bank[i], 0, 0);
+
+	int	nr_used = used_nodes.size();
+	std::vector < std::vector <double> >	values_distribution(nr_nodes);
+	std::vector < std::vector <double> >	fft_amplitudes(nr_nodes);
+	for (i = 0; i < nr_used; i++) {
+		netOnZeroDXC_initialize_surrogate_generation(values_distribution[used_nodes[i]], fft_amplitudes[used_nodes[i]], sequences, used_nodes[i]);
+		surrogate_bank[used_nodes[i]].resize(M);
+	}
+
+	int	nr_range = m_last - m_first;
+	long	nr_tasks = (long) nr_used * nr_range;
+	double	section_start_time = omp_get_wtime();
+	#pragma omp parallel num_threads(number_threads)
+	{
+		SurrogateGenerator	generator;
+		StageClock		thread_clock;
+		long			thread_iterations = 0;
+		int			thread_max_iterations = 0;
+		netOnZeroDXC_allocate_surrogate_generator(generator, N);
+		netOnZeroDXC_start_clock(thread_clock);
+		#pragma omp for schedule(dynamic)
+		for (long t = 0; t < nr_tasks; t++) {
+			int	node = used_nodes[t / nr_range];
+			int	m = m_first + t % nr_range;
+			netOnZeroDXC_generate_surrogate_sequence(surrogate_bank[node][m], generator, sequences[node], values_distribution[node], fft_amplitudes[node],
+								TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(seed, node, m));
+			thread_iterations += generator.iterations;
+			if (generator.iterations > thread_max_iterations)
+				thread_max_iterations = generator.iterations;
+		}
+		netOnZeroDXC_free_surrogate_generator(generator);
+		netOnZeroDXC_add_surrogate_iterations(timing, 0, thread_iterations, thread_max_iterations);
+		netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+		netOnZeroDXC_lap_clock(timing, TIMING_STAGE_SURROGATES, thread_clock, 0);
+	}
+	netOnZeroDXC_add_surrogate_iterations(timing, nr_tasks, 0, 0);
+	netOnZeroDXC_add_stage_elapsed(timing, TIMING_STAGE_SURROGATES, omp_get_wtime() - section_start_time, nr_tasks);
+	netOnZeroDXC_add_parallel_section(timing, number_threads, omp_get_wtime() - section_start_time);
+
+	return 0;
+}
+
+int netOnZeroDXC_xc_run_batch_multitau (const DiagramOptions & options, const std::vector < std::vector <double> > & sequences, const std::vector <std::string> & node_labels,
+				const std::vector <int> & pair_node_a, const std::vector <int> & pair_node_b, RunTiming & timing)
+{
+	// As netOnZeroDXC_xc_run_batch for every delay of tau_list in a single pass: the surrogate bank is generated once, and for every pair, data or
+	// surrogate, the cumulative sums are computed once and only their delayed products are moved from one delay to the next.
+	// As there, if the bank does not fit in memory_limit bytes it is generated in blocks, and the counts of every pair and delay are kept in between.
+	// The diagrams of delay tau go to [prefix_]tau<tau>_pdiag_<#>_<#>.dat (cdiag with -C), the same files a run with -tau <tau> would write.
+	// Returns 1 on write errors.
+	bool	only_cdiagrams = options.print_corr_diagram;
+	bool	report_progress = options.print_timing;
+	int	W = options.nr_window_widths;
+	int	L = options.window_basewidth;
+	int	M = options.nr_surrogates;
+	const std::vector <int> &	tau_list = options.tau_list;
+	unsigned int	seed = options.random_seed;
+	int	number_threads = netOnZeroDXC_xc_count_threads(options);
+	size_t	memory_limit = (size_t) options.memory_limit << 20;
+	int	nr_nodes = sequences.size();
+	int	nr_pairs = pair_node_a.size();
+	int	nr_taus = tau_list.size();
+	int	N = sequences[0].size();
+	int	i, t, k;
+
+	std::vector <int>		K(nr_taus, 0);
+	std::vector <std::string>	tau_prefix(nr_taus);
+	for (t = 0; t < nr_taus; t++) {
+		for (k = W*L / 2 - 1; k < N - W*L / 2 - tau_list[t]; k = k + L)
+			K[t]++;
+		std::ostringstream	name;
+		if (options.output_prefix.size())
+			name << options.output_prefix << "_";
+		name << "tau" << tau_list[t];
+		tau_prefix[t] = name.str();
+	}
+
+	std::vector <int>	used_nodes;
+	std::vector <bool>	node_used(nr_nodes, false);
+	for (i = 0; i < nr_pairs; i++) {
+		node_used[pair_node_a[i]] = true;
+		node_used[pair_node_b[i]] = true;
+	}
+	for (i = 0; i < nr_nodes; i++) {
+		if (node_used[i])
+			used_nodes.push_back(i);
+	}
+
+	size_t	counts_bytes = 0;
+	for (t = 0; t < nr_taus; t++)
+		counts_bytes += (size_t) nr_pairs * W * K[t] * sizeof(int);
+	int	block = (only_cdiagrams)? M : netOnZeroDXC_surrogate_block_size(used_nodes.size(), N, M, counts_bytes, memory_limit);
+	int	nr_blocks = (block < M)? (M + block - 1) / block : 1;
+	if (nr_blocks > 1)
+		std::cerr << "INFO: the surrogates of all nodes do not fit in memory: they are generated in " << nr_blocks << " blocks of " << block << ".\n";
+	std::vector < std::vector < std::vector <double> > >	surrogate_bank(nr_nodes);
+	std::vector < Array3D <int> >				pair_counts(nr_taus);		// Only with several blocks
+	if (nr_blocks > 1) {
+		for (t = 0; t < nr_taus; t++)
+			pair_counts[t].resize(nr_pairs, W, K[t], 0);
+	}
+
+	ResultsWriter	results_writer;							// Never opened: every diagram goes to its own file
+	bool	write_error = false;
+	long	pairs_done = 0;
+	int	old_progress = 0;
+	int	c;
+	double	section_start_time = omp_get_wtime();
+	for (c = 0; (c < nr_blocks) && !write_error; c++) {
+		int	block_first = c * block;
+		int	block_last = (block_first + block < M)? block_first + block : M;
+		if (!only_cdiagrams)
+			netOnZeroDXC_xc_generate_bank(surrogate_bank, sequences, used_nodes, M, block_first, block_last, seed, number_threads, timing);
+
+		double	block_start_time = omp_get_wtime();
+		#pragma omp parallel num_threads(number_threads)
+		{
+			std::vector < Array2D <double> >	cdiagram_data(nr_taus);
+			std::vector < Array2D <double> >	cdiagram_surr(nr_taus);
+			std::vector < Array2D <int> >		thread_counts(nr_taus);
+			std::vector < ArrayView2D <int> >	counts(nr_taus);
+			Array2D <double>			pdiagram;
+			CumulativeSumsXC			sums;
+			StageClock				thread_clock;
+			StageClock				pair_clock;
+			int					s;
+			for (s = 0; s < nr_taus; s++) {
+				cdiagram_data[s].resize(W, K[s], 0.0);
+				cdiagram_surr[s].resize(W, K[s], 0.0);
+				if (nr_blocks == 1)
+					thread_counts[s].resize(W, K[s], 0);
+			}
+			netOnZeroDXC_start_clock(thread_clock);
+
+			#pragma omp for schedule(dynamic)
+			for (int p = 0; p < nr_pairs; p++) {
+				int	a = pair_node_a[p];
+				int	b = pair_node_b[p];
+				int	error = 0;
+				int	m;
+				netOnZeroDXC_start_clock(pair_clock);
+				netOnZeroDXC_initialize_cumulative_sums(sums, sequences[a], sequences[b], tau_list[0]);
+				for (s = 0; s < nr_taus; s++) {
+					if (s > 0)
+						netOnZeroDXC_update_cumulative_shift(sums, sequences[a], sequences[b], tau_list[s]);
+					netOnZeroDXC_compute_cdiagram_cumulative(cdiagram_data[s], sums, L, W, (tau_list[s] > 0), tau_list[s]);
+				}
+				netOnZeroDXC_lap_clock(timing, TIMING_STAGE_CDIAGRAM, pair_clock, nr_taus);
+				if (only_cdiagrams) {
+					for (s = 0; (s < nr_taus) && !error; s++)
+						error = netOnZeroDXC_write_diagram(&results_writer, cdiagram_data[s], options.output_folder, tau_prefix[s], "cdiag", '_',
+										node_labels[a], node_labels[b], options.separator_char);
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_WRITE, pair_clock, nr_taus);
+				} else {
+					for (s = 0; s < nr_taus; s++) {
+						counts[s] = (nr_blocks > 1)? pair_counts[s][p] : ArrayView2D <int> (thread_counts[s]);
+						if (c == 0)
+							counts[s].fill(0);
+					}
+					for (m = block_first; m < block_last; m++) {
+						netOnZeroDXC_initialize_cumulative_sums(sums, surrogate_bank[a][m], surrogate_bank[b][m], tau_list[0]);
+						for (s = 0; s < nr_taus; s++) {
+							if (s > 0)
+								netOnZeroDXC_update_cumulative_shift(sums, surrogate_bank[a][m], surrogate_bank[b][m], tau_list[s]);
+							netOnZeroDXC_count_cumulative_exceedances(counts[s], cdiagram_data[s], sums, cdiagram_surr[s], L, W, (tau_list[s] > 0), tau_list[s]);
+						}
+					}
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_PDIAGRAM, pair_clock, (c == nr_blocks - 1)? nr_taus : 0);
+					if (c < nr_blocks - 1)
+						continue;					// Taken up again in the next block
+					for (s = 0; (s < nr_taus) && !error; s++) {
+						pdiagram.resize(W, K[s], 0.0);
+						netOnZeroDXC_convert_counts_to_pdiagram(pdiagram, counts[s], W, M);
+						error = netOnZeroDXC_write_diagram(&results_writer, pdiagram, options.output_folder, tau_prefix[s], "pdiag", '_',
+										node_labels[a], node_labels[b], options.separator_char);
+					}
+					netOnZeroDXC_lap_clock(timing, TIMING_STAGE_WRITE, pair_clock, nr_taus);
+				}
+				if (error) {
+					#pragma omp atomic write
+					write_error = true;
+				}
+				if (report_progress) {
+					#pragma omp critical (progress)
+					{
+						pairs_done++;
+						int	progress = (int) (10 * pairs_done / nr_pairs);
+						if (progress != old_progress) {
+							old_progress = progress;
+							std::cerr << "INFO: " << pairs_done << " of " << nr_pairs << " pairs done, elapsed "
+								<< netOnZeroDXC_format_duration(omp_get_wtime() - timing.start_time) << ", about "
+								<< netOnZeroDXC_format_duration(netOnZeroDXC_estimate_remaining_time(section_start_time, pairs_done, nr_pairs)) << " left.\n";
+						}
+					}
+				}
+			}
+
+			netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+		}
+		netOnZeroDXC_add_parallel_section(timing, number_threads, omp_get_wtime() - block_start_time);
+	}
+	surrogate_bank.clear();
+
+	return (write_error)? 1 : 0;
+}
+
+#ifdef NETONZERODXC_USE_CUDA
+int netOnZeroDXC_xc_run_batch_gpu (const DiagramOptions & options, const std::vector < std::vector <double> > & sequences, const std::vector <std::string> & node_labels,
+				const std::vector <int> & pair_node_a, const std::vector <int> & pair_node_b, RunTiming & timing)
+{
+	// As netOnZeroDXC_xc_run_batch for p value diagrams, with surrogates and exceedance counts computed on the GPU (netOnZeroDXC_gpu.hpp):
+	// the surrogates of all nodes involved are kept on the device, as many at a time as fit in its memory, and each pair only brings back
+	// its counts. Seeds and IAAFT steps are those of the CPU, so diagrams agree with it up to rounding. Correlation diagrams of the data
+	// are computed on the host. Returns 1 on write errors, 5 on GPU errors, 6 if the GPU memory cannot hold one surrogate per node.
+	bool	write_container = options.write_container;
+	bool	report_progress = options.print_timing;
+	int	W = options.nr_window_widths;
+	int	L = options.window_basewidth;
+	int	M = options.nr_surrogates;
+	int	tau = options.apply_tau;
+	unsigned int	seed = options.random_seed;
+	int	nr_nodes = sequences.size();
+	int	nr_pairs = pair_node_a.size();
+	int	N = sequences[0].size();
+	bool	apply_shift = (tau > 0);
+	int	shift = (apply_shift)? tau : 0;
+	int	i, k, p;
+
+	int	K = 0;
+	for (k = W*L / 2 - 1; k < N - W*L / 2 - shift; k = k + L)
+		K++;
+
+	bool	sharded = (options.nr_shards > 0);
+	int	m_first = (sharded && options.split_surrogates)? (int) ((long) options.shard_index * M / options.nr_shards) : 0;
+	int	m_last = (sharded && options.split_surrogates)? (int) ((long) (options.shard_index + 1) * M / options.nr_shards) : M;
+	std::vector <int>	selected_pairs;
+	for (i = 0; i < nr_pairs; i++) {
+		if (!sharded || options.split_surrogates || ((i % options.nr_shards) == options.shard_index))
+			selected_pairs.push_back(i);
+	}
+	int	nr_selected = selected_pairs.size();
+
+	CheckpointFiles	shard_files;
+	shard_files.journal = NULL;
+	if (sharded) {
+		CheckpointHeader	header;
+		netOnZeroDXC_fill_checkpoint_header(header, sequences, pair_node_a, pair_node_b, W, L, K, M, SEQUENTIAL_STOP_STEP, shift, seed, -1.0, -1.0);
+		if (netOnZeroDXC_open_shard_file(shard_files, header, options.output_folder, options.output_prefix, '_', options.shard_index))
+			return 1;
+		write_container = false;						// Diagrams are written by the merge step
+	}
+
+	ResultsWriter	results_writer;
+	if (write_container) {
+		if (results_writer.open(netOnZeroDXC_generate_filepath(options.output_folder, options.output_prefix, "results", '_', "", ""), options.compress_container))
+			return 1;
+	}
+
+	std::vector <int>	node_slot(nr_nodes, -1);
+	std::vector <int>	used_nodes;
+	for (i = 0; i < nr_selected; i++) {
+		node_slot[pair_node_a[selected_pairs[i]]] = 0;
+		node_slot[pair_node_b[selected_pairs[i]]] = 0;
+	}
+	for (i = 0; i < nr_nodes; i++) {
+		if (node_slot[i] == 0) {
+			node_slot[i] = used_nodes.size();
+			used_nodes.push_back(i);
+		}
+	}
+	int	nr_used = used_nodes.size();
+
+	StageClock	stage_clock;
+	StageClock	thread_clock;
+	netOnZeroDXC_start_clock(thread_clock);
+	netOnZeroDXC_start_clock(stage_clock);
+	GpuEngine	engine;
+	int	error = netOnZeroDXC_gpu_allocate_engine(engine, options.gpu_device, N, W, L, K, shift, nr_used, m_last - m_first, 0);
+	if (error) {
+		results_writer.close();
+		netOnZeroDXC_close_checkpoint(shard_files, false);
+		return (error == 2)? 6 : 5;
+	}
+	std::vector <double>	values_distribution, fft_amplitudes;
+	for (i = 0; (i < nr_used) && !error; i++) {
+		netOnZeroDXC_initialize_surrogate_generation(values_distribution, fft_amplitudes, sequences, used_nodes[i]);
+		error = netOnZeroDXC_gpu_load_node(engine, i, values_distribution, fft_amplitudes);
+	}
+	netOnZeroDXC_stop_clock(timing, TIMING_STAGE_SURROGATES, stage_clock, 0);
+
+	// Surrogate indexes are split in chunks that fit on the device; counts of a pair are kept across chunks only when there are several
+	int	chunk = engine.chunk;
+	int	nr_chunks = (m_last - m_first + chunk - 1) / chunk;
+	Array2D <double>	cdiagram_data(W, K, 0.0);
+	Array2D <double>	pdiagram(W, K, 0.0);
+	Array3D <int>		pair_counts((nr_chunks > 1)? nr_selected : 1, W, K, 0);
+	std::vector <SurrogateStream>	streams;
+	bool	write_error = false;
+	int	old_progress = 0;
+	int	c, s;
+	for (c = 0; (c < nr_chunks) && !error; c++) {
+		int	first = m_first + c * chunk;
+		int	nr_chunk = (m_last - first < chunk)? m_last - first : chunk;
+		long	iterations = 0;
+		int	max_iterations = 0;
+		streams.resize(nr_chunk);
+		for (i = 0; (i < nr_used) && !error; i++) {
+			for (s = 0; s < nr_chunk; s++)
+				streams[s] = netOnZeroDXC_surrogate_stream(seed, used_nodes[i], first + s);
+			error = netOnZeroDXC_gpu_generate_surrogates(engine, i, sequences[used_nodes[i]], streams, TOLERANCE_SURROGATES, iterations, max_iterations);
+		}
+		netOnZeroDXC_add_surrogate_iterations(timing, (long) nr_used * nr_chunk, iterations, max_iterations);
+		netOnZeroDXC_stop_clock(timing, TIMING_STAGE_SURROGATES, stage_clock, (long) nr_used * nr_chunk);
+
+		double	section_start_time = omp_get_wtime();
+		for (p = 0; (p < nr_selected) && !error; p++) {
+			int	pair = selected_pairs[p];
+			int	a = pair_node_a[pair];
+			int	b = pair_node_b[pair];
+			ArrayView2D <int>	counts = pair_counts[(nr_chunks > 1)? p : 0];
+			if ((c == 0) || (nr_chunks == 1))
+				counts.fill(0);
+			netOnZeroDXC_compute_cdiagram(cdiagram_data, sequences, a, b, L, W, apply_shift, shift);
+			netOnZeroDXC_stop_clock(timing, TIMING_STAGE_CDIAGRAM, stage_clock, (c == 0)? 1 : 0);
+			error = netOnZeroDXC_gpu_count_exceedances(engine, node_slot[a], node_slot[b], nr_chunk, cdiagram_data, counts);
+			netOnZeroDXC_stop_clock(timing, TIMING_STAGE_PDIAGRAM, stage_clock, (c == 0)? 1 : 0);
+			if (error || (c < nr_chunks - 1))
+				continue;
+
+			int	write_status;
+			if (sharded) {
+				write_status = netOnZeroDXC_append_checkpoint_pair(shard_files, pair, m_last - m_first, counts);
+			} else {
+				netOnZeroDXC_convert_counts_to_pdiagram(pdiagram, counts, W, M);
+				write_status = netOnZeroDXC_write_diagram(&results_writer, pdiagram, options.output_folder, options.output_prefix, "pdiag", '_', node_labels[a], node_labels[b], options.separator_char);
+			}
+			netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, stage_clock, 1);
+			if (write_status)
+				write_error = true;
+			if (report_progress) {
+				int	progress = (int) (10 * (p + 1) / nr_selected);
+				if (progress != old_progress) {
+					old_progress = progress;
+					std::cerr << "INFO: " << p + 1 << " of " << nr_selected << " pairs done, elapsed "
+						<< netOnZeroDXC_format_duration(omp_get_wtime() - timing.start_time) << ", about "
+						<< netOnZeroDXC_format_duration(netOnZeroDXC_estimate_remaining_time(section_start_time, p + 1, nr_selected)) << " left.\n";
+				}
+			}
+		}
+	}
+	netOnZeroDXC_gpu_free_engine(engine);
+	netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+
+	int	close_error = results_writer.close();
+	netOnZeroDXC_close_checkpoint(shard_files, false);
+	netOnZeroDXC_stop_clock(timing, TIMING_STAGE_WRITE, stage_clock, 0);
+	if (error)
+		return 5;
+	if (close_error || write_error)
+		return 1;
+
+	return 0;
+}
+#endif
+
+int netOnZeroDXC_xc_merge_shards (const DiagramOptions & options, const std::vector < std::vector <double> > & sequences, const std::vector <std::string> & node_labels,
+				const std::vector <int> & pair_node_a, const std::vector <int> & pair_node_b, RunTiming & timing)
+{
+	// Reduce step of a distributed run: the counts of every pair are added up over the shard files, whether the shards split the pairs or the
+	// surrogates, and the diagrams are written as netOnZeroDXC_xc_run_batch would, along with [prefix_]surrogates_used.dat with adaptive stopping.
+	// Shard files are checked against the data and parameters of this run; they are kept, so that a merge can be repeated.
+	// Returns 1 on write errors, 2-4 as netOnZeroDXC_read_shard_file, 5 if some pair or surrogate was not found in any shard.
+	int	W = options.nr_window_widths;
+	int	L = options.window_basewidth;
+	int	M = options.nr_surrogates;
+	int	tau = options.apply_tau;
+	unsigned int	seed = options.random_seed;
+	int	nr_shards = options.merge_shards;
+	int	nr_pairs = pair_node_a.size();
+	int	N = sequences[0].size();
+	int	shift = (tau > 0)? tau : 0;
+	bool	adaptive = (options.adaptive_error > 0.0);
+	int	i, k, s;
+
+	int	K = 0;
+	for (k = W*L / 2 - 1; k < N - W*L / 2 - shift; k = k + L)
+		K++;
+
+	StageClock	stage_clock;
+	netOnZeroDXC_start_clock(stage_clock);
+	CheckpointHeader	header;
+	netOnZeroDXC_fill_checkpoint_header(header, sequences, pair_node_a, pair_node_b, W, L, K, M, SEQUENTIAL_STOP_STEP, shift, seed, options.adaptive_alpha, options.adaptive_error);
+	std::vector <CheckpointFiles>	shard_files(nr_shards);
+	std::vector <CheckpointState>	shard_states(nr_shards);
+	int	error = 0;
+	for (s = 0; (s < nr_shards) && !error; s++)
+		error = netOnZeroDXC_read_shard_file(shard_files[s], shard_states[s], header, options.output_folder, options.output_prefix, '_', s);
+
+	ResultsWriter	results_writer;
+	if (!error && options.write_container)
+		error = (results_writer.open(netOnZeroDXC_generate_filepath(options.output_folder, options.output_prefix, "results", '_', "", ""), options.compress_container))? 1 : 0;
+	netOnZeroDXC_stop_clock(timing, TIMING_STAGE_LOAD, stage_clock, nr_shards);
+
+	Array2D <int>		counts(W, K, 0);
+	Array2D <int>		shard_counts(W, K, 0);
+	Array2D <double>	pdiagram(W, K, 0.0);
+	std::vector <int>	surrogates_used(nr_pairs, 0);
+	size_t			c;
+	for (i = 0; (i < nr_pairs) && !error; i++) {
+		int	nr_found = 0;
+		counts.fill(0);
+		for (s = 0; (s < nr_shards) && !error; s++) {
+			if (shard_states[s].status[i] != CHECKPOINT_PAIR_DONE)
+				continue;
+			error = netOnZeroDXC_read_checkpoint_pair(shard_files[s], shard_states[s], i, shard_counts);
+			for (c = 0; c < (size_t) W * K; c++)
+				counts.data()[c] += shard_counts.data()[c];
+			surrogates_used[i] += shard_states[s].surrogates[i];
+			nr_found++;
+		}
+		if (error)
+			error = 3;
+		else if ((nr_found == 0) || (surrogates_used[i] > M) || (!adaptive && (surrogates_used[i] != M)) || (adaptive && (nr_found > 1)))
+			error = 5;
+		if (error)
+			break;
+		netOnZeroDXC_lap_clock(timing, TIMING_STAGE_PDIAGRAM, stage_clock, 1);
+		netOnZeroDXC_convert_counts_to_pdiagram(pdiagram, counts, W, surrogates_used[i]);
+		error = netOnZeroDXC_write_diagram(&results_writer, pdiagram, options.output_folder, options.output_prefix, "pdiag", '_', node_labels[pair_node_a[i]], node_labels[pair_node_b[i]],
+						options.separator_char);
+		netOnZeroDXC_lap_clock(timing, TIMING_STAGE_WRITE, stage_clock, 1);
+	}
+	for (s = 0; s < nr_shards; s++)
+		netOnZeroDXC_close_checkpoint(shard_files[s], false);
+	if (results_writer.close() && !error)
+		error = 1;
+	if (!error && adaptive) {
+		std::vector <std::string>	labels_a, labels_b;
+		for (i = 0; i < nr_pairs; i++) {
+			labels_a.push_back(node_labels[pair_node_a[i]]);
+			labels_b.push_back(node_labels[pair_node_b[i]]);
+		}
+		error = netOnZeroDXC_save_surrogates_used(labels_a, labels_b, surrogates_used, M, options.output_folder, options.output_prefix, '_', options.separator_char);
+	}
+	timing.stages[TIMING_STAGE_WRITE].elapsed_time = timing.stages[TIMING_STAGE_WRITE].thread_time;	// A serial step: both stages took as long as their thread time
+	timing.stages[TIMING_STAGE_PDIAGRAM].elapsed_time = timing.stages[TIMING_STAGE_PDIAGRAM].thread_time;
+
+	return error;
+}
+
+int netOnZeroDXC_xc_compute_adaptive_counts (Array2D <int> & exceedance_counts, const std::vector < std::vector <double> > & sequences, int index_a, int index_b,
+				ArrayView2D <const double> cdiagram_data, int W, int L, int M, int tau, unsigned int seed, const SequentialStopRule & stop_rule, int number_threads,
+				RunTiming & timing)
+{
+	// Surrogates of the two sequences are generated one step of the rule at a time, split among threads, and only the current step is kept.
+	// Seeds are those of the full bank, so that the counts after m surrogates are the same as without adaptive stopping.
+	// Both stages are interleaved: each thread adds its own time to them.
+	// Returns the number of surrogates used.
+	int	N = sequences[index_a].size();
+	int	K = exceedance_counts.cols();
+	int	step = stop_rule.step;
+	bool	apply_shift = (tau > 0);
+	int	shift = (apply_shift)? tau : 0;
+	int	i;
+
+	std::vector <double>	values_distribution_a, fft_amplitudes_a, values_distribution_b, fft_amplitudes_b;
+	netOnZeroDXC_initialize_surrogate_generation(values_distribution_a, fft_amplitudes_a, sequences, index_a);
+	netOnZeroDXC_initialize_surrogate_generation(values_distribution_b, fft_amplitudes_b, sequences, index_b);
+
+	std::vector < std::vector <double> >	step_bank_a(step), step_bank_b(step);
+	std::vector <SurrogateGenerator>	generators(number_threads);
+	for (i = 0; i < number_threads; i++)
+		netOnZeroDXC_allocate_surrogate_generator(generators[i], N);
+
+	exceedance_counts.fill(0);
+	int	m_done = 0;
+	while (m_done < M) {
+		int	nr_new = ((m_done + step) < M)? step : (M - m_done);
+
+		double	section_start_time = omp_get_wtime();
+		#pragma omp parallel num_threads(number_threads)
+		{
+			SurrogateGenerator &	generator = generators[omp_get_thread_num()];
+			StageClock		thread_clock;
+			StageClock		step_clock;
+			long			thread_surrogates = 0;
+			long			thread_iterations = 0;
+			int			thread_max_iterations = 0;
+			netOnZeroDXC_start_clock(thread_clock);
+			step_clock = thread_clock;
+			#pragma omp for schedule(dynamic)
+			for (int t = 0; t < 2 * nr_new; t++) {
+				if (t % 2)
+					netOnZeroDXC_generate_surrogate_sequence(step_bank_b[t / 2], generator, sequences[index_b], values_distribution_b, fft_amplitudes_b,
+										TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(seed, index_b, m_done + t / 2));
+				else
+					netOnZeroDXC_generate_surrogate_sequence(step_bank_a[t / 2], generator, sequences[index_a], values_distribution_a, fft_amplitudes_a,
+										TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(seed, index_a, m_done + t / 2));
+				thread_surrogates++;
+				thread_iterations += generator.iterations;
+				if (generator.iterations > thread_max_iterations)
+					thread_max_iterations = generator.iterations;
+			}
+			netOnZeroDXC_add_surrogate_iterations(timing, thread_surrogates, thread_iterations, thread_max_iterations);
+			netOnZeroDXC_lap_clock(timing, TIMING_STAGE_SURROGATES, step_clock, thread_surrogates);
+
+			Array2D <double>	cdiagram_surr(W, K, 0.0);
+			Array2D <int>		partial_counts(W, K, 0);
+			CumulativeSumsXC	sums_surrogate;
+			#pragma omp for schedule(dynamic)
+			for (int m = 0; m < nr_new; m++)
+				netOnZeroDXC_count_surrogate_exceedances(partial_counts, cdiagram_data, step_bank_a, step_bank_b, m, m + 1, cdiagram_surr, sums_surrogate, L, W, apply_shift, shift);
+
+			#pragma omp critical
+			{
+				netOnZeroDXC_merge_exceedance_counts(exceedance_counts, partial_counts, W);
+			}
+			netOnZeroDXC_lap_clock(timing, TIMING_STAGE_PDIAGRAM, step_clock, 0);
+			netOnZeroDXC_stop_thread_clock(timing, thread_clock);
+		}
+		netOnZeroDXC_add_parallel_section(timing, number_threads, omp_get_wtime() - section_start_time);
+
+		m_done += nr_new;
+		if (netOnZeroDXC_check_counts_settled(stop_rule, exceedance_counts, W, m_done))
+			break;
+	}
+
+	for (i = 0; i < number_threads; i++)
+		netOnZeroDXC_free_surrogate_generator(generators[i]);
+	timing.stages[TIMING_STAGE_PDIAGRAM].items++;
+
+	return m_done;
+}
+
+int netOnZeroDXC_xc_run_follow (const DiagramOptions & options)
+{
+	// Samples are appended block_columns * L rows at a time, from standard input as they arrive or from a whole file as if it did, and after
+	// every block of new columns the efficiencies of each pair and the matrix of time scales over all columns so far are written again.
+	// Returns 1 on write errors, 2 if the file cannot be read, 3 on inconsistent rows, 4 if the pairs cannot be listed, 5 if no column was complete.
+	int	W = options.nr_window_widths;
+	int	L = options.window_basewidth;
+	int	M = options.nr_surrogates;
+	int	tau = options.apply_tau;
+	unsigned int	seed = options.random_seed;
+	int	block_columns = options.follow_columns;
+	int	number_threads = netOnZeroDXC_xc_count_threads(options);
+	if (L % 2 != 0) {
+		L = L - 1;
+		std::cerr << "WARNING: window base width was an odd number; it is now reduced to " << L << ".\n";
+	}
+	int	shift = (tau > 0)? tau : 0;
+	int	block_rows = block_columns * L;
+	int	first_rows = (W - 1) * L + shift + block_rows;		// The first block_columns columns, after which every block_rows rows complete as many
+	int	error, i;
+
+	std::vector < std::vector <double> >	sequences;
+	std::vector <std::string>		node_labels;
+	bool	end_of_stream = false;
+	if (options.read_from_file) {
+		error = netOnZeroDXC_load_single_file(sequences, node_labels, options.input_filename, options.separator_char);
+		if (error == 2)
+			return 2;
+		if (error)
+			return 3;
+		end_of_stream = true;
+	} else {
+		error = netOnZeroDXC_xc_read_stdin_rows(sequences, 0, first_rows, options.separator_char);
+		if (error == 3)
+			return 3;
+		end_of_stream = (error == 1);
+		char	temp_label[16];
+		for (i = 0; i < sequences.size(); i++) {
+			if ((i+1) < 10)
+				sprintf(temp_label, "0%d", i + 1);
+			else
+				sprintf(temp_label, "%d", i + 1);
+			node_labels.push_back(std::string(temp_label));
+		}
+	}
+	int	nr_nodes = sequences.size();
+	if (nr_nodes < 2)
+		return 3;
+
+	std::vector <int>	pair_node_a, pair_node_b;
+	if (netOnZeroDXC_xc_list_batch_pairs(pair_node_a, pair_node_b, options.batch_all_pairs, options.pairs_filename, nr_nodes, options.separator_char))
+		return 4;
+	int	nr_pairs = pair_node_a.size();
+
+	IncrementalAnalysis	analysis;
+	netOnZeroDXC_initialize_incremental(analysis, nr_nodes, pair_node_a, pair_node_b, W, L, M, tau, seed, options.follow_alpha);
+	std::vector <double>	window_widths(W, 0.0);
+	for (i = 0; i < W; i++)
+		window_widths[i] = (double) ((i + 1) * L);
+
+	std::vector < std::vector <double> >	block;
+	std::vector <double>			efficiency;
+	std::vector < std::vector <double> >	timescale_matrix;
+	size_t	next_row = 0;
+	int	nr_new_columns;
+	while (true) {
+		bool	last_block = end_of_stream;
+		if (options.read_from_file) {						// The file is replayed one block at a time
+			size_t	end_row = std::min(next_row + (size_t) ((next_row == 0)? first_rows : block_rows), sequences[0].size());
+			block.assign(nr_nodes, std::vector <double> ());
+			for (i = 0; i < nr_nodes; i++)
+				block[i].assign(sequences[i].begin() + next_row, sequences[i].begin() + end_row);
+			next_row = end_row;
+			last_block = (next_row == sequences[0].size());
+		} else {
+			block.swap(sequences);
+		}
+
+		double	block_start_time = omp_get_wtime();
+		if (netOnZeroDXC_append_samples(analysis, block, (last_block)? 1 : block_columns, nr_new_columns, number_threads))
+			return 3;
+		if (nr_new_columns > 0) {
+			for (i = 0; i < nr_pairs; i++) {
+				netOnZeroDXC_incremental_efficiency(efficiency, analysis, i);
+				error = netOnZeroDXC_save_linear_data(window_widths, efficiency, options.output_folder, options.output_prefix, "eff", '_',
+								node_labels[pair_node_a[i]], node_labels[pair_node_b[i]], options.separator_char);
+				if (error)
+					return 1;
+			}
+			netOnZeroDXC_incremental_wmatrix(timescale_matrix, analysis, nr_nodes, window_widths, options.follow_eta);
+			error = netOnZeroDXC_save_diagram(timescale_matrix, options.output_folder, options.output_prefix, "matrix", '_', "", "", options.separator_char);
+			if (error)
+				return 1;
+			if (options.print_timing) {
+				std::cerr << "INFO: block " << analysis.nr_blocks << ", " << nr_new_columns << " new columns (" << analysis.nr_columns << " in all), ";
+				std::cerr << omp_get_wtime() - block_start_time << " s.\n";
+			}
+		}
+		if (last_block)
+			break;
+
+		if (!options.read_from_file) {
+			error = netOnZeroDXC_xc_read_stdin_rows(sequences, nr_nodes, block_rows, options.separator_char);
+			if (error == 3)
+				return 3;
+			end_of_stream = (error == 1);
+		}
+	}
+
+	if (analysis.nr_columns == 0)
+		return 5;
+
+	return 0;
+}
+
+int netOnZeroDXC_xc_read_stdin_rows (std::vector < std::vector <double> > & sequences, int nr_nodes, int nr_rows, char separator_char)
+{
+	// Reads up to nr_rows rows from standard input into one sequence per node, without waiting for the end of the stream; with nr_nodes = 0,
+	// the number of nodes is that of the first row. Returns 1 at the end of the stream (the last rows are still stored), 3 on inconsistent rows.
+	std::string		line;
+	std::vector <double>	row;
+	int	c = 0;
+	int	nr_read = 0;
+	int	i;
+	sequences.assign(nr_nodes, std::vector <double> ());
+	while (nr_read < nr_rows) {
+		line.clear();
+		while (((c = getc(stdin)) != EOF) && (c != '\n'))
+			line.push_back((char) c);
+		if ((line.size() > 0) && (line[line.size() - 1] == '\r'))
+			line.erase(line.size() - 1);
+		if ((line.size() > 0) && (line[0] != '#')) {
+			netOnZeroDXC_parse_line(row, line.data(), line.data() + line.size(), separator_char);
+			if (sequences.size() == 0)
+				sequences.resize(row.size());
+			if (row.size() != sequences.size())
+				return 3;
+			for (i = 0; i < row.size(); i++)
+				sequences[i].push_back(row[i]);
+			nr_read++;
+		}
+		if (c == EOF)
+			return 1;
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_xc_report_timing (RunTiming & timing, bool print_timing, std::string timing_filename)
+{
+	// Summary on standard error and, if a file name is given, in JSON format. Returns 1 if the JSON file cannot be written.
+	netOnZeroDXC_finish_run_timing(timing);
+	if (print_timing) {
+		std::stringstream	summary;
+		netOnZeroDXC_format_timing_summary(summary, timing, "INFO: ");
+		std::cerr << summary.str();
+	}
+	if (timing_filename.size()) {
+		std::stringstream	content;
+		netOnZeroDXC_format_timing_json(content, timing);
+		if (netOnZeroDXC_save_log_file(content, timing_filename)) {
+			std::cerr << "ERROR: i/o error when writing the timing summary on file '" << timing_filename << "'. Please check permissions.\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}
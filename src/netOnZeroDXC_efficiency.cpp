@@ -48,30 +48,42 @@
 	#include "netOnZeroDXC_io.hpp"
 	#define INCLUDED_IOFUNCTIONS
 #endif
+#ifndef INCLUDED_IORESULTS
+	#include "netOnZeroDXC_io_results.hpp"
+	#define INCLUDED_IORESULTS
+#endif
 
 void netOnZeroDXC_eff_help (char *);
-int netOnZeroDXC_eff_parse_options (int, char **, bool &, bool &, double &, double &, std::string &, std::string &, char &);
+int netOnZeroDXC_eff_parse_options (int, char **, bool &, bool &, std::vector <double> &, double &, std::string &, std::string &, std::string &, std::string &, char &);
+int netOnZeroDXC_eff_load_container_diagram (std::vector < std::vector <double> > &, std::string, std::string, std::string);
+int netOnZeroDXC_eff_parse_thresholds (std::vector <double> &, const char *);
 int netOnZeroDXC_eff_check_diagram (const std::vector < std::vector <double> > &);
 
 int main(int argc, char *argv[]) {
 
 	bool	read_from_file = false;
 	bool	write_to_file = false;
-	double	threshold_significance = -1.0;
+	std::vector <double>	thresholds_significance;
 	double	window_basewidth = 1.0;
 	char	separator_char = 't';
 	std::string	selected_input_filename;
 	std::string	selected_output_filename;
+	std::string	selected_label_a;
+	std::string	selected_label_b;
 
 	int error;
-	error = netOnZeroDXC_eff_parse_options (argc, argv, read_from_file, write_to_file, threshold_significance, window_basewidth, selected_input_filename,
-					selected_output_filename, separator_char);
+	error = netOnZeroDXC_eff_parse_options (argc, argv, read_from_file, write_to_file, thresholds_significance, window_basewidth, selected_input_filename,
+					selected_output_filename, selected_label_a, selected_label_b, separator_char);
 	if (error)
 		exit(1);
 
 	std::vector < std::vector <double> > 	loaded_diagram;
 
-	if (read_from_file) {
+	if (read_from_file && netOnZeroDXC_check_results_file(selected_input_filename)) {
+		error = netOnZeroDXC_eff_load_container_diagram(loaded_diagram, selected_input_filename, selected_label_a, selected_label_b);
+		if (error)
+			exit(1);
+	} else if (read_from_file) {
 		error = netOnZeroDXC_load_single_table(loaded_diagram, selected_input_filename, separator_char);
 		if (error == 2) {
 			std::cerr << "ERROR: cannot read the selected file '" << selected_input_filename << "'.\n";
@@ -89,27 +101,22 @@ int main(int argc, char *argv[]) {
 		exit(1);
 
 
-	std::vector <double>	window_widths;
-	std::vector <double>	efficiency;
 	int	i, j;
-	double	temp_eta;
-	for (i = 0; i < loaded_diagram.size(); i++) {
-		temp_eta = 0.0;
-		for (j = 0; j < loaded_diagram[i].size(); j++) {
-			if (loaded_diagram[i][j] <= threshold_significance) {
-				temp_eta += 1.0;
-			}
-		}
-		temp_eta /= (double) loaded_diagram[i].size();
-		window_widths.push_back(window_basewidth * (i+1));
-		efficiency.push_back(temp_eta);
-	}
+	int	W = loaded_diagram.size();
+	int	nr_thresholds = thresholds_significance.size();
+	Array2D <double>	diagram(W, loaded_diagram[0].size(), 0.0);
+	for (i = 0; i < W; i++)
+		std::copy(loaded_diagram[i].begin(), loaded_diagram[i].end(), diagram[i]);
+
+	Array2D <double>	efficiencies(nr_thresholds, W, 0.0);		// All thresholds out of a single pass on the diagram
+	netOnZeroDXC_compute_efficiency_multithreshold(efficiencies.data(), W, diagram, thresholds_significance, true);
 
 	std::vector < std::vector <double> >	output_data;
-	std::vector <double>			w_eta(2, 0.0);
-	for (i = 0; i < window_widths.size(); i++) {
-		w_eta[0] = window_widths[i];
-		w_eta[1] = efficiency[i];
+	std::vector <double>			w_eta(nr_thresholds + 1, 0.0);
+	for (i = 0; i < W; i++) {
+		w_eta[0] = window_basewidth * (i+1);
+		for (j = 0; j < nr_thresholds; j++)
+			w_eta[j + 1] = efficiencies[j][i];
 		output_data.push_back(w_eta);
 	}
 
@@ -117,7 +124,10 @@ int main(int argc, char *argv[]) {
 		error = netOnZeroDXC_save_single_file(output_data, selected_output_filename, separator_char);
 	} else {
 		for (i = 0; i < output_data.size(); i++) {
-			std::cout << output_data[i][0] << separator_char << output_data[i][1] << "\n";
+			std::cout << output_data[i][0];
+			for (j = 1; j <= nr_thresholds; j++)
+				std::cout << separator_char << output_data[i][j];
+			std::cout << "\n";
 		}
 	}
 	if (error) {
@@ -133,27 +143,32 @@ void netOnZeroDXC_eff_help (char *program_name)
 	std::cerr << "Usage:\n";
 	std::cerr << "\t" << program_name << " -a <#> (<Options>)\t<\t<vector stream>\n";
 	std::cerr << "\nMandatory assignment:\n";
-	std::cerr << "\t-a <#>\t\tset p value significance threshold;\n";
+	std::cerr << "\t-a <#>\t\tset p value significance threshold; a list <#>,<#>,... or a range <first>:<step>:<last> gives one efficiency\n";
+	std::cerr << "\t\t\tcolumn per threshold, in the given order;\n";
 
 	std::cerr << "\nOptions:\n";
-	std::cerr << "\t-w <#>\t\tset the base window width (corresponding to the first row of the diagram), default is 1.\n";
+	std::cerr << "\t-w <#>\t\tset the base window width (corresponding to the first row of the diagram), default is 1;\n";
+	std::cerr << "\t-pair <a> <b>\tread the p-value diagram of the pair of labels a, b (e.g. 01 02) from the results container given with -i.\n";
 
 	std::cerr << "\nInput/output:\n";
-	std::cerr << "\t-i <fname>\tread from file 'fname' instead of standard input;\n";
+	std::cerr << "\t-i <fname>\tread from file 'fname' instead of standard input (text, binary, see netOnZeroDXC_convert, or results container);\n";
 	std::cerr << "\t-o <fname>\twrite to file 'fname' instead of standard output;\n";
 	std::cerr << "\t-s <@>\t\tselect label to choose column separator, default t (TAB); other valid options are s (space) or c (comma ',').\n";
 
 	std::cerr << "\n\t-h or --help\tshow this help.\n";
 }
 
-int netOnZeroDXC_eff_parse_options (int argc, char *argv[], bool & read_from_file, bool & write_to_file, double & threshold, double & basewidth,
-	 			std::string & input_filename, std::string & output_filename, char & separator_char)
+int netOnZeroDXC_eff_parse_options (int argc, char *argv[], bool & read_from_file, bool & write_to_file, std::vector <double> & thresholds, double & basewidth,
+	 			std::string & input_filename, std::string & output_filename, std::string & label_a, std::string & label_b, char & separator_char)
 {
 	int	n = 1;
 	while (n < argc) {
 		if (strcmp(argv[n], "-a") == 0) {
 			n++;
-			threshold = atof(argv[n]);
+			if (netOnZeroDXC_eff_parse_thresholds(thresholds, argv[n])) {
+				std::cerr << "ERROR: invalid list or range of significance thresholds '" << argv[n] << "'.\n";
+				return 1;
+			}
 
 		} else if (strcmp(argv[n], "-i") == 0) {
 			read_from_file = true;
@@ -170,6 +185,11 @@ int netOnZeroDXC_eff_parse_options (int argc, char *argv[], bool & read_from_fil
 		} else if( strcmp( argv[n], "-w" ) == 0 ) {
 			n++;
 			basewidth = atof(argv[n]);
+		} else if (strcmp(argv[n], "-pair") == 0) {
+			n++;
+			label_a = argv[n];
+			n++;
+			label_b = argv[n];
 
 		} else if ((strcmp("-h", argv[n]) == 0) || (strcmp("--help", argv[n]) == 0))  {
 			netOnZeroDXC_eff_help(argv[0]);
@@ -178,7 +198,7 @@ int netOnZeroDXC_eff_parse_options (int argc, char *argv[], bool & read_from_fil
 		n++;
 	}
 
-	if (threshold <= 0) {
+	if (thresholds.size() == 0) {
 		std::cerr << "ERROR: mandatory significance threshold not correctly set. Use " << argv[0] << " -h for a list of options.\n";
 		return 1;
 	}
@@ -186,6 +206,10 @@ int netOnZeroDXC_eff_parse_options (int argc, char *argv[], bool & read_from_fil
 		std::cerr << "ERROR: base window width is invalid (it is required to be positive).\n";
 		return 1;
 	}
+	if (label_a.size() && !read_from_file) {
+		std::cerr << "ERROR: a pair can only be selected in a results container read with -i. Use " << argv[0] << " -h for a list of options.\n";
+		return 1;
+	}
 	if (separator_char == 's') {
 		separator_char = ' ';
 	} else if (separator_char == 'c') {
@@ -197,6 +221,41 @@ int netOnZeroDXC_eff_parse_options (int argc, char *argv[], bool & read_from_fil
 	return 0;
 }
 
+int netOnZeroDXC_eff_parse_thresholds (std::vector <double> & thresholds, const char * argument)
+{
+	thresholds.clear();
+	std::string	text(argument);
+	size_t	first_colon = text.find(':');
+	if (first_colon != std::string::npos) {				// Range first:step:last, last included
+		size_t	second_colon = text.find(':', first_colon + 1);
+		if (second_colon == std::string::npos)
+			return 1;
+		double	first = atof(text.substr(0, first_colon).c_str());
+		double	step = atof(text.substr(first_colon + 1, second_colon - first_colon - 1).c_str());
+		double	last = atof(text.substr(second_colon + 1).c_str());
+		if ((first <= 0) || (step <= 0) || (last < first))
+			return 1;
+		int	s;
+		int	nr_steps = (int) floor((last - first) / step + 1e-9);
+		for (s = 0; s <= nr_steps; s++)
+			thresholds.push_back(first + s * step);
+		return 0;
+	}
+
+	size_t	start = 0;
+	size_t	comma;
+	do {								// List of values separated by commas
+		comma = text.find(',', start);
+		double	value = atof(text.substr(start, (comma == std::string::npos)? std::string::npos : comma - start).c_str());
+		if (value <= 0)
+			return 1;
+		thresholds.push_back(value);
+		start = comma + 1;
+	} while (comma != std::string::npos);
+
+	return 0;
+}
+
 int netOnZeroDXC_eff_check_diagram (const std::vector < std::vector <double> > & diagram)
 {
 	if (diagram.size() == 0) {
@@ -215,3 +274,26 @@ int netOnZeroDXC_eff_check_diagram (const std::vector < std::vector <double> > &
 
 	return 0;
 }
+
+int netOnZeroDXC_eff_load_container_diagram (std::vector < std::vector <double> > & diagram, std::string file_name, std::string label_a, std::string label_b)
+{
+	if (label_a.size() == 0) {
+		std::cerr << "ERROR: '" << file_name << "' is a results container: select the pair of its p-value diagram with -pair.\n";
+		return 1;
+	}
+
+	int	error = netOnZeroDXC_load_results_table(diagram, file_name, "pdiag", label_a, label_b);
+	if (error == 2) {
+		std::cerr << "ERROR: cannot read the selected file '" << file_name << "'.\n";
+	} else if (error == 3) {
+		std::cerr << "ERROR: the results container '" << file_name << "' is damaged.\n";
+	} else if (error == 4) {
+		std::cerr << "ERROR: the results container '" << file_name << "' was not completed: the run that wrote it was interrupted.\n";
+	} else if (error == 5) {
+		std::cerr << "ERROR: the results container '" << file_name << "' is compressed, and this program was compiled without zlib.\n";
+	} else if (error == 6) {
+		std::cerr << "ERROR: the results container '" << file_name << "' has no p-value diagram for the pair " << label_a << ", " << label_b << ".\n";
+	}
+
+	return (error)? 1 : 0;
+}
@@ -0,0 +1,306 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <vector>
+
+#include "omp.h"
+
+#ifndef INCLUDED_ALGORITHM
+	#include "netOnZeroDXC_algorithm.hpp"
+	#define INCLUDED_ALGORITHM
+#endif
+#ifndef INCLUDED_ENGINE
+	#include "netOnZeroDXC_engine.hpp"
+	#define INCLUDED_ENGINE
+#endif
+
+int netOnZeroDXC_engine_count_columns (int, int, int, int);
+bool netOnZeroDXC_engine_poll (const EngineCallbacks &, int, long, long, int &);
+
+void netOnZeroDXC_initialize_job (AnalysisJob & job)
+{
+	job.sequences = NULL;
+	job.pair_node_a.clear();
+	job.pair_node_b.clear();
+	job.W = 0;
+	job.L = 0;
+	job.M = 100;
+	job.tau = -1;
+	job.seed = 1;
+	job.threshold_alpha = 0.01;
+	job.threshold_eta = 0.5;
+	job.number_threads = 0;
+	job.memory_limit = 0;
+	job.callbacks.user_data = NULL;
+	job.callbacks.progress = NULL;
+	job.callbacks.cancelled = NULL;
+}
+
+int netOnZeroDXC_check_job (const AnalysisJob & job)
+{
+	// Returns 0 for a valid job; 2 if there are less than two sequences or their lengths differ, 3 if the windows do not fit in the sequences,
+	// the base width is odd or M < 1, 4 if a pair is out of range, 5 if the thresholds are not between 0 and 1
+	if ((job.sequences == NULL) || (job.sequences->size() < 2))
+		return 2;
+	const std::vector < std::vector <double> > &	sequences = *job.sequences;
+	int	nr_nodes = sequences.size();
+	int	i;
+	for (i = 1; i < nr_nodes; i++) {
+		if (sequences[i].size() != sequences[0].size())
+			return 2;
+	}
+
+	if ((job.W < 1) || (job.L < 2) || (job.L % 2 != 0) || (job.M < 1))
+		return 3;
+	if (netOnZeroDXC_engine_count_columns(sequences[0].size(), job.W, job.L, (job.tau > 0)? job.tau : 0) < 1)
+		return 3;
+
+	if (job.pair_node_a.size() != job.pair_node_b.size())
+		return 4;
+	for (i = 0; i < job.pair_node_a.size(); i++) {
+		if ((job.pair_node_a[i] < 0) || (job.pair_node_a[i] >= nr_nodes) || (job.pair_node_b[i] < 0) || (job.pair_node_b[i] >= nr_nodes))
+			return 4;
+		if (job.pair_node_a[i] == job.pair_node_b[i])
+			return 4;
+	}
+
+	if ((job.threshold_alpha <= 0.0) || (job.threshold_alpha >= 1.0) || (job.threshold_eta <= 0.0) || (job.threshold_eta >= 1.0))
+		return 5;
+
+	return 0;
+}
+
+int netOnZeroDXC_run_job (AnalysisResults & results, const AnalysisJob & job)
+{
+	// Same surrogates and p values as netOnZeroDXC_diagram in batch mode with the same seed; surrogates are generated once per node, one block at
+	// a time if they do not all fit in memory, then (pair, chunk of surrogates) tasks add their exceedances to the counts of the pair, and the
+	// block is freed. Returns 1 if cancelled, 2-5 as netOnZeroDXC_check_job.
+	int	error = netOnZeroDXC_check_job(job);
+	if (error)
+		return error;
+
+	const std::vector < std::vector <double> > &	sequences = *job.sequences;
+	const EngineCallbacks &				callbacks = job.callbacks;
+	int	nr_nodes = sequences.size();
+	int	N = sequences[0].size();
+	int	W = job.W;
+	int	L = job.L;
+	int	M = job.M;
+	bool	apply_shift = (job.tau > 0);
+	int	shift = (apply_shift)? job.tau : 0;
+	int	K = netOnZeroDXC_engine_count_columns(N, W, L, shift);
+	int	number_threads = (job.number_threads > 0)? job.number_threads : omp_get_max_threads();
+	int	i, j;
+
+	results.pair_node_a = job.pair_node_a;
+	results.pair_node_b = job.pair_node_b;
+	if (results.pair_node_a.size() == 0) {
+		for (i = 0; i < nr_nodes - 1; i++) {
+			for (j = i + 1; j < nr_nodes; j++) {
+				results.pair_node_a.push_back(i);
+				results.pair_node_b.push_back(j);
+			}
+		}
+	}
+	const std::vector <int> &	pair_node_a = results.pair_node_a;
+	const std::vector <int> &	pair_node_b = results.pair_node_b;
+	int	nr_pairs = pair_node_a.size();
+	results.K = K;
+	results.window_widths.assign(W, 0.0);
+	for (i = 0; i < W; i++)
+		results.window_widths[i] = (double) ((i + 1) * L);
+
+	std::vector <char>	node_used(nr_nodes, 0);
+	int			nr_used_nodes = 0;
+	for (i = 0; i < nr_pairs; i++) {
+		node_used[pair_node_a[i]] = 1;
+		node_used[pair_node_b[i]] = 1;
+	}
+	for (i = 0; i < nr_nodes; i++)
+		nr_used_nodes += node_used[i];
+
+	Array3D <double>	diagrams_correlation(nr_pairs, W, K, 0.0);
+	#pragma omp parallel for schedule(dynamic) num_threads(number_threads)
+	for (int p = 0; p < nr_pairs; p++)
+		netOnZeroDXC_compute_cdiagram(diagrams_correlation[p], sequences, pair_node_a[p], pair_node_b[p], L, W, apply_shift, shift);
+
+	size_t	pair_bytes = (size_t) nr_pairs * W * K * (sizeof(double) + sizeof(int));	// Correlation diagrams and counts, alive with every block
+	int	block = netOnZeroDXC_surrogate_block_size(nr_used_nodes, N, M, pair_bytes, job.memory_limit);
+	std::vector < std::vector <double> >			values_distribution(nr_nodes);
+	std::vector < std::vector <double> >			fft_amplitudes(nr_nodes);
+	std::vector < std::vector < std::vector <double> > >	surrogate_bank(nr_nodes);
+	for (i = 0; i < nr_nodes; i++) {
+		if (!node_used[i])
+			continue;
+		netOnZeroDXC_initialize_surrogate_generation(values_distribution[i], fft_amplitudes[i], sequences, i);
+		surrogate_bank[i].resize(M);
+	}
+
+	Array3D <int>	exceedance_counts(nr_pairs, W, K, 0);
+	bool	go_flag = 1;
+	int	old_progress_bank = -1;
+	int	old_progress_pairs = -1;
+	long	nr_bank_tasks = (long) nr_nodes * M;				// Over all blocks
+	long	nr_pair_tasks = 0;
+	long	bank_done = 0;
+	long	pairs_done = 0;
+	int	m_first;
+	for (m_first = 0; m_first < M; m_first += block)
+		nr_pair_tasks += (long) nr_pairs * ((((m_first + block < M)? block : M - m_first) + ENGINE_CHUNK_SIZE - 1) / ENGINE_CHUNK_SIZE);
+
+	for (m_first = 0; (m_first < M) && go_flag; m_first += block) {
+		int	m_last = (m_first + block < M)? m_first + block : M;
+		int	nr_range = m_last - m_first;
+		for (i = 0; i < nr_nodes; i++)
+			netOnZeroDXC_release_surrogates(surrogate_bank[i], m_first, m_last);
+
+		long	nr_tasks = (long) nr_nodes * nr_range;
+		#pragma omp parallel num_threads(number_threads)
+		{
+			SurrogateGenerator	generator;
+			netOnZeroDXC_allocate_surrogate_generator(generator, N);
+
+			#pragma omp for schedule(dynamic)
+			for (long t = 0; t < nr_tasks; t++) {
+				bool	go_on;
+				#pragma omp atomic read
+				go_on = go_flag;
+				int	node = t / nr_range;
+				int	m = m_first + t % nr_range;
+				if (go_on && node_used[node])
+					netOnZeroDXC_generate_surrogate_sequence(surrogate_bank[node][m], generator, sequences[node], values_distribution[node], fft_amplitudes[node],
+										TOLERANCE_SURROGATES, netOnZeroDXC_surrogate_stream(job.seed, node, m));
+				#pragma omp atomic
+				bank_done++;
+
+				if (omp_get_thread_num() == 0) {		// The thread that runs the job
+					long	done;
+					#pragma omp atomic read
+					done = bank_done;
+					if (netOnZeroDXC_engine_poll(callbacks, ENGINE_STAGE_SURROGATES, done, nr_bank_tasks, old_progress_bank)) {
+						#pragma omp atomic write
+						go_flag = 0;
+					}
+				}
+			}
+
+			netOnZeroDXC_free_surrogate_generator(generator);
+		}
+		if (!go_flag)
+			break;
+
+		int	chunks_per_pair = (nr_range + ENGINE_CHUNK_SIZE - 1) / ENGINE_CHUNK_SIZE;
+		nr_tasks = (long) nr_pairs * chunks_per_pair;
+		#pragma omp parallel num_threads(number_threads)
+		{
+			Array2D <double>	cdiagram_surr(W, K, 0.0);
+			Array2D <int>		local_counts(W, K, 0);
+			CumulativeSumsXC	sums_surr;
+
+			#pragma omp for schedule(dynamic)
+			for (long t = 0; t < nr_tasks; t++) {
+				bool	go_on;
+				#pragma omp atomic read
+				go_on = go_flag;
+				if (go_on) {
+					int	p = t / chunks_per_pair;
+					int	m_start = m_first + (t % chunks_per_pair) * ENGINE_CHUNK_SIZE;
+					int	m_end = ((m_start + ENGINE_CHUNK_SIZE) < m_last)? (m_start + ENGINE_CHUNK_SIZE) : m_last;
+					ArrayView2D <int>	pair_counts = exceedance_counts[p];
+					local_counts.fill(0);
+					netOnZeroDXC_count_surrogate_exceedances(local_counts, diagrams_correlation[p], surrogate_bank[pair_node_a[p]], surrogate_bank[pair_node_b[p]],
+										m_start, m_end, cdiagram_surr, sums_surr, L, W, apply_shift, shift);
+					for (int l = 0; l < W; l++) {
+						for (int c = 0; c < K; c++) {
+							if (local_counts[l][c]) {
+								#pragma omp atomic
+								pair_counts[l][c] += local_counts[l][c];
+							}
+						}
+					}
+				}
+				#pragma omp atomic
+				pairs_done++;
+
+				if (omp_get_thread_num() == 0) {
+					long	done;
+					#pragma omp atomic read
+					done = pairs_done;
+					if (netOnZeroDXC_engine_poll(callbacks, ENGINE_STAGE_PDIAGRAMS, done, nr_pair_tasks, old_progress_pairs)) {
+						#pragma omp atomic write
+						go_flag = 0;
+					}
+				}
+			}
+		}
+	}
+	surrogate_bank.clear();
+	diagrams_correlation.resize(0, 0, 0);
+	if (!go_flag)
+		return 1;
+
+	results.diagrams_pvalue.resize(nr_pairs, W, K, 0.0);
+	results.efficiencies.resize(nr_pairs, W, 0.0);
+	std::vector <double>	matrix_row(nr_nodes, -1.0);
+	results.timescale_matrix.assign(nr_nodes, matrix_row);
+	for (i = 0; i < nr_nodes; i++)
+		results.timescale_matrix[i][i] = 0.0;
+	for (i = 0; i < nr_pairs; i++) {
+		netOnZeroDXC_convert_counts_to_pdiagram(results.diagrams_pvalue[i], exceedance_counts[i], W, M);
+		netOnZeroDXC_compute_efficiency(results.efficiencies[i], results.diagrams_pvalue[i], job.threshold_alpha);
+		results.timescale_matrix[pair_node_a[i]][pair_node_b[i]] = netOnZeroDXC_compute_wmatrix_element(results.efficiencies[i], W, results.window_widths, job.threshold_eta);
+		results.timescale_matrix[pair_node_b[i]][pair_node_a[i]] = results.timescale_matrix[pair_node_a[i]][pair_node_b[i]];
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_engine_count_columns (int N, int W, int L, int shift)
+{
+	// Columns of a diagram, as in netOnZeroDXC_compute_cdiagram
+	int	K = 0;
+	int	k;
+	for (k = W * L / 2 - 1; k < N - W * L / 2 - shift; k = k + L)
+		K++;
+
+	return K;
+}
+
+bool netOnZeroDXC_engine_poll (const EngineCallbacks & callbacks, int stage, long done, long nr_tasks, int & old_progress)
+{
+	int	progress = (int) (100 * done / nr_tasks);
+	if ((callbacks.progress != NULL) && (progress != old_progress)) {
+		old_progress = progress;
+		callbacks.progress(callbacks.user_data, stage, done, nr_tasks);
+	}
+
+	return ((callbacks.cancelled != NULL) && callbacks.cancelled(callbacks.user_data));
+}
@@ -0,0 +1,84 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
+
+// A whole analysis as a single call, with no wxWidgets, files or global state: several jobs can run at once from different threads, each one on
+// its own team of OpenMP threads. The callbacks are only called by the thread that runs the job, between two tasks, never concurrently.
+// Memory of a job, with P pairs, K columns and n nodes in some pair: P * W * K doubles and ints for the correlation diagrams and the counts,
+// then P * W * K doubles for the p value diagrams of the results, and the surrogates of n nodes, N doubles each. These are generated in blocks
+// so that they fit in memory_limit, or in BANK_MEMORY_FRACTION of the available memory if it is 0: jobs that run at once each need a limit of
+// their own, otherwise every one of them takes the same fraction.
+#define ENGINE_STAGE_SURROGATES 0
+#define ENGINE_STAGE_PDIAGRAMS 1
+#define ENGINE_CHUNK_SIZE 16			// Surrogates of a pair counted by one task
+
+struct EngineCallbacks {			// Either function may be NULL
+	void *		user_data;
+	void		(*progress)(void *, int, long, long);		// Stage, tasks done, tasks of the stage; called when the percentage changes. If the
+									// surrogates are generated in several blocks, the two stages alternate
+	bool		(*cancelled)(void *);				// Polled after every task: true stops the job
+};
+
+struct AnalysisJob {
+	const std::vector < std::vector <double> > *	sequences;	// One sequence per node, all of the same length; not copied
+	std::vector <int>	pair_node_a;				// 0-based nodes of each pair; if left empty, all pairs i < j
+	std::vector <int>	pair_node_b;
+	int			W;
+	int			L;
+	int			M;
+	int			tau;					// <= 0: no delay
+	unsigned int		seed;
+	double			threshold_alpha;
+	double			threshold_eta;
+	int			number_threads;				// <= 0: as many as OpenMP would use
+	size_t			memory_limit;				// Bytes for the surrogates and counts kept at once; 0: see netOnZeroDXC_surrogate_block_size
+	EngineCallbacks		callbacks;
+};
+
+struct AnalysisResults {
+	int			K;
+	std::vector <int>	pair_node_a;
+	std::vector <int>	pair_node_b;
+	std::vector <double>	window_widths;				// In samples, L * (row + 1)
+	Array3D <double>	diagrams_pvalue;			// [pair][row][column]
+	Array2D <double>	efficiencies;				// [pair][row], at threshold_alpha
+	std::vector < std::vector <double> >	timescale_matrix;	// At threshold_eta; -1 for nodes in no pair, 0 on the diagonal
+};
+
+void netOnZeroDXC_initialize_job (AnalysisJob &);
+int netOnZeroDXC_check_job (const AnalysisJob &);
+int netOnZeroDXC_run_job (AnalysisResults &, const AnalysisJob &);
@@ -0,0 +1,552 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#include <cuda_runtime.h>
+#include <cufft.h>
+#include <cub/cub.cuh>
+
+#ifndef INCLUDED_GPU
+	#include "netOnZeroDXC_gpu.hpp"
+	#define INCLUDED_GPU
+#endif
+
+#define GPU_BLOCK_SIZE 256
+#define GPU_MAX_ITERATIONS 1000		// As netOnZeroDXC_generate_surrogate_sequence
+#define GPU_CHECK_INTERVAL 8		// Iterations between two checks, on the host, of the sequences still being refined
+#define GPU_NR_SUMS 7			// Cumulative sums of a pair: a, aa, b, bb, ab, and ab forward and backward with a shift
+
+struct GpuEngineState {
+	cufftHandle		plan_forward;
+	cufftHandle		plan_backward;
+	bool			plans_created;
+	double			*bank;			// nr_slots x chunk x N surrogates
+	double			*values;		// nr_slots x N sorted values of each node
+	double			*amplitudes;		// nr_slots x (N/2 + 1) Fourier amplitudes of each node
+	double			*data;			// batch x N, sequences being refined
+	double			*next;			// batch x N, their next iteration
+	double			*keys_in;
+	double			*keys_out;
+	int			*indexes_in;
+	int			*indexes_out;
+	int			*offsets;		// batch + 1 segment boundaries for the sort
+	void			*sort_temp;
+	size_t			sort_temp_bytes;
+	cufftDoubleComplex	*spectrum;		// batch x (N/2 + 1)
+	int			*active;		// Per sequence of the batch: 1 while it is refined
+	int			*converged;
+	int			*iterations;
+	double			*sums;			// GPU_NR_SUMS x chunk x (N + 1)
+	double			*cdiagram;		// W x K, data diagram of the current pair
+	int			*counts;		// W x K
+	std::vector <double>	host_data;
+	std::vector <int>	host_flags;
+	std::vector <int>	host_counts;
+};
+
+// Kernels run on all sequences of a batch, and leave untouched those that are no longer active.
+
+__global__ void netOnZeroDXC_gpu_kernel_restore_amplitude (cufftDoubleComplex * spectrum, const double * amplitudes, int N, int G, const int * active)
+{
+	// As netOnZeroDXC_restore_fft_amplitude: bins keep their phase, zero and Nyquist bins are real, bins with z = 0 get phase 0
+	int	nr_bins = N/2 + 1;
+	size_t	t = (size_t) blockIdx.x * blockDim.x + threadIdx.x;
+	if (t >= (size_t) G * nr_bins)
+		return;
+	int	g = t / nr_bins;
+	int	k = t % nr_bins;
+	if (!active[g])
+		return;
+
+	cufftDoubleComplex	z = spectrum[t];
+	if ((k == 0) || (2*k == N)) {
+		z.x = amplitudes[k];
+		z.y = 0.0;
+	} else {
+		double	magnitude = sqrt(z.x*z.x + z.y*z.y);
+		if (magnitude > 0) {
+			z.x = z.x * (amplitudes[k] / magnitude);
+			z.y = z.y * (amplitudes[k] / magnitude);
+		} else {
+			z.x = amplitudes[k];
+			z.y = 0.0;
+		}
+	}
+	spectrum[t] = z;
+}
+
+__global__ void netOnZeroDXC_gpu_kernel_prepare_sort (const double * inverse, double * keys, int * indexes, int N, int G, const int * active)
+{
+	// cuFFT does not normalize the inverse transform
+	size_t	t = (size_t) blockIdx.x * blockDim.x + threadIdx.x;
+	if (t >= (size_t) G * N)
+		return;
+	int	g = t / N;
+	keys[t] = (active[g])? inverse[t] / (double) N : 0.0;
+	indexes[t] = t % N;
+}
+
+__global__ void netOnZeroDXC_gpu_kernel_rescale (double * next, const int * indexes_sorted, const double * values, int N, int G, const int * active)
+{
+	// The i-th smallest sample takes the i-th smallest value of the data
+	size_t	t = (size_t) blockIdx.x * blockDim.x + threadIdx.x;
+	if (t >= (size_t) G * N)
+		return;
+	int	g = t / N;
+	if (active[g])
+		next[(size_t) g * N + indexes_sorted[t]] = values[t % N];
+}
+
+__global__ void netOnZeroDXC_gpu_kernel_check_convergence (const double * next, const double * data, int N, int iteration, double tolerance,
+							const int * active, int * converged)
+{
+	// One block per sequence, as netOnZeroDXC_check_iteration_convergence
+	typedef cub::BlockReduce <double, GPU_BLOCK_SIZE>	BlockReduce;
+	__shared__ typename BlockReduce::TempStorage		temp_storage;
+	int	g = blockIdx.x;
+	if (!active[g] || (iteration < 2)) {
+		if (threadIdx.x == 0)
+			converged[g] = 0;
+		return;
+	}
+
+	const double *	x = next + (size_t) g * N;
+	const double *	x_prev = data + (size_t) g * N;
+	double	z = 0.0, I = 0.0;
+	int	i;
+	for (i = threadIdx.x; i < N; i += blockDim.x) {
+		z += (x[i] - x_prev[i]) * (x[i] - x_prev[i]);
+		I += x[i] * x[i];
+	}
+	double	total_z = BlockReduce(temp_storage).Sum(z);
+	__syncthreads();
+	double	total_I = BlockReduce(temp_storage).Sum(I);
+	if (threadIdx.x == 0)
+		converged[g] = ((total_z / total_I) > tolerance)? 0 : 1;
+}
+
+__global__ void netOnZeroDXC_gpu_kernel_accept (double * data, const double * next, int N, int G, const int * active)
+{
+	size_t	t = (size_t) blockIdx.x * blockDim.x + threadIdx.x;
+	if (t >= (size_t) G * N)
+		return;
+	if (active[t / N])
+		data[t] = next[t];
+}
+
+__global__ void netOnZeroDXC_gpu_kernel_finish_iteration (int * active, const int * converged, int * iterations, int iteration, int G)
+{
+	int	g = blockIdx.x * blockDim.x + threadIdx.x;
+	if ((g >= G) || !active[g])
+		return;
+	if (converged[g] || (iteration >= GPU_MAX_ITERATIONS)) {
+		active[g] = 0;
+		iterations[g] = iteration;
+	}
+}
+
+__global__ void netOnZeroDXC_gpu_kernel_cumulative_sums (const double * bank_a, const double * bank_b, int N, int shift, double * sums, size_t sum_stride)
+{
+	// One block per surrogate: sums of the sequences centered on their means, as netOnZeroDXC_initialize_cumulative_sums, by block-wide scans of
+	// GPU_BLOCK_SIZE samples at a time. Sum q of surrogate m starts at sums + q * sum_stride + m * (N + 1).
+	typedef cub::BlockReduce <double, GPU_BLOCK_SIZE>	BlockReduce;
+	typedef cub::BlockScan <double, GPU_BLOCK_SIZE>		BlockScan;
+	__shared__ union {
+		typename BlockReduce::TempStorage	reduce;
+		typename BlockScan::TempStorage		scan;
+	} temp_storage;
+	__shared__ double	means[2];
+	__shared__ double	carry[GPU_NR_SUMS];
+
+	int		m = blockIdx.x;
+	const double *	a = bank_a + (size_t) m * N;
+	const double *	b = bank_b + (size_t) m * N;
+	double *	sum_q = sums + (size_t) m * (N + 1);
+	int		nr_sums = ((shift > 0) && (shift < N))? GPU_NR_SUMS : 5;
+	int		i, q, tile;
+
+	double	partial_a = 0.0, partial_b = 0.0;
+	for (i = threadIdx.x; i < N; i += blockDim.x) {
+		partial_a += a[i];
+		partial_b += b[i];
+	}
+	double	total = BlockReduce(temp_storage.reduce).Sum(partial_a);
+	if (threadIdx.x == 0)
+		means[0] = total / (double) N;
+	__syncthreads();
+	total = BlockReduce(temp_storage.reduce).Sum(partial_b);
+	if (threadIdx.x == 0)
+		means[1] = total / (double) N;
+	if (threadIdx.x < GPU_NR_SUMS) {
+		carry[threadIdx.x] = 0.0;
+		sum_q[threadIdx.x * sum_stride] = 0.0;
+	}
+	__syncthreads();
+
+	double	v[GPU_NR_SUMS];
+	double	y, aggregate;
+	for (tile = 0; tile < N; tile += blockDim.x) {
+		i = tile + threadIdx.x;
+		double	xa = (i < N)? a[i] - means[0] : 0.0;
+		double	xb = (i < N)? b[i] - means[1] : 0.0;
+		bool	shifted = (nr_sums == GPU_NR_SUMS) && (i < N - shift);
+		v[0] = xa;
+		v[1] = xa * xa;
+		v[2] = xb;
+		v[3] = xb * xb;
+		v[4] = xa * xb;
+		v[5] = (shifted)? (a[i + shift] - means[0]) * xb : 0.0;
+		v[6] = (shifted)? xa * (b[i + shift] - means[1]) : 0.0;
+		for (q = 0; q < nr_sums; q++) {
+			BlockScan(temp_storage.scan).InclusiveSum(v[q], y, aggregate);
+			if (i < N)
+				sum_q[q * sum_stride + i + 1] = carry[q] + y;
+			__syncthreads();
+			if (threadIdx.x == 0)
+				carry[q] += aggregate;
+			__syncthreads();
+		}
+	}
+}
+
+__device__ double netOnZeroDXC_gpu_crosscorr_cumulative (const double * sum_q, size_t sum_stride, int start_a, int end_a, int start_b, int end_b)
+{
+	// As netOnZeroDXC_compute_crosscorr_cumulative
+	double	n = (double) (end_a - start_a + 1);
+
+	double	s_a = sum_q[end_a + 1] - sum_q[start_a];
+	double	s_aa = sum_q[sum_stride + end_a + 1] - sum_q[sum_stride + start_a];
+	double	s_b = sum_q[2*sum_stride + end_b + 1] - sum_q[2*sum_stride + start_b];
+	double	s_bb = sum_q[3*sum_stride + end_b + 1] - sum_q[3*sum_stride + start_b];
+
+	double	s_ab;
+	if (start_a == start_b)
+		s_ab = sum_q[4*sum_stride + end_a + 1] - sum_q[4*sum_stride + start_a];
+	else if (start_a > start_b)
+		s_ab = sum_q[5*sum_stride + end_b + 1] - sum_q[5*sum_stride + start_b];
+	else
+		s_ab = sum_q[6*sum_stride + end_a + 1] - sum_q[6*sum_stride + start_a];
+
+	double	norm_a = s_aa - s_a * s_a / n;
+	double	norm_b = s_bb - s_b * s_b / n;
+	double	scalar_product = s_ab - s_a * s_b / n;
+
+	scalar_product /= sqrt(norm_a);
+	scalar_product /= sqrt(norm_b);
+
+	return scalar_product;
+}
+
+__global__ void netOnZeroDXC_gpu_kernel_count_exceedances (const double * sums, size_t sum_stride, int N, int S, int W, int w_base, int K, int shift,
+							const double * cdiagram, int * counts)
+{
+	// One thread per cell of the diagram, over the S surrogates of the chunk, as netOnZeroDXC_compute_cdiagram_cumulative
+	// followed by netOnZeroDXC_update_exceedance_counts
+	int	cell = blockIdx.x * blockDim.x + threadIdx.x;
+	if (cell >= W * K)
+		return;
+	int	l = cell / K;
+	int	ws = (l + 1) * w_base;
+	int	k = W * w_base / 2 - 1 + (cell % K) * w_base;
+	double	data_value = cdiagram[cell];
+	double	value;
+	int	count = 0;
+	int	m;
+	for (m = 0; m < S; m++) {
+		const double *	sum_q = sums + (size_t) m * (N + 1);
+		if (shift > 0) {
+			value = 0.5 * netOnZeroDXC_gpu_crosscorr_cumulative(sum_q, sum_stride, k + shift - ws/2 + 1, k + shift + ws/2, k - ws/2 + 1, k + ws/2);
+			value += 0.5 * netOnZeroDXC_gpu_crosscorr_cumulative(sum_q, sum_stride, k - ws/2 + 1, k + ws/2, k + shift - ws/2 + 1, k + shift + ws/2);
+		} else {
+			value = netOnZeroDXC_gpu_crosscorr_cumulative(sum_q, sum_stride, k - ws/2 + 1, k + ws/2, k - ws/2 + 1, k + ws/2);
+		}
+		if (data_value < value)
+			count++;
+	}
+	counts[cell] += count;
+}
+
+int netOnZeroDXC_gpu_count_devices ()
+{
+	int	nr_devices = 0;
+	if (cudaGetDeviceCount(&nr_devices) != cudaSuccess)
+		return 0;
+
+	return nr_devices;
+}
+
+int netOnZeroDXC_gpu_allocate_engine (GpuEngine & engine, int device, int N, int W, int w_base, int K, int shift, int nr_slots, int M, size_t memory_limit)
+{
+	// Room on the device for the surrogates of nr_slots nodes, for as many of the M surrogate indexes as fit in memory_limit bytes
+	// (0: GPU_MEMORY_FRACTION of the free memory). Returns 0 if ok, 1 on CUDA errors, 2 if not even one surrogate per node fits.
+	engine.device = device;
+	engine.N = N;
+	engine.W = W;
+	engine.w_base = w_base;
+	engine.K = K;
+	engine.shift = shift;
+	engine.nr_slots = nr_slots;
+	engine.chunk = 0;
+	engine.batch = GPU_IAAFT_BATCH;
+	GpuEngineState *	state = new GpuEngineState();		// Value-initialized: all device pointers are NULL
+	engine.state = state;
+
+	int	G = engine.batch;
+	int	nr_bins = N/2 + 1;
+	size_t	free_bytes, total_bytes;
+	bool	failed = (cudaSetDevice(device) != cudaSuccess);
+	failed = failed || (cudaMemGetInfo(&free_bytes, &total_bytes) != cudaSuccess);
+	size_t	start_free_bytes = free_bytes;
+	failed = failed || (cufftPlan1d(&state->plan_forward, N, CUFFT_D2Z, G) != CUFFT_SUCCESS);
+	failed = failed || (cufftPlan1d(&state->plan_backward, N, CUFFT_Z2D, G) != CUFFT_SUCCESS);
+	state->plans_created = !failed;
+	failed = failed || (cudaMalloc((void **) &state->values, (size_t) nr_slots * N * sizeof(double)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->amplitudes, (size_t) nr_slots * nr_bins * sizeof(double)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->data, (size_t) G * N * sizeof(double)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->next, (size_t) G * N * sizeof(double)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->keys_in, (size_t) G * N * sizeof(double)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->keys_out, (size_t) G * N * sizeof(double)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->indexes_in, (size_t) G * N * sizeof(int)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->indexes_out, (size_t) G * N * sizeof(int)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->offsets, (G + 1) * sizeof(int)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->spectrum, (size_t) G * nr_bins * sizeof(cufftDoubleComplex)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->active, G * sizeof(int)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->converged, G * sizeof(int)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->iterations, G * sizeof(int)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->cdiagram, (size_t) W * K * sizeof(double)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->counts, (size_t) W * K * sizeof(int)) != cudaSuccess);
+	if (!failed) {
+		std::vector <int>	offsets(G + 1);
+		int	g;
+		for (g = 0; g <= G; g++)
+			offsets[g] = g * N;
+		failed = (cudaMemcpy(state->offsets, offsets.data(), (G + 1) * sizeof(int), cudaMemcpyHostToDevice) != cudaSuccess);
+		failed = failed || (cub::DeviceSegmentedRadixSort::SortPairs(NULL, state->sort_temp_bytes, state->keys_in, state->keys_out, state->indexes_in,
+									state->indexes_out, G * N, G, state->offsets, state->offsets + 1) != cudaSuccess);
+		failed = failed || (cudaMalloc(&state->sort_temp, state->sort_temp_bytes) != cudaSuccess);
+	}
+	failed = failed || (cudaMemGetInfo(&free_bytes, &total_bytes) != cudaSuccess);
+	if (failed) {
+		netOnZeroDXC_gpu_free_engine(engine);
+		return 1;
+	}
+
+	size_t	used_bytes = start_free_bytes - free_bytes;
+	size_t	budget = (size_t) (GPU_MEMORY_FRACTION * free_bytes);
+	if (memory_limit > 0)
+		budget = (memory_limit > used_bytes)? ((memory_limit - used_bytes < free_bytes)? memory_limit - used_bytes : free_bytes) : 0;
+	size_t	bytes_per_surrogate = ((size_t) nr_slots * N + (size_t) GPU_NR_SUMS * (N + 1)) * sizeof(double);
+	size_t	chunk = budget / bytes_per_surrogate;
+	if (chunk > (size_t) M)
+		chunk = M;
+	if (chunk < 1) {
+		netOnZeroDXC_gpu_free_engine(engine);
+		return 2;
+	}
+	engine.chunk = chunk;
+	failed = (cudaMalloc((void **) &state->bank, (size_t) nr_slots * chunk * N * sizeof(double)) != cudaSuccess);
+	failed = failed || (cudaMalloc((void **) &state->sums, (size_t) GPU_NR_SUMS * chunk * (N + 1) * sizeof(double)) != cudaSuccess);
+	if (failed) {
+		netOnZeroDXC_gpu_free_engine(engine);
+		return 1;
+	}
+
+	state->host_data.resize((size_t) G * N);
+	state->host_flags.resize(G);
+	state->host_counts.resize((size_t) W * K);
+
+	return 0;
+}
+
+void netOnZeroDXC_gpu_free_engine (GpuEngine & engine)
+{
+	GpuEngineState *	state = (GpuEngineState *) engine.state;
+	if (!state)
+		return;
+
+	cudaSetDevice(engine.device);
+	if (state->plans_created) {
+		cufftDestroy(state->plan_forward);
+		cufftDestroy(state->plan_backward);
+	}
+	cudaFree(state->bank);				// cudaFree(NULL) does nothing
+	cudaFree(state->values);
+	cudaFree(state->amplitudes);
+	cudaFree(state->data);
+	cudaFree(state->next);
+	cudaFree(state->keys_in);
+	cudaFree(state->keys_out);
+	cudaFree(state->indexes_in);
+	cudaFree(state->indexes_out);
+	cudaFree(state->offsets);
+	cudaFree(state->sort_temp);
+	cudaFree(state->spectrum);
+	cudaFree(state->active);
+	cudaFree(state->converged);
+	cudaFree(state->iterations);
+	cudaFree(state->sums);
+	cudaFree(state->cdiagram);
+	cudaFree(state->counts);
+	delete state;
+	engine.state = NULL;
+	engine.chunk = 0;
+
+	return;
+}
+
+int netOnZeroDXC_gpu_load_node (GpuEngine & engine, int slot, const std::vector <double> & values_distribution, const std::vector <double> & fft_amplitudes)
+{
+	// Sorted values and Fourier amplitudes of a node, from netOnZeroDXC_initialize_surrogate_generation
+	GpuEngineState *	state = (GpuEngineState *) engine.state;
+	int	N = engine.N;
+	int	nr_bins = N/2 + 1;
+	if ((slot < 0) || (slot >= engine.nr_slots) || (values_distribution.size() != N) || (fft_amplitudes.size() != nr_bins))
+		return 1;
+
+	bool	failed = (cudaSetDevice(engine.device) != cudaSuccess);
+	failed = failed || (cudaMemcpy(state->values + (size_t) slot * N, values_distribution.data(), N * sizeof(double), cudaMemcpyHostToDevice) != cudaSuccess);
+	failed = failed || (cudaMemcpy(state->amplitudes + (size_t) slot * nr_bins, fft_amplitudes.data(), nr_bins * sizeof(double), cudaMemcpyHostToDevice) != cudaSuccess);
+
+	return (failed)? 1 : 0;
+}
+
+int netOnZeroDXC_gpu_generate_surrogates (GpuEngine & engine, int slot, const std::vector <double> & sequence, const std::vector <SurrogateStream> & streams,
+					double tolerance, long & iterations, int & max_iterations)
+{
+	// One surrogate per stream (at most engine.chunk), stored in the bank of the slot in the same order. The IAAFT iterations of all
+	// surrogates are added to iterations, and max_iterations is raised to the largest one. Returns 1 on CUDA errors.
+	GpuEngineState *	state = (GpuEngineState *) engine.state;
+	int	N = engine.N;
+	int	G = engine.batch;
+	int	S = streams.size();
+	int	nr_bins = N/2 + 1;
+	if ((S > engine.chunk) || (sequence.size() != N))
+		return 1;
+
+	const double *	values = state->values + (size_t) slot * N;
+	const double *	amplitudes = state->amplitudes + (size_t) slot * nr_bins;
+	int	grid_samples = (int) (((size_t) G * N + GPU_BLOCK_SIZE - 1) / GPU_BLOCK_SIZE);
+	int	grid_bins = (int) (((size_t) G * nr_bins + GPU_BLOCK_SIZE - 1) / GPU_BLOCK_SIZE);
+	int	grid_batch = (G + GPU_BLOCK_SIZE - 1) / GPU_BLOCK_SIZE;
+	bool	failed = (cudaSetDevice(engine.device) != cudaSuccess);
+	int	first, g, iteration;
+	for (first = 0; (first < S) && !failed; first += G) {
+		int	nr_sequences = (S - first < G)? S - first : G;
+
+		// Scramble randomly the original sequences (Fisher-Yates shuffle, in place), exactly as on the CPU
+		double *	host_data = state->host_data.data();
+		for (g = 0; g < G; g++) {
+			double *	x = host_data + (size_t) g * N;
+			if (g >= nr_sequences) {
+				memset(x, 0, N * sizeof(double));
+				continue;
+			}
+			memcpy(x, sequence.data(), N * sizeof(double));
+			netOnZeroDXC_shuffle_sequence(x, N, streams[first + g]);
+			state->host_flags[g] = 1;
+		}
+		for (g = nr_sequences; g < G; g++)
+			state->host_flags[g] = 0;
+		failed = (cudaMemcpy(state->data, host_data, (size_t) G * N * sizeof(double), cudaMemcpyHostToDevice) != cudaSuccess);
+		failed = failed || (cudaMemcpy(state->active, state->host_flags.data(), G * sizeof(int), cudaMemcpyHostToDevice) != cudaSuccess);
+
+		// Iteratively refine all sequences of the batch, until each of them has converged
+		int	nr_active = nr_sequences;
+		for (iteration = 1; (iteration <= GPU_MAX_ITERATIONS) && (nr_active > 0) && !failed; iteration++) {
+			failed = (cufftExecD2Z(state->plan_forward, state->data, state->spectrum) != CUFFT_SUCCESS);
+			netOnZeroDXC_gpu_kernel_restore_amplitude <<<grid_bins, GPU_BLOCK_SIZE>>> (state->spectrum, amplitudes, N, G, state->active);
+			failed = failed || (cufftExecZ2D(state->plan_backward, state->spectrum, state->next) != CUFFT_SUCCESS);
+			netOnZeroDXC_gpu_kernel_prepare_sort <<<grid_samples, GPU_BLOCK_SIZE>>> (state->next, state->keys_in, state->indexes_in, N, G, state->active);
+			failed = failed || (cub::DeviceSegmentedRadixSort::SortPairs(state->sort_temp, state->sort_temp_bytes, state->keys_in, state->keys_out,
+								state->indexes_in, state->indexes_out, G * N, G, state->offsets, state->offsets + 1) != cudaSuccess);
+			netOnZeroDXC_gpu_kernel_rescale <<<grid_samples, GPU_BLOCK_SIZE>>> (state->next, state->indexes_out, values, N, G, state->active);
+			netOnZeroDXC_gpu_kernel_check_convergence <<<G, GPU_BLOCK_SIZE>>> (state->next, state->data, N, iteration, tolerance, state->active, state->converged);
+			netOnZeroDXC_gpu_kernel_accept <<<grid_samples, GPU_BLOCK_SIZE>>> (state->data, state->next, N, G, state->active);
+			netOnZeroDXC_gpu_kernel_finish_iteration <<<grid_batch, GPU_BLOCK_SIZE>>> (state->active, state->converged, state->iterations, iteration, G);
+			failed = failed || (cudaGetLastError() != cudaSuccess);
+			if (((iteration % GPU_CHECK_INTERVAL) == 0) && !failed) {
+				failed = (cudaMemcpy(state->host_flags.data(), state->active, G * sizeof(int), cudaMemcpyDeviceToHost) != cudaSuccess);
+				nr_active = 0;
+				for (g = 0; g < G; g++)
+					nr_active += state->host_flags[g];
+			}
+		}
+
+		failed = failed || (cudaMemcpy(state->bank + ((size_t) slot * engine.chunk + first) * N, state->data, (size_t) nr_sequences * N * sizeof(double),
+						cudaMemcpyDeviceToDevice) != cudaSuccess);
+		failed = failed || (cudaMemcpy(state->host_flags.data(), state->iterations, G * sizeof(int), cudaMemcpyDeviceToHost) != cudaSuccess);
+		for (g = 0; (g < nr_sequences) && !failed; g++) {
+			iterations += state->host_flags[g];
+			if (state->host_flags[g] > max_iterations)
+				max_iterations = state->host_flags[g];
+		}
+	}
+
+	return (failed)? 1 : 0;
+}
+
+int netOnZeroDXC_gpu_count_exceedances (GpuEngine & engine, int slot_a, int slot_b, int S, ArrayView2D <const double> cdiagram_data, ArrayView2D <int> exceedance_counts)
+{
+	// Adds to exceedance_counts those of the first S surrogates in the banks of the two slots, against the correlation diagram of the data.
+	// Returns 1 on CUDA errors.
+	GpuEngineState *	state = (GpuEngineState *) engine.state;
+	int	N = engine.N;
+	int	W = engine.W;
+	int	K = engine.K;
+	size_t	nr_cells = (size_t) W * K;
+	size_t	sum_stride = (size_t) engine.chunk * (N + 1);
+	if ((S > engine.chunk) || (cdiagram_data.rows() != W) || (cdiagram_data.cols() != K))
+		return 1;
+
+	bool	failed = (cudaSetDevice(engine.device) != cudaSuccess);
+	failed = failed || (cudaMemcpy(state->cdiagram, cdiagram_data.data(), nr_cells * sizeof(double), cudaMemcpyHostToDevice) != cudaSuccess);
+	failed = failed || (cudaMemset(state->counts, 0, nr_cells * sizeof(int)) != cudaSuccess);
+	if (failed)
+		return 1;
+	netOnZeroDXC_gpu_kernel_cumulative_sums <<<S, GPU_BLOCK_SIZE>>> (state->bank + (size_t) slot_a * engine.chunk * N, state->bank + (size_t) slot_b * engine.chunk * N,
+									N, engine.shift, state->sums, sum_stride);
+	netOnZeroDXC_gpu_kernel_count_exceedances <<<(int) ((nr_cells + GPU_BLOCK_SIZE - 1) / GPU_BLOCK_SIZE), GPU_BLOCK_SIZE>>> (state->sums, sum_stride, N, S, W,
+									engine.w_base, K, engine.shift, state->cdiagram, state->counts);
+	failed = (cudaGetLastError() != cudaSuccess);
+	failed = failed || (cudaMemcpy(state->host_counts.data(), state->counts, nr_cells * sizeof(int), cudaMemcpyDeviceToHost) != cudaSuccess);
+	if (failed)
+		return 1;
+
+	size_t	c;
+	for (c = 0; c < nr_cells; c++)
+		exceedance_counts.data()[c] += state->host_counts[c];
+
+	return 0;
+}
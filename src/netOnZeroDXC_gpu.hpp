@@ -0,0 +1,70 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
+#ifndef INCLUDED_ALGORITHM
+	#include "netOnZeroDXC_algorithm.hpp"
+	#define INCLUDED_ALGORITHM
+#endif
+
+// Optional CUDA engine for batch mode, built with "make CUDA=1" (NETONZERODXC_USE_CUDA). The device keeps a bank of surrogates of every node
+// involved, for one range of surrogate indexes at a time: surrogates are refined by IAAFT in batches of GPU_IAAFT_BATCH sequences, with cuFFT
+// and a segmented radix sort for the rescaling step, and the correlation diagrams of the surrogates of a pair are computed and compared with
+// that of the data on the device, so that only exceedance counts are copied back. The initial shuffle of each surrogate is made on the host
+// with the same surrogate streams as netOnZeroDXC_generate_surrogate_sequence (netOnZeroDXC_shuffle_sequence); the results agree with the CPU up to the rounding of
+// the transforms, so a count can differ where a surrogate correlation is within rounding of that of the data.
+#define GPU_IAAFT_BATCH 256
+#define GPU_MEMORY_FRACTION 0.8		// Of the free device memory, when no limit is given
+
+struct GpuEngine {
+	int	device;
+	int	N;
+	int	W;
+	int	w_base;
+	int	K;
+	int	shift;
+	int	nr_slots;			// Nodes whose surrogates are held at the same time
+	int	chunk;				// Surrogates per node held on the device
+	int	batch;				// Sequences refined together
+	void	*state;				// Device buffers and cuFFT plans, see netOnZeroDXC_gpu.cu
+};
+
+int netOnZeroDXC_gpu_count_devices ();
+int netOnZeroDXC_gpu_allocate_engine (GpuEngine &, int, int, int, int, int, int, int, int, size_t);
+void netOnZeroDXC_gpu_free_engine (GpuEngine &);
+int netOnZeroDXC_gpu_load_node (GpuEngine &, int, const std::vector <double> &, const std::vector <double> &);
+int netOnZeroDXC_gpu_generate_surrogates (GpuEngine &, int, const std::vector <double> &, const std::vector <SurrogateStream> &, double, long &, int &);
+int netOnZeroDXC_gpu_count_exceedances (GpuEngine &, int, int, int, ArrayView2D <const double>, ArrayView2D <int>);
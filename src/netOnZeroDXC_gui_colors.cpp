@@ -29,6 +29,9 @@
 // --------------------------------------------------------------------------
 
 #include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <vector>
 
 #ifndef INCLUDED_COLORS
 	#include "netOnZeroDXC_gui_colors.hpp"
@@ -50,3 +53,78 @@ wxColour netOnZeroDXC_color_palette (double level)
 		return wxColour(255.0 * level, 255.0 * sin(3.14159 * level), 255.0 * cos(3.14159 * level / 2.0));
 	}
 }
+
+void netOnZeroDXC_build_color_lut (ColorLUT & lut)
+{
+	lut.rgb.resize(3 * (COLOR_LUT_LEVELS + 2));
+	int		i;
+	wxColour	color;
+	for (i = 0; i <= COLOR_LUT_LEVELS + 1; i++) {
+		if (i < COLOR_LUT_LEVELS)
+			color = netOnZeroDXC_color_palette((i + 1) / (double) COLOR_LUT_LEVELS);
+		else
+			color = netOnZeroDXC_color_palette((i == COLOR_LUT_LEVELS)? 0.0 : -1.0);
+		lut.rgb[3*i] = color.Red();
+		lut.rgb[3*i + 1] = color.Green();
+		lut.rgb[3*i + 2] = color.Blue();
+	}
+}
+
+const unsigned char * netOnZeroDXC_lookup_color (const ColorLUT & lut, double level)
+{
+	int	i;
+	if (level == 0.0) {
+		i = COLOR_LUT_LEVELS;
+	} else if (level < 0) {
+		i = COLOR_LUT_LEVELS + 1;
+	} else {
+		i = (int) (level * COLOR_LUT_LEVELS + 0.5) - 1;		// Nearest level; levels above 1 are drawn as 1
+		if (i < 0)
+			i = 0;
+		else if (i >= COLOR_LUT_LEVELS)
+			i = COLOR_LUT_LEVELS - 1;
+	}
+
+	return &lut.rgb[3*i];
+}
+
+void netOnZeroDXC_render_matrix (wxImage & image, ArrayView2D <const double> matrix, double w_max, int pxsize, const ColorLUT & lut)
+{
+	// One square of pxsize x pxsize pixels per element, colored as matrix[i][j] / w_max: each color is looked up once per element, a row of
+	// elements is written to its first pixel row, which is then copied to the other pxsize - 1
+	int	nr_elements = matrix.rows();
+	int	width = nr_elements * pxsize;
+	image.Create(width, width, false);
+	unsigned char	*pixels = image.GetData();
+	if ((width == 0) || (pixels == NULL))
+		return;
+
+	int	i, j, p;
+	size_t	row_bytes = (size_t) 3 * width;
+	for (i = 0; i < nr_elements; i++) {
+		unsigned char	*row_begin = pixels + (size_t) i * pxsize * row_bytes;
+		unsigned char	*pixel = row_begin;
+		for (j = 0; j < nr_elements; j++) {
+			const unsigned char	*color = netOnZeroDXC_lookup_color(lut, matrix[i][j] / w_max);
+			for (p = 0; p < pxsize; p++) {
+				pixel[0] = color[0];
+				pixel[1] = color[1];
+				pixel[2] = color[2];
+				pixel += 3;
+			}
+		}
+		for (p = 1; p < pxsize; p++)
+			memcpy(row_begin + p * row_bytes, row_begin, row_bytes);
+	}
+}
+
+void netOnZeroDXC_render_matrix (wxImage & image, const std::vector < std::vector <double> > & matrix, double w_max, int pxsize, const ColorLUT & lut)
+{
+	int	i;
+	int	nr_elements = matrix.size();
+	Array2D <double>	elements(nr_elements, nr_elements, 0.0);
+	for (i = 0; i < nr_elements; i++)
+		std::copy(matrix[i].begin(), matrix[i].end(), elements[i]);
+
+	netOnZeroDXC_render_matrix(image, elements, w_max, pxsize, lut);
+}
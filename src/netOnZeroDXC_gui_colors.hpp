@@ -28,9 +28,27 @@
 //
 // --------------------------------------------------------------------------
 
+#include <vector>
+
 #include <wx/colour.h>
 #include <wx/panel.h>
 #include <wx/event.h>
+#include <wx/image.h>
+
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
+
+#define COLOR_LUT_LEVELS 1024
+
+struct ColorLUT {			// RGB of netOnZeroDXC_color_palette(double) at COLOR_LUT_LEVELS levels in (0, 1], then of level 0 and of negative levels
+	std::vector <unsigned char>	rgb;
+};
 
 wxColour netOnZeroDXC_color_palette (int, int);
 wxColour netOnZeroDXC_color_palette (double);
+void netOnZeroDXC_build_color_lut (ColorLUT &);
+const unsigned char * netOnZeroDXC_lookup_color (const ColorLUT &, double);
+void netOnZeroDXC_render_matrix (wxImage &, ArrayView2D <const double>, double, int, const ColorLUT &);
+void netOnZeroDXC_render_matrix (wxImage &, const std::vector < std::vector <double> > &, double, int, const ColorLUT &);
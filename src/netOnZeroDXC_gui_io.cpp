@@ -41,6 +41,8 @@
 
 #include "wx/arrstr.h"
 
+#include "omp.h"
+
 #ifndef INCLUDED_IOFUNCTIONS
 	#include "netOnZeroDXC_io.hpp"
 	#define INCLUDED_IOFUNCTIONS
@@ -49,6 +51,10 @@
 	#include "netOnZeroDXC_gui_io.hpp"
 	#define INCLUDED_IOFUNCTIONS_WX
 #endif
+#ifndef INCLUDED_IORESULTS
+	#include "netOnZeroDXC_io_results.hpp"
+	#define INCLUDED_IORESULTS
+#endif
 
 int netOnZeroDXC_load_multi_sequences(std::vector < std::vector <double> > & sequences_table, std::vector <std::string> & node_labels, wxArrayString & list_of_files,
 				char separator_char, char filename_delimiter_char, int column_number)
@@ -56,30 +62,43 @@ int netOnZeroDXC_load_multi_sequences(std::vector < std::vector <double> > & seq
 	list_of_files.Sort();
 
 	int	i, j;
-	int	node_index;
 	int	error = 0;
 	int	nr_files = list_of_files.GetCount();
-	std::string				file_name;
-	std::string				temp_label;
-	std::vector <double>			temp_sequence;
-	std::vector < std::vector <double> >	temp_input;
+	std::vector <std::string>		file_names(nr_files);
+	std::vector <std::string>		file_labels(nr_files);
+	std::vector <int>			file_errors(nr_files, 0);
+	std::vector < std::vector <double> >	file_sequences(nr_files);
 	for (i = 0; i < nr_files; i++) {
-		temp_sequence.clear();
-		file_name = list_of_files[i].ToStdString();
-		if (netOnZeroDXC_parse_filename_1label(temp_label, file_name, filename_delimiter_char))
-			return 1;
-		node_labels.push_back(temp_label);
-		error = netOnZeroDXC_read_data_table(temp_input, file_name, separator_char);
-		if (error)
-			return 2;
-		if ((temp_input.size() == 0) || (column_number < 0))
-			return 3;
-		if (column_number > temp_input[0].size())
-			return 3;
+		file_names[i] = list_of_files[i].ToStdString();
+		if (netOnZeroDXC_parse_filename_1label(file_labels[i], file_names[i], filename_delimiter_char))
+			file_errors[i] = 1;
+	}
+
+	#pragma omp parallel for private(j) schedule(dynamic)
+	for (i = 0; i < nr_files; i++) {				// Files are parsed concurrently, the first error in file order is reported
+		if (file_errors[i])
+			continue;
+		std::vector < std::vector <double> >	temp_input;
+		if (netOnZeroDXC_read_data_table(temp_input, file_names[i], separator_char)) {
+			file_errors[i] = 2;
+			continue;
+		}
+		if ((temp_input.size() == 0) || (column_number < 0) || (column_number > temp_input[0].size())) {
+			file_errors[i] = 3;
+			continue;
+		}
+		file_sequences[i].reserve(temp_input.size());
 		for (j = 0; j < temp_input.size(); j++) {
-			temp_sequence.push_back(temp_input[j][column_number - 1]);
+			file_sequences[i].push_back(temp_input[j][column_number - 1]);
 		}
-		sequences_table.push_back(temp_sequence);
+	}
+
+	for (i = 0; i < nr_files; i++) {
+		node_labels.push_back(file_labels[i]);
+		if (file_errors[i])
+			return file_errors[i];
+		sequences_table.push_back(std::vector <double> ());
+		sequences_table.back().swap(file_sequences[i]);
 	}
 
 	error = netOnZeroDXC_check_linear_sizes(sequences_table);
@@ -96,7 +115,7 @@ int netOnZeroDXC_load_multi_sequences(std::vector < std::vector <double> > & seq
 	return 0;
 }
 
-int netOnZeroDXC_load_multi_diagrams (std::vector < std::vector < std::vector <double> > > & diagrams_pvalue, std::vector <PairOfLabels> & list_pairs,
+int netOnZeroDXC_load_multi_diagrams (Array3D <double> & diagrams_pvalue, std::vector <PairOfLabels> & list_pairs,
 				wxArrayString & list_of_files, char separator_char, char filename_delimiter_char)
 {
 	list_of_files.Sort();
@@ -104,24 +123,49 @@ int netOnZeroDXC_load_multi_diagrams (std::vector < std::vector < std::vector <d
 	int	i;
 	int	error = 0;
 	int	nr_files = list_of_files.GetCount();
-	std::string	file_name;
+	if (nr_files == 0)
+		return 3;
+	if ((nr_files == 1) && netOnZeroDXC_check_results_file(list_of_files[0].ToStdString()))	// All the diagrams of a run, out of its results container
+		return netOnZeroDXC_load_results_diagrams(diagrams_pvalue, list_pairs, list_of_files[0].ToStdString());
+
+	std::vector <std::string>	file_names(nr_files);
+	std::vector <int>		file_errors(nr_files, 0);
 	PairOfLabels	parsed_label_pair;
-	std::vector < std::vector <double> >	temp_diagram;
 	for (i = 0; i < nr_files; i++) {
-		file_name = list_of_files[i].ToStdString();
-		error = netOnZeroDXC_parse_filename_2labels(parsed_label_pair, file_name, filename_delimiter_char);
+		file_names[i] = list_of_files[i].ToStdString();
+		error = netOnZeroDXC_parse_filename_2labels(parsed_label_pair, file_names[i], filename_delimiter_char);
 		if (error)
 			return 1;
 		list_pairs.push_back(parsed_label_pair);
-		error = netOnZeroDXC_read_data_table(temp_diagram, file_name, separator_char);
-		if (error)
-			return 2;
-		diagrams_pvalue.push_back(temp_diagram);
 	}
 
-	error = netOnZeroDXC_check_table_sizes(diagrams_pvalue);
+	std::vector < std::vector < std::vector <double> > >	temp_diagram(1);
+	error = netOnZeroDXC_read_data_table(temp_diagram[0], file_names[0], separator_char);
+	if (error)
+		return 2;
+	error = netOnZeroDXC_check_table_sizes(temp_diagram);
 	if (error)
 		return 3;
+	diagrams_pvalue.resize(nr_files, temp_diagram[0].size(), temp_diagram[0][0].size(), 0.0);	// The first diagram sets the size of all the others
+
+	#pragma omp parallel for firstprivate(temp_diagram) schedule(dynamic)
+	for (i = 0; i < nr_files; i++) {				// Files are parsed concurrently, straight into their slice of the storage
+		if ((i > 0) && netOnZeroDXC_read_data_table(temp_diagram[0], file_names[i], separator_char)) {
+			file_errors[i] = 2;
+			continue;
+		}
+		if ((netOnZeroDXC_check_table_sizes(temp_diagram)) || (temp_diagram[0].size() != diagrams_pvalue.rows()) || (temp_diagram[0][0].size() != diagrams_pvalue.cols())) {
+			file_errors[i] = 3;
+			continue;
+		}
+		for (int l = 0; l < diagrams_pvalue.rows(); l++)
+			std::copy(temp_diagram[0][l].begin(), temp_diagram[0][l].end(), diagrams_pvalue[i][l]);
+	}
+
+	for (i = 0; i < nr_files; i++) {
+		if (file_errors[i])
+			return file_errors[i];
+	}
 
 	error = netOnZeroDXC_check_list_pairs(list_pairs);
 	if (error)
@@ -137,25 +181,40 @@ int netOnZeroDXC_load_multi_efficiencies (std::vector < std::vector <double> > &
 	list_pairs.clear();
 	list_of_files.Sort();
 	efficiencies.clear();
+	if ((list_of_files.GetCount() == 1) && netOnZeroDXC_check_results_file(list_of_files[0].ToStdString()))	// All the efficiencies of a run, out of its results container
+		return netOnZeroDXC_load_results_efficiencies(efficiencies, list_pairs, window_widths, list_of_files[0].ToStdString());
 
 	bool	inconsistent_w_found = 0;
 	int	i, j;
 	int	error = 0;
 	int	nr_files = list_of_files.GetCount();
-	std::string	file_name;
+	std::vector <std::string>	file_names(nr_files);
+	std::vector <int>		file_errors(nr_files, 0);
+	std::vector <PairOfLabels>	file_pairs(nr_files);
+	std::vector < std::vector < std::vector <double> > >	file_tables(nr_files);
+	for (i = 0; i < nr_files; i++) {
+		file_names[i] = list_of_files[i].ToStdString();
+		if (netOnZeroDXC_parse_filename_2labels(file_pairs[i], file_names[i], filename_delimiter_char))
+			file_errors[i] = 1;
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for (i = 0; i < nr_files; i++) {				// Files are parsed concurrently, then checked in file order
+		if (file_errors[i])
+			continue;
+		if (netOnZeroDXC_read_data_table(file_tables[i], file_names[i], separator_char))
+			file_errors[i] = 2;
+	}
+
 	std::vector <double>	temp_eta;
-	std::vector < std::vector <double> >	temp_efficiency;
-	PairOfLabels	parsed_label_pair;
 	for (i = 0; i < nr_files; i++) {
-		file_name = list_of_files[i].ToStdString();
-		temp_eta.clear();
-		error = netOnZeroDXC_parse_filename_2labels(parsed_label_pair, file_name, filename_delimiter_char);
-		if (error)
+		if (file_errors[i] == 1)
 			return 1;
-		list_pairs.push_back(parsed_label_pair);
-		error = netOnZeroDXC_read_data_table(temp_efficiency, file_name, separator_char);
-		if (error)
-			return 2;
+		list_pairs.push_back(file_pairs[i]);
+		if (file_errors[i])
+			return file_errors[i];
+		temp_eta.clear();
+		const std::vector < std::vector <double> > &	temp_efficiency = file_tables[i];
 		for (j = 0; j < temp_efficiency.size(); j++) {
 			if (i) {
 				if (window_widths[j] != temp_efficiency[j][0]) {
@@ -170,6 +229,7 @@ int netOnZeroDXC_load_multi_efficiencies (std::vector < std::vector <double> > &
 		if (inconsistent_w_found)
 			return 3;
 		efficiencies.push_back(temp_eta);
+		std::vector < std::vector <double> > ().swap(file_tables[i]);
 	}
 
 	error = netOnZeroDXC_check_linear_sizes(efficiencies);
@@ -32,7 +32,11 @@
 	#include "netOnZeroDXC_pair.hpp"
 	#define INCLUDED_PAIR
 #endif
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
 
 int netOnZeroDXC_load_multi_sequences(std::vector < std::vector <double> > &, std::vector <std::string> &, wxArrayString &, char, char, int);
-int netOnZeroDXC_load_multi_diagrams(std::vector < std::vector < std::vector <double> > > &, std::vector <PairOfLabels> &, wxArrayString &, char, char);
+int netOnZeroDXC_load_multi_diagrams(Array3D <double> &, std::vector <PairOfLabels> &, wxArrayString &, char, char);
 int netOnZeroDXC_load_multi_efficiencies(std::vector < std::vector <double> > &, std::vector <PairOfLabels> &, std::vector <double> &, wxArrayString &, char, char);
@@ -0,0 +1,200 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <vector>
+
+#include "omp.h"
+
+#ifndef INCLUDED_ALGORITHM
+	#include "netOnZeroDXC_algorithm.hpp"
+	#define INCLUDED_ALGORITHM
+#endif
+#ifndef INCLUDED_INCREMENTAL
+	#include "netOnZeroDXC_incremental.hpp"
+	#define INCLUDED_INCREMENTAL
+#endif
+
+int netOnZeroDXC_initialize_incremental (IncrementalAnalysis & analysis, int nr_nodes, const std::vector <int> & pair_node_a, const std::vector <int> & pair_node_b,
+				int W, int L, int M, int tau, unsigned int seed, double threshold_alpha)
+{
+	int	i;
+	analysis.W = W;
+	analysis.L = L;
+	analysis.M = M;
+	analysis.apply_shift = (tau > 0);
+	analysis.shift = (analysis.apply_shift)? tau : 0;
+	analysis.seed = seed;
+	analysis.threshold_alpha = threshold_alpha;
+	analysis.pair_node_a = pair_node_a;
+	analysis.pair_node_b = pair_node_b;
+
+	analysis.node_used.assign(nr_nodes, false);
+	for (i = 0; i < pair_node_a.size(); i++) {
+		analysis.node_used[pair_node_a[i]] = true;
+		analysis.node_used[pair_node_b[i]] = true;
+	}
+
+	analysis.tail.clear();
+	analysis.tail.resize(nr_nodes);
+	analysis.tail_start = 0;
+	analysis.nr_columns = 0;
+	analysis.nr_blocks = 0;
+	analysis.significant_cells.resize(pair_node_a.size(), W, 0);
+
+	return 0;
+}
+
+int netOnZeroDXC_count_new_columns (const IncrementalAnalysis & analysis)
+{
+	// Complete columns of the retained tail, whose first one is the next column of the recording
+	if (analysis.tail.size() == 0)
+		return 0;
+
+	int	N = analysis.tail[0].size();
+	int	K = 0;
+	int	k;
+	for (k = analysis.W * analysis.L / 2 - 1; k < N - analysis.W * analysis.L / 2 - analysis.shift; k = k + analysis.L)
+		K++;
+
+	return K;
+}
+
+int netOnZeroDXC_append_samples (IncrementalAnalysis & analysis, const std::vector < std::vector <double> > & new_samples, int min_new_columns,
+				int & nr_new_columns, int number_threads)
+{
+	// New samples come as one sequence per node. Columns are computed once at least min_new_columns of them are complete, so that the
+	// surrogates of a block are worth their cost; the samples they no longer need are then dropped. Returns 1 if the new sequences do not
+	// match the nodes of the analysis or have different lengths.
+	int	nr_nodes = analysis.tail.size();
+	int	i;
+	nr_new_columns = 0;
+	if (new_samples.size() != nr_nodes)
+		return 1;
+	for (i = 0; i < nr_nodes; i++) {
+		if (new_samples[i].size() != new_samples[0].size())
+			return 1;
+	}
+	for (i = 0; i < nr_nodes; i++)
+		analysis.tail[i].insert(analysis.tail[i].end(), new_samples[i].begin(), new_samples[i].end());
+
+	int	K = netOnZeroDXC_count_new_columns(analysis);
+	if ((K < 1) || (K < min_new_columns))
+		return 0;
+
+	// Every block draws new surrogates from the streams of the run: those of block b are surrogates b * M to b * M + M - 1 of each node. The first
+	// block thus gives the p values of netOnZeroDXC_compute_cdiagram against the surrogates of a batch run with the same seed.
+	std::vector < std::vector < std::vector <double> > >	surrogate_banks(nr_nodes);
+	for (i = 0; i < nr_nodes; i++) {
+		if (analysis.node_used[i])
+			netOnZeroDXC_generate_surrogate_bank(surrogate_banks[i], analysis.tail, i, analysis.M, analysis.nr_blocks * analysis.M, TOLERANCE_SURROGATES, analysis.seed,
+								number_threads);
+	}
+
+	int	W = analysis.W;
+	int	M = analysis.M;
+	int	nr_pairs = analysis.pair_node_a.size();
+	#pragma omp parallel num_threads(number_threads) if (number_threads > 1)
+	{
+		Array2D <double>	cdiagram_data(W, K, 0.0);
+		Array2D <double>	cdiagram_surrogates(W, K, 0.0);
+		Array2D <int>		exceedance_counts(W, K, 0);
+		CumulativeSumsXC	sums_surrogates;
+
+		#pragma omp for schedule(dynamic)
+		for (int p = 0; p < nr_pairs; p++) {
+			int	a = analysis.pair_node_a[p];
+			int	b = analysis.pair_node_b[p];
+			netOnZeroDXC_compute_cdiagram(cdiagram_data, analysis.tail, a, b, analysis.L, W, analysis.apply_shift, analysis.shift);
+			exceedance_counts.fill(0);
+			netOnZeroDXC_count_surrogate_exceedances(exceedance_counts, cdiagram_data, surrogate_banks[a], surrogate_banks[b], 0, M, cdiagram_surrogates,
+								sums_surrogates, analysis.L, W, analysis.apply_shift, analysis.shift);
+			int	*significant = analysis.significant_cells[p];
+			for (int l = 0; l < W; l++) {
+				for (int k = 0; k < K; k++) {
+					if (exceedance_counts[l][k] / (double) M < analysis.threshold_alpha)	// Same p value as netOnZeroDXC_convert_counts_to_pdiagram
+						significant[l]++;
+				}
+			}
+		}
+	}
+
+	int	nr_dropped = K * analysis.L;
+	for (i = 0; i < nr_nodes; i++)
+		analysis.tail[i].erase(analysis.tail[i].begin(), analysis.tail[i].begin() + nr_dropped);
+	analysis.tail_start += nr_dropped;
+	analysis.nr_columns += K;
+	analysis.nr_blocks++;
+	nr_new_columns = K;
+
+	return 0;
+}
+
+int netOnZeroDXC_incremental_efficiency (std::vector <double> & efficiency, const IncrementalAnalysis & analysis, int pair)
+{
+	// Same ratio as netOnZeroDXC_compute_efficiency on the p value diagram of all the columns analyzed so far
+	if ((pair < 0) || (pair >= analysis.pair_node_a.size()))
+		return 1;
+
+	int	l;
+	efficiency.assign(analysis.W, 0.0);
+	if (analysis.nr_columns == 0)
+		return 0;
+	const int	*significant = analysis.significant_cells[pair];
+	for (l = 0; l < analysis.W; l++)
+		efficiency[l] = significant[l] / (double) analysis.nr_columns;
+
+	return 0;
+}
+
+int netOnZeroDXC_incremental_wmatrix (std::vector < std::vector <double> > & timescale_matrix, const IncrementalAnalysis & analysis, int nr_nodes,
+				const std::vector <double> & window_widths, double threshold_eta)
+{
+	// Links of nodes in no pair, or of a recording with no column yet, are left at -1 as links with no time scale
+	int	i;
+	std::vector <double>	matrix_row(nr_nodes, -1.0);
+	timescale_matrix.assign(nr_nodes, matrix_row);
+	for (i = 0; i < nr_nodes; i++)
+		timescale_matrix[i][i] = 0.0;
+	if (analysis.nr_columns == 0)
+		return 0;
+
+	std::vector <double>	efficiency;
+	int	a, b;
+	for (i = 0; i < analysis.pair_node_a.size(); i++) {
+		a = analysis.pair_node_a[i];
+		b = analysis.pair_node_b[i];
+		netOnZeroDXC_incremental_efficiency(efficiency, analysis, i);
+		timescale_matrix[a][b] = netOnZeroDXC_compute_wmatrix_element(efficiency.data(), analysis.W, window_widths, threshold_eta);
+		timescale_matrix[b][a] = timescale_matrix[a][b];
+	}
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <vector>
+
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
+
+// A sliding analysis keeps, for every pair, the number of significant cells (p < alpha) in each row of its p value diagram, and only the samples
+// of the recording that are not yet covered by complete columns. When samples are appended, the new columns are computed on the retained tail,
+// against surrogates of that tail: the columns of a block and their p values are those that a single run on the samples of the block would give.
+// Column j of the whole recording is centered on sample W*L/2 - 1 + j*L, as in netOnZeroDXC_compute_cdiagram.
+
+struct IncrementalAnalysis {
+	int			W;
+	int			L;
+	int			M;
+	int			shift;			// 0 without tau
+	bool			apply_shift;
+	unsigned int		seed;
+	double			threshold_alpha;
+	std::vector <int>	pair_node_a;
+	std::vector <int>	pair_node_b;
+	std::vector <bool>	node_used;			// Surrogates are only generated for nodes in some pair
+	std::vector < std::vector <double> >	tail;		// Samples from tail_start on, one sequence per node
+	long			tail_start;
+	int			nr_columns;			// Columns analyzed so far, from the beginning of the recording
+	int			nr_blocks;			// Blocks of columns analyzed so far, each one with its own surrogates
+	Array2D <int>		significant_cells;		// [pair][row]
+};
+
+int netOnZeroDXC_initialize_incremental (IncrementalAnalysis &, int, const std::vector <int> &, const std::vector <int> &, int, int, int, int, unsigned int, double);
+int netOnZeroDXC_count_new_columns (const IncrementalAnalysis &);
+int netOnZeroDXC_append_samples (IncrementalAnalysis &, const std::vector < std::vector <double> > &, int, int &, int);
+int netOnZeroDXC_incremental_efficiency (std::vector <double> &, const IncrementalAnalysis &, int);
+int netOnZeroDXC_incremental_wmatrix (std::vector < std::vector <double> > &, const IncrementalAnalysis &, int, const std::vector <double> &, double);
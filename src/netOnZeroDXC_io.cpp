@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <cctype>
 #include <iostream>
 #include <fstream>
@@ -38,70 +39,180 @@
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <iterator>
+#include <unordered_map>
+#if __cplusplus >= 201703L
+	#include <charconv>
+#endif
+
+#include "omp.h"
 
 #ifndef INCLUDED_IOFUNCTIONS
 	#include "netOnZeroDXC_io.hpp"
 	#define INCLUDED_IOFUNCTIONS
 #endif
+#ifndef INCLUDED_IOBINARY
+	#include "netOnZeroDXC_io_binary.hpp"
+	#define INCLUDED_IOBINARY
+#endif
+#ifndef INCLUDED_IORESULTS
+	#include "netOnZeroDXC_io_results.hpp"
+	#define INCLUDED_IORESULTS
+#endif
+
+#define TEXT_BLOCK_SIZE		(1 << 22)	// Bytes read at once from text files
+#define TEXT_PARALLEL_SIZE	(1 << 20)	// Smallest block whose lines are parsed by several threads
 
 int netOnZeroDXC_read_data_table (std::vector < std::vector <double> > & data_table, std::string file_path, char separator)
 {
 	data_table.clear();
-	std::ifstream	selected_file_stream;
-	selected_file_stream.open(file_path.c_str(), std::ifstream::in);
-	if (selected_file_stream.fail())
+	FILE *	file_pointer = fopen(file_path.c_str(), "rb");
+	if (!file_pointer)
 		return 1;
 
-	char *buffered_line = new char[16384];
-	std::string	line;
-	std::vector <double>	temp_vector;
-	while(selected_file_stream.getline(buffered_line, 16384)) {
-		line = buffered_line;
-		if ((line.size()) && (line[0] != '#')) {
-			netOnZeroDXC_parse_line(temp_vector, line, separator);
-			data_table.push_back(temp_vector);
+	int	error = netOnZeroDXC_read_text_stream(data_table, file_pointer, separator);
+	fclose(file_pointer);
+
+	return error;
+}
+
+int netOnZeroDXC_read_text_stream (std::vector < std::vector <double> > & data_table, FILE * file_pointer, char separator)
+{
+	std::vector <char>	buffer(TEXT_BLOCK_SIZE);
+	size_t	nr_filled = 0;
+	size_t	nr_complete;
+	bool	end_of_stream = false;
+	while (!end_of_stream) {
+		if (nr_filled == buffer.size())					// A single line longer than the whole buffer
+			buffer.resize(2 * buffer.size());
+		size_t	nr_requested = buffer.size() - nr_filled;
+		size_t	nr_read = fread(&buffer[nr_filled], 1, nr_requested, file_pointer);
+		nr_filled += nr_read;
+		end_of_stream = (nr_read < nr_requested);
+
+		nr_complete = nr_filled;					// Only complete lines are parsed, the rest is kept for the next block
+		if (!end_of_stream) {
+			while ((nr_complete > 0) && (buffer[nr_complete - 1] != '\n'))
+				nr_complete--;
 		}
+		if (nr_complete == 0)
+			continue;
+
+		netOnZeroDXC_parse_text_block(data_table, &buffer[0], &buffer[0] + nr_complete, separator);
+		if (nr_filled > nr_complete)
+			memmove(&buffer[0], &buffer[nr_complete], nr_filled - nr_complete);
+		nr_filled -= nr_complete;
 	}
-	selected_file_stream.close();
 
-	delete	buffered_line;
+	if (ferror(file_pointer))
+		return 1;
 
 	return 0;
 }
 
-int netOnZeroDXC_parse_line (std::vector <double> & data_line, std::string & text_line, char separator)
+void netOnZeroDXC_parse_text_block (std::vector < std::vector <double> > & data_table, const char * block_begin, const char * block_end, char separator)
 {
-	size_t	found = text_line.find_first_of(separator);
-        while (found != std::string::npos) {
-                text_line[found]='\t';
-                found = text_line.find_first_of(separator,found + 1);
-        }
+	int	nr_pieces = 1;
+	if (((block_end - block_begin) >= TEXT_PARALLEL_SIZE) && (!omp_in_parallel()))
+		nr_pieces = omp_get_max_threads();
 
-	std::istringstream	string_buffer_stream;
-        found = text_line.find_first_of("\t");
-        while ((found != std::string::npos) && ((found + 1) != text_line.length())) {
-                if(text_line[found+1] != '\t') {
-                        found = text_line.find_first_of("\t",found + 1);
-                        continue;
-                }
-                text_line.erase(text_line.begin() + found + 1);
-        }
-        string_buffer_stream.str(text_line);
+	if (nr_pieces <= 1) {
+		netOnZeroDXC_parse_text_lines(data_table, block_begin, block_end, separator);
+		return;
+	}
 
-	double	x;
-	std::string	temp_string_token;
+	int	k;
+	size_t	piece_size = (block_end - block_begin) / nr_pieces;
+	std::vector <const char *>	piece_bounds(nr_pieces + 1, block_end);
+	piece_bounds[0] = block_begin;
+	for (k = 1; k < nr_pieces; k++) {						// Pieces start right after a newline
+		const char *	position = std::max(piece_bounds[k - 1], block_begin + k * piece_size);
+		const char *	newline = (const char *) memchr(position, '\n', block_end - position);
+		piece_bounds[k] = (newline)? newline + 1 : block_end;
+	}
+
+	std::vector < std::vector < std::vector <double> > >	pieces(nr_pieces);
+	#pragma omp parallel for schedule(static) num_threads(nr_pieces)
+	for (k = 0; k < nr_pieces; k++)
+		netOnZeroDXC_parse_text_lines(pieces[k], piece_bounds[k], piece_bounds[k + 1], separator);
+
+	for (k = 0; k < nr_pieces; k++)
+		data_table.insert(data_table.end(), std::make_move_iterator(pieces[k].begin()), std::make_move_iterator(pieces[k].end()));
+}
+
+void netOnZeroDXC_parse_text_lines (std::vector < std::vector <double> > & data_table, const char * block_begin, const char * block_end, char separator)
+{
+	size_t		row_size_hint = (data_table.size())? data_table.back().size() : 0;
+	const char *	line_begin = block_begin;
+	while (line_begin < block_end) {
+		const char *	line_end = (const char *) memchr(line_begin, '\n', block_end - line_begin);
+		const char *	next_line = (line_end)? line_end + 1 : block_end;
+		if (!line_end)
+			line_end = block_end;
+		if ((line_end != line_begin) && (*(line_end - 1) == '\r'))
+			line_end--;
+		if ((line_end != line_begin) && (*line_begin != '#')) {		// Rows are parsed in place, no temporary line is allocated
+			data_table.emplace_back();
+			data_table.back().reserve(row_size_hint);
+			netOnZeroDXC_parse_line(data_table.back(), line_begin, line_end, separator);
+			row_size_hint = data_table.back().size();
+		}
+		line_begin = next_line;
+	}
+}
+
+int netOnZeroDXC_parse_line (std::vector <double> & data_line, const char * line_begin, const char * line_end, char separator)
+{
 	data_line.clear();
-        while (!string_buffer_stream.eof()) {
-                getline(string_buffer_stream, temp_string_token, '\t');
-                x = atof(temp_string_token.c_str());
-                if ((x != 0 && x/x != x/x) || (x != x))
+
+	double		x;
+	const char *	field_begin = line_begin;
+	const char *	field_end;
+	while (true) {							// Runs of separators (or TABs) count as a single one
+		field_end = field_begin;
+		while ((field_end != line_end) && (*field_end != separator) && (*field_end != '\t'))
+			field_end++;
+		x = netOnZeroDXC_parse_number(field_begin, field_end);
+		if ((x != 0 && x/x != x/x) || (x != x))
 			return 1;
-                data_line.push_back(x);
+		data_line.push_back(x);
+
+		if (field_end == line_end)
+			break;
+		field_begin = field_end;
+		while ((field_begin != line_end) && ((*field_begin == separator) || (*field_begin == '\t')))
+			field_begin++;
 	}
 
 	return 0;
 }
 
+double netOnZeroDXC_parse_number (const char * field_begin, const char * field_end)
+{
+	while ((field_begin != field_end) && isspace((unsigned char) *field_begin))
+		field_begin++;
+	if ((field_begin != field_end) && (*field_begin == '+') && ((field_begin + 1) != field_end) && (*(field_begin + 1) != '-'))
+		field_begin++;
+	if (field_begin == field_end)
+		return 0.0;
+
+	double	x = 0.0;
+#ifdef __cpp_lib_to_chars
+	const char *	number_end = field_end;
+	while ((number_end != field_begin) && isspace((unsigned char) *(number_end - 1)))
+		number_end--;						// Trailing blanks and carriage returns, which atof ignores too
+	std::from_chars_result	result = std::from_chars(field_begin, number_end, x);
+	if ((result.ec == std::errc()) && (result.ptr == number_end))
+		return x;
+#endif
+	char	field_copy[64];							// Same result as atof for fields from_chars does not take whole (e.g. out of range, hexadecimal)
+	size_t	field_length = std::min((size_t) (field_end - field_begin), sizeof(field_copy) - 1);
+	memcpy(field_copy, field_begin, field_length);
+	field_copy[field_length] = '\0';
+
+	return atof(field_copy);
+}
+
 int netOnZeroDXC_parse_configuration_line (std::string & system_name, std::string & recording_name, bool & matrix_mode, std::string & file_name, std::string & text_line, char separator)
 {
 	size_t found = text_line.find_first_of(separator);
@@ -163,6 +274,15 @@ int netOnZeroDXC_parse_configuration_line (std::string & system_name, std::strin
 int netOnZeroDXC_load_single_file (std::vector < std::vector <double> > & data_table, std::vector <std::string> & node_labels, std::string file_name, char separator_char)
 {
 	int	error = 0;
+	if (netOnZeroDXC_check_binary_file(file_name)) {		// Binary files already hold one sequence per channel
+		error = netOnZeroDXC_load_binary_file(data_table, node_labels, file_name);
+		if (error)
+			return error;
+		if (data_table.size() < 2)
+			return 5;
+		return 0;
+	}
+
 	std::vector < std::vector <double> >	temp_table;
 	error = netOnZeroDXC_read_data_table(temp_table, file_name, separator_char);
 	if (error)
@@ -199,18 +319,7 @@ int netOnZeroDXC_load_single_file (std::vector < std::vector <double> > & data_t
 int netOnZeroDXC_load_stdin (std::vector < std::vector <double> > & data_table, char separator_char)
 {
 	data_table.clear();
-
-	char *buffered_line = new char[16384];
-	std::string	line;
-	std::vector <double>	temp_vector;
-	while(std::cin.getline(buffered_line, 16384)) {
-		line = buffered_line;
-		if ((line.size()) && (line[0] != '#')) {
-			netOnZeroDXC_parse_line(temp_vector, line, separator_char);
-			data_table.push_back(temp_vector);
-		}
-	}
-	delete	buffered_line;
+	netOnZeroDXC_read_text_stream(data_table, stdin, separator_char);
 
 	return 0;
 }
@@ -219,7 +328,10 @@ int netOnZeroDXC_load_single_matrix (std::vector < std::vector <double> > & matr
 {
 	int	error = 0;
 	std::vector < std::vector <double> >	temp_table;
-	error = netOnZeroDXC_read_data_table(temp_table, file_name, separator_char);
+	if (netOnZeroDXC_check_results_file(file_name))			// The matrix of time scales of a run written to a results container
+		error = netOnZeroDXC_load_results_table(temp_table, file_name, "matrix", "", "");
+	else
+		error = netOnZeroDXC_read_data_table(temp_table, file_name, separator_char);
 	if (error)
 		return 2;
 
@@ -246,6 +358,12 @@ int netOnZeroDXC_load_single_matrix (std::vector < std::vector <double> > & matr
 int netOnZeroDXC_load_single_table (std::vector < std::vector <double> > & data_table, std::string file_name, char separator_char)
 {
 	int	error = 0;
+	if (netOnZeroDXC_check_binary_file(file_name)) {		// Each channel of a binary file is a row of the table
+		std::vector <std::string>	dummy_labels;
+		error = netOnZeroDXC_load_binary_file(data_table, dummy_labels, file_name);
+		return error;
+	}
+
 	error = netOnZeroDXC_read_data_table(data_table, file_name, separator_char);
 	if (error)
 		return 2;
@@ -261,14 +379,12 @@ int netOnZeroDXC_read_dictionary (std::vector <std::string> & string_list, std::
 	if (selected_file_stream.fail())
 		return 1;
 
-	char *buffered_line = new char[256];
 	std::string	line;
 	std::string	temp_string;
 	int		temp_index;
 	std::vector <std::string>	temp_string_list;
 	std::vector <int>		indexes_list;
-	while(selected_file_stream.getline(buffered_line, 256)) {
-		line = buffered_line;
+	while(std::getline(selected_file_stream, line)) {
 		if ((line.size()) && (line[0] != '#')) {
 			netOnZeroDXC_parse_dictionary_line(temp_string, temp_index, line, separator);
 			temp_string_list.push_back(temp_string);
@@ -276,7 +392,6 @@ int netOnZeroDXC_read_dictionary (std::vector <std::string> & string_list, std::
 		}
 	}
 	selected_file_stream.close();
-	delete	buffered_line;
 
 	if (netOnZeroDXC_check_list_labels(temp_string_list))
 		return 2;
@@ -572,17 +687,69 @@ int netOnZeroDXC_associate_index_of_pair (const std::vector <PairOfLabels> & nod
 	return -1;
 }
 
-int netOnZeroDXC_check_new_label_pairs (std::vector <PairOfLabels> & temp_label_pairs, const std::vector <PairOfLabels> & already_known)
+int netOnZeroDXC_build_pair_index_table (PairIndexTable & table, const std::vector <PairOfLabels> & node_pairs, const std::vector <std::string> & node_labels)
 {
-	int	i, j;
-	for (i = 0; i < already_known.size(); i++) {
-		for (j = 0; j < temp_label_pairs.size(); j++) {
-			if ((already_known[i].label_a == temp_label_pairs[j].label_a) && (already_known[i].label_b == temp_label_pairs[j].label_b)) {
-				temp_label_pairs.erase(temp_label_pairs.begin() + j);
-				break;
-			}
+	// Same result as netOnZeroDXC_associate_index_of_pair for every (i, j), with one hash lookup per pair instead of a scan per (i, j)
+	int	nr_nodes = node_labels.size();
+	table.nr_nodes = nr_nodes;
+	table.pair_index.assign((size_t) nr_nodes * (nr_nodes - 1) / 2, -1);
+
+	int	i, k;
+	std::unordered_map <std::string, int>	label_index;
+	for (i = nr_nodes - 1; i >= 0; i--)
+		label_index[node_labels[i]] = i;				// Labels are unique, see netOnZeroDXC_check_list_labels
+
+	std::unordered_map <std::string, int>::const_iterator	found_a, found_b;
+	for (k = 0; k < node_pairs.size(); k++) {
+		found_a = label_index.find(node_pairs[k].label_a);
+		found_b = label_index.find(node_pairs[k].label_b);
+		if ((found_a == label_index.end()) || (found_b == label_index.end()) || (found_a->second == found_b->second))
+			continue;
+		int	a = std::min(found_a->second, found_b->second);
+		int	b = std::max(found_a->second, found_b->second);
+		int &	entry = table.pair_index[(size_t) a * (2 * nr_nodes - a - 1) / 2 + (b - a - 1)];
+		if (entry < 0)							// The first matching pair wins, as in a scan
+			entry = k;
+	}
+
+	return 0;
+}
+
+void netOnZeroDXC_build_label_pair_set (LabelPairSet & known_pairs, const std::vector <PairOfLabels> & list_pairs)
+{
+	known_pairs.clear();
+	int	i;
+	std::unordered_map <std::string, int>::const_iterator	found;
+	for (i = 0; i < list_pairs.size(); i++) {
+		std::string	key = list_pairs[i].label_a + '\0' + list_pairs[i].label_b;
+		found = known_pairs.pair_slot.find(key);
+		if (found == known_pairs.pair_slot.end()) {
+			known_pairs.pair_slot[key] = known_pairs.multiplicity.size();
+			known_pairs.multiplicity.push_back(1);
+		} else {
+			known_pairs.multiplicity[found->second]++;
 		}
 	}
+
+	return;
+}
+
+int netOnZeroDXC_check_new_label_pairs (std::vector <PairOfLabels> & temp_label_pairs, const LabelPairSet & known_pairs)
+{
+	// Each known pair matches at most one of the new pairs, the first one in order; matched pairs are removed from temp_label_pairs.
+	// Returns 1 if some new pairs are left, i.e. unknown pairs or more duplicates than known.
+	std::vector <int>	matches_left = known_pairs.multiplicity;
+	std::vector <PairOfLabels>	pairs_left;
+	int	j;
+	std::unordered_map <std::string, int>::const_iterator	found;
+	for (j = 0; j < temp_label_pairs.size(); j++) {
+		found = known_pairs.pair_slot.find(temp_label_pairs[j].label_a + '\0' + temp_label_pairs[j].label_b);
+		if ((found != known_pairs.pair_slot.end()) && (matches_left[found->second] > 0))
+			matches_left[found->second]--;
+		else
+			pairs_left.push_back(temp_label_pairs[j]);
+	}
+	temp_label_pairs.swap(pairs_left);
 	if (temp_label_pairs.size() > 0) {
 		return 1;
 	}
@@ -590,6 +757,14 @@ int netOnZeroDXC_check_new_label_pairs (std::vector <PairOfLabels> & temp_label_
 	return 0;
 }
 
+int netOnZeroDXC_check_new_label_pairs (std::vector <PairOfLabels> & temp_label_pairs, const std::vector <PairOfLabels> & already_known)
+{
+	LabelPairSet	known_pairs;
+	netOnZeroDXC_build_label_pair_set(known_pairs, already_known);
+
+	return netOnZeroDXC_check_new_label_pairs(temp_label_pairs, known_pairs);
+}
+
 int netOnZeroDXC_save_diagram (const std::vector < std::vector <double> > & diagram, std::string path, std::string prefix, std::string label,
 			char delimiter, std::string label_a, std::string label_b, char separator)
 {
@@ -616,6 +791,16 @@ int netOnZeroDXC_save_diagram (const std::vector < std::vector <double> > & diag
 	return 0;
 }
 
+int netOnZeroDXC_save_diagram (ArrayView2D <const double> diagram, std::string path, std::string prefix, std::string label,
+			char delimiter, std::string label_a, std::string label_b, char separator)
+{
+	std::string		filename;
+
+	filename = netOnZeroDXC_generate_filepath(path, prefix, label, delimiter, label_a, label_b);
+
+	return netOnZeroDXC_save_single_file(diagram, filename, separator);
+}
+
 int netOnZeroDXC_save_linear_data (const std::vector <double> & x, const std::vector <double> & y, std::string path, std::string prefix, std::string label,
 				char delimiter, std::string label_a, std::string label_b, char separator)
 {
@@ -662,6 +847,46 @@ int netOnZeroDXC_save_single_file (const std::vector < std::vector <double> > &
 	return 0;
 }
 
+int netOnZeroDXC_save_single_file (ArrayView2D <const double> data_table, std::string file_name, char separator)
+{
+	FILE *	file_pointer;
+	file_pointer = fopen(file_name.c_str(), "w");
+	if (!file_pointer)
+		return 1;
+
+	int	i, j;
+	int	K = data_table.cols();
+	for (i = 0; i < data_table.rows(); i++) {		// Rows are contiguous, so they are written straight from the diagram storage
+		const double *	row = data_table[i];
+		fprintf(file_pointer, "%.3f", row[0]);
+		for (j = 1; j < K; j++) {
+			fprintf(file_pointer, "%c%.3f", separator, row[j]);
+		}
+		fprintf(file_pointer, "\n");
+	}
+
+	if(fclose(file_pointer) == EOF)
+		return 1;
+
+	return 0;
+}
+
+int netOnZeroDXC_save_surrogates_used (const std::vector <std::string> & labels_a, const std::vector <std::string> & labels_b, const std::vector <int> & used,
+				int M, std::string path, std::string prefix, char delimiter, char separator)
+{
+	// Log of adaptive stopping: one line per pair with its labels and the number of surrogates it used, out of at most M
+	if ((labels_a.size() != used.size()) || (labels_b.size() != used.size()))
+		return 1;
+
+	std::stringstream	content;
+	content << "# Surrogates used by each pair (adaptive stopping, at most " << M << ")\n";
+	int	i;
+	for (i = 0; i < used.size(); i++)
+		content << labels_a[i] << separator << labels_b[i] << separator << used[i] << "\n";
+
+	return netOnZeroDXC_save_log_file(content, netOnZeroDXC_generate_filepath(path, prefix, "surrogates_used", delimiter, "", ""));
+}
+
 int netOnZeroDXC_save_log_file (const std::stringstream & content, std::string file_name)
 {
 	FILE *		file_pointer;
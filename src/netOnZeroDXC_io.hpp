@@ -28,10 +28,16 @@
 //
 // --------------------------------------------------------------------------
 
+#include <cstdio>
+
 #ifndef INCLUDED_PAIR
 	#include "netOnZeroDXC_pair.hpp"
 	#define INCLUDED_PAIR
 #endif
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
 
 int netOnZeroDXC_load_single_file (std::vector < std::vector <double> > &, std::vector <std::string> &, std::string, char);
 int netOnZeroDXC_load_single_matrix (std::vector < std::vector <double> > &, std::string, char);
@@ -41,7 +47,11 @@ int netOnZeroDXC_load_single_table (std::vector < std::vector <double> > &, std:
 
 int netOnZeroDXC_read_dictionary (std::vector <std::string> &, std::string, char);
 int netOnZeroDXC_read_data_table (std::vector < std::vector <double> > &, std::string, char);
-int netOnZeroDXC_parse_line (std::vector <double> &, std::string &, char);
+int netOnZeroDXC_read_text_stream (std::vector < std::vector <double> > &, FILE *, char);
+void netOnZeroDXC_parse_text_block (std::vector < std::vector <double> > &, const char *, const char *, char);
+void netOnZeroDXC_parse_text_lines (std::vector < std::vector <double> > &, const char *, const char *, char);
+int netOnZeroDXC_parse_line (std::vector <double> &, const char *, const char *, char);
+double netOnZeroDXC_parse_number (const char *, const char *);
 int netOnZeroDXC_parse_dictionary_line (std::string &, int &, std::string &, char);
 int netOnZeroDXC_parse_configuration_line (std::string &, std::string &, bool &, std::string &, std::string &, char);
 
@@ -58,10 +68,16 @@ int netOnZeroDXC_check_label_format (const std::string &);
 int netOnZeroDXC_fill_list_pairs(std::vector <PairOfLabels> &, const std::vector <std::string> &);
 int netOnZeroDXC_postfill_list_labels(std::vector <std::string> &, const std::vector <PairOfLabels> &);
 int netOnZeroDXC_associate_index_of_pair(const std::vector <PairOfLabels> &, const std::vector <std::string> &, int, int);
+int netOnZeroDXC_build_pair_index_table(PairIndexTable &, const std::vector <PairOfLabels> &, const std::vector <std::string> &);
+void netOnZeroDXC_build_label_pair_set(LabelPairSet &, const std::vector <PairOfLabels> &);
+int netOnZeroDXC_check_new_label_pairs(std::vector <PairOfLabels> &, const LabelPairSet &);
 int netOnZeroDXC_check_new_label_pairs(std::vector <PairOfLabels> &, const std::vector <PairOfLabels> &);
 
 std::string netOnZeroDXC_generate_filepath(std::string, std::string, std::string, char, std::string, std::string);
 int netOnZeroDXC_save_diagram(const std::vector < std::vector <double> > &, std::string, std::string, std::string, char, std::string, std::string, char);
+int netOnZeroDXC_save_diagram(ArrayView2D <const double>, std::string, std::string, std::string, char, std::string, std::string, char);
 int netOnZeroDXC_save_linear_data(const std::vector <double> &, const std::vector <double> &, std::string, std::string, std::string, char, std::string, std::string, char);
 int netOnZeroDXC_save_single_file(const std::vector < std::vector <double> > &, std::string, char);
+int netOnZeroDXC_save_single_file(ArrayView2D <const double>, std::string, char);
+int netOnZeroDXC_save_surrogates_used(const std::vector <std::string> &, const std::vector <std::string> &, const std::vector <int> &, int, std::string, std::string, char, char);
 int netOnZeroDXC_save_log_file(const std::stringstream &, std::string);
@@ -0,0 +1,277 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#ifndef INCLUDED_IOBINARY
+	#include "netOnZeroDXC_io_binary.hpp"
+	#define INCLUDED_IOBINARY
+#endif
+
+struct MappedFile {
+	const char	*data;
+	size_t		size;
+#ifdef _WIN32
+	HANDLE		file_handle;
+	HANDLE		mapping_handle;
+#else
+	int		file_descriptor;
+#endif
+};
+
+int netOnZeroDXC_map_file (MappedFile &, std::string);
+void netOnZeroDXC_unmap_file (MappedFile &);
+
+int netOnZeroDXC_check_binary_file (std::string file_name)
+{
+	BinaryFileHeader	header;
+	if (netOnZeroDXC_read_binary_header(header, file_name))
+		return 0;
+
+	return 1;
+}
+
+int netOnZeroDXC_read_binary_header (BinaryFileHeader & header, std::string file_name)
+{
+	FILE *	file_pointer = fopen(file_name.c_str(), "rb");
+	if (!file_pointer)
+		return 2;
+
+	size_t	nr_read = fread(&header, sizeof(BinaryFileHeader), 1, file_pointer);
+	fclose(file_pointer);
+
+	if ((nr_read != 1) || (memcmp(header.magic, BINARY_FILE_MAGIC, 8) != 0))
+		return 3;
+
+	return 0;
+}
+
+int netOnZeroDXC_load_binary_file (std::vector < std::vector <double> > & sequences, std::vector <std::string> & labels, std::string file_name)
+{
+	// The file is mapped in memory and each channel is copied with a single block copy (or a float32 -> float64 conversion): no parsing
+	MappedFile	mapped;
+	if (netOnZeroDXC_map_file(mapped, file_name))
+		return 2;
+
+	BinaryFileHeader	header;
+	if (mapped.size < sizeof(BinaryFileHeader)) {
+		netOnZeroDXC_unmap_file(mapped);
+		return 3;
+	}
+	memcpy(&header, mapped.data, sizeof(BinaryFileHeader));
+
+	uint64_t	labels_offset = sizeof(BinaryFileHeader);
+	uint64_t	data_offset = ((labels_offset + header.labels_size + 7) / 8) * 8;
+	bool	valid = (memcmp(header.magic, BINARY_FILE_MAGIC, 8) == 0) && ((header.value_size == 4) || (header.value_size == 8));
+	valid = valid && (header.labels_size <= mapped.size - labels_offset) && (data_offset <= mapped.size);
+	valid = valid && (header.nr_channels > 0) && (header.nr_channels < 0x7fffffff) && (header.length > 0);
+	valid = valid && (header.length <= (mapped.size - data_offset) / header.value_size / header.nr_channels);
+	if (!valid) {
+		netOnZeroDXC_unmap_file(mapped);
+		return 3;
+	}
+
+	int	i;
+	sequences.clear();
+	labels.clear();
+	if (header.labels_size > 0) {
+		const char *	label_pointer = mapped.data + labels_offset;
+		const char *	labels_end = label_pointer + header.labels_size;
+		for (i = 0; i < header.nr_channels; i++) {
+			const char *	label_end = (const char *) memchr(label_pointer, '\0', labels_end - label_pointer);
+			if (!label_end) {
+				netOnZeroDXC_unmap_file(mapped);
+				labels.clear();
+				return 3;
+			}
+			labels.push_back(std::string(label_pointer, label_end));
+			label_pointer = label_end + 1;
+		}
+	} else {
+		char	temp_label[16];
+		for (i = 0; i < header.nr_channels; i++) {
+			if ((i+1) < 10) {
+				sprintf(temp_label, "0%d", i + 1);
+			} else {
+				sprintf(temp_label, "%d", i + 1);
+			}
+			labels.push_back(std::string(temp_label));
+		}
+	}
+
+	size_t	length = header.length;
+	sequences.resize(header.nr_channels);
+	for (i = 0; i < header.nr_channels; i++) {
+		const char *	column = mapped.data + data_offset + (size_t) i * length * header.value_size;
+		sequences[i].resize(length);
+		if (header.value_size == 8) {
+			memcpy(sequences[i].data(), column, length * sizeof(double));
+		} else {
+			const float *	values = (const float *) column;
+			size_t	j;
+			for (j = 0; j < length; j++)
+				sequences[i][j] = values[j];
+		}
+	}
+
+	netOnZeroDXC_unmap_file(mapped);
+
+	return 0;
+}
+
+int netOnZeroDXC_save_binary_file (const std::vector < std::vector <double> > & sequences, const std::vector <std::string> & labels, std::string file_name,
+				int value_size, unsigned int flags)
+{
+	if ((sequences.size() == 0) || ((value_size != 4) && (value_size != 8)))
+		return 1;
+	if ((labels.size() != 0) && (labels.size() != sequences.size()))
+		return 1;
+
+	int	i;
+	BinaryFileHeader	header;
+	memcpy(header.magic, BINARY_FILE_MAGIC, 8);
+	header.value_size = value_size;
+	header.flags = flags;
+	header.nr_channels = sequences.size();
+	header.length = sequences[0].size();
+	header.labels_size = 0;
+	for (i = 0; i < labels.size(); i++)
+		header.labels_size += labels[i].size() + 1;
+	for (i = 0; i < sequences.size(); i++) {
+		if (sequences[i].size() != header.length)
+			return 1;
+	}
+
+	FILE *	file_pointer = fopen(file_name.c_str(), "wb");
+	if (!file_pointer)
+		return 1;
+
+	bool	failed = (fwrite(&header, sizeof(BinaryFileHeader), 1, file_pointer) != 1);
+	for (i = 0; i < labels.size(); i++)
+		failed = failed || (fwrite(labels[i].c_str(), 1, labels[i].size() + 1, file_pointer) != labels[i].size() + 1);
+
+	const char	padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	size_t	padding_size = (8 - (sizeof(BinaryFileHeader) + header.labels_size) % 8) % 8;
+	if (padding_size)
+		failed = failed || (fwrite(padding, 1, padding_size, file_pointer) != padding_size);
+
+	std::vector <float>	buffer_float;
+	for (i = 0; (i < sequences.size()) && !failed; i++) {
+		if (value_size == 8) {
+			failed = (fwrite(sequences[i].data(), sizeof(double), header.length, file_pointer) != header.length);
+		} else {
+			buffer_float.assign(sequences[i].begin(), sequences[i].end());
+			failed = (fwrite(buffer_float.data(), sizeof(float), header.length, file_pointer) != header.length);
+		}
+	}
+
+	if ((fclose(file_pointer) == EOF) || failed)
+		return 1;
+
+	return 0;
+}
+
+int netOnZeroDXC_map_file (MappedFile & mapped, std::string file_name)
+{
+	mapped.data = NULL;
+	mapped.size = 0;
+#ifdef _WIN32
+	mapped.file_handle = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mapped.file_handle == INVALID_HANDLE_VALUE)
+		return 1;
+	LARGE_INTEGER	file_size;
+	if (!GetFileSizeEx(mapped.file_handle, &file_size) || (file_size.QuadPart == 0)) {
+		CloseHandle(mapped.file_handle);
+		return 1;
+	}
+	mapped.mapping_handle = CreateFileMappingA(mapped.file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapped.mapping_handle) {
+		CloseHandle(mapped.file_handle);
+		return 1;
+	}
+	mapped.data = (const char *) MapViewOfFile(mapped.mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (!mapped.data) {
+		CloseHandle(mapped.mapping_handle);
+		CloseHandle(mapped.file_handle);
+		return 1;
+	}
+	mapped.size = (size_t) file_size.QuadPart;
+#else
+	mapped.file_descriptor = open(file_name.c_str(), O_RDONLY);
+	if (mapped.file_descriptor < 0)
+		return 1;
+	struct stat	file_status;
+	if ((fstat(mapped.file_descriptor, &file_status) != 0) || (file_status.st_size == 0)) {
+		close(mapped.file_descriptor);
+		return 1;
+	}
+	void *	address = mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, mapped.file_descriptor, 0);
+	if (address == MAP_FAILED) {
+		close(mapped.file_descriptor);
+		return 1;
+	}
+	madvise(address, file_status.st_size, MADV_SEQUENTIAL);
+	mapped.data = (const char *) address;
+	mapped.size = file_status.st_size;
+#endif
+
+	return 0;
+}
+
+void netOnZeroDXC_unmap_file (MappedFile & mapped)
+{
+	if (!mapped.data)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(mapped.data);
+	CloseHandle(mapped.mapping_handle);
+	CloseHandle(mapped.file_handle);
+#else
+	munmap((void *) mapped.data, mapped.size);
+	close(mapped.file_descriptor);
+#endif
+	mapped.data = NULL;
+	mapped.size = 0;
+
+	return;
+}
@@ -0,0 +1,53 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <stdint.h>
+
+// Binary container of sequences ("channels"), stored column-major in the byte order of the machine that wrote it:
+//	BinaryFileHeader (40 bytes)
+//	labels_size bytes of labels, one NUL-terminated string per channel (labels_size = 0 means default labels "01", "02", ...)
+//	padding up to a multiple of 8 bytes from the beginning of the file
+//	nr_channels x length values (float32 or float64, see value_size), one channel after the other
+#define BINARY_FILE_MAGIC "NZDXBIN1"
+#define BINARY_FLAG_ROWS 1		// Channels are the rows of a table (e.g. a diagram) rather than the columns of a sequences file
+
+struct BinaryFileHeader {
+	char		magic[8];
+	uint32_t	value_size;
+	uint32_t	flags;
+	uint64_t	nr_channels;
+	uint64_t	length;
+	uint64_t	labels_size;
+};
+
+int netOnZeroDXC_check_binary_file (std::string);
+int netOnZeroDXC_read_binary_header (BinaryFileHeader &, std::string);
+int netOnZeroDXC_load_binary_file (std::vector < std::vector <double> > &, std::vector <std::string> &, std::string);
+int netOnZeroDXC_save_binary_file (const std::vector < std::vector <double> > &, const std::vector <std::string> &, std::string, int, unsigned int);
@@ -0,0 +1,620 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+	#define results_fseek _fseeki64
+	#define results_ftell _ftelli64
+#else
+	#define results_fseek fseeko
+	#define results_ftell ftello
+#endif
+
+#ifdef NETONZERODXC_USE_ZLIB
+	#include <zlib.h>
+#endif
+
+#ifndef INCLUDED_IOFUNCTIONS
+	#include "netOnZeroDXC_io.hpp"
+	#define INCLUDED_IOFUNCTIONS
+#endif
+#ifndef INCLUDED_IORESULTS
+	#include "netOnZeroDXC_io_results.hpp"
+	#define INCLUDED_IORESULTS
+#endif
+
+void netOnZeroDXC_shuffle_bytes (std::vector <unsigned char> &, const std::vector <double> &);
+void netOnZeroDXC_unshuffle_bytes (std::vector <double> &, const std::vector <unsigned char> &);
+
+ResultsWriter::ResultsWriter ()
+{
+	file_pointer = NULL;
+	compress = false;
+	file_offset = 0;
+	queued_bytes = 0;
+	closing = false;
+	failed = false;
+}
+
+ResultsWriter::~ResultsWriter ()
+{
+	close();
+}
+
+bool ResultsWriter::isOpen () const
+{
+	return (file_pointer != NULL);
+}
+
+int ResultsWriter::open (std::string file_name, bool compressed)
+{
+	// Tables are written by a background thread as they are added; a placeholder header is rewritten on close(), together with the index
+	close();
+#ifndef NETONZERODXC_USE_ZLIB
+	if (compressed)
+		return 1;
+#endif
+
+	file_pointer = fopen(file_name.c_str(), "wb");
+	if (!file_pointer)
+		return 1;
+
+	ResultsFileHeader	header;
+	memset(&header, 0, sizeof(ResultsFileHeader));
+	memcpy(header.magic, RESULTS_FILE_MAGIC, 8);
+	header.flags = (compressed)? RESULTS_FLAG_COMPRESSED : 0;
+	if (fwrite(&header, sizeof(ResultsFileHeader), 1, file_pointer) != 1) {
+		fclose(file_pointer);
+		file_pointer = NULL;
+		return 1;
+	}
+
+	compress = compressed;
+	file_offset = sizeof(ResultsFileHeader);
+	entries.clear();
+	queue.clear();
+	queued_bytes = 0;
+	closing = false;
+	failed = false;
+	writer = std::thread(&ResultsWriter::writeQueuedTables, this);
+
+	return 0;
+}
+
+int ResultsWriter::add (std::string product, std::string label_a, std::string label_b, ArrayView2D <const double> table)
+{
+	// The table is copied, so that the caller can reuse it at once; if too much is waiting to be written, this waits for the writer thread
+	if (!file_pointer)
+		return 1;
+
+	PendingTable	pending;
+	pending.entry.product = product;
+	pending.entry.label_a = label_a;
+	pending.entry.label_b = label_b;
+	memset(&pending.entry.record, 0, sizeof(ResultsIndexRecord));
+	pending.entry.record.rows = table.rows();
+	pending.entry.record.cols = table.cols();
+	pending.values.assign(table.data(), table.data() + table.count());
+	size_t	table_bytes = pending.values.size() * sizeof(double);
+
+	std::unique_lock <std::mutex>	lock(queue_mutex);
+	while (!failed && !queue.empty() && (queued_bytes + table_bytes > RESULTS_QUEUE_BYTES))
+		queue_changed.wait(lock);
+	if (failed)
+		return 1;
+	queued_bytes += table_bytes;
+	queue.push_back(PendingTable());
+	queue.back().entry = pending.entry;
+	queue.back().values.swap(pending.values);
+	queue_changed.notify_all();
+
+	return 0;
+}
+
+int ResultsWriter::close ()
+{
+	// Waits for the queued tables, then appends the index and completes the header. Returns 1 if anything could not be written.
+	if (!file_pointer)
+		return 0;
+
+	{
+		std::lock_guard <std::mutex>	lock(queue_mutex);
+		closing = true;
+		queue_changed.notify_all();
+	}
+	writer.join();
+
+	bool	write_failed = failed;
+	std::vector <char>	index_buffer;
+	size_t	i;
+	for (i = 0; i < entries.size(); i++) {
+		ResultsIndexRecord &	record = entries[i].record;
+		record.product_size = entries[i].product.size();
+		record.label_a_size = entries[i].label_a.size();
+		record.label_b_size = entries[i].label_b.size();
+		const char *	record_bytes = (const char *) &record;
+		index_buffer.insert(index_buffer.end(), record_bytes, record_bytes + sizeof(ResultsIndexRecord));
+		index_buffer.insert(index_buffer.end(), entries[i].product.begin(), entries[i].product.end());
+		index_buffer.insert(index_buffer.end(), entries[i].label_a.begin(), entries[i].label_a.end());
+		index_buffer.insert(index_buffer.end(), entries[i].label_b.begin(), entries[i].label_b.end());
+	}
+
+	ResultsFileHeader	header;
+	memset(&header, 0, sizeof(ResultsFileHeader));
+	memcpy(header.magic, RESULTS_FILE_MAGIC, 8);
+	header.flags = (compress)? RESULTS_FLAG_COMPRESSED : 0;
+	header.nr_entries = entries.size();
+	header.index_offset = file_offset;
+	header.index_size = index_buffer.size();
+	if (!write_failed && index_buffer.size())
+		write_failed = (fwrite(index_buffer.data(), 1, index_buffer.size(), file_pointer) != index_buffer.size());
+	if (!write_failed)
+		write_failed = (results_fseek(file_pointer, 0, SEEK_SET) != 0) || (fwrite(&header, sizeof(ResultsFileHeader), 1, file_pointer) != 1);
+	if (fclose(file_pointer) == EOF)
+		write_failed = true;
+
+	file_pointer = NULL;
+	entries.clear();
+	queue.clear();
+	queued_bytes = 0;
+
+	return (write_failed)? 1 : 0;
+}
+
+void ResultsWriter::writeQueuedTables ()
+{
+	// Body of the writer thread: tables are compressed (if requested) and written one at a time, in the order they were added
+	std::unique_lock <std::mutex>	lock(queue_mutex);
+	while (true) {
+		while (!closing && queue.empty())
+			queue_changed.wait(lock);
+		if (queue.empty())
+			break;
+
+		PendingTable	table;
+		table.entry = queue.front().entry;
+		table.values.swap(queue.front().values);
+		queue.pop_front();
+		bool	skip = failed;
+		lock.unlock();
+
+		int	error = (skip)? 0 : writeTable(table);
+
+		lock.lock();
+		queued_bytes -= table.values.size() * sizeof(double);
+		if (error)
+			failed = true;
+		queue_changed.notify_all();
+	}
+
+	return;
+}
+
+int ResultsWriter::writeTable (PendingTable & table)
+{
+	ResultsIndexRecord &	record = table.entry.record;
+	const void *	block = table.values.data();
+	size_t		block_size = table.values.size() * sizeof(double);
+	record.flags = 0;
+
+#ifdef NETONZERODXC_USE_ZLIB
+	std::vector <unsigned char>	shuffled, compressed;
+	if (compress && block_size) {			// Kept uncompressed if compression does not make it smaller
+		netOnZeroDXC_shuffle_bytes(shuffled, table.values);
+		uLongf	compressed_size = compressBound(block_size);
+		compressed.resize(compressed_size);
+		if ((compress2(compressed.data(), &compressed_size, shuffled.data(), block_size, RESULTS_COMPRESSION_LEVEL) == Z_OK) && (compressed_size < block_size)) {
+			block = compressed.data();
+			block_size = compressed_size;
+			record.flags = RESULTS_FLAG_COMPRESSED;
+		}
+	}
+#endif
+
+	if (block_size && (fwrite(block, 1, block_size, file_pointer) != block_size))
+		return 1;
+	record.offset = file_offset;
+	record.stored_size = block_size;
+	file_offset += block_size;
+	entries.push_back(table.entry);
+
+	return 0;
+}
+
+bool netOnZeroDXC_results_compression_available ()
+{
+#ifdef NETONZERODXC_USE_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+int netOnZeroDXC_check_results_file (std::string file_name)
+{
+	FILE *	file_pointer = fopen(file_name.c_str(), "rb");
+	if (!file_pointer)
+		return 0;
+
+	ResultsFileHeader	header;
+	size_t	nr_read = fread(&header, sizeof(ResultsFileHeader), 1, file_pointer);
+	fclose(file_pointer);
+
+	if ((nr_read != 1) || (memcmp(header.magic, RESULTS_FILE_MAGIC, 8) != 0))
+		return 0;
+
+	return 1;
+}
+
+int netOnZeroDXC_read_results_index (std::vector <ResultsEntry> & entries, std::string file_name)
+{
+	// Returns 2 if the file cannot be read, 3 if it is not a valid container, 4 if it was not completed (no index)
+	entries.clear();
+	FILE *	file_pointer = fopen(file_name.c_str(), "rb");
+	if (!file_pointer)
+		return 2;
+
+	ResultsFileHeader	header;
+	if ((fread(&header, sizeof(ResultsFileHeader), 1, file_pointer) != 1) || (memcmp(header.magic, RESULTS_FILE_MAGIC, 8) != 0)) {
+		fclose(file_pointer);
+		return 3;
+	}
+	if (header.index_offset == 0) {
+		fclose(file_pointer);
+		return 4;
+	}
+
+	int64_t	file_size = -1;
+	if (results_fseek(file_pointer, 0, SEEK_END) == 0)
+		file_size = results_ftell(file_pointer);
+	if ((file_size < 0) || (header.index_offset < sizeof(ResultsFileHeader)) || (header.index_offset > (uint64_t) file_size)
+			|| (header.index_size != (uint64_t) file_size - header.index_offset)) {
+		fclose(file_pointer);
+		return 3;
+	}
+
+	std::vector <char>	index_buffer(header.index_size);
+	bool	valid = (results_fseek(file_pointer, header.index_offset, SEEK_SET) == 0);
+	valid = valid && ((header.index_size == 0) || (fread(index_buffer.data(), 1, header.index_size, file_pointer) == header.index_size));
+	fclose(file_pointer);
+
+	size_t	position = 0;
+	uint32_t	i;
+	for (i = 0; (i < header.nr_entries) && valid; i++) {
+		ResultsEntry	entry;
+		if (index_buffer.size() - position < sizeof(ResultsIndexRecord)) {
+			valid = false;
+			break;
+		}
+		memcpy(&entry.record, index_buffer.data() + position, sizeof(ResultsIndexRecord));
+		position += sizeof(ResultsIndexRecord);
+
+		const ResultsIndexRecord &	record = entry.record;
+		uint64_t	strings_size = (uint64_t) record.product_size + record.label_a_size + record.label_b_size;
+		uint64_t	values_size = (uint64_t) record.rows * record.cols * sizeof(double);
+		valid = (strings_size <= index_buffer.size() - position) && (record.offset >= sizeof(ResultsFileHeader));
+		valid = valid && (record.stored_size <= header.index_offset - record.offset) && (record.offset <= header.index_offset);
+		valid = valid && ((record.flags & RESULTS_FLAG_COMPRESSED) || (record.stored_size == values_size));
+		if (!valid)
+			break;
+
+		const char *	strings = index_buffer.data() + position;
+		entry.product.assign(strings, record.product_size);
+		entry.label_a.assign(strings + record.product_size, record.label_a_size);
+		entry.label_b.assign(strings + record.product_size + record.label_a_size, record.label_b_size);
+		position += strings_size;
+		entries.push_back(entry);
+	}
+
+	if (!valid || (position != index_buffer.size())) {
+		entries.clear();
+		return 3;
+	}
+
+	return 0;
+}
+
+int netOnZeroDXC_find_results_entry (const std::vector <ResultsEntry> & entries, std::string product, std::string label_a, std::string label_b)
+{
+	// A table written twice (e.g. by a resumed run) is taken from its last copy. Returns -1 if there is none.
+	int	i;
+	for (i = entries.size() - 1; i >= 0; i--) {
+		if ((entries[i].product == product) && (entries[i].label_a == label_a) && (entries[i].label_b == label_b))
+			return i;
+	}
+
+	return -1;
+}
+
+int netOnZeroDXC_load_results_table (std::vector < std::vector <double> > & data_table, const ResultsEntry & entry, FILE * file_pointer)
+{
+	// Returns 2 if the block cannot be read, 3 if it is damaged, 5 if it is compressed and zlib support was not compiled in
+	const ResultsIndexRecord &	record = entry.record;
+	size_t	nr_values = (size_t) record.rows * record.cols;
+	std::vector <double>	values(nr_values);
+	std::vector <unsigned char>	stored(record.stored_size);
+
+	if (results_fseek(file_pointer, record.offset, SEEK_SET) != 0)
+		return 2;
+	if (stored.size() && (fread(stored.data(), 1, stored.size(), file_pointer) != stored.size()))
+		return 2;
+
+	if (record.flags & RESULTS_FLAG_COMPRESSED) {
+#ifdef NETONZERODXC_USE_ZLIB
+		std::vector <unsigned char>	shuffled(nr_values * sizeof(double));
+		uLongf	shuffled_size = shuffled.size();
+		if ((uncompress(shuffled.data(), &shuffled_size, stored.data(), stored.size()) != Z_OK) || (shuffled_size != shuffled.size()))
+			return 3;
+		netOnZeroDXC_unshuffle_bytes(values, shuffled);
+#else
+		return 5;
+#endif
+	} else if (nr_values) {
+		memcpy(values.data(), stored.data(), nr_values * sizeof(double));
+	}
+
+	uint32_t	i;
+	data_table.assign(record.rows, std::vector <double> ());
+	for (i = 0; i < record.rows; i++)
+		data_table[i].assign(values.begin() + (size_t) i * record.cols, values.begin() + (size_t) (i + 1) * record.cols);
+
+	return 0;
+}
+
+int netOnZeroDXC_load_results_table (std::vector < std::vector <double> > & data_table, std::string file_name, std::string product, std::string label_a,
+				std::string label_b)
+{
+	// Returns 2-5 as netOnZeroDXC_read_results_index and netOnZeroDXC_load_results_table, 6 if the container has no such table
+	std::vector <ResultsEntry>	entries;
+	int	error = netOnZeroDXC_read_results_index(entries, file_name);
+	if (error)
+		return error;
+
+	int	position = netOnZeroDXC_find_results_entry(entries, product, label_a, label_b);
+	if (position < 0)
+		return 6;
+
+	FILE *	file_pointer = fopen(file_name.c_str(), "rb");
+	if (!file_pointer)
+		return 2;
+	error = netOnZeroDXC_load_results_table(data_table, entries[position], file_pointer);
+	fclose(file_pointer);
+
+	return error;
+}
+
+int netOnZeroDXC_list_results_pairs (std::vector <int> & selected, const std::vector <ResultsEntry> & entries, std::string product)
+{
+	// Tables of the given product, one per pair, ordered by labels as the sorted list of the corresponding text files; returns 1 if there is none
+	std::vector < std::pair < std::pair <std::string, std::string>, int > >	sorted_pairs;
+	int	i;
+	for (i = 0; i < entries.size(); i++) {
+		if (entries[i].product == product)
+			sorted_pairs.push_back(std::make_pair(std::make_pair(entries[i].label_a, entries[i].label_b), i));
+	}
+	std::sort(sorted_pairs.begin(), sorted_pairs.end());
+
+	selected.clear();
+	for (i = 0; i < sorted_pairs.size(); i++) {			// Copies of a table are sorted by position: the last one is kept
+		if ((i + 1 == sorted_pairs.size()) || (sorted_pairs[i + 1].first != sorted_pairs[i].first))
+			selected.push_back(sorted_pairs[i].second);
+	}
+
+	return (selected.size())? 0 : 1;
+}
+
+int netOnZeroDXC_load_results_diagrams (Array3D <double> & diagrams, std::vector <PairOfLabels> & list_pairs, std::string file_name)
+{
+	// All the p-value diagrams of a container. Returns 2 if they cannot be read, 3 if their sizes differ, 4 if the labels are not consistent.
+	std::vector <ResultsEntry>	entries;
+	std::vector <int>		selected;
+	if (netOnZeroDXC_read_results_index(entries, file_name) || netOnZeroDXC_list_results_pairs(selected, entries, "pdiag"))
+		return 2;
+
+	const ResultsIndexRecord &	first = entries[selected[0]].record;
+	if ((first.rows == 0) || (first.cols == 0))
+		return 3;
+	FILE *	file_pointer = fopen(file_name.c_str(), "rb");
+	if (!file_pointer)
+		return 2;
+
+	int	i, l;
+	int	error = 0;
+	std::vector < std::vector <double> >	table;
+	diagrams.resize(selected.size(), first.rows, first.cols, 0.0);
+	list_pairs.clear();
+	for (i = 0; (i < selected.size()) && !error; i++) {
+		const ResultsEntry &	entry = entries[selected[i]];
+		if ((entry.record.rows != first.rows) || (entry.record.cols != first.cols)) {
+			error = 3;
+			break;
+		}
+		if (netOnZeroDXC_load_results_table(table, entry, file_pointer)) {
+			error = 2;
+			break;
+		}
+		for (l = 0; l < first.rows; l++)
+			std::copy(table[l].begin(), table[l].end(), diagrams[i][l]);
+		PairOfLabels	pair;
+		pair.label_a = entry.label_a;
+		pair.label_b = entry.label_b;
+		list_pairs.push_back(pair);
+	}
+	fclose(file_pointer);
+	if (error)
+		return error;
+
+	if (netOnZeroDXC_check_list_pairs(list_pairs))
+		return 4;
+
+	return 0;
+}
+
+int netOnZeroDXC_load_results_efficiencies (std::vector < std::vector <double> > & efficiencies, std::vector <PairOfLabels> & list_pairs,
+					std::vector <double> & window_widths, std::string file_name)
+{
+	// All the efficiencies of a container, with the same checks and return values as netOnZeroDXC_load_results_diagrams
+	std::vector <ResultsEntry>	entries;
+	std::vector <int>		selected;
+	if (netOnZeroDXC_read_results_index(entries, file_name) || netOnZeroDXC_list_results_pairs(selected, entries, "eff"))
+		return 2;
+
+	FILE *	file_pointer = fopen(file_name.c_str(), "rb");
+	if (!file_pointer)
+		return 2;
+
+	int	i, j;
+	int	error = 0;
+	std::vector < std::vector <double> >	table;
+	std::vector <double>	temp_eta;
+	efficiencies.clear();
+	window_widths.clear();
+	list_pairs.clear();
+	for (i = 0; (i < selected.size()) && !error; i++) {
+		const ResultsEntry &	entry = entries[selected[i]];
+		if ((entry.record.cols != 2) || (i && (entry.record.rows != window_widths.size()))) {
+			error = 3;
+			break;
+		}
+		if (netOnZeroDXC_load_results_table(table, entry, file_pointer)) {
+			error = 2;
+			break;
+		}
+		temp_eta.clear();
+		for (j = 0; j < table.size(); j++) {
+			if (i == 0) {
+				window_widths.push_back(table[j][0]);
+			} else if (window_widths[j] != table[j][0]) {
+				error = 3;
+				break;
+			}
+			temp_eta.push_back(table[j][1]);
+		}
+		efficiencies.push_back(temp_eta);
+		PairOfLabels	pair;
+		pair.label_a = entry.label_a;
+		pair.label_b = entry.label_b;
+		list_pairs.push_back(pair);
+	}
+	fclose(file_pointer);
+	if (error)
+		return error;
+
+	if (netOnZeroDXC_check_list_pairs(list_pairs))
+		return 4;
+
+	return 0;
+}
+
+int netOnZeroDXC_write_diagram (ResultsWriter * results_writer, ArrayView2D <const double> diagram, std::string path, std::string prefix, std::string label,
+			char delimiter, std::string label_a, std::string label_b, char separator)
+{
+	// Goes to the results container if one is open, otherwise to its own text file as netOnZeroDXC_save_diagram
+	if (results_writer && results_writer->isOpen())
+		return results_writer->add(label, label_a, label_b, diagram);
+
+	return netOnZeroDXC_save_diagram(diagram, path, prefix, label, delimiter, label_a, label_b, separator);
+}
+
+int netOnZeroDXC_write_diagram (ResultsWriter * results_writer, const std::vector < std::vector <double> > & diagram, std::string path, std::string prefix,
+			std::string label, char delimiter, std::string label_a, std::string label_b, char separator)
+{
+	if (!results_writer || !results_writer->isOpen())
+		return netOnZeroDXC_save_diagram(diagram, path, prefix, label, delimiter, label_a, label_b, separator);
+
+	int	i;
+	int	nr_cols = (diagram.size())? diagram[0].size() : 0;
+	Array2D <double>	table(diagram.size(), nr_cols, 0.0);
+	for (i = 0; i < diagram.size(); i++) {
+		if (diagram[i].size() != nr_cols)
+			return 1;
+		std::copy(diagram[i].begin(), diagram[i].end(), table[i]);
+	}
+
+	return results_writer->add(label, label_a, label_b, table);
+}
+
+int netOnZeroDXC_write_linear_data (ResultsWriter * results_writer, const std::vector <double> & x, const std::vector <double> & y, std::string path,
+				std::string prefix, std::string label, char delimiter, std::string label_a, std::string label_b, char separator)
+{
+	// In a container, the two columns of the text file become a table of x.size() rows and 2 columns
+	if (!results_writer || !results_writer->isOpen())
+		return netOnZeroDXC_save_linear_data(x, y, path, prefix, label, delimiter, label_a, label_b, separator);
+	if (x.size() != y.size())
+		return 1;
+
+	int	i;
+	Array2D <double>	table(x.size(), 2, 0.0);
+	for (i = 0; i < x.size(); i++) {
+		table[i][0] = x[i];
+		table[i][1] = y[i];
+	}
+
+	return results_writer->add(label, label_a, label_b, table);
+}
+
+void netOnZeroDXC_shuffle_bytes (std::vector <unsigned char> & shuffled, const std::vector <double> & values)
+{
+	// Byte b of every value goes to plane b: exponents and leading mantissa bytes of close values end up next to each other, and compress well
+	size_t	n = values.size();
+	size_t	i;
+	int	b;
+	const unsigned char *	bytes = (const unsigned char *) values.data();
+	shuffled.resize(n * sizeof(double));
+	for (b = 0; b < sizeof(double); b++) {
+		unsigned char *	plane = shuffled.data() + b * n;
+		for (i = 0; i < n; i++)
+			plane[i] = bytes[i * sizeof(double) + b];
+	}
+
+	return;
+}
+
+void netOnZeroDXC_unshuffle_bytes (std::vector <double> & values, const std::vector <unsigned char> & shuffled)
+{
+	size_t	n = values.size();
+	size_t	i;
+	int	b;
+	unsigned char *	bytes = (unsigned char *) values.data();
+	for (b = 0; b < sizeof(double); b++) {
+		const unsigned char *	plane = shuffled.data() + b * n;
+		for (i = 0; i < n; i++)
+			bytes[i * sizeof(double) + b] = plane[i];
+	}
+
+	return;
+}
@@ -0,0 +1,134 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#ifndef INCLUDED_PAIR
+	#include "netOnZeroDXC_pair.hpp"
+	#define INCLUDED_PAIR
+#endif
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
+
+// Results container: the diagrams, efficiencies and matrices of a run in a single file, in the byte order of the machine that wrote it:
+//	ResultsFileHeader (32 bytes)
+//	one block per table, in the order the tables were added: rows x cols float64 values, row-major, or (RESULTS_FLAG_COMPRESSED)
+//		the same values zlib-compressed after grouping the bytes of equal significance of all values
+//	the index, at index_offset: one ResultsIndexRecord per table, each followed by its product, label_a and label_b (not NUL-terminated)
+// Tables are laid out as the text file of the same product: "cdiag" and "pdiag" are W x K, "eff" is W x 2 (window width, efficiency),
+// "matrix" is N x N with empty labels. The index is written when the container is closed: index_offset = 0 means an incomplete file.
+#define RESULTS_FILE_MAGIC "NZDXRES1"
+#define RESULTS_FLAG_COMPRESSED 1
+#define RESULTS_QUEUE_BYTES 67108864		// Tables waiting for the writer thread beyond which add() waits
+#define RESULTS_COMPRESSION_LEVEL 1		// zlib level: output speed matters more than size
+
+struct ResultsFileHeader {
+	char		magic[8];
+	uint32_t	flags;				// RESULTS_FLAG_COMPRESSED if the writer was asked to compress
+	uint32_t	nr_entries;
+	uint64_t	index_offset;
+	uint64_t	index_size;
+};
+
+struct ResultsIndexRecord {
+	uint32_t	product_size;
+	uint32_t	label_a_size;
+	uint32_t	label_b_size;
+	uint32_t	flags;				// RESULTS_FLAG_COMPRESSED if this block is compressed
+	uint32_t	rows;
+	uint32_t	cols;
+	uint64_t	offset;
+	uint64_t	stored_size;
+};
+
+struct ResultsEntry {
+	std::string		product;
+	std::string		label_a;
+	std::string		label_b;
+	ResultsIndexRecord	record;
+};
+
+class ResultsWriter
+{
+public:
+	ResultsWriter();
+	~ResultsWriter();
+
+	int open(std::string, bool);
+	int add(std::string, std::string, std::string, ArrayView2D <const double>);
+	int close();
+	bool isOpen() const;
+
+private:
+	struct PendingTable {
+		ResultsEntry		entry;
+		std::vector <double>	values;
+	};
+
+	void writeQueuedTables();
+	int writeTable(PendingTable &);
+
+	FILE				*file_pointer;
+	bool				compress;
+	uint64_t			file_offset;		// Only used by the writer thread until close() has joined it
+	std::vector <ResultsEntry>	entries;
+
+	std::thread			writer;
+	std::mutex			queue_mutex;
+	std::condition_variable		queue_changed;
+	std::deque <PendingTable>	queue;
+	size_t				queued_bytes;
+	bool				closing;
+	bool				failed;
+};
+
+bool netOnZeroDXC_results_compression_available ();
+int netOnZeroDXC_check_results_file (std::string);
+int netOnZeroDXC_read_results_index (std::vector <ResultsEntry> &, std::string);
+int netOnZeroDXC_find_results_entry (const std::vector <ResultsEntry> &, std::string, std::string, std::string);
+int netOnZeroDXC_load_results_table (std::vector < std::vector <double> > &, const ResultsEntry &, FILE *);
+int netOnZeroDXC_load_results_table (std::vector < std::vector <double> > &, std::string, std::string, std::string, std::string);
+int netOnZeroDXC_list_results_pairs (std::vector <int> &, const std::vector <ResultsEntry> &, std::string);
+int netOnZeroDXC_load_results_diagrams (Array3D <double> &, std::vector <PairOfLabels> &, std::string);
+int netOnZeroDXC_load_results_efficiencies (std::vector < std::vector <double> > &, std::vector <PairOfLabels> &, std::vector <double> &, std::string);
+
+int netOnZeroDXC_write_diagram (ResultsWriter *, ArrayView2D <const double>, std::string, std::string, std::string, char, std::string, std::string, char);
+int netOnZeroDXC_write_diagram (ResultsWriter *, const std::vector < std::vector <double> > &, std::string, std::string, std::string, char, std::string, std::string, char);
+int netOnZeroDXC_write_linear_data (ResultsWriter *, const std::vector <double> &, const std::vector <double> &, std::string, std::string, std::string, char,
+				std::string, std::string, char);
@@ -47,6 +47,7 @@
 wxBEGIN_EVENT_TABLE(GuiFrame, wxFrame)
 	EVT_MENU(APP_ABOUT, GuiFrame::showAboutDialog)
 	EVT_MENU(APP_QUIT, GuiFrame::onFrameQuit)
+	EVT_THREAD(EVENT_WORKER_UPDATE, GuiFrame::onLoaderEvent)
 wxEND_EVENT_TABLE()
 
 // Frame constructor: this contains the initialization of all buttons, controls and boxes within the main window.
@@ -68,6 +69,9 @@ GuiFrame::GuiFrame(const wxString& title)
 
 	data_container = new ContainerWorkspace();
 	data_container->clearWorkspace();
+	configured_load = new ConfiguredLoad();
+	dialog_progress = (wxProgressDialog *) NULL;
+	m_cancelled = false;
 
 	initializeConstants();
 
@@ -408,6 +412,7 @@ void GuiFrame::initializeConstants ()
 GuiFrame::~GuiFrame ()
 {
 	delete	data_container;
+	delete	configured_load;
 	delete	spinner_thr_efficiency;
 	delete	spinner_ranking_recordings;
 	delete	spinner_ranking_systems;
@@ -33,6 +33,7 @@
 #include <sstream>
 #include <string>
 #include <algorithm>
+#include <limits>
 
 #ifndef INCLUDED_MAINAPP
 	#include "netOnZeroDXC_merge_main.hpp"
@@ -54,11 +55,8 @@ void GuiFrame::validatePreprocessData (wxCommandEvent& WXUNUSED(event))
 	int	i, j;
 
 	if (status_ready) {
-		for (i = 0; i < data_container->number_of_systems; i++) {
-			for (j = 0; j < data_container->systems_stored[i].recordings_stored.size(); j++) {
-				data_container->systems_stored[i].recordings_stored[j].matrices_multieta.clear();
-			}
-		}
+		data_container->sorted_recordings.clear();
+		data_container->sorted_systems.clear();
 		unsetReadyStatus();
 		return;
 	}
@@ -143,32 +141,10 @@ void GuiFrame::validatePreprocessData (wxCommandEvent& WXUNUSED(event))
 		}
 	}
 
-	int	k;
 	if (variable_eta) {
 		netOnZeroDXC_postfill_list_labels(data_container->node_labels, data_container->node_pairs);
+		netOnZeroDXC_build_pair_index_table(data_container->pair_index, data_container->node_pairs, data_container->node_labels);
 		data_container->number_of_nodes = data_container->node_labels.size();
-		int	s, r, eta_index;
-		std::vector <double>	temp_row(data_container->number_of_nodes, -1.0);
-		std::vector < std::vector <double> >	temp_matrix;
-		for (s = 0; s < data_container->number_of_systems; s++) {
-			for (r = 0; r < data_container->number_of_recordings; r++) {
-				for (eta_index = 0; eta_index <= 100; eta_index++) {
-					temp_matrix.clear();
-					temp_matrix.resize(data_container->number_of_nodes, temp_row);
-					for (i = 0; i < data_container->number_of_nodes - 1; i++) {
-						temp_matrix[i][i] = 0.0;
-						for (j = i + 1; j < data_container->number_of_nodes; j++) {
-							k = netOnZeroDXC_associate_index_of_pair(data_container->node_pairs, data_container->node_labels, i, j);
-							temp_matrix[i][j] = netOnZeroDXC_compute_wmatrix_element(data_container->systems_stored[s].recordings_stored[r].efficiencies[k],
-														data_container->window_widths, ((double) eta_index) / 100.0);
-							temp_matrix[j][i] = temp_matrix[i][j];
-						}
-					}
-					temp_matrix[i][i] = 0.0;
-					data_container->systems_stored[s].recordings_stored[r].matrices_multieta.push_back(temp_matrix);
-				}
-			}
-		}
 	} else {
 		double	w_max = -1.0;
 		int	r, s;
@@ -190,6 +166,7 @@ void GuiFrame::validatePreprocessData (wxCommandEvent& WXUNUSED(event))
 			data_container->window_widths.push_back(w_max * ((double) i) / 100.0);
 		}
 	}
+	data_container->buildRankTables();
 	sstm << "Validation succeeded.\n";
 	sstm << "There are " << data_container->number_of_systems << " systems, each containing " << data_container->number_of_recordings << " recordings.\n";
 	sstm << "Loaded data are " << ((variable_eta)? "efficiencies" : "matrices") << "\n";
@@ -342,17 +319,16 @@ void ContainerWorkspace::evaluateMergedMatrix (int rank_systems, int rank_record
 	ranked_matrix.clear();
 	ranked_matrix.resize(number_of_nodes, temp_row);
 
-	int	i, j, s;
-	std::vector <double>	temp_list;
+	int	i, j;
+	int	pair = 0;
+	int	level = (eta_index < 0)? 0 : eta_index;
+	int	column = (rank_recordings - 1) * number_of_systems + rank_systems - 1;
+	double	temp_element;
 	for (i = 0; i < number_of_nodes - 1; i++) {
 		ranked_matrix[i][i] = 0.0;
 		for (j = i + 1; j < number_of_nodes; j++) {
-			temp_list.clear();
-			for (s = 0; s < number_of_systems; s++) { // traverse the systems
-				temp_list.push_back(systems_stored[s].mergeRecordingMatrices(i, j, rank_recordings, eta_index));
-			}
-			partial_sort(temp_list.begin(), temp_list.begin() + rank_systems, temp_list.end());
-			ranked_matrix[i][j] = (temp_list[rank_systems - 1] == huge)? -1.0 : temp_list[rank_systems - 1];
+			temp_element = sorted_systems[level][pair++][column];
+			ranked_matrix[i][j] = (temp_element == huge)? -1.0 : temp_element;
 			ranked_matrix[j][i] = ranked_matrix[i][j];
 		}
 	}
@@ -369,11 +345,14 @@ void ContainerWorkspace::evaluateSystemMatrix (int system_index, int rank_record
 	ranked_matrix.resize(number_of_nodes, temp_row);
 
 	int	i, j;
+	int	pair = 0;
+	int	level = (eta_index < 0)? 0 : eta_index;
+	int	column = system_index * number_of_recordings + rank_recordings - 1;
 	double	temp_element;
 	for (i = 0; i < number_of_nodes - 1; i++) {
 		ranked_matrix[i][i] = 0.0;
 		for (j = i + 1; j < number_of_nodes; j++) {
-			temp_element = systems_stored[system_index].mergeRecordingMatrices(i, j, rank_recordings, eta_index);
+			temp_element = sorted_recordings[level][pair++][column];
 			ranked_matrix[i][j] = (temp_element == huge)? -1.0 : temp_element;
 			ranked_matrix[j][i] = ranked_matrix[i][j];
 		}
@@ -383,6 +362,65 @@ void ContainerWorkspace::evaluateSystemMatrix (int system_index, int rank_record
 	return;
 }
 
+void ContainerWorkspace::buildRankTables ()
+{
+	// For each eta level (a single one with loaded matrices) and each pair, the recordings of every system are sorted, then the systems
+	// are sorted at every rank of recordings: the evaluation of a merged matrix reads a single element per pair.
+	// Missing links (-1) are sorted as the largest value. (Level, pair) tasks are independent and filled in parallel.
+	double	huge = std::numeric_limits<double>::max();
+	int	nr_levels = (multiple_eta)? 101 : 1;
+	int	nr_pairs = number_of_nodes * (number_of_nodes - 1) / 2;
+	int	nr_systems = number_of_systems;
+	int	nr_recordings = number_of_recordings;
+	sorted_recordings.resize(nr_levels, nr_pairs, nr_systems * nr_recordings, 0.0);
+	sorted_systems.resize(nr_levels, nr_pairs, nr_recordings * nr_systems, 0.0);
+
+	std::vector <int>	pair_node_a, pair_node_b;
+	int	i, j;
+	for (i = 0; i < number_of_nodes - 1; i++) {
+		for (j = i + 1; j < number_of_nodes; j++) {
+			pair_node_a.push_back(i);
+			pair_node_b.push_back(j);
+		}
+	}
+
+	long	nr_tasks = (long) nr_levels * nr_pairs;
+	#pragma omp parallel for schedule(dynamic)
+	for (long t = 0; t < nr_tasks; t++) {
+		int	level = t / nr_pairs;
+		int	pair = t % nr_pairs;
+		int	a = pair_node_a[pair];
+		int	b = pair_node_b[pair];
+		int	k = (multiple_eta)? pair_index.index(a, b) : -1;
+		double	*recordings = sorted_recordings[level][pair];
+		double	*systems = sorted_systems[level][pair];
+
+		int	s, r;
+		for (s = 0; s < nr_systems; s++) {
+			double	*system_recordings = recordings + (size_t) s * nr_recordings;
+			for (r = 0; r < nr_recordings; r++) {
+				if (multiple_eta) {
+					system_recordings[r] = netOnZeroDXC_compute_wmatrix_element(systems_stored[s].recordings_stored[r].efficiencies[k], window_widths,
+													((double) level) / 100.0);
+				} else {
+					system_recordings[r] = systems_stored[s].recordings_stored[r].matrix_timescales[a][b];
+				}
+				if (system_recordings[r] == -1.0)
+					system_recordings[r] = huge;
+			}
+			std::sort(system_recordings, system_recordings + nr_recordings);
+		}
+		for (r = 0; r < nr_recordings; r++) {
+			double	*ranked_systems = systems + (size_t) r * nr_systems;
+			for (s = 0; s < nr_systems; s++)
+				ranked_systems[s] = recordings[(size_t) s * nr_recordings + r];
+			std::sort(ranked_systems, ranked_systems + nr_systems);
+		}
+	}
+
+	return;
+}
+
 void ContainerWorkspace::clearWorkspace ()
 {
 	number_of_systems = 0;
@@ -393,8 +431,11 @@ void ContainerWorkspace::clearWorkspace ()
 
 	systems_stored.clear();
 	ranked_matrix.clear();
+	sorted_recordings.clear();
+	sorted_systems.clear();
 	window_widths.clear();
 	node_pairs.clear();
+	pair_index.clear();
 	node_labels.clear();
 
 	return;
@@ -405,27 +446,6 @@ ObservedSystem::ObservedSystem (const std::string name)
 	system_name = name;
 }
 
-double ObservedSystem::mergeRecordingMatrices (int i, int j, int rank_recordings, int eta_index)
-{
-	double	huge = std::numeric_limits<double>::max();
-	int	number_of_recordings = recordings_stored.size();
-	std::vector <double>	temp_list;
-	int	r;
-	for (r = 0; r < number_of_recordings; r++) { // traverse the recordings
-		if (eta_index < 0) {
-			temp_list.push_back(recordings_stored[r].matrix_timescales[i][j]);
-		} else {
-			temp_list.push_back(recordings_stored[r].matrices_multieta[eta_index][i][j]);
-		}
-	}
-	for (r = 0; r < temp_list.size(); r++) {
-		if (temp_list[r] == -1.0)
-			temp_list[r] = huge;
-	}
-	partial_sort(temp_list.begin(), temp_list.begin() + rank_recordings, temp_list.end());
-	return temp_list[rank_recordings - 1];
-}
-
 ObservedRecording::ObservedRecording (const std::string name)
 {
 	recording_name = name;
@@ -159,6 +159,7 @@ void PlotFrame::OnSlide (wxCommandEvent & WXUNUSED(event))
 		results_workspace->evaluateSystemMatrix(system_index, slider_rnk_recordings->GetValue(), eta_index);
 
 	parent_window->updateSpinnerFromSliders(((double) slider_thr_efficiency->GetValue()) / 100.0, slider_rnk_recordings->GetValue(), slider_rnk_systems->GetValue());
+	plot_area->invalidateBitmap();
 	plot_area->Refresh();
 }
 
@@ -167,6 +168,9 @@ PanelPlot::PanelPlot (PlotFrame *parent, wxSize panel_size)
 {
 	parent_frame = parent;
 	results_workspace = parent->results_workspace;
+	netOnZeroDXC_build_color_lut(color_lut);
+	bitmap_valid = false;
+	bitmap_pxsize = 0;
 
 	Connect(wxEVT_PAINT, wxPaintEventHandler(PanelPlot::OnPaint));
 	Connect(wxEVT_SIZE, wxSizeEventHandler(PanelPlot::OnResize));
@@ -177,6 +181,11 @@ void PanelPlot::OnResize (wxSizeEvent & WXUNUSED(event))
 	this->Refresh();
 }
 
+void PanelPlot::invalidateBitmap ()
+{
+	bitmap_valid = false;
+}
+
 void PanelPlot::OnPaint (wxPaintEvent & WXUNUSED(event))
 {
 	wxPaintDC dc(this);
@@ -197,18 +206,16 @@ void PanelPlot::OnPaint (wxPaintEvent & WXUNUSED(event))
 		dc.DrawLabel(results_workspace->node_labels[i], wxRect(wxPoint(0, size_displace + i*pxsize),wxSize(size_displace, pxsize)), wxALIGN_RIGHT | wxALIGN_CENTER_VERTICAL);
 	}
 
-	dc.SetPen(*wxTRANSPARENT_PEN);
-	int	j;
-	double	w_to_draw;
-	for (i = 0; i < nr_pixels; i++) {
-		for (j = 0; j < nr_pixels; j++) {
-			wxBrush brush1;
-			w_to_draw = results_workspace->ranked_matrix[i][j] / w_max;
-			brush1 = wxBrush(netOnZeroDXC_color_palette(w_to_draw));
-			dc.SetBrush(brush1);
-			dc.DrawRectangle(wxRect(size_displace + j*pxsize, size_displace + i*pxsize, pxsize, pxsize));
-		}
+	if (pxsize < 1)
+		return;
+	if (!bitmap_valid || (pxsize != bitmap_pxsize)) {		// Resizes that keep the size of the elements only blit the bitmap again
+		wxImage	matrix_image;
+		netOnZeroDXC_render_matrix(matrix_image, results_workspace->ranked_matrix, w_max, pxsize, color_lut);
+		matrix_bitmap = wxBitmap(matrix_image);
+		bitmap_valid = true;
+		bitmap_pxsize = pxsize;
 	}
+	dc.DrawBitmap(matrix_bitmap, size_displace, size_displace, false);
 
 	return;
 }
@@ -34,6 +34,9 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <algorithm>
+
+#include "omp.h"
 
 #ifndef INCLUDED_MAINAPP
 	#include "netOnZeroDXC_merge_main.hpp"
@@ -47,6 +50,10 @@
 	#include "netOnZeroDXC_gui_io.hpp"
 	#define INCLUDED_IOFUNCTIONS_WX
 #endif
+#ifndef INCLUDED_IORESULTS
+	#include "netOnZeroDXC_io_results.hpp"
+	#define INCLUDED_IORESULTS
+#endif
 
 void GuiFrame::loadEfficiencyFiles (int system_index, int recording_index)
 {
@@ -92,8 +99,12 @@ void GuiFrame::loadEfficiencyFiles (int system_index, int recording_index)
 	}
 
 	std::string	temp_recording_name = file_name.substr(file_name.find_last_of("/\\") + 1, std::string::npos);
-	temp_recording_name = temp_recording_name.substr(0, temp_recording_name.find_last_of(filename_delimiter_char));
-	temp_recording_name = temp_recording_name.substr(0, temp_recording_name.find_last_of(filename_delimiter_char));
+	if ((list_of_files.size() == 1) && netOnZeroDXC_check_results_file(file_name)) {	// A results container is named after its file
+		temp_recording_name = temp_recording_name.substr(0, temp_recording_name.find_last_of('.'));
+	} else {
+		temp_recording_name = temp_recording_name.substr(0, temp_recording_name.find_last_of(filename_delimiter_char));
+		temp_recording_name = temp_recording_name.substr(0, temp_recording_name.find_last_of(filename_delimiter_char));
+	}
 
 	int	loading_error;
 	std::stringstream		sstm;
@@ -298,21 +309,16 @@ void GuiFrame::configuredLoadFiles (wxCommandEvent& WXUNUSED(event))
 		return;
 	}
 
-	int	error;
-	char	*buffered_line = new char[256];
+	int	error = 0;
 	bool	matrix_mode = true;
 	bool	temp_matrix_mode;
 	std::string	line;
-	std::string	system_name;
-	std::string	recording_name;
-	std::string	temp_file_name;
-	std::vector <ObservedSystem>	temp_loaded_observations;
-	std::vector <PairOfLabels>	temp_loaded_pair_labels;
-	std::vector <PairOfLabels>	loaded_pair_labels;
-	while(selected_file_stream.getline(buffered_line, 256)) {
-		line = buffered_line;
+	ConfiguredEntry	entry;
+	ConfiguredLoad &	load = *configured_load;
+	load.entries.clear();
+	while(std::getline(selected_file_stream, line)) {		// Lines are only parsed here: files are read by a LoaderThread
 		if (line.size()) {
-			error = netOnZeroDXC_parse_configuration_line(system_name, recording_name, temp_matrix_mode, temp_file_name, line, separator_char);
+			error = netOnZeroDXC_parse_configuration_line(entry.system_name, entry.recording_name, temp_matrix_mode, entry.file_name, line, separator_char);
 			if (error == 1) {
 				wxMessageBox("Error in reading configuration file.\nFormat is invalid, maybe a wrong separator?\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
 				break;
@@ -321,59 +327,89 @@ void GuiFrame::configuredLoadFiles (wxCommandEvent& WXUNUSED(event))
 				break;
 			}
 			if (data_container->number_of_systems > 0) {
-				if ((data_container->multiple_eta && matrix_mode) || ((!data_container->multiple_eta) && (!matrix_mode))) {
+				if ((data_container->multiple_eta && temp_matrix_mode) || ((!data_container->multiple_eta) && (!temp_matrix_mode))) {
 					wxMessageBox("Error in reading configuration file.\nLoading mode label is inconsistent with previously loaded data.\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
 					error = 1;
 					break;
 				}
 			}
-
-			ObservedRecording	temp_recording = ObservedRecording(recording_name);
-			if (temp_loaded_observations.size() == 0) {
+			if (load.entries.size() == 0) {
 				matrix_mode = temp_matrix_mode;
-				error = loadConfiguredRecording(temp_recording, temp_loaded_pair_labels, matrix_mode, temp_file_name, folder_name, separator_char, filename_delimiter_char);
-				if (error)
-					break;
-				if (!matrix_mode && (data_container->number_of_systems == 0)) {
-					loaded_pair_labels = temp_loaded_pair_labels;
-				} else if (!matrix_mode) {
-					loaded_pair_labels = temp_loaded_pair_labels;
-					error = netOnZeroDXC_check_new_label_pairs(temp_loaded_pair_labels, data_container->node_pairs);
-				}
-				if (error)
-					break;
-
-				ObservedSystem		temp_system = ObservedSystem(system_name);
-				temp_system.addObservedRecording(temp_recording);
-				temp_loaded_observations.push_back(temp_system);
-			} else {
-				if (matrix_mode != temp_matrix_mode) {
-					wxMessageBox("Error in reading configuration file.\nLoading mode specifier labels are inconsistent across the file.\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
-					break;
-				}
-				error = loadConfiguredRecording(temp_recording, temp_loaded_pair_labels, matrix_mode, temp_file_name, folder_name, separator_char, filename_delimiter_char);
-				if (error)
-					break;
-				if (!matrix_mode) {
-					error = netOnZeroDXC_check_new_label_pairs(temp_loaded_pair_labels, loaded_pair_labels);
-				}
-				if (error)
-					break;
-				if (system_name == temp_loaded_observations.back().system_name) {
-					temp_loaded_observations.back().addObservedRecording(temp_recording);
-				} else {
-					ObservedSystem		temp_system = ObservedSystem(system_name);
-					temp_system.addObservedRecording(temp_recording);
-					temp_loaded_observations.push_back(temp_system);
-				}
+			} else if (matrix_mode != temp_matrix_mode) {
+				wxMessageBox("Error in reading configuration file.\nLoading mode specifier labels are inconsistent across the file.\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+				error = 1;
+				break;
 			}
+			load.entries.push_back(entry);
 		}
 	}
 	selected_file_stream.close();
-	delete	buffered_line;
 
-	if (error)
+	if (!error && (load.entries.size() == 0)) {
+		wxMessageBox("Error in reading configuration file.\nNo recordings are listed.\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+		error = 1;
+	}
+	if (error) {
+		load.entries.clear();
+		return;
+	}
+	load.matrix_mode = matrix_mode;
+	load.file_name = file_name;
+	load.folder_name = folder_name;
+	load.separator = separator_char;
+	load.filename_delimiter = filename_delimiter_char;
+
+	LoaderThread *thread = new LoaderThread(this);
+	if (thread->Create() != wxTHREAD_NO_ERROR) {
+		wxMessageBox("Runtime error:\ncannot start loading.", "Error", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+		thread->Delete();
+		return;
+	}
+
+	dialog_progress = new wxProgressDialog("Loading...", "Loading the recordings listed in the configuration file.\nPress [Cancel] to abort.", 100, this, wxPD_CAN_ABORT | wxPD_APP_MODAL | wxPD_ELAPSED_TIME | wxPD_REMAINING_TIME);
+	m_cancelled = false;
+	thread->Run();
+
+	return;
+}
+
+bool GuiFrame::loadingCancelled ()
+{
+	wxCriticalSectionLocker lock(m_cs_cancelled);
+	return m_cancelled;
+}
+
+void GuiFrame::onLoaderEvent (wxThreadEvent& event)
+{
+	int n = event.GetInt();
+	if (n == -1) {					// The loader has finished, whatever the outcome
+		dialog_progress->Destroy();
+		dialog_progress = (wxProgressDialog *) NULL;
+		wxWakeUpIdle();
+		finishConfiguredLoad();
+	} else if (!m_cancelled) {
+		if (!dialog_progress->Update(n)) {
+			wxCriticalSectionLocker lock(m_cs_cancelled);
+			m_cancelled = true;
+		}
+	}
+}
+
+void GuiFrame::finishConfiguredLoad ()
+{
+	ConfiguredLoad &	load = *configured_load;
+	std::vector <ObservedSystem> &	temp_loaded_observations = load.loaded_observations;
+	bool	matrix_mode = load.matrix_mode;
+	load.entries.clear();
+
+	if (load.error) {
+		if (load.error == -1)
+			wxMessageBox("Loading was cancelled by the user.\nNothing was loaded.", "Info", wxOK, NULL, wxDefaultCoord, wxDefaultCoord);
+		else
+			wxMessageBox(load.error_message, "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+		temp_loaded_observations.clear();
 		return;
+	}
 
 	int	i, j;
 	if (data_container->number_of_systems == 0) {
@@ -389,6 +425,7 @@ void GuiFrame::configuredLoadFiles (wxCommandEvent& WXUNUSED(event))
 			for (j = 0; j < temp_loaded_observations[i].recordings_stored.size(); j++) {
 				if (temp_loaded_observations[i].recordings_stored[j].matrix_timescales.size() != data_container->number_of_nodes) {
 					wxMessageBox("Error in loading data from configuration file.\nMatrices sizes are inconsistent.\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+					temp_loaded_observations.clear();
 					return;
 				}
 			}
@@ -398,14 +435,17 @@ void GuiFrame::configuredLoadFiles (wxCommandEvent& WXUNUSED(event))
 			for (j = 0; j < temp_loaded_observations[i].recordings_stored.size(); j++) {
 				if (temp_loaded_observations[i].recordings_stored[j].efficiencies.size() != temp_loaded_observations[0].recordings_stored[0].efficiencies.size()) {
 					wxMessageBox("Error in loading data from configuration file.\nNumber of efficiency files is inconsistent.\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+					temp_loaded_observations.clear();
 					return;
 				}
 				if (temp_loaded_observations[i].recordings_stored[j].efficiencies[0].size() != data_container->window_widths.size()) {
 					wxMessageBox("Error in loading data from configuration file.\nLengths of efficiencies are inconsistent.\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+					temp_loaded_observations.clear();
 					return;
 				}
 				if (temp_loaded_observations[i].recordings_stored[j].window_widths[0] != data_container->window_widths[0]) {
 					wxMessageBox("Error in loading data from configuration file.\nWindow widths are inconsistent.\nNothing was loaded.", "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+					temp_loaded_observations.clear();
 					return;
 				}
 			}
@@ -414,7 +454,7 @@ void GuiFrame::configuredLoadFiles (wxCommandEvent& WXUNUSED(event))
 
 	// Got here, means we're *good*
 	if (!matrix_mode) {
-		data_container->node_pairs = loaded_pair_labels;
+		data_container->node_pairs = load.loaded_pair_labels;
 		data_container->available_node_labels = true;
 		radiobox_input->SetSelection(0);
 		radiobox_input->Disable();
@@ -424,18 +464,135 @@ void GuiFrame::configuredLoadFiles (wxCommandEvent& WXUNUSED(event))
 		button_dictionary_load->Show();
 	}
 	for (i = 0; i < temp_loaded_observations.size(); i++) {
-		data_container->systems_stored.push_back(temp_loaded_observations[i]);
+		data_container->systems_stored.push_back(ObservedSystem(temp_loaded_observations[i].system_name));
+		data_container->systems_stored.back().recordings_stored.swap(temp_loaded_observations[i].recordings_stored);
 		data_container->number_of_systems += 1;
 		listbox_systems->Append(temp_loaded_observations[i].system_name);
 	}
 	std::stringstream	sstm;
-	sstm << "Successfully parsed and fulfilled configuration file '" << file_name << "'\n";
+	sstm << "Successfully parsed and fulfilled configuration file '" << load.file_name << "'\n";
 	sstm << "Created " << temp_loaded_observations.size() << " systems.\n";
+	temp_loaded_observations.clear();
 	wxMessageBox(sstm.str(), "Info", wxOK | wxICON_INFORMATION, NULL, wxDefaultCoord, wxDefaultCoord);
 
 	return;
 }
 
+LoaderThread::LoaderThread (GuiFrame *frame)
+: wxThread()
+{
+	parent_frame = frame;
+	data_container = parent_frame->data_container;
+	job = parent_frame->configured_load;
+}
+
+wxThread::ExitCode LoaderThread::Entry ()
+{
+	// Recordings of a configuration file are loaded concurrently, one task each. The first one is read before the others: its pairs of
+	// labels are those every other recording is checked against, through a hashed set, as soon as it is read.
+	// The first failing recording in file order is reported, and nothing is loaded. The GUI thread is told with -1 in any case.
+	ConfiguredLoad &	load = *job;
+	int	nr_entries = load.entries.size();
+	std::vector <ObservedRecording>	recordings;
+	std::vector <int>		errors(nr_entries, 0);
+	std::vector <std::string>	messages(nr_entries);
+	const char *	labels_message = "Error in loading files!\nLabels are inconsistent with previously loaded files,\nor pair duplicates have been found.\nNothing was loaded";
+	int	i;
+	for (i = 0; i < nr_entries; i++)
+		recordings.push_back(ObservedRecording(load.entries[i].recording_name));
+
+	load.error = 0;
+	load.error_message.clear();
+	load.loaded_observations.clear();
+	load.loaded_pair_labels.clear();
+	errors[0] = parent_frame->loadConfiguredRecording(recordings[0], load.loaded_pair_labels, load.matrix_mode, load.entries[0].file_name, load.folder_name,
+								load.separator, load.filename_delimiter, messages[0]);
+	if (!errors[0] && !load.matrix_mode && (data_container->number_of_systems > 0)) {
+		std::vector <PairOfLabels>	temp_label_pairs = load.loaded_pair_labels;
+		if (netOnZeroDXC_check_new_label_pairs(temp_label_pairs, data_container->node_pairs)) {
+			errors[0] = 1;
+			messages[0] = labels_message;
+		}
+	}
+
+	LabelPairSet	known_pairs;
+	netOnZeroDXC_build_label_pair_set(known_pairs, load.loaded_pair_labels);
+	long	entries_done = 1;
+	bool	go_flag = !errors[0];
+	int	old_progress = -1;
+	#pragma omp parallel
+	{
+		std::vector <PairOfLabels>	label_pairs;
+
+		#pragma omp for schedule(dynamic)
+		for (i = 1; i < nr_entries; i++) {
+			bool	go_on;
+			#pragma omp atomic read
+			go_on = go_flag;
+			if (!go_on)
+				continue;
+
+			int	error = parent_frame->loadConfiguredRecording(recordings[i], label_pairs, load.matrix_mode, load.entries[i].file_name, load.folder_name,
+										load.separator, load.filename_delimiter, messages[i]);
+			if (!error && !load.matrix_mode && netOnZeroDXC_check_new_label_pairs(label_pairs, known_pairs)) {
+				error = 1;
+				messages[i] = labels_message;
+			}
+			errors[i] = error;
+			if (error) {
+				#pragma omp atomic write
+				go_flag = 0;
+			}
+
+			#pragma omp atomic
+			entries_done++;
+
+			if (omp_get_thread_num() == 0) {
+				long	done;
+				#pragma omp atomic read
+				done = entries_done;
+				if (TestDestroy() || parent_frame->loadingCancelled()) {
+					#pragma omp atomic write
+					go_flag = 0;
+				}
+				int	progress = (int) (99 * done / nr_entries);
+				if (progress != old_progress) {
+					wxThreadEvent eventProgress(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+					eventProgress.SetInt(progress);
+					wxQueueEvent(parent_frame, eventProgress.Clone());
+					old_progress = progress;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < nr_entries; i++) {
+		if (errors[i]) {
+			load.error = errors[i];
+			load.error_message = messages[i];
+			break;
+		}
+	}
+	if (!load.error && !go_flag)
+		load.error = -1;
+
+	if (!load.error) {
+		for (i = 0; i < nr_entries; i++) {		// Consecutive lines of the same system make one system
+			if ((i == 0) || (load.entries[i].system_name != load.loaded_observations.back().system_name))
+				load.loaded_observations.push_back(ObservedSystem(load.entries[i].system_name));
+			ObservedSystem &	system = load.loaded_observations.back();
+			system.recordings_stored.push_back(ObservedRecording(load.entries[i].recording_name));
+			std::swap(system.recordings_stored.back(), recordings[i]);
+		}
+	}
+
+	wxThreadEvent eventEnd(wxEVT_THREAD, EVENT_WORKER_UPDATE);
+	eventEnd.SetInt(-1);
+	wxQueueEvent(parent_frame, eventEnd.Clone());
+
+	return NULL;
+}
+
 void GuiFrame::loadLabelsDictionary (wxCommandEvent& WXUNUSED(event))
 {
 	wxString	selected_file_name;
@@ -505,8 +662,9 @@ void GuiFrame::loadLabelsDictionary (wxCommandEvent& WXUNUSED(event))
 }
 
 int GuiFrame::loadConfiguredRecording (ObservedRecording & recording, std::vector<PairOfLabels> & label_pairs, bool matrix_mode,
-					const std::string & file_name, const std::string & folder_name, char separator, char filename_delimiter)
+					const std::string & file_name, const std::string & folder_name, char separator, char filename_delimiter, std::string & error_message)
 {
+	// Called by the LoaderThread, possibly from several threads at once: nothing is shown here, errors are described in error_message.
 	char	directory_char = '/';
 	if (folder_name.find_first_of('\\') != std::string::npos)
 		directory_char = '\\';
@@ -537,15 +695,13 @@ int GuiFrame::loadConfiguredRecording (ObservedRecording & recording, std::vecto
 		selected_file_stream.open(selected_file_name.c_str(), std::ifstream::in);
 		if (selected_file_stream.fail()) {
 			sstm << "Error in opening efficiencies list " << selected_file_name << "\nCannot load anything.";
-			wxMessageBox(sstm.str(), "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+			error_message = sstm.str();
 			return 1;
 		}
 		wxArrayString	list_of_files;
 		std::string	line;
-		char	*buffered_line = new char[256];
-		while(selected_file_stream.getline(buffered_line, 256)) {
+		while(std::getline(selected_file_stream, line)) {
 			std::stringstream	temp_file_path;
-			std::string		line = buffered_line;
 			if (line.size()) {
 				temp_file_path << folder_name;
 				if ((folder_name.find_last_of(directory_char) != folder_name.size()) && (line.find_first_of(directory_char) != 0))
@@ -554,7 +710,6 @@ int GuiFrame::loadConfiguredRecording (ObservedRecording & recording, std::vecto
 			}
 			list_of_files.Add(temp_file_path.str());
 		}
-		delete buffered_line;
 		loading_error = netOnZeroDXC_load_multi_efficiencies(recording.efficiencies, label_pairs, recording.window_widths, list_of_files, separator, filename_delimiter);
 		switch (loading_error) {
 			case 1:
@@ -578,7 +733,7 @@ int GuiFrame::loadConfiguredRecording (ObservedRecording & recording, std::vecto
 	}
 
 	if (loading_error) {
-		wxMessageBox(sstm.str(), "Error!", wxOK | wxICON_ERROR, NULL, wxDefaultCoord, wxDefaultCoord);
+		error_message = sstm.str();
 		return 1;
 	}
 
@@ -61,6 +61,10 @@
 	#include "netOnZeroDXC_pair.hpp"
 	#define INCLUDED_PAIR
 #endif
+#ifndef INCLUDED_ARRAY
+	#include "netOnZeroDXC_array.hpp"
+	#define INCLUDED_ARRAY
+#endif
 
 
 class MainApp;
@@ -68,6 +72,8 @@ class GuiFrame;
 class ObservedSystem;
 class ObservedRecording;
 class ContainerWorkspace;
+class LoaderThread;
+struct ConfiguredLoad;
 class PlotFrame;
 class PanelPlot;
 class PanelColorbox;
@@ -115,8 +121,11 @@ public:
 	int getRecordingIndex();
 	int getSystemIndex();
 	void updateSpinnerFromSliders(double, int, int);
+	bool loadingCancelled();
+	int loadConfiguredRecording(ObservedRecording &, std::vector<PairOfLabels> &, bool, const std::string &, const std::string &, char, char, std::string &);
 
 	ContainerWorkspace	*data_container;
+	ConfiguredLoad		*configured_load;
 	wxSpinCtrlDouble	*spinner_thr_efficiency;
 	wxSpinCtrl		*spinner_ranking_recordings;
 	wxSpinCtrl		*spinner_ranking_systems;
@@ -134,6 +143,8 @@ private:
 	void loadEfficiencyFiles(int, int);
 	void loadMatrixFiles(int);
 	void configuredLoadFiles(wxCommandEvent&);
+	void onLoaderEvent(wxThreadEvent&);
+	void finishConfiguredLoad();
 	void loadLabelsDictionary(wxCommandEvent&);
 	void deleteAllData(wxCommandEvent&);
 	void displayRecordingInfo(wxCommandEvent&);
@@ -145,9 +156,10 @@ private:
 	void saveMergedSystems(wxCommandEvent&);
 	void saveMergedGlobal(wxCommandEvent&);
 
-	int loadConfiguredRecording(ObservedRecording &, std::vector<PairOfLabels> &, bool, const std::string &, const std::string &, char, char);
-
 	bool			status_ready;
+	bool			m_cancelled;
+	wxCriticalSection	m_cs_cancelled;
+	wxProgressDialog	*dialog_progress;
 
 	wxListBox		*listbox_systems;
 	wxListBox		*listbox_recordings;
@@ -197,7 +209,6 @@ class ObservedSystem
 public:
 	ObservedSystem(const std::string);
 	void addObservedRecording(ObservedRecording);
-	double mergeRecordingMatrices(int, int, int, int);
 
 	std::string	system_name;
 	std::vector <ObservedRecording>		recordings_stored;
@@ -210,12 +221,31 @@ public:
 
 	std::string	recording_name;
 	std::vector < std::vector <double> >			matrix_timescales;
-	std::vector < std::vector < std::vector <double> > >	matrices_multieta;
 	std::vector < std::vector <double> >	efficiencies;
 	std::vector <double>			window_widths;
 };
 
 
+struct ConfiguredEntry {			// One line of a configuration file
+	std::string	system_name;
+	std::string	recording_name;
+	std::string	file_name;
+};
+
+struct ConfiguredLoad {				// Recordings of a configuration file, loaded by a LoaderThread and then added by the GUI thread
+	std::vector <ConfiguredEntry>	entries;
+	bool				matrix_mode;
+	std::string			file_name;
+	std::string			folder_name;
+	char				separator;
+	char				filename_delimiter;
+
+	int				error;		// 0 if all were loaded, -1 if cancelled
+	std::string			error_message;
+	std::vector <ObservedSystem>	loaded_observations;
+	std::vector <PairOfLabels>	loaded_pair_labels;
+};
+
 class ContainerWorkspace
 {
 public:
@@ -223,6 +253,7 @@ public:
 	void clearWorkspace();
 	void evaluateMergedMatrix(int, int, int);
 	void evaluateSystemMatrix(int, int, int);
+	void buildRankTables();
 
 	bool	multiple_eta;
 	bool	available_node_labels;
@@ -234,8 +265,24 @@ public:
 	std::vector <ObservedSystem>	systems_stored;
 	std::vector <std::string>	node_labels;
 	std::vector <PairOfLabels>	node_pairs;
+	PairIndexTable			pair_index;
 	std::vector <double>		window_widths;
 	std::vector < std::vector <double> >	ranked_matrix;
+
+	Array3D <double>		sorted_recordings;	// [eta level][pair i < j][system * recordings + rank of recording], missing links last
+	Array3D <double>		sorted_systems;		// [eta level][pair i < j][rank of recording * systems + rank of system]
+};
+
+class LoaderThread : public wxThread
+{
+public:
+	LoaderThread(GuiFrame *frame);
+
+	virtual void *Entry();
+
+	ConfiguredLoad		*job;
+	ContainerWorkspace	*data_container;
+	GuiFrame		*parent_frame;
 };
 
 class PlotFrame : public wxFrame
@@ -270,10 +317,15 @@ public:
 	PanelPlot(PlotFrame *, wxSize);
 	void OnPaint(wxPaintEvent&);
 	void OnResize(wxSizeEvent &);
+	void invalidateBitmap();
 
 private:
 	PlotFrame		*parent_frame;
 	ContainerWorkspace	*results_workspace;
+	ColorLUT		color_lut;
+	wxBitmap		matrix_bitmap;		// The matrix as last drawn, rendered again only when its slice or the size of its elements change
+	bool			bitmap_valid;
+	int			bitmap_pxsize;
 
 	wxDECLARE_EVENT_TABLE();
 };
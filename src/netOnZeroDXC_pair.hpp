@@ -28,7 +28,36 @@
 //
 // --------------------------------------------------------------------------
 
+#include <cstddef>
+#include <utility>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
 struct PairOfLabels {
 	std::string label_a;
 	std::string label_b;
 };
+
+struct PairIndexTable {			// Index in node_pairs of the pair of nodes (i, j), in either order; -1 if the pair is missing
+	int			nr_nodes;
+	std::vector <int>	pair_index;	// Upper triangle (i < j), row by row
+
+	PairIndexTable() : nr_nodes(0) {}
+	int	index(int i, int j) const
+	{
+		if (i == j)
+			return -1;
+		if (i > j)
+			std::swap(i, j);
+		return pair_index[(size_t) i * (2 * nr_nodes - i - 1) / 2 + (j - i - 1)];
+	}
+	void	clear() {nr_nodes = 0; pair_index.clear();}
+};
+
+struct LabelPairSet {			// Hashed pairs of labels, each with its number of occurrences, for netOnZeroDXC_check_new_label_pairs
+	std::unordered_map <std::string, int>	pair_slot;	// Key label_a + '\0' + label_b -> index in multiplicity
+	std::vector <int>			multiplicity;
+
+	void	clear() {pair_slot.clear(); multiplicity.clear();}
+};
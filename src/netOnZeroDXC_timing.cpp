@@ -0,0 +1,277 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+#endif
+
+#include "omp.h"
+
+#ifndef INCLUDED_IOFUNCTIONS
+	#include "netOnZeroDXC_io.hpp"
+	#define INCLUDED_IOFUNCTIONS
+#endif
+#ifndef INCLUDED_TIMING
+	#include "netOnZeroDXC_timing.hpp"
+	#define INCLUDED_TIMING
+#endif
+
+static const char *	timing_stage_names[NR_TIMING_STAGES] = {"load", "cdiagram", "surrogates", "pdiagram", "efficiency", "matrix", "write"};
+static const char *	timing_stage_units[NR_TIMING_STAGES] = {"inputs", "diagrams", "surrogates", "diagrams", "pairs", "elements", "tables"};
+
+void netOnZeroDXC_initialize_run_timing (RunTiming & timing, int number_threads)
+{
+	int	s;
+	timing.start_time = omp_get_wtime();
+	timing.start_cpu_time = netOnZeroDXC_process_cpu_time();
+	timing.elapsed_time = 0.0;
+	timing.cpu_time = 0.0;
+	for (s = 0; s < NR_TIMING_STAGES; s++) {
+		timing.stages[s].elapsed_time = 0.0;
+		timing.stages[s].thread_time = 0.0;
+		timing.stages[s].cpu_time = 0.0;
+		timing.stages[s].items = 0;
+	}
+	ThreadTiming	idle_thread = {0.0, 0.0};
+	timing.threads.assign((number_threads > 1)? number_threads : 1, idle_thread);
+	timing.surrogates = 0;
+	timing.surrogate_iterations = 0;
+	timing.max_surrogate_iterations = 0;
+}
+
+void netOnZeroDXC_finish_run_timing (RunTiming & timing)
+{
+	timing.elapsed_time = omp_get_wtime() - timing.start_time;
+	timing.cpu_time = netOnZeroDXC_process_cpu_time() - timing.start_cpu_time;
+}
+
+double netOnZeroDXC_thread_cpu_time ()
+{
+#ifdef _WIN32
+	FILETIME	creation, exit, kernel, user;
+	GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+	return 1e-7 * (double) (((unsigned long long) kernel.dwHighDateTime << 32) + kernel.dwLowDateTime + ((unsigned long long) user.dwHighDateTime << 32) + user.dwLowDateTime);
+#else
+	struct timespec	now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+#endif
+}
+
+double netOnZeroDXC_process_cpu_time ()
+{
+#ifdef _WIN32
+	FILETIME	creation, exit, kernel, user;
+	GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	return 1e-7 * (double) (((unsigned long long) kernel.dwHighDateTime << 32) + kernel.dwLowDateTime + ((unsigned long long) user.dwHighDateTime << 32) + user.dwLowDateTime);
+#else
+	struct timespec	now;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+	return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+#endif
+}
+
+void netOnZeroDXC_start_clock (StageClock & clock)
+{
+	clock.wall = omp_get_wtime();
+	clock.cpu = netOnZeroDXC_thread_cpu_time();
+}
+
+void netOnZeroDXC_lap_clock (RunTiming & timing, int stage, StageClock & clock, long items)
+{
+	// Adds the time of the calling thread since the clock was started, or since its last lap, to the stage; then restarts the clock.
+	// Safe to call from any thread: it costs two clock readings and a few atomic additions, so it is meant for steps of a pair, not of a window.
+	double	wall = omp_get_wtime();
+	double	cpu = netOnZeroDXC_thread_cpu_time();
+	StageTiming &	record = timing.stages[stage];
+	#pragma omp atomic
+	record.thread_time += wall - clock.wall;
+	#pragma omp atomic
+	record.cpu_time += cpu - clock.cpu;
+	#pragma omp atomic
+	record.items += items;
+	clock.wall = wall;
+	clock.cpu = cpu;
+}
+
+void netOnZeroDXC_stop_clock (RunTiming & timing, int stage, StageClock & clock, long items)
+{
+	// A step run by the calling thread alone: its elapsed time is also that of the stage
+	double	start = clock.wall;
+	netOnZeroDXC_lap_clock(timing, stage, clock, items);
+	timing.stages[stage].elapsed_time += clock.wall - start;
+}
+
+void netOnZeroDXC_stop_thread_clock (RunTiming & timing, const StageClock & clock)
+{
+	// At the end of a parallel section, from each thread: CPU time of the thread since the clock was started
+	int	thread = omp_get_thread_num();
+	if (thread < (int) timing.threads.size())
+		timing.threads[thread].cpu_time += netOnZeroDXC_thread_cpu_time() - clock.cpu;
+}
+
+void netOnZeroDXC_add_stage_elapsed (RunTiming & timing, int stage, double elapsed, long items)
+{
+	// A step split among threads, from the thread that started it: its elapsed time, and the items not counted by the threads
+	timing.stages[stage].elapsed_time += elapsed;
+	timing.stages[stage].items += items;
+}
+
+void netOnZeroDXC_add_parallel_section (RunTiming & timing, int number_threads, double elapsed)
+{
+	// After a parallel section: every thread of the team was available for its whole duration
+	int	t;
+	int	nr_threads = (number_threads > 1)? number_threads : 1;
+	for (t = 0; (t < nr_threads) && (t < (int) timing.threads.size()); t++)
+		timing.threads[t].elapsed_time += elapsed;
+}
+
+void netOnZeroDXC_add_surrogate_iterations (RunTiming & timing, long surrogates, long iterations, int max_iterations)
+{
+	#pragma omp atomic
+	timing.surrogates += surrogates;
+	#pragma omp atomic
+	timing.surrogate_iterations += iterations;
+	#pragma omp critical (netOnZeroDXC_timing)
+	{
+		if (max_iterations > timing.max_surrogate_iterations)
+			timing.max_surrogate_iterations = max_iterations;
+	}
+}
+
+double netOnZeroDXC_estimate_remaining_time (double start_time, long done, long total)
+{
+	// Seconds left at the average rate observed since start_time; negative if there is no estimate yet
+	if ((done <= 0) || (total <= 0))
+		return -1.0;
+
+	double	elapsed = omp_get_wtime() - start_time;
+
+	return elapsed * (double) (total - done) / (double) done;
+}
+
+std::string netOnZeroDXC_format_duration (double seconds)
+{
+	char	buffer[32];
+	if (seconds < 0.0)
+		return std::string("unknown");
+	long	total = (long) (seconds + 0.5);
+	sprintf(buffer, "%ld:%02ld:%02ld", total / 3600, (total / 60) % 60, total % 60);
+
+	return std::string(buffer);
+}
+
+void netOnZeroDXC_format_timing_summary (std::stringstream & content, const RunTiming & timing, std::string line_prefix)
+{
+	// Tab-separated tables, each line starting with line_prefix (e.g. "# " for a log file)
+	char	buffer[256];
+	int	s, t;
+	int	nr_threads = timing.threads.size();
+	sprintf(buffer, "Elapsed time: %.3f s, CPU time: %.3f s, threads: %d\n", timing.elapsed_time, timing.cpu_time, nr_threads);
+	content << line_prefix << buffer;
+	content << line_prefix << "stage\telapsed_s\tthread_s\tcpu_s\titems\tunit\titems_per_thread_s\n";
+	for (s = 0; s < NR_TIMING_STAGES; s++) {
+		const StageTiming &	record = timing.stages[s];
+		if ((record.items == 0) && (record.thread_time == 0.0))
+			continue;
+		sprintf(buffer, "%s\t%.3f\t%.3f\t%.3f\t%ld\t%s\t%.6g\n", timing_stage_names[s], record.elapsed_time, record.thread_time, record.cpu_time, record.items,
+			timing_stage_units[s], (record.thread_time > 0.0)? (double) record.items / record.thread_time : 0.0);
+		content << line_prefix << buffer;
+	}
+
+	const StageTiming &	generation = timing.stages[TIMING_STAGE_SURROGATES];
+	double	generation_time = (generation.elapsed_time > 0.0)? generation.elapsed_time : generation.thread_time / nr_threads;
+	if (generation.items > 0) {
+		sprintf(buffer, "Surrogates: %ld, %.6g per second", generation.items, (generation_time > 0.0)? (double) generation.items / generation_time : 0.0);
+		content << line_prefix << buffer;
+		if (timing.surrogates > 0) {
+			sprintf(buffer, ", IAAFT iterations until convergence: mean %.2f, max %d", (double) timing.surrogate_iterations / (double) timing.surrogates,
+				timing.max_surrogate_iterations);
+			content << buffer;
+		}
+		content << "\n";
+	}
+
+	content << line_prefix << "thread\telapsed_s\tcpu_s\tutilization\n";
+	for (t = 0; t < nr_threads; t++) {
+		const ThreadTiming &	record = timing.threads[t];
+		sprintf(buffer, "%d\t%.3f\t%.3f\t%.3f\n", t, record.elapsed_time, record.cpu_time, (record.elapsed_time > 0.0)? record.cpu_time / record.elapsed_time : 0.0);
+		content << line_prefix << buffer;
+	}
+}
+
+void netOnZeroDXC_format_timing_json (std::stringstream & content, const RunTiming & timing)
+{
+	char	buffer[256];
+	int	s, t;
+	int	nr_threads = timing.threads.size();
+	sprintf(buffer, "{\n\t\"elapsed_s\": %.6f,\n\t\"cpu_s\": %.6f,\n\t\"threads\": %d,\n\t\"stages\": {", timing.elapsed_time, timing.cpu_time, nr_threads);
+	content << buffer;
+	for (s = 0; s < NR_TIMING_STAGES; s++) {
+		const StageTiming &	record = timing.stages[s];
+		sprintf(buffer, "%s\n\t\t\"%s\": {\"elapsed_s\": %.6f, \"thread_s\": %.6f, \"cpu_s\": %.6f, \"items\": %ld, \"unit\": \"%s\"}", (s > 0)? "," : "",
+			timing_stage_names[s], record.elapsed_time, record.thread_time, record.cpu_time, record.items, timing_stage_units[s]);
+		content << buffer;
+	}
+
+	const StageTiming &	generation = timing.stages[TIMING_STAGE_SURROGATES];
+	double	generation_time = (generation.elapsed_time > 0.0)? generation.elapsed_time : generation.thread_time / nr_threads;
+	sprintf(buffer, "\n\t},\n\t\"surrogates\": {\"count\": %ld, \"per_s\": %.6g, \"iterations_counted\": %ld, \"iterations_mean\": %.6g, \"iterations_max\": %d},\n",
+		generation.items, (generation_time > 0.0)? (double) generation.items / generation_time : 0.0, timing.surrogates,
+		(timing.surrogates > 0)? (double) timing.surrogate_iterations / (double) timing.surrogates : 0.0, timing.max_surrogate_iterations);
+	content << buffer;
+
+	content << "\t\"thread_utilization\": [";
+	for (t = 0; t < nr_threads; t++) {
+		const ThreadTiming &	record = timing.threads[t];
+		sprintf(buffer, "%s%.4f", (t > 0)? ", " : "", (record.elapsed_time > 0.0)? record.cpu_time / record.elapsed_time : 0.0);
+		content << buffer;
+	}
+	content << "]\n}\n";
+}
+
+int netOnZeroDXC_save_timing_log (const RunTiming & timing, std::string path, std::string prefix, char delimiter)
+{
+	// Written as [prefix_]timing.log next to the results
+	std::stringstream	content;
+	content << "# Timing of the run, per stage and per thread (thread_s and cpu_s add up all threads working on a stage).\n";
+	netOnZeroDXC_format_timing_summary(content, timing, "# ");
+
+	std::string	file_name = netOnZeroDXC_generate_filepath(path, prefix, "timing", delimiter, "", "");
+	file_name = file_name.substr(0, file_name.find_last_of(".")) + ".log";
+
+	return netOnZeroDXC_save_log_file(content, file_name);
+}
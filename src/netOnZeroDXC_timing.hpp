@@ -0,0 +1,90 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the NetOnZeroDXC software package.
+//
+// Version 1.0 - April 2019
+//
+//
+// The NetOnZeroDXC package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		https://github.com/LeonardoRicci/netOnZeroDXC
+//
+//
+// If you use the NetOnZeroDXC package for your analyses, please cite:
+//
+//	A. Perinelli, D. E. Chiari and L. Ricci,
+//	"Correlation in brain networks at different time scale resolution".
+//	Chaos 28 (6):063127, 2018
+//
+// --------------------------------------------------------------------------
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Stages of a run, as reported in [prefix_]timing.log. Each stage adds up the elapsed and CPU time of every thread working on it: with
+// several threads, thread time can exceed the elapsed time of the stage, which is only known when the stage runs as a separate step.
+#define NR_TIMING_STAGES 7
+#define TIMING_STAGE_LOAD 0
+#define TIMING_STAGE_CDIAGRAM 1
+#define TIMING_STAGE_SURROGATES 2
+#define TIMING_STAGE_PDIAGRAM 3
+#define TIMING_STAGE_EFFICIENCY 4
+#define TIMING_STAGE_MATRIX 5
+#define TIMING_STAGE_WRITE 6
+
+struct StageTiming {
+	double	elapsed_time;			// 0 if the stage was interleaved with others
+	double	thread_time;
+	double	cpu_time;
+	long	items;
+};
+
+struct ThreadTiming {				// Per OpenMP thread number, over the parallel sections of a run
+	double	elapsed_time;
+	double	cpu_time;
+};
+
+struct RunTiming {
+	double			start_time;
+	double			start_cpu_time;
+	double			elapsed_time;
+	double			cpu_time;
+	StageTiming		stages[NR_TIMING_STAGES];
+	std::vector <ThreadTiming>	threads;
+	long			surrogates;			// Generated with a known number of IAAFT iterations
+	long			surrogate_iterations;
+	int			max_surrogate_iterations;
+};
+
+struct StageClock {				// Start of a timed step on the calling thread
+	double	wall;
+	double	cpu;
+};
+
+void netOnZeroDXC_initialize_run_timing (RunTiming &, int);
+void netOnZeroDXC_finish_run_timing (RunTiming &);
+double netOnZeroDXC_thread_cpu_time ();
+double netOnZeroDXC_process_cpu_time ();
+void netOnZeroDXC_start_clock (StageClock &);
+void netOnZeroDXC_lap_clock (RunTiming &, int, StageClock &, long);
+void netOnZeroDXC_stop_clock (RunTiming &, int, StageClock &, long);
+void netOnZeroDXC_stop_thread_clock (RunTiming &, const StageClock &);
+void netOnZeroDXC_add_stage_elapsed (RunTiming &, int, double, long);
+void netOnZeroDXC_add_parallel_section (RunTiming &, int, double);
+void netOnZeroDXC_add_surrogate_iterations (RunTiming &, long, long, int);
+double netOnZeroDXC_estimate_remaining_time (double, long, long);
+std::string netOnZeroDXC_format_duration (double);
+void netOnZeroDXC_format_timing_summary (std::stringstream &, const RunTiming &, std::string);
+void netOnZeroDXC_format_timing_json (std::stringstream &, const RunTiming &);
+int netOnZeroDXC_save_timing_log (const RunTiming &, std::string, std::string, char);